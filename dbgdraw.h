@@ -227,6 +227,69 @@ extern "C" {
 #define DBGDRAW_ROUND(x) roundf(x)
 #endif
 
+// Define DBGDRAW_NO_STATS to compile out all statistics counters
+#ifdef DBGDRAW_NO_STATS
+#define DBGDRAW_STATS(expr)
+#else
+#define DBGDRAW_STATS(expr) expr
+#endif
+
+// Define DBGDRAW_TRACING to report spans of dbgdraw's work to the hooks set
+// with dd_set_trace_hooks. Without it the trace points compile out.
+#ifdef DBGDRAW_TRACING
+#define DBGDRAW_TRACE_BEGIN(ctx, name)                                         \
+  do {                                                                         \
+    if ((ctx)->trace_hooks.begin)                                              \
+    {                                                                          \
+      (ctx)->trace_hooks.begin((ctx)->trace_hooks.user_data, name);            \
+    }                                                                          \
+  } while (0)
+#define DBGDRAW_TRACE_END(ctx, name)                                           \
+  do {                                                                         \
+    if ((ctx)->trace_hooks.end)                                                \
+    {                                                                          \
+      (ctx)->trace_hooks.end((ctx)->trace_hooks.user_data, name);              \
+    }                                                                          \
+  } while (0)
+#else
+#define DBGDRAW_TRACE_BEGIN(ctx, name)
+#define DBGDRAW_TRACE_END(ctx, name)
+#endif
+
+#ifndef DBGDRAW_TRACE_BUFFER_SIZE
+#define DBGDRAW_TRACE_BUFFER_SIZE (64 * 1024)
+#endif
+
+#ifndef DBGDRAW_CAPTURE_KEYFRAME_INTERVAL
+#define DBGDRAW_CAPTURE_KEYFRAME_INTERVAL 60
+#endif
+
+#ifndef DBGDRAW_TEXT_CACHE_MAX_AGE
+#define DBGDRAW_TEXT_CACHE_MAX_AGE 60
+#endif
+
+#ifndef DBGDRAW_DECLUTTER_CELL_SIZE
+#define DBGDRAW_DECLUTTER_CELL_SIZE 64
+#endif
+
+#ifndef DBGDRAW_TEXT_FMT_MAX
+#define DBGDRAW_TEXT_FMT_MAX 128
+#endif
+
+// Define DBGDRAW_FONT_CACHE_DIR (e.g. "/tmp") to keep glyphs that fonts
+// rasterize when they are loaded in that directory. Later runs read them back
+// instead of rasterizing. The cache is written with stdio.
+#if defined(DBGDRAW_FONT_CACHE_DIR) && defined(DBGDRAW_NO_STDIO)
+#undef DBGDRAW_FONT_CACHE_DIR
+#endif
+
+// Define DBGDRAW_ASYNC_FONTS to load fonts from files on worker threads with
+// dd_init_font_from_file_async. Outside of Windows this uses pthreads, so the
+// program has to link them.
+#if defined(DBGDRAW_ASYNC_FONTS) && defined(DBGDRAW_NO_STDIO)
+#undef DBGDRAW_ASYNC_FONTS
+#endif
+
 #define DD_MAX(a, b) (((a) > (b)) ? (a) : (b))
 #define DD_MIN(a, b) (((a) < (b)) ? (a) : (b))
 #define DD_ABS(x)    (((x) < 0) ? -(x) : (x))
@@ -290,10 +353,45 @@ typedef enum dd_projection_type
   DBGDRAW_ORTHOGRAPHIC
 } dd_proj_type_t;
 
+typedef enum dd_procedural_type
+{
+  DBGDRAW_PROCEDURAL_SPHERE,
+  DBGDRAW_PROCEDURAL_CONICAL_FRUSTUM,
+  DBGDRAW_PROCEDURAL_TORUS,
+  DBGDRAW_PROCEDURAL_CIRCLE,
+  DBGDRAW_PROCEDURAL_IMPOSTOR_SPHERE,
+  DBGDRAW_PROCEDURAL_IMPOSTOR_CAPSULE,
+  DBGDRAW_PROCEDURAL_IMPOSTOR_CYLINDER,
+
+  DBGDRAW_PROCEDURAL_COUNT
+} dd_procedural_type_t;
+
+typedef enum dd_backend_caps
+{
+  DBGDRAW_BACKEND_CAPS_NONE       = 0,
+  DBGDRAW_BACKEND_CAPS_PROCEDURAL = 1 << 0,
+  DBGDRAW_BACKEND_CAPS_IMPOSTORS  = 1 << 1,
+  DBGDRAW_BACKEND_CAPS_SDF_TEXT   = 1 << 2,
+  DBGDRAW_BACKEND_CAPS_FONT_ARRAY = 1 << 3,
+  DBGDRAW_BACKEND_CAPS_GLYPH_INSTANCES = 1 << 4,
+  DBGDRAW_BACKEND_CAPS_CLIP_RECT       = 1 << 5,
+} dd_backend_caps_t;
+
 typedef struct dd_context_desc dd_ctx_desc_t;
 typedef struct dd_new_frame_info dd_new_frame_info_t;
 typedef struct dd_ctx_t dd_ctx_t;
 typedef struct dd_instance_data dd_instance_data_t;
+typedef struct dd_procedural_prim dd_procedural_prim_t;
+typedef struct dd_frame_timings dd_frame_timings_t;
+typedef struct dd_frame_stats dd_frame_stats_t;
+typedef struct dd_trace_hooks dd_trace_hooks_t;
+// Defined by backends that can share resources between contexts
+typedef struct dd_shared_resources dd_shared_resources_t;
+#ifndef DBGDRAW_NO_STDIO
+typedef struct dd_trace_file dd_trace_file_t;
+typedef struct dd_replay dd_replay_t;
+#endif
+typedef void (*dd_trace_fn)(void* user_data, const char* name);
 #if DBGDRAW_HAS_TEXT_SUPPORT
 typedef struct dd_text_info dd_text_info_t;
 #endif
@@ -311,6 +409,43 @@ int32_t dd_term(dd_ctx_t* ctx);
 int32_t dd_new_frame(dd_ctx_t* ctx, dd_new_frame_info_t* info);
 int32_t dd_render(dd_ctx_t* ctx);
 
+// Sort commands by draw mode and depth - call before dd_render, if needed
+void dd_sort_commands(dd_ctx_t* ctx);
+
+// Pipelined rendering - requires '.pipeline_depth' in desc. The recording
+// thread hands a finished frame off with dd_submit_frame and continues with the
+// next one, while the render thread draws the oldest submitted frame with
+// dd_render_submitted
+int32_t dd_submit_frame(dd_ctx_t* ctx);
+int32_t dd_render_submitted(dd_ctx_t* ctx);
+
+// Timings of the most recent frame - requires '.enable_timings' in desc
+int32_t dd_get_frame_timings(dd_ctx_t* ctx, dd_frame_timings_t* timings);
+
+// Counters of the current frame - call after dd_render for backend counters
+int32_t dd_get_frame_stats(dd_ctx_t* ctx, dd_frame_stats_t* stats);
+
+// Tracing - hooks receive spans of dbgdraw work if built with DBGDRAW_TRACING.
+// The trace file writer streams these spans as Chrome Trace Event JSON
+int32_t dd_set_trace_hooks(dd_ctx_t* ctx, dd_trace_hooks_t* hooks);
+#ifndef DBGDRAW_NO_STDIO
+int32_t dd_trace_file_open(dd_trace_file_t* file, const char* filename);
+int32_t dd_trace_file_close(dd_trace_file_t* file);
+dd_trace_hooks_t dd_trace_file_hooks(dd_trace_file_t* file);
+void dd_trace_file_begin(void* user_data, const char* name);
+void dd_trace_file_end(void* user_data, const char* name);
+#endif
+
+// Capture / Replay - write every frame passed to dd_render or dd_submit_frame
+// into a file, and load captured frames back into a context
+#ifndef DBGDRAW_NO_STDIO
+int32_t dd_capture_begin(dd_ctx_t* ctx, const char* filename);
+int32_t dd_capture_end(dd_ctx_t* ctx);
+int32_t dd_replay_open(dd_replay_t* replay, const char* filename);
+int32_t dd_replay_close(dd_replay_t* replay);
+int32_t dd_replay_frame(dd_ctx_t* ctx, dd_replay_t* replay, int32_t frame_idx);
+#endif
+
 // Command start and end + modify global state
 int32_t dd_begin_cmd(dd_ctx_t* ctx, dd_mode_t draw_mode);
 int32_t dd_end_cmd(dd_ctx_t* ctx);
@@ -323,6 +458,13 @@ int32_t dd_set_primitive_size(dd_ctx_t* ctx, float primitive_size);
 int32_t
 dd_set_line_antialias_radius(dd_ctx_t* ctx, float amount_x, float amount_y);
 int32_t dd_set_antialias_radius(dd_ctx_t* ctx, float radius);
+int32_t dd_set_procedural(dd_ctx_t* ctx, uint8_t enable);
+int32_t dd_set_impostors(dd_ctx_t* ctx, uint8_t enable);
+// Clips the commands that follow to 'rect' - x, y, width and height in pixels
+// of the viewport, from its top left corner. NULL turns clipping off. Inside a
+// command the command is split. Backends with DBGDRAW_BACKEND_CAPS_CLIP_RECT
+// apply it per pixel, others only drop what is fully outside of it.
+int32_t dd_set_clip_rect(dd_ctx_t* ctx, float* rect);
 
 // 3d drawing API
 int32_t dd_point(dd_ctx_t* ctx, float* pt_a);
@@ -340,6 +482,7 @@ int32_t
 dd_torus(dd_ctx_t* ctx, float* center_pt, float radius_a, float radius_b);
 int32_t dd_cone(dd_ctx_t* ctx, float* a, float* b, float radius);
 int32_t dd_cylinder(dd_ctx_t* ctx, float* a, float* b, float radius);
+int32_t dd_capsule(dd_ctx_t* ctx, float* a, float* b, float radius);
 int32_t dd_conical_frustum(dd_ctx_t* ctx,
                            float* a,
                            float* b,
@@ -369,9 +512,35 @@ dd_rounded_rect2d_ex(dd_ctx_t* ctx, float* a, float* b, float* rounding);
 // Text rendering
 #if DBGDRAW_HAS_TEXT_SUPPORT
 int32_t dd_find_font(dd_ctx_t* ctx, char* font_name);
+// Can be called inside a command. Backends without
+// DBGDRAW_BACKEND_CAPS_FONT_ARRAY bind one font per command, so for them the
+// command is split when text in another font follows
 int32_t dd_set_font(dd_ctx_t* ctx, int32_t font_idx);
+// Pixel height of text, 0 draws it at the size its font was loaded with
+int32_t dd_set_text_size(dd_ctx_t* ctx, float text_size);
+// Text drawn while decluttering is enabled is kept until the end of the
+// command, and only labels that do not overlap a label of higher priority on
+// screen are drawn. For such labels 'info' only receives width and height
+int32_t dd_set_text_declutter(dd_ctx_t* ctx, uint8_t enable);
+int32_t dd_set_text_priority(dd_ctx_t* ctx, float priority);
 int32_t
 dd_text_line(dd_ctx_t* ctx, float* pos, const char* str, dd_text_info_t* info);
+// Numbers and formatted text, placed from the cached quads of printable ASCII
+// instead of being laid out and cached per string. 'precision' is the number
+// of digits after the decimal point; negative values print up to six
+// significant digits, like "%g". dd_text_fmt formats at most
+// DBGDRAW_TEXT_FMT_MAX - 1 characters, with the d, i, u, x, X, c, s, p, f, F,
+// e, E, g, G and % conversions of printf, their flags, width and precision
+int32_t dd_text_number(dd_ctx_t* ctx,
+                       float* pos,
+                       double value,
+                       int32_t precision,
+                       dd_text_info_t* info);
+int32_t dd_text_fmt(dd_ctx_t* ctx,
+                    float* pos,
+                    dd_text_info_t* info,
+                    const char* fmt,
+                    ...);
 void dd_get_text_size_font_space(dd_ctx_t* ctx,
                                  int32_t font_idx,
                                  const char* str,
@@ -394,6 +563,48 @@ int32_t dd_init_font_from_file(dd_ctx_t* ctx,
                                int32_t height,
                                int32_t* font_idx);
 #endif
+// Signed distance field fonts - 'font_size' is the size glyphs are rasterized
+// at, but they stay sharp at any size set with dd_set_text_size. Backends
+// without DBGDRAW_BACKEND_CAPS_SDF_TEXT get a regular font instead
+int32_t dd_init_sdf_font_from_memory(dd_ctx_t* ctx,
+                                     const void* ttf_buf,
+                                     const char* name,
+                                     int32_t font_size,
+                                     int32_t width,
+                                     int32_t height,
+                                     int32_t* font_idx);
+#ifndef DBGDRAW_NO_STDIO
+int32_t dd_init_sdf_font_from_file(dd_ctx_t* ctx,
+                                   const char* font_path,
+                                   const char* name,
+                                   int32_t font_size,
+                                   int32_t width,
+                                   int32_t height,
+                                   int32_t* font_idx);
+#endif
+#ifdef DBGDRAW_ASYNC_FONTS
+// Return right away with the index of the font, while the file is read and the
+// atlas rasterized on a worker thread. The texture is created by the first
+// dd_render after that finishes. Until then text set to use the font is drawn
+// with the default font, or not at all without one.
+int32_t dd_init_font_from_file_async(dd_ctx_t* ctx,
+                                     const char* font_path,
+                                     const char* name,
+                                     int32_t font_size,
+                                     int32_t width,
+                                     int32_t height,
+                                     int32_t* font_idx);
+int32_t dd_init_sdf_font_from_file_async(dd_ctx_t* ctx,
+                                         const char* font_path,
+                                         const char* name,
+                                         int32_t font_size,
+                                         int32_t width,
+                                         int32_t height,
+                                         int32_t* font_idx);
+#endif
+// DBGDRAW_ERR_OK once the font can be drawn, DBGDRAW_ERR_FONT_LOADING while it
+// is loaded asynchronously, or the error that stopped the load
+int32_t dd_get_font_status(dd_ctx_t* ctx, int32_t font_idx);
 #endif
 
 // Utility
@@ -405,6 +616,7 @@ dd_color_t dd_rgbau(uint8_t r, uint8_t g, uint8_t b, uint8_t a);
 dd_color_t dd_hsl(float hue_degres, float saturation, float lightness);
 dd_color_t dd_interpolate_color(dd_color_t c0, dd_color_t c1, float t);
 void dd_extract_frustum_planes(dd_ctx_t* ctx);
+double dd_time_ms(void);
 const char* dd_error_message(int32_t error_code);
 int32_t dd_set_instance_data(dd_ctx_t* ctx,
                              int32_t instance_count,
@@ -421,6 +633,17 @@ int32_t dd_backend_init_font_texture(dd_ctx_t* ctx,
                                      int32_t width,
                                      int32_t height,
                                      uint32_t* tex_id);
+// 'data' is the whole atlas, only the rect at (x, y) of size (w, h) changed.
+// Backends may replace the texture, in which case 'tex_id' is updated
+int32_t dd_backend_update_font_texture(dd_ctx_t* ctx,
+                                       const uint8_t* data,
+                                       int32_t width,
+                                       int32_t height,
+                                       int32_t x,
+                                       int32_t y,
+                                       int32_t w,
+                                       int32_t h,
+                                       uint32_t* tex_id);
 #endif
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -612,18 +835,149 @@ typedef struct dd_text_info
   dd_text_rect_t clip_rect;
 } dd_text_info_t;
 
+typedef struct dd_glyph
+{
+  stbtt_packedchar quad;
+  uint32_t codepoint;
+  uint32_t last_used_frame;
+} dd_glyph_t;
+
+// Printable ASCII glyph placed at the origin, used by dd_text_number and
+// dd_text_fmt. It is placed again once 'generation' differs from the font's
+typedef struct dd_ascii_glyph
+{
+  stbtt_aligned_quad q;
+  float advance;
+  int32_t glyph_idx;
+  uint32_t generation;
+} dd_ascii_glyph_t;
+
+// Glyphs are rasterized into a grid of equally sized cells the first time they
+// are drawn, and found through an open addressing hash table from codepoint to
+// glyph. Once all cells are taken, the least recently used glyph that no frame
+// in flight refers to is evicted. The font keeps its own copy of the ttf data
+// and of the atlas bitmap. The default font only keeps the embedded deflated
+// data, until a glyph it needs is not in the atlas.
 typedef struct dd_font_data
 {
   char* name;
   int32_t bitmap_width, bitmap_height;
   float ascent, descent, line_gap;
 
-  stbtt_packedchar char_data[1024];
+  uint8_t* ttf_data;
+  const uint8_t* deflated_ttf;
+  int32_t deflated_size;
+  int32_t ttf_size;
+  uint8_t* bitmap;
+  int32_t cell_width, cell_height;
+  dd_glyph_t* glyphs;
+  int32_t glyphs_len;
+  int32_t glyphs_cap;
+  int32_t* glyph_table;
+  uint32_t glyph_table_mask;
+  uint32_t generation; // Advanced whenever a glyph is evicted
+  dd_ascii_glyph_t* ascii_glyphs;
+  uint8_t is_sdf;
+  int32_t status; // DBGDRAW_ERR_FONT_LOADING until an async load finishes
+
   stbtt_fontinfo info;
   uint32_t size;
   uint32_t tex_id;
 } dd_font_data_t;
 
+// Part of a font atlas that changed during the frame
+typedef struct dd_glyph_upload
+{
+  int32_t font_idx;
+  int32_t x0, y0, x1, y1;
+} dd_glyph_upload_t;
+
+// Glyph of a cached text layout, positioned in font space
+typedef struct dd_layout_glyph
+{
+  stbtt_aligned_quad q;
+  int32_t glyph_idx;
+} dd_layout_glyph_t;
+
+typedef struct dd_text_layout
+{
+  uint64_t hash;
+  int32_t font_idx;
+  uint32_t font_generation;
+  uint32_t last_used_frame;
+  uint8_t is_complete;
+  int32_t str_offset, str_len;
+  int32_t glyphs_offset, glyphs_len;
+  float width;
+} dd_text_layout_t;
+
+// Layouts of strings drawn with dd_text_line, found through an open addressing
+// hash table from (string, font) to layout. Strings and glyphs of all layouts
+// are kept in two pools. A layout is rebuilt when a glyph of its font was
+// evicted since it was laid out, and layouts that were not drawn for
+// DBGDRAW_TEXT_CACHE_MAX_AGE frames are dropped, at which point the pools are
+// compacted.
+typedef struct dd_text_cache
+{
+  dd_text_layout_t* layouts;
+  int32_t layouts_len;
+  int32_t layouts_cap;
+  int32_t* table;
+  uint32_t table_mask;
+  dd_layout_glyph_t* glyphs;
+  int32_t glyphs_len;
+  int32_t glyphs_cap;
+  char* chars;
+  int32_t chars_len;
+  int32_t chars_cap;
+} dd_text_cache_t;
+
+typedef struct dd_text_label
+{
+  dd_vec3_t pos;
+  int32_t layout_idx;
+  int32_t font_idx;
+  float text_size;
+  float priority;
+  dd_color_t color;
+  dd_text_info_t info;
+  uint8_t has_info;
+  uint8_t is_kept;
+  float x0, y0, x1, y1;
+} dd_text_label_t;
+
+typedef struct dd_label_key
+{
+  float priority;
+  int32_t label_idx;
+} dd_label_key_t;
+
+typedef struct dd_label_node
+{
+  int32_t label_idx;
+  int32_t next;
+} dd_label_node_t;
+
+// Labels deferred by dd_text_line while decluttering is enabled, with their
+// rectangles in viewport pixels. At the end of the command they are visited
+// from the highest priority down, and each one is kept if it does not overlap a
+// label that was kept before it. Kept labels are linked into every cell of a
+// DBGDRAW_DECLUTTER_CELL_SIZE grid over the viewport that they touch, so a
+// label is only tested against the labels in its own cells.
+typedef struct dd_declutter
+{
+  dd_text_label_t* labels;
+  int32_t labels_len;
+  int32_t labels_cap;
+  dd_label_key_t* keys;
+  int32_t keys_cap;
+  int32_t* cells;
+  int32_t cells_cap;
+  dd_label_node_t* nodes;
+  int32_t nodes_len;
+  int32_t nodes_cap;
+} dd_declutter_t;
+
 #endif
 
 typedef enum dd_error
@@ -643,6 +997,12 @@ typedef enum dd_error
   DBGDRAW_ERR_INVALID_MODE,
   DBGDRAW_ERR_USING_TEXT_WITHOUT_FONT,
   DBGDRAW_ERR_INVALID_SHADING,
+  DBGDRAW_ERR_INVALID_IMAGE,
+  DBGDRAW_ERR_FILE_OPEN_FAILED,
+  DBGDRAW_ERR_INVALID_CAPTURE,
+  DBGDRAW_ERR_NO_FREE_FRAME,
+  DBGDRAW_ERR_NO_SUBMITTED_FRAME,
+  DBGDRAW_ERR_FONT_LOADING,
 
   DBGDRAW_ERR_COUNT
 } dd_err_code_t;
@@ -652,14 +1012,23 @@ typedef struct dd_context_desc
   int32_t max_vertices;
   int32_t max_commands;
   int32_t max_instances;
+  int32_t max_procedural_prims;
   int32_t max_fonts;
   uint8_t detail_level;
   float antialias_radius;
   uint8_t enable_frustum_cull;
   uint8_t enable_depth_test;
+  uint8_t enable_procedural_prims;
+  uint8_t enable_impostors;
+  uint8_t enable_timings;
 #if DBGDRAW_HAS_TEXT_SUPPORT && defined(DBGDRAW_USE_DEFAULT_FONT)
   uint8_t enable_default_font;
 #endif
+  /* Optional, pool of backend resources used by several contexts */
+  dd_shared_resources_t* shared_resources;
+  /* Optional, number of submitted frames that can wait for the render thread.
+     1 gives double buffering, 2 triple buffering */
+  int32_t pipeline_depth;
 } dd_ctx_desc_t;
 
 typedef struct dd_new_frame_info
@@ -671,12 +1040,97 @@ typedef struct dd_new_frame_info
   uint8_t projection_type;
 } dd_new_frame_info_t;
 
+// All times are in milliseconds. CPU times cover recording (dd_begin_cmd to
+// dd_end_cmd spans), dd_sort_commands and dd_render, of which 'upload_ms' was
+// spent uploading buffers in the backend. GPU times are measured per (mode,
+// shading) pair and only become available a few frames later - 'gpu_latency'
+// says how many. They stay negative until the first results arrive, or if the
+// backend does not support timer queries.
+typedef struct dd_frame_timings
+{
+  float record_ms;
+  float sort_ms;
+  float upload_ms;
+  float render_ms;
+  float gpu_ms;
+  float gpu_bucket_ms[DBGDRAW_MODE_COUNT][DBGDRAW_SHADING_COUNT];
+  int32_t gpu_latency;
+} dd_frame_timings_t;
+
+// Per-frame counters, reset in dd_new_frame. 'grow_count' counts buffer
+// reallocations (both on the cpu and in the backend) since dd_init, and
+// capacities are the current sizes of the buffers, which never shrink, so they
+// are also the peak sizes. All counters stay zero with DBGDRAW_NO_STATS.
+typedef struct dd_frame_stats
+{
+  int32_t vertex_count[DBGDRAW_MODE_COUNT];
+  int32_t command_count[DBGDRAW_MODE_COUNT];
+  int32_t instance_count;
+  int32_t procedural_count;
+  int32_t glyph_count;
+  int32_t text_cache_hit_count;
+  int32_t text_cache_miss_count;
+  int32_t decluttered_label_count;
+  int32_t culled_sphere_count;
+  int32_t culled_aabb_count;
+  int32_t culled_obb_count;
+  int32_t culled_clip_count;
+  int32_t drawcall_count;
+  int32_t grow_count;
+  size_t bytes_uploaded;
+  int32_t vertex_capacity;
+  int32_t command_capacity;
+  int32_t procedural_capacity;
+  int32_t instance_capacity;
+} dd_frame_stats_t;
+
+// Names passed to the hooks are string literals, so hooks are free to keep the
+// pointers. Spans nest, and every 'begin' is followed by an 'end' with the same
+// name on the same thread. With 'pipeline_depth' > 0 the recording and the
+// render thread call the hooks at the same time.
+typedef struct dd_trace_hooks
+{
+  dd_trace_fn begin;
+  dd_trace_fn end;
+  void* user_data;
+} dd_trace_hooks_t;
+
+#ifndef DBGDRAW_NO_STDIO
+typedef struct dd_trace_file
+{
+  FILE* fp;
+  char* buffer;
+  size_t buffer_len;
+  size_t buffer_cap;
+  int32_t event_count;
+  int32_t lock;
+} dd_trace_file_t;
+#endif
+
 typedef struct dd_instance_data
 {
   dd_vec3_t position;
   dd_color_t color;
 } dd_instance_data_t;
 
+// Parameter record for shapes that the backend generates on the GPU. All shapes
+// are surfaces of revolution around 'axis'. For the conical frustum 'axis'
+// spans from the bottom to the top cap, for the remaining shapes it is just a
+// direction. Impostor types are ray-cast by the backend instead; capsules and
+// cylinders span from 'center' to 'center + axis'. Layout matches std430, so it
+// can be uploaded as is.
+typedef struct dd_procedural_prim
+{
+  dd_vec3_t center;
+  float radius_a;
+  dd_vec3_t axis;
+  float radius_b;
+  dd_color_t color;
+  uint32_t type;
+  uint32_t detail_level;
+  uint32_t padding;
+} dd_procedural_prim_t;
+
 typedef struct dd_vertex
 {
   union
@@ -693,13 +1147,35 @@ typedef struct dd_vertex
     struct
     {
       dd_vec2_t uv;
-      float dummy;
+      float font; // Index of the font of text vertices
     };
     dd_vec3_t normal;
   };
   dd_color_t col;
 } dd_vertex_t;
 
+#if DBGDRAW_HAS_TEXT_SUPPORT
+// Backends with DBGDRAW_BACKEND_CAPS_GLYPH_INSTANCES get one record per glyph
+// instead of six vertices, and expand it into a quad. Corners of the quad are
+// 'origin + axis_x * x + axis_y * y' of its line's anchor, with (x, y) in font
+// pixels. Layouts match std430, so both can be uploaded as is.
+typedef struct dd_glyph_instance
+{
+  float x, y;              // Top left corner of the quad
+  uint16_t s0, t0, s1, t1; // Rect in the font atlas, in texels
+  uint32_t anchor;
+  dd_color_t col;
+} dd_glyph_instance_t;
+
+typedef struct dd_text_anchor
+{
+  dd_vec4_t origin; // xyz: start of the line, on the baseline
+  dd_vec4_t axis_x; // xyz: one font pixel along the line
+  dd_vec4_t axis_y; // xyz: one font pixel down
+  dd_vec4_t atlas;  // xy: texel size in uv, z: font pixels per texel, w: font
+} dd_text_anchor_t;
+#endif
+
 typedef struct dd_cmd_t
 {
   int32_t base_index;
@@ -708,17 +1184,155 @@ typedef struct dd_cmd_t
 
   dd_instance_data_t* instance_data;
 
+  int32_t procedural_base_index;
+  int32_t procedural_count;
+  int32_t procedural_vertex_count;
+  uint32_t procedural_types;
+
   dd_mat4_t xform;
   float min_depth;
 
   dd_mode_t draw_mode;
   dd_shading_t shading_type;
   dd_vec2_t aa_radius;
+  dd_vec4_t clip_rect;
 #if DBGDRAW_HAS_TEXT_SUPPORT
   int32_t font_idx;
+  int32_t glyph_base_index;
+  int32_t glyph_count;
 #endif
 } dd_cmd_t;
 
+#ifndef DBGDRAW_NO_STDIO
+// Capture files are laid out so that they can be mapped and read in place -
+// every chunk starts at an 8 byte boundary, all arrays are 4 byte aligned, and
+// data is stored in little-endian order:
+//   dd_capture_header_t
+//   'FRAM' chunk per frame: dd_capture_frame_t followed by command records,
+//                           vertices, procedural primitives and instances
+//   'INDX' chunk: uint64_t file offset of each 'FRAM' chunk
+//   dd_capture_footer_t
+// Keyframes (DBGDRAW_CAPTURE_CHUNK_KEYFRAME flag) store the arrays as they
+// are. Other frames store them as runs against the previous frame: a pair of
+// uint32_t - number of elements that did not change, and number of elements
+// that follow inline.
+#define DBGDRAW_CAPTURE_MAGIC          0x50434444 /* "DDCP" */
+#define DBGDRAW_CAPTURE_VERSION        2
+#define DBGDRAW_CAPTURE_TAG_FRAME      0x4d415246 /* "FRAM" */
+#define DBGDRAW_CAPTURE_TAG_INDEX      0x58444e49 /* "INDX" */
+#define DBGDRAW_CAPTURE_CHUNK_KEYFRAME (1 << 0)
+
+enum
+{
+  DBGDRAW_CAPTURE_COMMANDS,
+  DBGDRAW_CAPTURE_VERTICES,
+  DBGDRAW_CAPTURE_PROCEDURALS,
+  DBGDRAW_CAPTURE_INSTANCES,
+
+  DBGDRAW_CAPTURE_STREAM_COUNT
+};
+
+typedef struct dd_capture_header
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t keyframe_interval;
+  uint32_t reserved;
+  uint32_t elem_size[DBGDRAW_CAPTURE_STREAM_COUNT];
+} dd_capture_header_t;
+
+typedef struct dd_capture_chunk
+{
+  uint32_t tag;
+  uint32_t flags;
+  uint64_t size;
+} dd_capture_chunk_t;
+
+typedef struct dd_capture_footer
+{
+  uint64_t index_offset;
+  uint32_t frame_count;
+  uint32_t magic;
+} dd_capture_footer_t;
+
+typedef struct dd_capture_frame
+{
+  dd_mat4_t view;
+  dd_mat4_t proj;
+  dd_vec4_t viewport;
+  float vertical_fov;
+  uint32_t projection_type;
+  int32_t len[DBGDRAW_CAPTURE_STREAM_COUNT];
+} dd_capture_frame_t;
+
+// Command with instance data pointer swapped for an offset into the frame's
+// instance array
+typedef struct dd_capture_cmd
+{
+  dd_mat4_t xform;
+  dd_vec4_t clip_rect;
+  dd_vec2_t aa_radius;
+  float min_depth;
+  int32_t base_index;
+  int32_t vertex_count;
+  int32_t instance_count;
+  int32_t instance_offset;
+  int32_t procedural_base_index;
+  int32_t procedural_count;
+  int32_t procedural_vertex_count;
+  uint32_t procedural_types;
+  int32_t draw_mode;
+  int32_t shading_type;
+  int32_t font_idx;
+  int32_t padding;
+} dd_capture_cmd_t;
+
+typedef struct dd_capture
+{
+  FILE* fp;
+  uint64_t offset;
+  uint64_t* frame_offsets;
+  size_t frame_offsets_cap;
+  int32_t frame_count;
+  dd_capture_frame_t frame;
+  void* prev[DBGDRAW_CAPTURE_STREAM_COUNT];
+  size_t prev_cap[DBGDRAW_CAPTURE_STREAM_COUNT];
+  dd_capture_cmd_t* cmds;
+  dd_instance_data_t* instances;
+  size_t cmds_cap;
+  size_t instances_cap;
+  uint8_t* buffer;
+  size_t buffer_len;
+  size_t buffer_cap;
+} dd_capture_t;
+
+typedef struct dd_replay
+{
+  uint8_t* data;
+  size_t size;
+  const uint64_t* frame_offsets;
+  int32_t frame_count;
+  int32_t frame_idx;
+  dd_capture_frame_t frame;
+  void* streams[DBGDRAW_CAPTURE_STREAM_COUNT];
+  size_t streams_cap[DBGDRAW_CAPTURE_STREAM_COUNT];
+} dd_replay_t;
+#endif
+
+// Single producer, single consumer ring of submitted frames. Each slot is a
+// copy of the context taken by dd_submit_frame, which owns a set of vertex,
+// procedural and command buffers. Submitting swaps the recorded buffers with
+// the ones of a slot that was already rendered, so nothing is copied. Only the
+// recording thread writes 'submit_count' and only the render thread writes
+// 'render_count'.
+typedef struct dd_frame_ring
+{
+  struct dd_ctx_t* frames;
+  int32_t depth;
+  volatile uint32_t submit_count;
+  volatile uint32_t render_count;
+} dd_frame_ring_t;
+
 typedef struct dd_ctx_t
 {
   /* User accessible state */
@@ -733,6 +1347,9 @@ typedef struct dd_ctx_t
   dd_shading_t shading_type;
   dd_fill_t fill_type;
   float primitive_size;
+  uint8_t procedural;
+  uint8_t impostors;
+  dd_vec4_t clip_rect;
 
   /* Command storage */
   dd_cmd_t* cur_cmd;
@@ -745,6 +1362,14 @@ typedef struct dd_ctx_t
   int32_t verts_len;
   int32_t verts_cap;
 
+  /* Procedural primitive buffer */
+  dd_procedural_prim_t* procedural_data;
+  int32_t procedural_len;
+  int32_t procedural_cap;
+
+  /* Advanced by dd_new_frame */
+  uint32_t frame_idx;
+
   /* Camera info */
   dd_mat4_t view;
   dd_mat4_t proj;
@@ -754,6 +1379,7 @@ typedef struct dd_ctx_t
   float proj_scale_y;
 
   dd_vec4_t frustum_planes[6];
+  dd_vec4_t clip_planes[4];
 
 #if DBGDRAW_HAS_TEXT_SUPPORT
   /* Text info */
@@ -761,17 +1387,56 @@ typedef struct dd_ctx_t
   int32_t fonts_len;
   int32_t fonts_cap;
   int32_t active_font_idx;
+  float text_size;
+  uint8_t text_declutter;
+  float text_priority;
 #ifdef DBGDRAW_USE_DEFAULT_FONT
   int32_t default_font_idx;
 #endif
+#ifdef DBGDRAW_ASYNC_FONTS
+  struct dd_font_job** font_jobs;
+  int32_t font_jobs_len;
+  int32_t font_jobs_cap;
+  int32_t pending_font_idx;
+#endif
+  dd_glyph_upload_t* glyph_uploads;
+  int32_t glyph_uploads_len;
+  int32_t glyph_uploads_cap;
+  dd_glyph_instance_t* glyph_instances;
+  int32_t glyph_instances_len;
+  int32_t glyph_instances_cap;
+  dd_text_anchor_t* text_anchors;
+  int32_t text_anchors_len;
+  int32_t text_anchors_cap;
+  dd_text_cache_t text_cache;
+  dd_declutter_t declutter;
 #endif
 
   /* Render backend */
   void* render_backend;
+  dd_shared_resources_t* shared_resources;
+  uint32_t backend_caps;
   int32_t drawcall_count;
   dd_vec2_t aa_radius;
   uint8_t enable_depth_test;
 
+  /* Timings */
+  uint8_t enable_timings;
+  dd_frame_timings_t timings;
+  double cmd_start_ms;
+
+  /* Statistics */
+  dd_frame_stats_t stats;
+
+  /* Tracing */
+  dd_trace_hooks_t trace_hooks;
+
+  /* Capture */
+  struct dd_capture* capture;
+
+  /* Pipelined rendering */
+  dd_frame_ring_t* frame_ring;
+
   /* Extras */
   int32_t instance_cap;
   float* sinf_lut;
@@ -820,6 +1485,88 @@ typedef struct dd_ctx_t
 
 #ifdef DBGDRAW_IMPLEMENTATION
 
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include <stdarg.h>
+#include <stddef.h>
+
+// Used by the frame ring and the trace file writer - loads and exchanges
+// acquire, stores release
+#if defined(_WIN32)
+#define DD_ATOMIC_LOAD(ptr) InterlockedCompareExchange((volatile LONG*)(ptr), 0, 0)
+#define DD_ATOMIC_STORE(ptr, val)                                              \
+  InterlockedExchange((volatile LONG*)(ptr), (LONG)(val))
+#define DD_ATOMIC_EXCHANGE(ptr, val)                                           \
+  InterlockedExchange((volatile LONG*)(ptr), (LONG)(val))
+#define DD_ATOMIC_INCREMENT(ptr) InterlockedIncrement((volatile LONG*)(ptr))
+#else
+#define DD_ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define DD_ATOMIC_STORE(ptr, val)                                              \
+  __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#define DD_ATOMIC_EXCHANGE(ptr, val)                                           \
+  __atomic_exchange_n((ptr), (val), __ATOMIC_ACQUIRE)
+#define DD_ATOMIC_INCREMENT(ptr) __atomic_add_fetch((ptr), 1, __ATOMIC_RELAXED)
+#endif
+
+#if defined(_MSC_VER)
+#define DD_THREAD_LOCAL __declspec(thread)
+#else
+#define DD_THREAD_LOCAL __thread
+#endif
+
+// Grows a buffer through DBGDRAW_HANDLE_OUT_OF_MEMORY, counting reallocations
+#define DD_GROW(ctx, ptr, len, cap, elemsize)                                  \
+  do {                                                                         \
+    int32_t dd__prev_cap = (cap);                                              \
+    DBGDRAW_HANDLE_OUT_OF_MEMORY(ptr, len, cap, elemsize);                     \
+    if ((cap) != dd__prev_cap) { DBGDRAW_STATS((ctx)->stats.grow_count++); }   \
+  } while (0)
+
+#ifdef DBGDRAW_ASYNC_FONTS
+#if defined(_WIN32)
+typedef HANDLE dd__thread_t;
+#else
+#include <pthread.h>
+typedef pthread_t dd__thread_t;
+#endif
+#endif
+
+#ifndef DBGDRAW_NO_STDIO
+int32_t dd__capture_frame(dd_ctx_t* ctx);
+void dd__capture_next_frame(dd_ctx_t* ctx);
+#endif
+int32_t dd__split_cmd(dd_ctx_t* ctx);
+void dd__update_clip_planes(dd_ctx_t* ctx);
+int32_t dd__frame_ring_init(dd_ctx_t* ctx, int32_t depth);
+void dd__frame_ring_term(dd_frame_ring_t* ring);
+#if DBGDRAW_HAS_TEXT_SUPPORT
+int32_t dd__flush_glyph_uploads(dd_ctx_t* ctx);
+void dd__free_font(dd_font_data_t* font);
+#ifdef DBGDRAW_ASYNC_FONTS
+int32_t dd__finish_font_jobs(dd_ctx_t* ctx);
+void dd__term_font_jobs(dd_ctx_t* ctx);
+#endif
+int32_t dd__init_font_from_memory(dd_ctx_t* ctx,
+                                  const void* ttf_buf,
+                                  int32_t ttf_size,
+                                  int32_t deflated_size,
+                                  const char* name,
+                                  int32_t font_size,
+                                  int32_t width,
+                                  int32_t height,
+                                  bool is_sdf,
+                                  int32_t* font_idx);
+void dd__text_cache_evict(dd_ctx_t* ctx);
+int32_t dd__draw_text_labels(dd_ctx_t* ctx);
+void dd__text_cache_term(dd_text_cache_t* cache);
+#endif
+
 #if DBGDRAW_HAS_TEXT_SUPPORT && defined(DBGDRAW_USE_DEFAULT_FONT)
 int32_t dbgdraw__inflate(unsigned char* out, const unsigned char* in, int size);
 static unsigned char dd_proggy_square[7976];
@@ -865,20 +1612,54 @@ dd_init(dd_ctx_t* ctx, dd_ctx_desc_t* desc)
   if (!ctx->commands) { return DBGDRAW_ERR_FAILED_ALLOC; }
   DBGDRAW_MEMSET(ctx->commands, 0, ctx->commands_cap * sizeof(dd_cmd_t));
 
+  ctx->procedural_len  = 0;
+  ctx->procedural_cap  = DD_MAX(16, desc->max_procedural_prims);
+  ctx->procedural_data =
+    DBGDRAW_MALLOC(ctx->procedural_cap * sizeof(dd_procedural_prim_t));
+  if (!ctx->procedural_data) { return DBGDRAW_ERR_FAILED_ALLOC; }
+
   ctx->instance_cap = DD_MAX(512, desc->max_instances);
 
+  ctx->frame_ring = NULL;
+  if (desc->pipeline_depth > 0 &&
+      dd__frame_ring_init(ctx, desc->pipeline_depth))
+  {
+    return DBGDRAW_ERR_FAILED_ALLOC;
+  }
+
   ctx->cur_cmd           = NULL;
+  ctx->frame_idx         = 0;
   ctx->color             = (dd_color_t) {0, 0, 0, 255};
   ctx->detail_level      = DD_MAX(desc->detail_level, 0);
   ctx->xform             = dd_mat4_identity();
   ctx->frustum_cull      = desc->enable_frustum_cull;
   ctx->primitive_size    = 2.0f;
+  ctx->clip_rect         = dd_vec4(0.0f, 0.0f, 0.0f, 0.0f);
   ctx->view              = dd_mat4_identity();
   ctx->proj              = dd_mat4_identity();
   ctx->aa_radius         = dd_vec2(desc->antialias_radius, 0.0f);
   ctx->enable_depth_test = desc->enable_depth_test;
+  ctx->procedural        = desc->enable_procedural_prims;
+  ctx->impostors         = desc->enable_impostors;
+  ctx->backend_caps      = DBGDRAW_BACKEND_CAPS_NONE;
+  ctx->enable_timings    = desc->enable_timings;
+
+  memset(&ctx->timings, 0, sizeof(ctx->timings));
+  ctx->timings.gpu_ms = -1.0f;
+  for (int32_t i = 0; i < DBGDRAW_MODE_COUNT; ++i)
+  {
+    for (int32_t j = 0; j < DBGDRAW_SHADING_COUNT; ++j)
+    {
+      ctx->timings.gpu_bucket_ms[i][j] = -1.0f;
+    }
+  }
+  memset(&ctx->stats, 0, sizeof(ctx->stats));
+  memset(&ctx->trace_hooks, 0, sizeof(ctx->trace_hooks));
+  ctx->capture = NULL;
 
-  dd_backend_init(ctx);
+  ctx->shared_resources = desc->shared_resources;
+  int32_t error         = dd_backend_init(ctx);
+  if (error) { return error; }
 
 #if DBGDRAW_HAS_TEXT_SUPPORT
   ctx->fonts_len = 0;
@@ -886,27 +1667,54 @@ dd_init(dd_ctx_t* ctx, dd_ctx_desc_t* desc)
   ctx->fonts     = DBGDRAW_MALLOC(ctx->fonts_cap * sizeof(dd_font_data_t));
   if (!ctx->fonts) { return DBGDRAW_ERR_FAILED_ALLOC; }
   DBGDRAW_MEMSET(ctx->fonts, 0, ctx->fonts_cap * sizeof(dd_font_data_t));
+
+  ctx->glyph_uploads_len = 0;
+  ctx->glyph_uploads_cap = 16;
+  ctx->glyph_uploads =
+    DBGDRAW_MALLOC(ctx->glyph_uploads_cap * sizeof(dd_glyph_upload_t));
+  if (!ctx->glyph_uploads) { return DBGDRAW_ERR_FAILED_ALLOC; }
+
+  ctx->glyph_instances_len = 0;
+  ctx->glyph_instances_cap = 256;
+  ctx->glyph_instances =
+    DBGDRAW_MALLOC(ctx->glyph_instances_cap * sizeof(dd_glyph_instance_t));
+  if (!ctx->glyph_instances) { return DBGDRAW_ERR_FAILED_ALLOC; }
+
+  ctx->text_anchors_len = 0;
+  ctx->text_anchors_cap = 16;
+  ctx->text_anchors =
+    DBGDRAW_MALLOC(ctx->text_anchors_cap * sizeof(dd_text_anchor_t));
+  if (!ctx->text_anchors) { return DBGDRAW_ERR_FAILED_ALLOC; }
+
+  memset(&ctx->text_cache, 0, sizeof(dd_text_cache_t));
+  memset(&ctx->declutter, 0, sizeof(dd_declutter_t));
+  ctx->text_size      = 0.0f;
+  ctx->text_declutter = 0;
+  ctx->text_priority  = 0.0f;
+#ifdef DBGDRAW_ASYNC_FONTS
+  ctx->font_jobs        = NULL;
+  ctx->font_jobs_len    = 0;
+  ctx->font_jobs_cap    = 0;
+  ctx->pending_font_idx = -1;
+#endif
 #endif /* DBGDRAW_HAS_TEXT_SUPPORT */
 
 #ifdef DBGDRAW_USE_DEFAULT_FONT
   if (desc->enable_default_font)
   {
-    unsigned char* uncompressed_font_data =
-      DBGDRAW_MALLOC(dd_default_font_info.size);
-    int uncompressed_size =
-      dbgdraw__inflate(uncompressed_font_data,
-                       dd_default_font_info.data,
-                       dd_default_font_info.compressed_size);
-    DBGDRAW_ASSERT(uncompressed_size == dd_default_font_info.size);
-    (void)uncompressed_size; /* Silence warning in release */
-    dd_init_font_from_memory(ctx,
-                             uncompressed_font_data,
-                             "ProggySquare",
-                             11,
-                             256,
-                             256,
-                             &ctx->default_font_idx);
-    DBGDRAW_FREE(uncompressed_font_data);
+    // Inflated only once a glyph has to be rasterized, which with
+    // DBGDRAW_FONT_CACHE_DIR is not needed for printable ASCII
+    error = dd__init_font_from_memory(ctx,
+                                      dd_default_font_info.data,
+                                      dd_default_font_info.size,
+                                      dd_default_font_info.compressed_size,
+                                      "ProggySquare",
+                                      11,
+                                      256,
+                                      256,
+                                      false,
+                                      &ctx->default_font_idx);
+    if (error) { return error; }
   }
   else
   {
@@ -922,6 +1730,7 @@ dd_term(dd_ctx_t* ctx)
 {
   DBGDRAW_ASSERT(ctx);
   DBGDRAW_FREE(ctx->verts_data);
+  DBGDRAW_FREE(ctx->procedural_data);
   DBGDRAW_FREE(ctx->commands);
 
 #if DBGDRAW_USE_TRANSCENDENTAL_LUT
@@ -929,14 +1738,27 @@ dd_term(dd_ctx_t* ctx)
 #endif
 
 #if DBGDRAW_HAS_TEXT_SUPPORT
-  for (int32_t i = 0; i < ctx->fonts_len; ++i)
-  {
-    dd_font_data_t* font = ctx->fonts + i;
-    DBGDRAW_FREE(font->name);
-  }
+#ifdef DBGDRAW_ASYNC_FONTS
+  dd__term_font_jobs(ctx);
+#endif
+  for (int32_t i = 0; i < ctx->fonts_len; ++i) { dd__free_font(ctx->fonts + i); }
   DBGDRAW_FREE(ctx->fonts);
+  DBGDRAW_FREE(ctx->glyph_uploads);
+  DBGDRAW_FREE(ctx->glyph_instances);
+  DBGDRAW_FREE(ctx->text_anchors);
+  dd__text_cache_term(&ctx->text_cache);
+  DBGDRAW_FREE(ctx->declutter.labels);
+  DBGDRAW_FREE(ctx->declutter.keys);
+  DBGDRAW_FREE(ctx->declutter.cells);
+  DBGDRAW_FREE(ctx->declutter.nodes);
+#endif
+
+#ifndef DBGDRAW_NO_STDIO
+  dd_capture_end(ctx);
 #endif
 
+  if (ctx->frame_ring) { dd__frame_ring_term(ctx->frame_ring); }
+
   dd_backend_term(ctx);
   memset(ctx, 0, sizeof(dd_ctx_t));
 
@@ -1100,6 +1922,10 @@ dd_set_primitive_size(dd_ctx_t* ctx, float primitive_size)
 {
   DBGDRAW_ASSERT(ctx);
   ctx->primitive_size = primitive_size;
+  if (ctx->cur_cmd && ctx->cur_cmd->clip_rect.z > 0.0f)
+  {
+    dd__update_clip_planes(ctx);
+  }
   return DBGDRAW_ERR_OK;
 }
 
@@ -1121,6 +1947,52 @@ dd_set_line_antialias_radius(dd_ctx_t* ctx, float amount_x, float amount_y)
   return DBGDRAW_ERR_OK;
 }
 
+int32_t
+dd_set_procedural(dd_ctx_t* ctx, uint8_t enable)
+{
+  DBGDRAW_ASSERT(ctx);
+  ctx->procedural = enable;
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_set_impostors(dd_ctx_t* ctx, uint8_t enable)
+{
+  DBGDRAW_ASSERT(ctx);
+  ctx->impostors = enable;
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_set_clip_rect(dd_ctx_t* ctx, float* rect)
+{
+  DBGDRAW_ASSERT(ctx);
+  dd_vec4_t clip_rect = dd_vec4(0.0f, 0.0f, 0.0f, 0.0f);
+  if (rect && rect[2] > 0.0f && rect[3] > 0.0f)
+  {
+    clip_rect = dd_vec4(rect[0], rect[1], rect[2], rect[3]);
+  }
+  ctx->clip_rect = clip_rect;
+
+  dd_cmd_t* cmd = ctx->cur_cmd;
+  if (!cmd || memcmp(&cmd->clip_rect, &clip_rect, sizeof(dd_vec4_t)) == 0)
+  {
+    return DBGDRAW_ERR_OK;
+  }
+  bool is_empty = cmd->vertex_count == 0 && cmd->procedural_count == 0;
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  is_empty = is_empty && cmd->glyph_count == 0;
+#endif
+  if (!is_empty)
+  {
+    int32_t error = dd__split_cmd(ctx);
+    if (error) { return error; }
+  }
+  ctx->cur_cmd->clip_rect = clip_rect;
+  if (clip_rect.z > 0.0f) { dd__update_clip_planes(ctx); }
+  return DBGDRAW_ERR_OK;
+}
+
 int32_t
 dd_begin_cmd(dd_ctx_t* ctx, dd_mode_t draw_mode)
 {
@@ -1129,23 +2001,31 @@ dd_begin_cmd(dd_ctx_t* ctx, dd_mode_t draw_mode)
                  (int32_t)draw_mode < (int32_t)DBGDRAW_MODE_COUNT);
 
   DBGDRAW_VALIDATE(ctx->cur_cmd == NULL, DBGDRAW_ERR_PREV_CMD_NOT_ENDED);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->commands,
-                               ctx->commands_len + 1,
-                               ctx->commands_cap,
-                               sizeof(dd_cmd_t));
+  DD_GROW(ctx,
+          ctx->commands,
+          ctx->commands_len + 1,
+          ctx->commands_cap,
+          sizeof(dd_cmd_t));
 
   ctx->cur_cmd = &ctx->commands[ctx->commands_len];
   memset(ctx->cur_cmd, 0, sizeof(dd_cmd_t));
-  ctx->cur_cmd->xform        = ctx->xform;
-  ctx->cur_cmd->base_index   = ctx->verts_len;
-  ctx->cur_cmd->draw_mode    = draw_mode;
-  ctx->cur_cmd->shading_type = ctx->shading_type;
-  ctx->cur_cmd->aa_radius    = ctx->aa_radius;
+  ctx->cur_cmd->xform                 = ctx->xform;
+  ctx->cur_cmd->base_index            = ctx->verts_len;
+  ctx->cur_cmd->procedural_base_index = ctx->procedural_len;
+  ctx->cur_cmd->draw_mode             = draw_mode;
+  ctx->cur_cmd->shading_type          = ctx->shading_type;
+  ctx->cur_cmd->aa_radius             = ctx->aa_radius;
+  ctx->cur_cmd->clip_rect             = ctx->clip_rect;
+  if (ctx->clip_rect.z > 0.0f) { dd__update_clip_planes(ctx); }
 
 #if DBGDRAW_HAS_TEXT_SUPPORT
-  ctx->cur_cmd->font_idx = -1;
+  ctx->cur_cmd->font_idx         = -1;
+  ctx->cur_cmd->glyph_base_index = ctx->glyph_instances_len;
 #endif
 
+  if (ctx->enable_timings) { ctx->cmd_start_ms = dd_time_ms(); }
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_cmd");
+
   return DBGDRAW_ERR_OK;
 }
 
@@ -1166,9 +2046,45 @@ dd_end_cmd(dd_ctx_t* ctx)
 {
   DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
 
+  int32_t error = DBGDRAW_ERR_OK;
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  if (ctx->declutter.labels_len) { error = dd__draw_text_labels(ctx); }
+#endif
+
   ctx->commands_len++;
   ctx->cur_cmd = 0;
 
+  if (ctx->enable_timings)
+  {
+    ctx->timings.record_ms += (float)(dd_time_ms() - ctx->cmd_start_ms);
+  }
+  DBGDRAW_TRACE_END(ctx, "dd_cmd");
+
+  return error;
+}
+
+// Ends the current command and starts another one with the same state
+int32_t
+dd__split_cmd(dd_ctx_t* ctx)
+{
+  DD_GROW(ctx,
+          ctx->commands,
+          ctx->commands_len + 2,
+          ctx->commands_cap,
+          sizeof(dd_cmd_t));
+  dd_cmd_t* prev = ctx->commands + ctx->commands_len++;
+  ctx->cur_cmd   = ctx->commands + ctx->commands_len;
+  *ctx->cur_cmd  = *prev;
+  ctx->cur_cmd->base_index              = ctx->verts_len;
+  ctx->cur_cmd->vertex_count            = 0;
+  ctx->cur_cmd->procedural_base_index   = ctx->procedural_len;
+  ctx->cur_cmd->procedural_count        = 0;
+  ctx->cur_cmd->procedural_vertex_count = 0;
+  ctx->cur_cmd->procedural_types        = 0;
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  ctx->cur_cmd->glyph_base_index = ctx->glyph_instances_len;
+  ctx->cur_cmd->glyph_count      = 0;
+#endif
   return DBGDRAW_ERR_OK;
 }
 
@@ -1188,6 +2104,8 @@ void
 dd_sort_commands(dd_ctx_t* ctx)
 {
   DBGDRAW_ASSERT(ctx);
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_sort_commands");
+  double start_ms = ctx->enable_timings ? dd_time_ms() : 0.0;
   if (ctx->commands_len)
   {
     qsort(ctx->commands,
@@ -1195,2235 +2113,5299 @@ dd_sort_commands(dd_ctx_t* ctx)
           sizeof(ctx->commands[0]),
           dd__cmd_cmp);
   }
+  if (ctx->enable_timings)
+  {
+    ctx->timings.sort_ms += (float)(dd_time_ms() - start_ms);
+  }
+  DBGDRAW_TRACE_END(ctx, "dd_sort_commands");
 }
 
 int32_t
 dd_render(dd_ctx_t* ctx)
 {
   DBGDRAW_ASSERT(ctx);
-  return dd_backend_render(ctx);
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_render");
+#ifndef DBGDRAW_NO_STDIO
+  if (ctx->capture) { dd__capture_next_frame(ctx); }
+#endif
+  double start_ms = ctx->enable_timings ? dd_time_ms() : 0.0;
+  int32_t error   = DBGDRAW_ERR_OK;
+#if DBGDRAW_HAS_TEXT_SUPPORT
+#ifdef DBGDRAW_ASYNC_FONTS
+  error = dd__finish_font_jobs(ctx);
+#endif
+  if (!error) { error = dd__flush_glyph_uploads(ctx); }
+#endif
+  if (!error) { error = dd_backend_render(ctx); }
+  if (ctx->enable_timings)
+  {
+    ctx->timings.render_ms += (float)(dd_time_ms() - start_ms);
+  }
+  DBGDRAW_TRACE_END(ctx, "dd_render");
+  return error;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pipelined rendering
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 int32_t
-dd_new_frame(dd_ctx_t* ctx, dd_new_frame_info_t* info)
+dd__frame_ring_init(dd_ctx_t* ctx, int32_t depth)
 {
-  DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(info);
-  DBGDRAW_ASSERT(info->view_matrix);
-  DBGDRAW_ASSERT(info->projection_matrix);
-  DBGDRAW_ASSERT(info->viewport_size);
-
-  ctx->xform          = dd_mat4_identity();
-  ctx->verts_len      = 0;
-  ctx->commands_len   = 0;
-  ctx->drawcall_count = 0;
-  ctx->is_ortho       = (info->projection_type == DBGDRAW_ORTHOGRAPHIC);
-
-  memcpy(ctx->view.data, info->view_matrix, sizeof(ctx->view));
-  memcpy(ctx->proj.data, info->projection_matrix, sizeof(ctx->proj));
-  memcpy(ctx->viewport.data, info->viewport_size, sizeof(dd_vec4_t));
+  dd_frame_ring_t* ring = DBGDRAW_MALLOC(sizeof(dd_frame_ring_t));
+  if (!ring) { return DBGDRAW_ERR_FAILED_ALLOC; }
+  memset(ring, 0, sizeof(dd_frame_ring_t));
+  ctx->frame_ring = ring;
 
-  dd_mat4_t inv_view_matrix = dd_mat4_se3_inverse(ctx->view);
-  memcpy(ctx->view_origin.data, inv_view_matrix.col[3].data, sizeof(dd_vec3_t));
+  ring->frames = DBGDRAW_MALLOC(depth * sizeof(dd_ctx_t));
+  if (!ring->frames) { return DBGDRAW_ERR_FAILED_ALLOC; }
+  memset(ring->frames, 0, depth * sizeof(dd_ctx_t));
+  ring->depth = depth;
 
-  if (ctx->is_ortho) { ctx->proj_scale_y = 2.0f / ctx->proj.data[5]; }
-  else
+  for (int32_t i = 0; i < depth; ++i)
   {
-    ctx->proj_scale_y = 2.0f * tanf(info->vertical_fov * 0.5f);
+    dd_ctx_t* frame       = ring->frames + i;
+    frame->verts_cap      = ctx->verts_cap;
+    frame->commands_cap   = ctx->commands_cap;
+    frame->procedural_cap = ctx->procedural_cap;
+    frame->verts_data = DBGDRAW_MALLOC(frame->verts_cap * sizeof(dd_vertex_t));
+    frame->commands   = DBGDRAW_MALLOC(frame->commands_cap * sizeof(dd_cmd_t));
+    frame->procedural_data =
+      DBGDRAW_MALLOC(frame->procedural_cap * sizeof(dd_procedural_prim_t));
+    if (!frame->verts_data || !frame->commands || !frame->procedural_data)
+    {
+      return DBGDRAW_ERR_FAILED_ALLOC;
+    }
+#if DBGDRAW_HAS_TEXT_SUPPORT
+    frame->glyph_uploads_cap = 16;
+    frame->glyph_uploads =
+      DBGDRAW_MALLOC(frame->glyph_uploads_cap * sizeof(dd_glyph_upload_t));
+    frame->glyph_instances_cap = ctx->glyph_instances_cap;
+    frame->glyph_instances     = DBGDRAW_MALLOC(frame->glyph_instances_cap *
+                                            sizeof(dd_glyph_instance_t));
+    frame->text_anchors_cap = ctx->text_anchors_cap;
+    frame->text_anchors =
+      DBGDRAW_MALLOC(frame->text_anchors_cap * sizeof(dd_text_anchor_t));
+    if (!frame->glyph_uploads || !frame->glyph_instances ||
+        !frame->text_anchors)
+    {
+      return DBGDRAW_ERR_FAILED_ALLOC;
+    }
+#endif
   }
-
-  if (ctx->frustum_cull) { dd_extract_frustum_planes(ctx); }
-
   return DBGDRAW_ERR_OK;
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Frustum culling for higher order primitives
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-// After Fabian "rygorous" Giessen
 void
-dd__normalize_plane(dd_vec4_t* plane)
+dd__frame_ring_term(dd_frame_ring_t* ring)
 {
-  float mag =
-    sqrtf(plane->x * plane->x + plane->y * plane->y + plane->z * plane->z);
-  plane->x /= mag;
-  plane->y /= mag;
-  plane->z /= mag;
-  plane->w /= mag;
+  for (int32_t i = 0; ring->frames && i < ring->depth; ++i)
+  {
+    DBGDRAW_FREE(ring->frames[i].verts_data);
+    DBGDRAW_FREE(ring->frames[i].procedural_data);
+    DBGDRAW_FREE(ring->frames[i].commands);
+#if DBGDRAW_HAS_TEXT_SUPPORT
+    DBGDRAW_FREE(ring->frames[i].glyph_uploads);
+    DBGDRAW_FREE(ring->frames[i].glyph_instances);
+    DBGDRAW_FREE(ring->frames[i].text_anchors);
+#endif
+  }
+  DBGDRAW_FREE(ring->frames);
+  DBGDRAW_FREE(ring);
 }
 
-void
-dd_extract_frustum_planes(dd_ctx_t* ctx)
+int32_t
+dd_submit_frame(dd_ctx_t* ctx)
 {
   DBGDRAW_ASSERT(ctx);
-  dd_mat4_t pv = dd_mat4_transpose(dd_mat4_mul(ctx->proj, ctx->view));
+  DBGDRAW_ASSERT(ctx->frame_ring);
+  DBGDRAW_VALIDATE(ctx->cur_cmd == NULL, DBGDRAW_ERR_PREV_CMD_NOT_ENDED);
 
-  ctx->frustum_planes[0] = dd_vec4_add(pv.col[3], pv.col[2]);
-  ctx->frustum_planes[1] = dd_vec4_sub(pv.col[3], pv.col[2]);
-  ctx->frustum_planes[2] = dd_vec4_add(pv.col[3], pv.col[1]);
-  ctx->frustum_planes[3] = dd_vec4_sub(pv.col[3], pv.col[1]);
-  ctx->frustum_planes[4] = dd_vec4_add(pv.col[3], pv.col[0]);
-  ctx->frustum_planes[5] = dd_vec4_sub(pv.col[3], pv.col[0]);
+  dd_frame_ring_t* ring = ctx->frame_ring;
+  uint32_t submit_count = ring->submit_count;
+  if (submit_count - DD_ATOMIC_LOAD(&ring->render_count) >=
+      (uint32_t)ring->depth)
+  {
+    return DBGDRAW_ERR_NO_FREE_FRAME;
+  }
 
-  dd__normalize_plane(&ctx->frustum_planes[0]);
-  dd__normalize_plane(&ctx->frustum_planes[1]);
-  dd__normalize_plane(&ctx->frustum_planes[2]);
-  dd__normalize_plane(&ctx->frustum_planes[3]);
-  dd__normalize_plane(&ctx->frustum_planes[4]);
-  dd__normalize_plane(&ctx->frustum_planes[5]);
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_submit_frame");
+#ifndef DBGDRAW_NO_STDIO
+  if (ctx->capture) { dd__capture_next_frame(ctx); }
+#endif
+
+  // The slot was already rendered, so its buffers are recorded into next.
+  // Everything else the backend reads is copied with the context.
+  dd_ctx_t* frame = ring->frames + submit_count % ring->depth;
+
+  dd_vertex_t* verts_data               = frame->verts_data;
+  dd_cmd_t* commands                    = frame->commands;
+  dd_procedural_prim_t* procedural_data = frame->procedural_data;
+  int32_t verts_cap                     = frame->verts_cap;
+  int32_t commands_cap                  = frame->commands_cap;
+  int32_t procedural_cap                = frame->procedural_cap;
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  dd_glyph_upload_t* glyph_uploads     = frame->glyph_uploads;
+  dd_glyph_instance_t* glyph_instances = frame->glyph_instances;
+  dd_text_anchor_t* text_anchors       = frame->text_anchors;
+  int32_t glyph_uploads_cap            = frame->glyph_uploads_cap;
+  int32_t glyph_instances_cap          = frame->glyph_instances_cap;
+  int32_t text_anchors_cap             = frame->text_anchors_cap;
+#endif
+
+  *frame            = *ctx;
+  frame->capture    = NULL;
+  frame->frame_ring = NULL;
+
+  ctx->verts_data      = verts_data;
+  ctx->commands        = commands;
+  ctx->procedural_data = procedural_data;
+  ctx->verts_cap       = verts_cap;
+  ctx->commands_cap    = commands_cap;
+  ctx->procedural_cap  = procedural_cap;
+  ctx->verts_len       = 0;
+  ctx->commands_len    = 0;
+  ctx->procedural_len  = 0;
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  ctx->glyph_uploads     = glyph_uploads;
+  ctx->glyph_uploads_cap = glyph_uploads_cap;
+  ctx->glyph_uploads_len = 0;
+  ctx->glyph_instances     = glyph_instances;
+  ctx->glyph_instances_cap = glyph_instances_cap;
+  ctx->glyph_instances_len = 0;
+  ctx->text_anchors        = text_anchors;
+  ctx->text_anchors_cap    = text_anchors_cap;
+  ctx->text_anchors_len    = 0;
+#endif
+
+  DD_ATOMIC_STORE(&ring->submit_count, submit_count + 1);
+  DBGDRAW_TRACE_END(ctx, "dd_submit_frame");
+  return DBGDRAW_ERR_OK;
 }
 
 int32_t
-dd__frustum_sphere_test(dd_ctx_t* ctx, dd_vec3_t c, float radius)
+dd_render_submitted(dd_ctx_t* ctx)
 {
-  if (!ctx->frustum_cull) { return true; }
-  dd_vec4_t xc = dd_mat4_vec4_mul(ctx->xform, dd_vec4(c.x, c.y, c.z, 1.0));
-  for (int32_t i = 0; i < 6; ++i)
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(ctx->frame_ring);
+
+  dd_frame_ring_t* ring = ctx->frame_ring;
+  uint32_t render_count = ring->render_count;
+  if (render_count == DD_ATOMIC_LOAD(&ring->submit_count))
   {
-    float dot = dd_vec4_dot(xc, ctx->frustum_planes[i]);
-    if (dot <= -radius) { return false; }
+    return DBGDRAW_ERR_NO_SUBMITTED_FRAME;
   }
-  return true;
-}
 
-int32_t
-dd__frustum_aabb_test(dd_ctx_t* ctx, dd_vec3_t min, dd_vec3_t max)
-{
-  if (!ctx->frustum_cull) { return true; }
-  dd_vec4_t min_pt =
-    dd_mat4_vec4_mul(ctx->xform, dd_vec4(min.x, min.y, min.z, 1.0));
-  dd_vec4_t max_pt =
-    dd_mat4_vec4_mul(ctx->xform, dd_vec4(max.x, max.y, max.z, 1.0));
-  for (int32_t i = 0; i < 6; ++i)
+  // Only the copy is touched here, the recording thread keeps using the context
+  dd_ctx_t* frame = ring->frames + render_count % ring->depth;
+  DBGDRAW_TRACE_BEGIN(frame, "dd_render");
+  double start_ms = frame->enable_timings ? dd_time_ms() : 0.0;
+  int32_t error   = DBGDRAW_ERR_OK;
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  error = dd__flush_glyph_uploads(frame);
+#endif
+  if (!error) { error = dd_backend_render(frame); }
+  if (frame->enable_timings)
   {
-    const dd_vec4_t plane = ctx->frustum_planes[i];
-    float d               = DD_MAX(min_pt.x * plane.x, max_pt.x * plane.x) +
-              DD_MAX(min_pt.y * plane.y, max_pt.y * plane.y) +
-              DD_MAX(min_pt.z * plane.z, max_pt.z * plane.z) + plane.w;
-
-    if (d < 0.0f) { return false; }
+    frame->timings.render_ms += (float)(dd_time_ms() - start_ms);
   }
-  return true;
+  DBGDRAW_TRACE_END(frame, "dd_render");
+
+  DD_ATOMIC_STORE(&ring->render_count, render_count + 1);
+  return error;
 }
 
 int32_t
-dd__frustum_obb_test(dd_ctx_t* ctx, dd_vec3_t c, dd_mat3_t axes)
+dd_get_frame_timings(dd_ctx_t* ctx, dd_frame_timings_t* timings)
 {
-  if (!ctx->frustum_cull) { return true; }
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(timings);
+  *timings = ctx->timings;
+  return DBGDRAW_ERR_OK;
+}
 
-  dd_vec4_t xc = dd_mat4_vec4_mul(ctx->xform, dd_vec4(c.x, c.y, c.z, 1.0));
-  dd_vec4_t xu =
-    dd_mat4_vec4_mul(ctx->xform,
-                     dd_vec4(axes.col[0].x, axes.col[0].y, axes.col[0].z, 0.0));
-  dd_vec4_t xv =
-    dd_mat4_vec4_mul(ctx->xform,
-                     dd_vec4(axes.col[1].x, axes.col[1].y, axes.col[1].z, 0.0));
-  dd_vec4_t xn =
-    dd_mat4_vec4_mul(ctx->xform,
-                     dd_vec4(axes.col[2].x, axes.col[2].y, axes.col[2].z, 0.0));
-  for (int32_t i = 0; i < 6; ++i)
+int32_t
+dd_get_frame_stats(dd_ctx_t* ctx, dd_frame_stats_t* stats)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(stats);
+  *stats = ctx->stats;
+#ifndef DBGDRAW_NO_STATS
+  // Counts that follow from the command list are computed here, instead of
+  // being tracked while recording
+  for (int32_t i = 0; i < ctx->commands_len; ++i)
   {
-    const dd_vec4_t plane = ctx->frustum_planes[i];
-
-    float pdotu = DD_ABS(dd_vec4_dot(plane, xu));
-    float pdotv = DD_ABS(dd_vec4_dot(plane, xv));
-    float pdotn = DD_ABS(dd_vec4_dot(plane, xn));
-
-    float effective_radius = (pdotu + pdotv + pdotn);
-
-    float dot = dd_vec4_dot(xc, ctx->frustum_planes[i]);
-    if (dot <= -effective_radius) { return false; }
+    dd_cmd_t* cmd = ctx->commands + i;
+    stats->vertex_count[cmd->draw_mode] += cmd->vertex_count;
+    stats->command_count[cmd->draw_mode]++;
+    if (cmd->instance_data) { stats->instance_count += cmd->instance_count; }
   }
-  return true;
+  stats->procedural_count    = ctx->procedural_len;
+  stats->drawcall_count      = ctx->drawcall_count;
+  stats->vertex_capacity     = ctx->verts_cap;
+  stats->command_capacity    = ctx->commands_cap;
+  stats->procedural_capacity = ctx->procedural_cap;
+  stats->instance_capacity   = ctx->instance_cap;
+#endif
+  return DBGDRAW_ERR_OK;
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Helper functions
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-float
-dd__pixels_to_world_size(dd_ctx_t* ctx, dd_vec3_t pos, float pixels)
+double
+dd_time_ms(void)
 {
-  DBGDRAW_ASSERT(ctx);
-
-  dd_vec3_t v           = dd_vec3_sub(pos, ctx->view_origin);
-  float dist            = ctx->is_ortho ? 1.0f : dd_vec3_norm(v);
-  float viewport_height = ctx->viewport.w;
-  float projected_size  = ctx->proj_scale_y * (pixels / viewport_height);
-  return dist * projected_size;
+#if defined(_WIN32)
+  static LARGE_INTEGER frequency;
+  if (!frequency.QuadPart) { QueryPerformanceFrequency(&frequency); }
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec * 1e-6;
+#endif
 }
 
-float
-dd__world_size_to_pixels(dd_ctx_t* ctx, dd_vec3_t pos, float size)
+int32_t
+dd_set_trace_hooks(dd_ctx_t* ctx, dd_trace_hooks_t* hooks)
 {
   DBGDRAW_ASSERT(ctx);
-
-  float dist =
-    ctx->is_ortho ? 1.0f : dd_vec3_norm(dd_vec3_sub(pos, ctx->view_origin));
-  float viewport_height = ctx->viewport.w - ctx->viewport.y;
-  return (size * viewport_height) / dist / ctx->proj_scale_y;
+  if (hooks) { ctx->trace_hooks = *hooks; }
+  else { memset(&ctx->trace_hooks, 0, sizeof(ctx->trace_hooks)); }
+  return DBGDRAW_ERR_OK;
 }
 
+#ifndef DBGDRAW_NO_STDIO
 void
-dd__transform_verts(dd_mat4_t xform,
-                    dd_vertex_t* start,
-                    dd_vertex_t* end,
-                    bool normals)
+dd__trace_file_flush(dd_trace_file_t* file)
 {
-  dd_mat4_t normal_mat = dd_mat4_identity();
-  if (normals) normal_mat = dd_mat4_transpose(dd_mat4_se3_inverse(xform));
-  for (dd_vertex_t* it = start; it != end; it++)
+  if (file->buffer_len)
   {
-    dd_vec3_t pos = dd_mat4_vec3_mul(xform, dd_vec4_to_vec3(it->pos_size), 1);
-    it->pos_size  = dd_vec4(pos.x, pos.y, pos.z, it->pos_size.w);
-    if (normals)
-    {
-      dd_vec3_t normal = dd_mat4_vec3_mul(normal_mat, it->normal, 0);
-      it->normal       = normal;
-    }
+    fwrite(file->buffer, 1, file->buffer_len, file->fp);
+    file->buffer_len = 0;
   }
 }
 
-dd_mat3_t
-dd__get_view_aligned_basis(dd_ctx_t* ctx, dd_vec3_t p)
-{
-  DBGDRAW_ASSERT(ctx);
-  dd_mat3_t m;
-  dd_mat4_t inv_view = dd_mat4_se3_inverse(ctx->view);
+// Threads are numbered in the order of their first event, so that spans of the
+// recording and the render thread are shown on separate tracks
+DD_THREAD_LOCAL int32_t dd__trace_thread_id;
+int32_t dd__trace_thread_count;
 
-  if (!ctx->is_ortho)
+// Timestamps come straight from dd_time_ms, in microseconds, so the spans line
+// up with other events sampled from the same monotonic clock.
+void
+dd__trace_file_write(dd_trace_file_t* file,
+                     const char* name,
+                     char phase,
+                     int32_t tid)
+{
+  const char* fmt = "%s{\"name\":\"%s\",\"cat\":\"dbgdraw\",\"ph\":\"%c\","
+                    "\"ts\":%.3f,\"pid\":1,\"tid\":%d}";
+  const char* sep = file->event_count ? ",\n" : "";
+  double ts_us    = dd_time_ms() * 1000.0;
+  file->event_count++;
+
+  size_t space = file->buffer_cap - file->buffer_len;
+  int32_t len  = snprintf(file->buffer + file->buffer_len,
+                         space,
+                         fmt,
+                         sep,
+                         name,
+                         phase,
+                         ts_us,
+                         tid);
+  if (len < 0) { return; }
+  if ((size_t)len < space)
   {
-    dd_vec3_t u = dd_vec4_to_vec3(inv_view.col[1]);
-    dd_vec3_t v = dd_vec4_to_vec3(inv_view.col[3]);
-
-    m.col[2] = dd_vec3_normalize(dd_vec3_sub(v, p));
-
-    m.col[0] = dd_vec3_normalize(dd_vec3_cross(u, m.col[2]));
-    m.col[1] = dd_vec3_cross(m.col[0], m.col[2]);
+    file->buffer_len += len;
+    return;
   }
-  else
+
+  // Event did not fit - flush and retry, or skip the buffer for huge names
+  dd__trace_file_flush(file);
+  if ((size_t)len < file->buffer_cap)
   {
-    m        = dd_mat4_to_mat3(inv_view);
-    m.col[1] = dd_vec3_invert(m.col[1]);
+    file->buffer_len = snprintf(file->buffer,
+                                file->buffer_cap,
+                                fmt,
+                                sep,
+                                name,
+                                phase,
+                                ts_us,
+                                tid);
   }
-  return m;
+  else { fprintf(file->fp, fmt, sep, name, phase, ts_us, tid); }
 }
 
-// NOTE(maciej):
-// Idea here is to calculate transformation that will map a cylinder with ends
-// at (0,0,0) and (0,1,0) and radius 1 to a cylinder with endpoints q0 and q1
-// and radius "radius"
-dd_mat4_t
-dd__generate_cone_orientation(dd_vec3_t q0, dd_vec3_t q1)
+void
+dd__trace_file_event(dd_trace_file_t* file, const char* name, char phase)
 {
-  dd_vec3_t n  = dd_vec3_sub(q1, q0);
-  dd_vec3_t u0 = dd_vec3(n.z, n.z, -n.x - n.y);
-  dd_vec3_t u1 = dd_vec3(-n.y - n.z, n.x, n.x);
-  dd_vec3_t u  = ((n.z != 0) && (-n.x != n.y)) ? u0 : u1;
-  dd_vec3_t v  = dd_vec3_cross(u, n);
-
-  n = dd_vec3_normalize(n);
-  u = dd_vec3_normalize(u);
-  v = dd_vec3_normalize(v);
-
-  dd_mat4_t rot = dd_mat4_identity();
-  rot.col[0]    = dd_vec3_to_vec4(u);
-  rot.col[1]    = dd_vec3_to_vec4(n);
-  rot.col[2]    = dd_vec3_to_vec4(v);
-  float det     = dd_mat4_determinant(rot);
-  rot.col[2]    = dd_vec4_scalar_mul(rot.col[2], det);
+  if (!file->fp) { return; }
+  if (!dd__trace_thread_id)
+  {
+    dd__trace_thread_id = DD_ATOMIC_INCREMENT(&dd__trace_thread_count);
+  }
 
-  return rot;
+  // Events are short, so threads that share the file spin instead of sleeping
+  while (DD_ATOMIC_EXCHANGE(&file->lock, 1)) {}
+  dd__trace_file_write(file, name, phase, dd__trace_thread_id);
+  DD_ATOMIC_STORE(&file->lock, 0);
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Private Draw Commands
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void
-dd__vertex(dd_ctx_t* ctx, dd_vec3_t* pt)
+int32_t
+dd_trace_file_open(dd_trace_file_t* file, const char* filename)
 {
-  float sz             = ctx->primitive_size;
-  dd_color_t out_color = ctx->color;
+  DBGDRAW_ASSERT(file);
+  DBGDRAW_ASSERT(filename);
+  memset(file, 0, sizeof(*file));
 
-  if (ctx->fill_type == DBGDRAW_FILL_LINEAR_GRADIENT)
+  file->buffer_cap = DBGDRAW_TRACE_BUFFER_SIZE;
+  file->buffer     = DBGDRAW_MALLOC(file->buffer_cap);
+  if (!file->buffer) { return DBGDRAW_ERR_FAILED_ALLOC; }
+
+  file->fp = fopen(filename, "wb");
+  if (!file->fp)
   {
-    dd_vec3_t ba  = dd_vec3_sub(ctx->gradient_b_pt, ctx->gradient_a_pt);
-    dd_vec3_t pa  = dd_vec3_sub(*pt, ctx->gradient_a_pt);
-    float dot     = dd_vec3_dot(pa, ba);
-    float ba_norm = dd_vec3_norm_sq(ba);
-    float t       = DD_MAX(DD_MIN(dot / ba_norm, 1.0f), 0.0f);
-    dd_color_t gradient_color =
-      dd_interpolate_color(ctx->gradient_a_col, ctx->gradient_b_col, t);
-    out_color = gradient_color;
+    DBGDRAW_FREE(file->buffer);
+    file->buffer = NULL;
+    return DBGDRAW_ERR_FILE_OPEN_FAILED;
   }
-  ctx->verts_data[ctx->verts_len++] =
-    (dd_vertex_t) {.pos_size = {{pt->x, pt->y, pt->z, sz}}, .col = out_color};
-  ctx->cur_cmd->vertex_count++;
+
+  file->buffer_len = snprintf(file->buffer, file->buffer_cap, "[\n");
+  return DBGDRAW_ERR_OK;
 }
 
-void
-dd__vertex2d(dd_ctx_t* ctx, dd_vec2_t* pt)
+int32_t
+dd_trace_file_close(dd_trace_file_t* file)
 {
-  float sz             = ctx->primitive_size;
-  dd_color_t out_color = ctx->color;
-
-  if (ctx->fill_type == DBGDRAW_FILL_LINEAR_GRADIENT)
+  DBGDRAW_ASSERT(file);
+  if (file->fp)
   {
-    dd_vec2_t grad_a_pt2d = dd_vec2(ctx->gradient_a_pt.x, ctx->gradient_a_pt.y);
-    dd_vec2_t grad_b_pt2d = dd_vec2(ctx->gradient_b_pt.x, ctx->gradient_b_pt.y);
-    dd_vec2_t ba          = dd_vec2_sub(grad_b_pt2d, grad_a_pt2d);
-    dd_vec2_t pa          = dd_vec2_sub(*pt, grad_a_pt2d);
-    float dot             = dd_vec2_dot(pa, ba);
-    float ba_norm         = dd_vec2_norm_sq(ba);
-    float t               = DD_MAX(DD_MIN(dot / ba_norm, 1.0f), 0.0f);
-    dd_color_t gradient_color =
-      dd_interpolate_color(ctx->gradient_a_col, ctx->gradient_b_col, t);
-    out_color = gradient_color;
+    dd__trace_file_flush(file);
+    fprintf(file->fp, "\n]\n");
+    fclose(file->fp);
   }
-  ctx->verts_data[ctx->verts_len++] =
-    (dd_vertex_t) {.pos_size = {{pt->x, pt->y, 0.0, sz}}, .col = out_color};
-  ctx->cur_cmd->vertex_count++;
+  DBGDRAW_FREE(file->buffer);
+  memset(file, 0, sizeof(*file));
+  return DBGDRAW_ERR_OK;
 }
 
-void
-dd__vertex_normal(dd_ctx_t* ctx, dd_vec3_t* pt, dd_vec3_t* nor)
+dd_trace_hooks_t
+dd_trace_file_hooks(dd_trace_file_t* file)
 {
-  float sz                          = ctx->primitive_size;
-  ctx->verts_data[ctx->verts_len++] = (dd_vertex_t) {
-    .pos_size = {{pt->x, pt->y, pt->z, sz}},
-    .normal   = {{nor->x, nor->y, nor->z}},
-    .col      = ctx->color,
-  };
-  ctx->cur_cmd->vertex_count++;
+  dd_trace_hooks_t hooks = {.begin     = dd_trace_file_begin,
+                            .end       = dd_trace_file_end,
+                            .user_data = file};
+  return hooks;
 }
 
 void
-dd__vertex_text(dd_ctx_t* ctx, dd_vec3_t* pt, dd_vec2_t* uv)
+dd_trace_file_begin(void* user_data, const char* name)
 {
-  dd_color_t c = ctx->color;
-  float sz     = ctx->primitive_size;
-  ctx->verts_data[ctx->verts_len++] =
-    (dd_vertex_t) {.pos_size = {{pt->x, pt->y, pt->z, sz}},
-                   .uv       = {{uv->x, uv->y}},
-                   .col      = c};
-  ctx->cur_cmd->vertex_count++;
+  dd__trace_file_event((dd_trace_file_t*)user_data, name, 'B');
 }
 
 void
-dd__line(dd_ctx_t* ctx, dd_vec3_t* pt_a, dd_vec3_t* pt_b)
+dd_trace_file_end(void* user_data, const char* name)
 {
-  dd__vertex(ctx, pt_a);
-  dd__vertex(ctx, pt_b);
+  dd__trace_file_event((dd_trace_file_t*)user_data, name, 'E');
 }
+#endif
 
-void
-dd__triangle(dd_ctx_t* ctx, dd_vec3_t* pt_a, dd_vec3_t* pt_b, dd_vec3_t* pt_c)
+int32_t
+dd_new_frame(dd_ctx_t* ctx, dd_new_frame_info_t* info)
 {
-  dd__vertex(ctx, pt_a);
-  dd__vertex(ctx, pt_b);
-  dd__vertex(ctx, pt_c);
-}
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(info);
+  DBGDRAW_ASSERT(info->view_matrix);
+  DBGDRAW_ASSERT(info->projection_matrix);
+  DBGDRAW_ASSERT(info->viewport_size);
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_new_frame");
 
-void
-dd__triangle_normal(dd_ctx_t* ctx,
-                    dd_vec3_t* pt_a,
-                    dd_vec3_t* pt_b,
-                    dd_vec3_t* pt_c,
-                    dd_vec3_t* normal)
-{
-  dd__vertex_normal(ctx, pt_a, normal);
-  dd__vertex_normal(ctx, pt_b, normal);
-  dd__vertex_normal(ctx, pt_c, normal);
-}
+  ctx->frame_idx++;
+  ctx->xform          = dd_mat4_identity();
+  ctx->verts_len      = 0;
+  ctx->procedural_len = 0;
+  ctx->commands_len   = 0;
+  ctx->drawcall_count = 0;
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  ctx->glyph_instances_len = 0;
+  ctx->text_anchors_len    = 0;
+#endif
 
-void
-dd__quad_point(dd_ctx_t* ctx,
-               dd_vec3_t* pt_a,
-               dd_vec3_t* pt_b,
-               dd_vec3_t* pt_c,
-               dd_vec3_t* pt_d)
-{
-  dd__vertex(ctx, pt_a);
-  dd__vertex(ctx, pt_b);
-  dd__vertex(ctx, pt_c);
-  dd__vertex(ctx, pt_d);
-}
+  ctx->timings.record_ms = 0.0f;
+  ctx->timings.sort_ms   = 0.0f;
+  ctx->timings.upload_ms = 0.0f;
+  ctx->timings.render_ms = 0.0f;
+
+  ctx->stats.glyph_count             = 0;
+  ctx->stats.text_cache_hit_count    = 0;
+  ctx->stats.text_cache_miss_count   = 0;
+  ctx->stats.decluttered_label_count = 0;
+  ctx->stats.culled_sphere_count     = 0;
+  ctx->stats.culled_aabb_count       = 0;
+  ctx->stats.culled_obb_count        = 0;
+  ctx->stats.culled_clip_count       = 0;
+  ctx->stats.bytes_uploaded          = 0;
 
-void
-dd__quad_stroke(dd_ctx_t* ctx,
-                dd_vec3_t* pt_a,
-                dd_vec3_t* pt_b,
-                dd_vec3_t* pt_c,
-                dd_vec3_t* pt_d)
-{
-  dd__line(ctx, pt_a, pt_b);
-  dd__line(ctx, pt_b, pt_c);
-  dd__line(ctx, pt_c, pt_d);
-  dd__line(ctx, pt_d, pt_a);
-}
+  ctx->is_ortho       = (info->projection_type == DBGDRAW_ORTHOGRAPHIC);
 
-void
-dd__quad_fill(dd_ctx_t* ctx,
-              dd_vec3_t* pt_a,
-              dd_vec3_t* pt_b,
-              dd_vec3_t* pt_c,
-              dd_vec3_t* pt_d)
-{
-  switch (ctx->cur_cmd->shading_type)
+  memcpy(ctx->view.data, info->view_matrix, sizeof(ctx->view));
+  memcpy(ctx->proj.data, info->projection_matrix, sizeof(ctx->proj));
+  memcpy(ctx->viewport.data, info->viewport_size, sizeof(dd_vec4_t));
+
+  dd_mat4_t inv_view_matrix = dd_mat4_se3_inverse(ctx->view);
+  memcpy(ctx->view_origin.data, inv_view_matrix.col[3].data, sizeof(dd_vec3_t));
+
+  if (ctx->is_ortho) { ctx->proj_scale_y = 2.0f / ctx->proj.data[5]; }
+  else
   {
-    case DBGDRAW_SHADING_SOLID:
-    {
-      dd_vec3_t normal = dd_vec3_normalize(
-        dd_vec3_cross(dd_vec3_sub(*pt_c, *pt_a), dd_vec3_sub(*pt_b, *pt_a)));
-      dd__triangle_normal(ctx, pt_a, pt_b, pt_c, &normal);
-      dd__triangle_normal(ctx, pt_a, pt_c, pt_d, &normal);
-    }
-    break;
+    ctx->proj_scale_y = 2.0f * tanf(info->vertical_fov * 0.5f);
+  }
 
-    default:
-    {
-      dd__triangle(ctx, pt_a, pt_b, pt_c);
-      dd__triangle(ctx, pt_a, pt_c, pt_d);
-    }
-    break;
+  if (ctx->frustum_cull) { dd_extract_frustum_planes(ctx); }
+
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  if (ctx->frame_idx % DBGDRAW_TEXT_CACHE_MAX_AGE == 0)
+  {
+    dd__text_cache_evict(ctx);
   }
-}
+#endif
 
-void
-dd__quad(dd_ctx_t* ctx,
-         dd_vec3_t* pt_a,
-         dd_vec3_t* pt_b,
-         dd_vec3_t* pt_c,
-         dd_vec3_t* pt_d)
-{
-  switch (ctx->cur_cmd->draw_mode)
+#ifndef DBGDRAW_NO_STDIO
+  if (ctx->capture)
   {
-    case DBGDRAW_MODE_POINT:
-      dd__quad_point(ctx, pt_a, pt_b, pt_c, pt_d);
-      break;
-    case DBGDRAW_MODE_STROKE:
-      dd__quad_stroke(ctx, pt_a, pt_b, pt_c, pt_d);
-      break;
-    case DBGDRAW_MODE_FILL:
-      dd__quad_fill(ctx, pt_a, pt_b, pt_c, pt_d);
-      break;
-    default:
-      break;
+    ctx->capture->frame.view            = ctx->view;
+    ctx->capture->frame.proj            = ctx->proj;
+    ctx->capture->frame.viewport        = ctx->viewport;
+    ctx->capture->frame.vertical_fov    = info->vertical_fov;
+    ctx->capture->frame.projection_type = info->projection_type;
   }
+#endif
+
+  DBGDRAW_TRACE_END(ctx, "dd_new_frame");
+  return DBGDRAW_ERR_OK;
 }
 
-void
-dd__box_point(dd_ctx_t* ctx, dd_vec3_t* pts)
-{
-  dd__vertex(ctx, pts + 0);
-  dd__vertex(ctx, pts + 1);
-  dd__vertex(ctx, pts + 2);
-  dd__vertex(ctx, pts + 3);
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Frame capture and replay
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  dd__vertex(ctx, pts + 4);
-  dd__vertex(ctx, pts + 5);
-  dd__vertex(ctx, pts + 6);
-  dd__vertex(ctx, pts + 7);
-}
+#ifndef DBGDRAW_NO_STDIO
+static const uint32_t dd__capture_elem_size[DBGDRAW_CAPTURE_STREAM_COUNT] = {
+  sizeof(dd_capture_cmd_t),
+  sizeof(dd_vertex_t),
+  sizeof(dd_procedural_prim_t),
+  sizeof(dd_instance_data_t)};
 
 void
-dd__box_stroke(dd_ctx_t* ctx, dd_vec3_t* pts)
+dd__capture_next_frame(dd_ctx_t* ctx)
 {
-  dd__quad_stroke(ctx, pts + 0, pts + 1, pts + 2, pts + 3);
-  dd__quad_stroke(ctx, pts + 4, pts + 5, pts + 6, pts + 7);
+  // A frame that failed to write would break the delta chain, so the capture
+  // ends with the last complete frame
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_capture");
+  if (dd__capture_frame(ctx)) { dd_capture_end(ctx); }
+  DBGDRAW_TRACE_END(ctx, "dd_capture");
+}
 
-  dd__line(ctx, pts + 0, pts + 5);
-  dd__line(ctx, pts + 1, pts + 4);
-  dd__line(ctx, pts + 2, pts + 7);
-  dd__line(ctx, pts + 3, pts + 6);
+// Grows buffer pointed to by 'ptr' to at least 'size' bytes, 'cap' is in bytes
+int32_t
+dd__capture_grow(void** ptr, size_t* cap, size_t size)
+{
+  if (size <= *cap) { return DBGDRAW_ERR_OK; }
+  size_t new_cap = DD_MAX(2 * (*cap), size);
+  void* new_ptr  = DBGDRAW_REALLOC(*ptr, new_cap);
+  if (!new_ptr) { return DBGDRAW_ERR_FAILED_ALLOC; }
+  *ptr = new_ptr;
+  *cap = new_cap;
+  return DBGDRAW_ERR_OK;
 }
 
-void
-dd__box_fill(dd_ctx_t* ctx, dd_vec3_t* pts)
+int32_t
+dd__capture_write(dd_capture_t* cap, const void* data, size_t size)
 {
-  dd__quad_fill(ctx, pts + 0, pts + 1, pts + 2, pts + 3);
-  dd__quad_fill(ctx, pts + 4, pts + 5, pts + 6, pts + 7);
-
-  dd__quad_fill(ctx, pts + 5, pts + 4, pts + 1, pts + 0);
-  dd__quad_fill(ctx, pts + 5, pts + 0, pts + 3, pts + 6);
-  dd__quad_fill(ctx, pts + 7, pts + 6, pts + 3, pts + 2);
-  dd__quad_fill(ctx, pts + 1, pts + 4, pts + 7, pts + 2);
+  if (!size) { return DBGDRAW_ERR_OK; }
+  void** buffer = (void**)&cap->buffer;
+  if (dd__capture_grow(buffer, &cap->buffer_cap, cap->buffer_len + size))
+  {
+    return DBGDRAW_ERR_FAILED_ALLOC;
+  }
+  memcpy(cap->buffer + cap->buffer_len, data, size);
+  cap->buffer_len += size;
+  return DBGDRAW_ERR_OK;
 }
 
-void
-dd__box(dd_ctx_t* ctx, dd_vec3_t* pts)
-{
-  switch (ctx->cur_cmd->draw_mode)
+int32_t
+dd__capture_write_delta(dd_capture_t* cap,
+                        const uint8_t* cur,
+                        int32_t len,
+                        const uint8_t* prev,
+                        int32_t prev_len,
+                        size_t elem_size)
+{
+  int32_t error = DBGDRAW_ERR_OK;
+  int32_t i     = 0;
+  while (i < len && !error)
   {
-    case DBGDRAW_MODE_POINT:
-      dd__box_point(ctx, pts);
-      break;
-    case DBGDRAW_MODE_STROKE:
-      dd__box_stroke(ctx, pts);
-      break;
-    case DBGDRAW_MODE_FILL:
-      dd__box_fill(ctx, pts);
-      break;
-    default:
-      break;
+    uint32_t run[2] = {0, 0};
+    while (i < len && i < prev_len &&
+           !memcmp(cur + i * elem_size, prev + i * elem_size, elem_size))
+    {
+      run[0]++;
+      i++;
+    }
+    int32_t start = i;
+    while (i < len && (i >= prev_len || memcmp(cur + i * elem_size,
+                                               prev + i * elem_size,
+                                               elem_size)))
+    {
+      run[1]++;
+      i++;
+    }
+    error = dd__capture_write(cap, run, sizeof(run));
+    if (!error && run[1])
+    {
+      error = dd__capture_write(cap, cur + start * elem_size, run[1] * elem_size);
+    }
   }
+  return error;
 }
 
-void
-dd__arc_point(dd_ctx_t* ctx,
-              dd_vec3_t* center,
-              float radius,
-              float theta,
-              int32_t resolution)
+int32_t
+dd__capture_frame(dd_ctx_t* ctx)
 {
-  resolution          = DD_MAX(4, resolution);
-  float d_theta       = theta / resolution;
-  int32_t full_circle = (int32_t)(!(theta < DBGDRAW_TWO_PI));
+  dd_capture_t* cap = ctx->capture;
 
-  if (!full_circle) { dd__vertex(ctx, center); }
+  // Flatten commands, so that instance data travels with the frame
+  int32_t instances_len = 0;
+  for (int32_t i = 0; i < ctx->commands_len; ++i)
+  {
+    dd_cmd_t* cmd = ctx->commands + i;
+    if (cmd->instance_data) { instances_len += cmd->instance_count; }
+  }
+  if (dd__capture_grow((void**)&cap->cmds,
+                       &cap->cmds_cap,
+                       ctx->commands_len * sizeof(dd_capture_cmd_t)) ||
+      dd__capture_grow((void**)&cap->instances,
+                       &cap->instances_cap,
+                       instances_len * sizeof(dd_instance_data_t)))
+  {
+    return DBGDRAW_ERR_FAILED_ALLOC;
+  }
 
-#if 0
-//TODO(maciej): Since transcendentals are so slow, we could precompute some data
-// using simd instructions
-  __m128 wide_x = _mm_set_ps(0.0f, 1.57f, 3.143f, 0.707f);
-  __m128 wide_cosx;
-  __m128 wide_sinx = _mm_sincos_ps(&wide_cosx, wide_x);
-  float sin_x[4];
-  float cos_x[4];
-  _mm_store_ps(sin_x, wide_sinx);
-  _mm_store_ps(cos_x, wide_cosx);
+  int32_t instance_offset = 0;
+  for (int32_t i = 0; i < ctx->commands_len; ++i)
+  {
+    dd_cmd_t* cmd = ctx->commands + i;
+    dd_capture_cmd_t* rec = cap->cmds + i;
+    memset(rec, 0, sizeof(*rec));
+    rec->xform                   = cmd->xform;
+    rec->clip_rect               = cmd->clip_rect;
+    rec->aa_radius               = cmd->aa_radius;
+    rec->min_depth               = cmd->min_depth;
+    rec->base_index              = cmd->base_index;
+    rec->vertex_count            = cmd->vertex_count;
+    rec->instance_count          = cmd->instance_count;
+    rec->instance_offset         = -1;
+    rec->procedural_base_index   = cmd->procedural_base_index;
+    rec->procedural_count        = cmd->procedural_count;
+    rec->procedural_vertex_count = cmd->procedural_vertex_count;
+    rec->procedural_types        = cmd->procedural_types;
+    rec->draw_mode               = cmd->draw_mode;
+    rec->shading_type            = cmd->shading_type;
+    rec->font_idx                = -1;
+#if DBGDRAW_HAS_TEXT_SUPPORT
+    rec->font_idx = cmd->font_idx;
 #endif
+    if (cmd->instance_data)
+    {
+      rec->instance_offset = instance_offset;
+      memcpy(cap->instances + instance_offset,
+             cmd->instance_data,
+             cmd->instance_count * sizeof(dd_instance_data_t));
+      instance_offset += cmd->instance_count;
+    }
+  }
 
-  float theta1;
-  float ox1 = 0.0f, oy1 = 0.0f;
-  int32_t final_res = full_circle ? resolution : resolution + 1;
-  dd_vec3_t pt      = dd_vec3(0.0f, 0.0f, center->z);
-  for (int32_t i = 0; i < final_res; ++i)
+  const uint8_t* streams[DBGDRAW_CAPTURE_STREAM_COUNT];
+  streams[DBGDRAW_CAPTURE_COMMANDS]    = (const uint8_t*)cap->cmds;
+  streams[DBGDRAW_CAPTURE_VERTICES]    = (const uint8_t*)ctx->verts_data;
+  streams[DBGDRAW_CAPTURE_PROCEDURALS] = (const uint8_t*)ctx->procedural_data;
+  streams[DBGDRAW_CAPTURE_INSTANCES]   = (const uint8_t*)cap->instances;
+
+  dd_capture_frame_t prev_frame = cap->frame;
+  cap->frame.len[DBGDRAW_CAPTURE_COMMANDS]    = ctx->commands_len;
+  cap->frame.len[DBGDRAW_CAPTURE_VERTICES]    = ctx->verts_len;
+  cap->frame.len[DBGDRAW_CAPTURE_PROCEDURALS] = ctx->procedural_len;
+  cap->frame.len[DBGDRAW_CAPTURE_INSTANCES]   = instances_len;
+
+  bool keyframe =
+    (cap->frame_count % DBGDRAW_CAPTURE_KEYFRAME_INTERVAL) == 0;
+  dd_capture_chunk_t chunk = {
+    .tag   = DBGDRAW_CAPTURE_TAG_FRAME,
+    .flags = keyframe ? DBGDRAW_CAPTURE_CHUNK_KEYFRAME : 0};
+
+  cap->buffer_len = 0;
+  int32_t error   = dd__capture_write(cap, &chunk, sizeof(chunk));
+  if (!error) { error = dd__capture_write(cap, &cap->frame, sizeof(cap->frame)); }
+  for (int32_t i = 0; i < DBGDRAW_CAPTURE_STREAM_COUNT && !error; ++i)
   {
-    theta1 = i * d_theta;
-    ox1    = radius * DBGDRAW_SIN(theta1);
-    oy1    = radius * DBGDRAW_COS(theta1);
+    size_t elem_size = dd__capture_elem_size[i];
+    if (keyframe)
+    {
+      error = dd__capture_write(cap, streams[i], cap->frame.len[i] * elem_size);
+    }
+    else
+    {
+      error = dd__capture_write_delta(cap,
+                                      streams[i],
+                                      cap->frame.len[i],
+                                      cap->prev[i],
+                                      prev_frame.len[i],
+                                      elem_size);
+    }
+  }
+  uint8_t padding[8] = {0};
+  if (!error && (cap->buffer_len & 7))
+  {
+    error = dd__capture_write(cap, padding, 8 - (cap->buffer_len & 7));
+  }
+  if (error) { return error; }
 
-    pt.x = center->x + ox1;
-    pt.y = center->y + oy1;
-    dd__vertex(ctx, &pt);
+  if (dd__capture_grow((void**)&cap->frame_offsets,
+                       &cap->frame_offsets_cap,
+                       (cap->frame_count + 1) * sizeof(uint64_t)))
+  {
+    return DBGDRAW_ERR_FAILED_ALLOC;
   }
-}
+  cap->frame_offsets[cap->frame_count++] = cap->offset;
 
-void
-dd__arc_stroke(dd_ctx_t* ctx,
-               dd_vec3_t* center,
-               float radius,
-               float theta,
-               int32_t resolution)
-{
-  dd_vec3_t pt_a = dd_vec3(center->x, center->y, center->z);
-  dd_vec3_t pt_b = dd_vec3(center->x, center->y + radius, center->z);
+  chunk.size = cap->buffer_len - sizeof(chunk);
+  memcpy(cap->buffer, &chunk, sizeof(chunk));
+  fwrite(cap->buffer, 1, cap->buffer_len, cap->fp);
+  cap->offset += cap->buffer_len;
 
-  int32_t init_offset = ctx->cur_cmd->base_index + ctx->cur_cmd->vertex_count;
-  int32_t full_circle = (int32_t)(!(theta < DBGDRAW_TWO_PI));
-  if (!full_circle) { dd__line(ctx, &pt_a, &pt_b); }
-  else
+  // Keep this frame's data around, to delta encode the next one against
+  for (int32_t i = 0; i < DBGDRAW_CAPTURE_STREAM_COUNT; ++i)
   {
-    resolution += 1;
+    size_t size = cap->frame.len[i] * dd__capture_elem_size[i];
+    if (dd__capture_grow(&cap->prev[i], &cap->prev_cap[i], size))
+    {
+      return DBGDRAW_ERR_FAILED_ALLOC;
+    }
+    if (size) { memcpy(cap->prev[i], streams[i], size); }
   }
 
-  int32_t mod   = full_circle ? -1 : 0;
-  float d_theta = theta / (resolution + mod);
+  return DBGDRAW_ERR_OK;
+}
 
-  float theta1, theta2;
-  float ox1, ox2, oy1, oy2;
-  ox1 = ox2 = oy1 = oy2 = 0.0f;
-  for (int32_t i = 0; i < resolution; ++i)
-  {
-    theta1 = i * d_theta;
-    theta2 = (i + 1) * d_theta;
-    ox1    = radius * DBGDRAW_SIN(theta1);
-    ox2    = radius * DBGDRAW_SIN(theta2);
-    oy1    = radius * DBGDRAW_COS(theta1);
-    oy2    = radius * DBGDRAW_COS(theta2);
+int32_t
+dd_capture_begin(dd_ctx_t* ctx, const char* filename)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(filename);
+  if (ctx->capture) { dd_capture_end(ctx); }
 
-    pt_a.x = center->x + ox1;
-    pt_a.y = center->y + oy1;
-    pt_b.x = center->x + ox2;
-    pt_b.y = center->y + oy2;
-    dd__line(ctx, &pt_a, &pt_b);
-  }
+  dd_capture_t* cap = DBGDRAW_MALLOC(sizeof(dd_capture_t));
+  if (!cap) { return DBGDRAW_ERR_FAILED_ALLOC; }
+  memset(cap, 0, sizeof(*cap));
 
-  if (!full_circle)
+  cap->fp = fopen(filename, "wb");
+  if (!cap->fp)
   {
-    pt_a.x = center->x;
-    pt_a.y = center->y;
-    pt_b.x = center->x + ox2;
-    pt_b.y = center->y + oy2;
-    dd__line(ctx, &pt_b, &pt_a);
+    DBGDRAW_FREE(cap);
+    return DBGDRAW_ERR_FILE_OPEN_FAILED;
   }
-  else
+
+  dd_capture_header_t header = {
+    .magic             = DBGDRAW_CAPTURE_MAGIC,
+    .version           = DBGDRAW_CAPTURE_VERSION,
+    .keyframe_interval = DBGDRAW_CAPTURE_KEYFRAME_INTERVAL};
+  for (int32_t i = 0; i < DBGDRAW_CAPTURE_STREAM_COUNT; ++i)
   {
-    /* This is an ugly fix to allow non-broken lines.
-       We add an extra segment, and we modify its positions to lie on a segment,
-       not vertex. */
-    dd_vertex_t* v1 = ctx->verts_data + init_offset;
-    dd_vertex_t* v2 = v1 + 1;
-    dd_vec3_t p1    = v1->pos;
-    dd_vec3_t p2    = v2->pos;
-    v1->pos =
-      dd_vec3(0.5f * (p1.x + p2.x), 0.5f * (p1.y + p2.y), 0.5f * (p1.z + p2.z));
+    header.elem_size[i] = dd__capture_elem_size[i];
+  }
+  fwrite(&header, 1, sizeof(header), cap->fp);
+  cap->offset = sizeof(header);
+
+  // Frames rendered before the first dd_new_frame use the current camera
+  cap->frame.view     = ctx->view;
+  cap->frame.proj     = ctx->proj;
+  cap->frame.viewport = ctx->viewport;
+  cap->frame.projection_type =
+    ctx->is_ortho ? DBGDRAW_ORTHOGRAPHIC : DBGDRAW_PERSPECTIVE;
+  cap->frame.vertical_fov = 2.0f * atanf(ctx->proj_scale_y * 0.5f);
+
+  ctx->capture = cap;
+  return DBGDRAW_ERR_OK;
+}
 
-    v1 = ctx->verts_data + ctx->cur_cmd->base_index +
-         ctx->cur_cmd->vertex_count - 2;
-    v2 = v1 + 1;
-    p1 = v1->pos;
-    p2 = v2->pos;
-    v2->pos =
-      dd_vec3(0.5f * (p1.x + p2.x), 0.5f * (p1.y + p2.y), 0.5f * (p1.z + p2.z));
+int32_t
+dd_capture_end(dd_ctx_t* ctx)
+{
+  DBGDRAW_ASSERT(ctx);
+  dd_capture_t* cap = ctx->capture;
+  if (!cap) { return DBGDRAW_ERR_OK; }
+
+  dd_capture_chunk_t chunk   = {.tag  = DBGDRAW_CAPTURE_TAG_INDEX,
+                                .size = cap->frame_count * sizeof(uint64_t)};
+  dd_capture_footer_t footer = {.index_offset = cap->offset,
+                                .frame_count  = (uint32_t)cap->frame_count,
+                                .magic        = DBGDRAW_CAPTURE_MAGIC};
+  fwrite(&chunk, 1, sizeof(chunk), cap->fp);
+  fwrite(cap->frame_offsets, sizeof(uint64_t), cap->frame_count, cap->fp);
+  fwrite(&footer, 1, sizeof(footer), cap->fp);
+  int32_t error = ferror(cap->fp) ? DBGDRAW_ERR_FILE_OPEN_FAILED : 0;
+  fclose(cap->fp);
+
+  for (int32_t i = 0; i < DBGDRAW_CAPTURE_STREAM_COUNT; ++i)
+  {
+    DBGDRAW_FREE(cap->prev[i]);
   }
+  DBGDRAW_FREE(cap->frame_offsets);
+  DBGDRAW_FREE(cap->cmds);
+  DBGDRAW_FREE(cap->instances);
+  DBGDRAW_FREE(cap->buffer);
+  DBGDRAW_FREE(cap);
+  ctx->capture = NULL;
+  return error;
 }
 
-void
-dd__arc_fill(dd_ctx_t* ctx,
-             dd_vec3_t* center,
-             float radius,
-             float theta,
-             int32_t resolution,
-             uint8_t flip)
+int32_t
+dd_replay_open(dd_replay_t* replay, const char* filename)
+{
+  DBGDRAW_ASSERT(replay);
+  DBGDRAW_ASSERT(filename);
+  memset(replay, 0, sizeof(*replay));
+  replay->frame_idx = -1;
+
+  FILE* fp = fopen(filename, "rb");
+  if (!fp) { return DBGDRAW_ERR_FILE_OPEN_FAILED; }
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  if (size <= 0)
+  {
+    fclose(fp);
+    return DBGDRAW_ERR_INVALID_CAPTURE;
+  }
+
+  replay->size = (size_t)size;
+  replay->data = DBGDRAW_MALLOC(replay->size);
+  if (!replay->data)
+  {
+    fclose(fp);
+    return DBGDRAW_ERR_FAILED_ALLOC;
+  }
+  size_t read_size = fread(replay->data, 1, replay->size, fp);
+  fclose(fp);
+
+  dd_capture_header_t header;
+  dd_capture_footer_t footer;
+  int32_t error = DBGDRAW_ERR_INVALID_CAPTURE;
+  if (read_size != replay->size ||
+      replay->size < sizeof(header) + sizeof(footer))
+  {
+    goto dd_replay_open_fail;
+  }
+
+  memcpy(&header, replay->data, sizeof(header));
+  memcpy(&footer, replay->data + replay->size - sizeof(footer), sizeof(footer));
+  if (header.magic != DBGDRAW_CAPTURE_MAGIC ||
+      header.version != DBGDRAW_CAPTURE_VERSION ||
+      footer.magic != DBGDRAW_CAPTURE_MAGIC)
+  {
+    goto dd_replay_open_fail;
+  }
+  for (int32_t i = 0; i < DBGDRAW_CAPTURE_STREAM_COUNT; ++i)
+  {
+    if (header.elem_size[i] != dd__capture_elem_size[i])
+    {
+      goto dd_replay_open_fail;
+    }
+  }
+
+  uint64_t index_size = footer.frame_count * sizeof(uint64_t);
+  if (footer.index_offset + sizeof(dd_capture_chunk_t) + index_size >
+      replay->size - sizeof(footer))
+  {
+    goto dd_replay_open_fail;
+  }
+  dd_capture_chunk_t* index =
+    (dd_capture_chunk_t*)(replay->data + footer.index_offset);
+  if (index->tag != DBGDRAW_CAPTURE_TAG_INDEX || index->size != index_size)
+  {
+    goto dd_replay_open_fail;
+  }
+
+  replay->frame_offsets = (const uint64_t*)(index + 1);
+  replay->frame_count   = (int32_t)footer.frame_count;
+  for (int32_t i = 0; i < replay->frame_count; ++i)
+  {
+    uint64_t offset = replay->frame_offsets[i];
+    if ((offset & 7) || offset + sizeof(dd_capture_chunk_t) +
+                            sizeof(dd_capture_frame_t) > footer.index_offset)
+    {
+      goto dd_replay_open_fail;
+    }
+  }
+  return DBGDRAW_ERR_OK;
+
+dd_replay_open_fail:
+  DBGDRAW_FREE(replay->data);
+  memset(replay, 0, sizeof(*replay));
+  return error;
+}
+
+int32_t
+dd_replay_close(dd_replay_t* replay)
 {
-  float d_theta = theta / resolution;
+  DBGDRAW_ASSERT(replay);
+  DBGDRAW_FREE(replay->data);
+  for (int32_t i = 0; i < DBGDRAW_CAPTURE_STREAM_COUNT; ++i)
+  {
+    DBGDRAW_FREE(replay->streams[i]);
+  }
+  memset(replay, 0, sizeof(*replay));
+  return DBGDRAW_ERR_OK;
+}
 
-  float theta1, theta2;
-  float ox1, ox2, oy1, oy2;
-  ox1 = ox2 = oy1 = oy2 = 0.0f;
-  dd_vec3_t pt_a        = dd_vec3(0.0f, 0.0f, center->z);
-  dd_vec3_t pt_b        = dd_vec3(0.0f, 0.0f, center->z);
-  dd_vec3_t normal;
-  for (int32_t i = 0; i < resolution; ++i)
+int32_t
+dd__replay_decode_frame(dd_replay_t* replay, int32_t frame_idx)
+{
+  const uint8_t* ptr = replay->data + replay->frame_offsets[frame_idx];
+  dd_capture_chunk_t chunk;
+  memcpy(&chunk, ptr, sizeof(chunk));
+  ptr += sizeof(chunk);
+  const uint8_t* end = ptr + chunk.size;
+  if (chunk.tag != DBGDRAW_CAPTURE_TAG_FRAME ||
+      chunk.size > (uint64_t)(replay->data + replay->size - ptr) ||
+      chunk.size < sizeof(dd_capture_frame_t))
   {
-    theta1 = i * d_theta;
-    theta2 = (i + 1) * d_theta;
-    ox1    = radius * DBGDRAW_SIN(theta1);
-    ox2    = radius * DBGDRAW_SIN(theta2);
-    oy1    = radius * DBGDRAW_COS(theta1);
-    oy2    = radius * DBGDRAW_COS(theta2);
+    return DBGDRAW_ERR_INVALID_CAPTURE;
+  }
 
-    pt_a.x = center->x + ox2;
-    pt_a.y = center->y + oy2;
-    pt_b.x = center->x + ox1;
-    pt_b.y = center->y + oy1;
-    if (i == 0 && ctx->cur_cmd->shading_type)
+  bool keyframe = chunk.flags & DBGDRAW_CAPTURE_CHUNK_KEYFRAME;
+  if (!keyframe && replay->frame_idx != frame_idx - 1)
+  {
+    return DBGDRAW_ERR_INVALID_CAPTURE;
+  }
+
+  dd_capture_frame_t prev_frame = replay->frame;
+  memcpy(&replay->frame, ptr, sizeof(replay->frame));
+  ptr += sizeof(replay->frame);
+
+  // Arrays are decoded in place - unchanged runs are already there
+  for (int32_t i = 0; i < DBGDRAW_CAPTURE_STREAM_COUNT; ++i)
+  {
+    int32_t len      = replay->frame.len[i];
+    int32_t prev_len = keyframe ? 0 : prev_frame.len[i];
+    size_t elem_size = dd__capture_elem_size[i];
+    if (len < 0 || (size_t)len > prev_len + (end - ptr) / elem_size)
     {
-      normal = dd_vec3_normalize(
-        dd_vec3_cross(dd_vec3_sub(pt_b, *center), dd_vec3_sub(pt_a, *center)));
-      if (flip) { normal = dd_vec3(-normal.x, -normal.y, -normal.z); }
+      return DBGDRAW_ERR_INVALID_CAPTURE;
     }
 
-    if (flip)
+    if (dd__capture_grow(&replay->streams[i],
+                         &replay->streams_cap[i],
+                         len * elem_size))
     {
-      if (ctx->cur_cmd->shading_type)
-      {
-        dd__triangle_normal(ctx, center, &pt_b, &pt_a, &normal);
-      }
-      else
-      {
-        dd__triangle(ctx, center, &pt_b, &pt_a);
-      }
+      return DBGDRAW_ERR_FAILED_ALLOC;
     }
-    else
+    uint8_t* stream = replay->streams[i];
+
+    if (keyframe)
     {
-      if (ctx->cur_cmd->shading_type)
+      if ((size_t)(end - ptr) < len * elem_size)
       {
-        dd__triangle_normal(ctx, center, &pt_a, &pt_b, &normal);
+        return DBGDRAW_ERR_INVALID_CAPTURE;
       }
-      else
+      if (len) { memcpy(stream, ptr, len * elem_size); }
+      ptr += len * elem_size;
+      continue;
+    }
+
+    int32_t decoded = 0;
+    while (decoded < len)
+    {
+      uint32_t run[2];
+      if ((size_t)(end - ptr) < sizeof(run)) { return DBGDRAW_ERR_INVALID_CAPTURE; }
+      memcpy(run, ptr, sizeof(run));
+      ptr += sizeof(run);
+      if (run[0] + (uint64_t)run[1] > (uint64_t)(len - decoded) ||
+          decoded + run[0] > (uint64_t)prev_len ||
+          (size_t)(end - ptr) < run[1] * elem_size)
       {
-        dd__triangle(ctx, center, &pt_a, &pt_b);
+        return DBGDRAW_ERR_INVALID_CAPTURE;
       }
+      decoded += run[0];
+      if (run[1]) { memcpy(stream + decoded * elem_size, ptr, run[1] * elem_size); }
+      ptr += run[1] * elem_size;
+      decoded += run[1];
     }
   }
-  // printf("%f %f %f\n", normal.x, normal.y, normal.y);
+
+  replay->frame_idx = frame_idx;
+  return DBGDRAW_ERR_OK;
 }
 
-void
-dd__arc(dd_ctx_t* ctx,
-        dd_vec3_t* center,
-        float radius,
-        float theta,
-        int32_t resolution,
-        uint8_t flip)
+int32_t
+dd_replay_frame(dd_ctx_t* ctx, dd_replay_t* replay, int32_t frame_idx)
 {
-  switch (ctx->cur_cmd->draw_mode)
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(replay);
+  if (frame_idx < 0 || frame_idx >= replay->frame_count)
   {
-    case DBGDRAW_MODE_POINT:
-      dd__arc_point(ctx, center, radius, theta, resolution >> 1);
-      break;
-    case DBGDRAW_MODE_STROKE:
-      dd__arc_stroke(ctx, center, radius, theta, resolution);
-      break;
-    case DBGDRAW_MODE_FILL:
-      dd__arc_fill(ctx, center, radius, theta, resolution, flip);
-      break;
-    default:
-      break;
+    return DBGDRAW_ERR_OUT_OF_BOUNDS_ACCESS;
   }
-}
 
-// NOTE(maciej): dd_arc(...) deals with both points and strokes
-void
-dd__sphere_point_stroke(dd_ctx_t* ctx,
-                        dd_vec3_t* center,
-                        float radius,
-                        int32_t resolution)
-{
-  /* Store initial state */
-  const int32_t n_rings = 3;
-  dd_vertex_t* base_ptr = ctx->verts_data + ctx->verts_len;
+  // Decode forward from the closest keyframe, unless we are at the next frame
+  int32_t start_idx = frame_idx;
+  if (frame_idx != replay->frame_idx + 1)
+  {
+    while (start_idx > 0)
+    {
+      dd_capture_chunk_t chunk;
+      memcpy(&chunk,
+             replay->data + replay->frame_offsets[start_idx],
+             sizeof(chunk));
+      if (chunk.flags & DBGDRAW_CAPTURE_CHUNK_KEYFRAME) { break; }
+      start_idx--;
+    }
+  }
+  for (int32_t i = start_idx; i <= frame_idx; ++i)
+  {
+    int32_t error = dd__replay_decode_frame(replay, i);
+    if (error) { return error; }
+  }
 
-  /* Create unit circle, and get data boundaries */
-  dd_vertex_t* start_ptr = base_ptr;
-  dd_vec3_t zero_pt      = dd_vec3(0.0f, 0.0f, 0.0f);
-  dd__arc(ctx, &zero_pt, 1.0f, (float)DBGDRAW_TWO_PI, resolution, 0);
-  dd_vertex_t* end_ptr = ctx->verts_data + ctx->verts_len;
-  int32_t len          = (int32_t)(end_ptr - start_ptr);
-  int32_t new_verts    = n_rings * len;
+  dd_capture_frame_t* frame = &replay->frame;
+  int32_t* len              = frame->len;
+  dd_capture_cmd_t* cmds =
+    (dd_capture_cmd_t*)replay->streams[DBGDRAW_CAPTURE_COMMANDS];
+  for (int32_t i = 0; i < len[DBGDRAW_CAPTURE_COMMANDS]; ++i)
+  {
+    dd_capture_cmd_t* rec = cmds + i;
+    if (rec->draw_mode < 0 || rec->draw_mode >= DBGDRAW_MODE_COUNT ||
+        rec->shading_type < 0 || rec->shading_type >= DBGDRAW_SHADING_COUNT ||
+        rec->base_index < 0 || rec->vertex_count < 0 ||
+        rec->base_index + rec->vertex_count > len[DBGDRAW_CAPTURE_VERTICES] ||
+        rec->procedural_base_index < 0 || rec->procedural_count < 0 ||
+        rec->procedural_base_index + rec->procedural_count >
+          len[DBGDRAW_CAPTURE_PROCEDURALS] ||
+        (rec->instance_offset >= 0 &&
+         (rec->instance_count < 0 ||
+          rec->instance_offset + rec->instance_count >
+            len[DBGDRAW_CAPTURE_INSTANCES])))
+    {
+      return DBGDRAW_ERR_INVALID_CAPTURE;
+    }
+  }
 
-  /* Copy the memory, so that we have all the rings we need. */
-  for (int32_t i = 1; i < n_rings; ++i)
+  dd_new_frame_info_t info = {.view_matrix       = frame->view.data,
+                              .projection_matrix = frame->proj.data,
+                              .viewport_size     = frame->viewport.data,
+                              .vertical_fov      = frame->vertical_fov,
+                              .projection_type   = frame->projection_type};
+  dd_new_frame(ctx, &info);
+
+  DD_GROW(ctx,
+          ctx->commands,
+          len[DBGDRAW_CAPTURE_COMMANDS],
+          ctx->commands_cap,
+          sizeof(dd_cmd_t));
+  DD_GROW(ctx,
+          ctx->verts_data,
+          len[DBGDRAW_CAPTURE_VERTICES],
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+  DD_GROW(ctx,
+          ctx->procedural_data,
+          len[DBGDRAW_CAPTURE_PROCEDURALS],
+          ctx->procedural_cap,
+          sizeof(dd_procedural_prim_t));
+
+  if (len[DBGDRAW_CAPTURE_VERTICES])
   {
-    memcpy(end_ptr, start_ptr, len * sizeof(dd_vertex_t));
-    end_ptr += len;
-    start_ptr += len;
+    memcpy(ctx->verts_data,
+           replay->streams[DBGDRAW_CAPTURE_VERTICES],
+           len[DBGDRAW_CAPTURE_VERTICES] * sizeof(dd_vertex_t));
+  }
+  if (len[DBGDRAW_CAPTURE_PROCEDURALS])
+  {
+    memcpy(ctx->procedural_data,
+           replay->streams[DBGDRAW_CAPTURE_PROCEDURALS],
+           len[DBGDRAW_CAPTURE_PROCEDURALS] * sizeof(dd_procedural_prim_t));
   }
+  ctx->verts_len      = len[DBGDRAW_CAPTURE_VERTICES];
+  ctx->procedural_len = len[DBGDRAW_CAPTURE_PROCEDURALS];
 
-  dd_mat4_t xform;
+  dd_instance_data_t* instances =
+    (dd_instance_data_t*)replay->streams[DBGDRAW_CAPTURE_INSTANCES];
+  for (int32_t i = 0; i < len[DBGDRAW_CAPTURE_COMMANDS]; ++i)
+  {
+    dd_capture_cmd_t* rec = cmds + i;
+    dd_cmd_t* cmd         = ctx->commands + i;
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->xform                   = rec->xform;
+    cmd->clip_rect               = rec->clip_rect;
+    cmd->aa_radius               = rec->aa_radius;
+    cmd->min_depth               = rec->min_depth;
+    cmd->base_index              = rec->base_index;
+    cmd->vertex_count            = rec->vertex_count;
+    cmd->instance_count          = rec->instance_count;
+    cmd->procedural_base_index   = rec->procedural_base_index;
+    cmd->procedural_count        = rec->procedural_count;
+    cmd->procedural_vertex_count = rec->procedural_vertex_count;
+    cmd->procedural_types        = rec->procedural_types;
+    cmd->draw_mode               = (dd_mode_t)rec->draw_mode;
+    cmd->shading_type            = (dd_shading_t)rec->shading_type;
+    if (rec->instance_offset >= 0)
+    {
+      cmd->instance_data = instances + rec->instance_offset;
+    }
+#if DBGDRAW_HAS_TEXT_SUPPORT
+    // Fonts are not captured - text falls back to the first font
+    cmd->font_idx = rec->font_idx;
+    if (cmd->font_idx >= ctx->fonts_len)
+    {
+      cmd->font_idx = ctx->fonts_len ? 0 : -1;
+    }
+    if (cmd->shading_type == DBGDRAW_SHADING_TEXT)
+    {
+      dd_vertex_t* v = ctx->verts_data + cmd->base_index;
+      for (int32_t j = 0; j < cmd->vertex_count; ++j)
+      {
+        if (v[j].font >= ctx->fonts_len) { v[j].font = 0.0f; }
+      }
+    }
+#endif
+  }
+  ctx->commands_len = len[DBGDRAW_CAPTURE_COMMANDS];
+  ctx->cur_cmd      = NULL;
 
-  /* Circle A */
-  xform     = dd_pre_scale(dd_mat4_identity(), dd_vec3(radius, radius, radius));
-  xform     = dd_pre_translate(xform, *center);
-  start_ptr = base_ptr;
-  end_ptr   = start_ptr + len;
-  dd__transform_verts(xform, start_ptr, end_ptr, 0);
+  return DBGDRAW_ERR_OK;
+}
+#endif
 
-  /* Circle B */
-  xform = dd_pre_scale(dd_mat4_identity(), dd_vec3(radius, radius, radius));
-  xform = dd_pre_rotate(xform, (float)DBGDRAW_PI_OVER_TWO, dd_vec3(1, 0, 0));
-  xform = dd_pre_translate(xform, *center);
-  start_ptr = end_ptr;
-  end_ptr   = start_ptr + len;
-  dd__transform_verts(xform, start_ptr, end_ptr, 0);
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Frustum culling for higher order primitives
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  /* Circle C */
-  xform = dd_pre_scale(dd_mat4_identity(), dd_vec3(radius, radius, radius));
-  xform = dd_pre_rotate(xform, (float)DBGDRAW_PI_OVER_TWO, dd_vec3(0, 1, 0));
-  xform = dd_pre_translate(xform, *center);
-  start_ptr = end_ptr;
-  end_ptr   = start_ptr + len;
-  dd__transform_verts(xform, start_ptr, end_ptr, 0);
+// After Fabian "rygorous" Giessen
+void
+dd__normalize_plane(dd_vec4_t* plane)
+{
+  float mag =
+    sqrtf(plane->x * plane->x + plane->y * plane->y + plane->z * plane->z);
+  plane->x /= mag;
+  plane->y /= mag;
+  plane->z /= mag;
+  plane->w /= mag;
+}
 
-  /* Tell the context that there is new vertex data */
-  ctx->verts_len += (new_verts - (int32_t)len);
-  ctx->cur_cmd->vertex_count += (new_verts - (int32_t)len);
+void
+dd_extract_frustum_planes(dd_ctx_t* ctx)
+{
+  DBGDRAW_ASSERT(ctx);
+  dd_mat4_t pv = dd_mat4_transpose(dd_mat4_mul(ctx->proj, ctx->view));
+
+  ctx->frustum_planes[0] = dd_vec4_add(pv.col[3], pv.col[2]);
+  ctx->frustum_planes[1] = dd_vec4_sub(pv.col[3], pv.col[2]);
+  ctx->frustum_planes[2] = dd_vec4_add(pv.col[3], pv.col[1]);
+  ctx->frustum_planes[3] = dd_vec4_sub(pv.col[3], pv.col[1]);
+  ctx->frustum_planes[4] = dd_vec4_add(pv.col[3], pv.col[0]);
+  ctx->frustum_planes[5] = dd_vec4_sub(pv.col[3], pv.col[0]);
+
+  dd__normalize_plane(&ctx->frustum_planes[0]);
+  dd__normalize_plane(&ctx->frustum_planes[1]);
+  dd__normalize_plane(&ctx->frustum_planes[2]);
+  dd__normalize_plane(&ctx->frustum_planes[3]);
+  dd__normalize_plane(&ctx->frustum_planes[4]);
+  dd__normalize_plane(&ctx->frustum_planes[5]);
 }
 
+// Planes of the clip rect of the command, in the space of its transform, so
+// points are tested as they are given. The rect is grown by the size of points
+// and lines and the antialiasing, which reach past the vertices. Instanced
+// commands are not tested, as each instance moves the vertices.
 void
-dd__sphere_fill(dd_ctx_t* ctx, dd_vec3_t* c, float radius, int32_t resolution)
+dd__update_clip_planes(dd_ctx_t* ctx)
 {
-  float half_pi  = (float)DBGDRAW_PI_OVER_TWO;
-  float half_res = (float)(resolution >> 1);
-  float prev_y   = -1.0;
-  float prev_r   = 0.0f;
-  dd_vec3_t pt_a, pt_b, pt_c;
-  dd_vec3_t normal;
+  dd_cmd_t* cmd = ctx->cur_cmd;
+  dd_mat4_t mvp =
+    dd_mat4_transpose(dd_mat4_mul(ctx->proj, dd_mat4_mul(ctx->view, cmd->xform)));
 
-  for (int32_t i = 1; i <= half_res; ++i)
-  {
-    float phi    = ((i / half_res) * 2.0f - 1.0f) * half_pi;
-    float curr_r = DBGDRAW_COS(phi) * radius;
-    float curr_y = DBGDRAW_SIN(phi);
+  float width  = ctx->viewport.z > 0.0f ? ctx->viewport.z : 1.0f;
+  float height = ctx->viewport.w > 0.0f ? ctx->viewport.w : 1.0f;
+  float margin =
+    ctx->primitive_size + DD_MAX(cmd->aa_radius.x, cmd->aa_radius.y) + 1.0f;
+  float l = 2.0f * (cmd->clip_rect.x - margin) / width - 1.0f;
+  float r = 2.0f * (cmd->clip_rect.x + cmd->clip_rect.z + margin) / width - 1.0f;
+  float t = 1.0f - 2.0f * (cmd->clip_rect.y - margin) / height;
+  float b = 1.0f - 2.0f * (cmd->clip_rect.y + cmd->clip_rect.w + margin) / height;
 
-    float prev_x = 1.0f;
-    float prev_z = 0.0f;
+  ctx->clip_planes[0] = dd_vec4_sub(mvp.col[0], dd_vec4_scalar_mul(mvp.col[3], l));
+  ctx->clip_planes[1] = dd_vec4_sub(dd_vec4_scalar_mul(mvp.col[3], r), mvp.col[0]);
+  ctx->clip_planes[2] = dd_vec4_sub(mvp.col[1], dd_vec4_scalar_mul(mvp.col[3], b));
+  ctx->clip_planes[3] = dd_vec4_sub(dd_vec4_scalar_mul(mvp.col[3], t), mvp.col[1]);
+  for (int32_t i = 0; i < 4; ++i) { dd__normalize_plane(&ctx->clip_planes[i]); }
+}
 
-    for (int32_t j = 1; j <= resolution; ++j)
+// False if the sphere is fully outside of the clip rect of the command
+int32_t
+dd__clip_sphere_test(dd_ctx_t* ctx, dd_vec3_t c, float radius)
+{
+  if (ctx->cur_cmd->clip_rect.z <= 0.0f) { return true; }
+  if (ctx->cur_cmd->instance_count > 0) { return true; }
+  dd_vec4_t xc = dd_vec4(c.x, c.y, c.z, 1.0f);
+  for (int32_t i = 0; i < 4; ++i)
+  {
+    if (dd_vec4_dot(xc, ctx->clip_planes[i]) <= -radius)
     {
-      float theta  = (j / (float)resolution) * (float)DBGDRAW_TWO_PI;
-      float curr_z = DBGDRAW_SIN(theta);
-      float curr_x = DBGDRAW_COS(theta);
+      DBGDRAW_STATS(ctx->stats.culled_clip_count++);
+      return false;
+    }
+  }
+  return true;
+}
+
+// False if all points are outside of the same edge of the clip rect
+int32_t
+dd__clip_points_test(dd_ctx_t* ctx, const dd_vec3_t* pts, int32_t count)
+{
+  if (ctx->cur_cmd->clip_rect.z <= 0.0f) { return true; }
+  if (ctx->cur_cmd->instance_count > 0) { return true; }
+  for (int32_t i = 0; i < 4; ++i)
+  {
+    dd_vec4_t plane = ctx->clip_planes[i];
+    int32_t j       = 0;
+    while (j < count &&
+           dd_vec4_dot(dd_vec4(pts[j].x, pts[j].y, pts[j].z, 1.0f), plane) < 0)
+    {
+      j++;
+    }
+    if (j == count)
+    {
+      DBGDRAW_STATS(ctx->stats.culled_clip_count++);
+      return false;
+    }
+  }
+  return true;
+}
+
+int32_t
+dd__frustum_sphere_test(dd_ctx_t* ctx, dd_vec3_t c, float radius)
+{
+  if (!ctx->frustum_cull) { return true; }
+  dd_vec4_t xc = dd_mat4_vec4_mul(ctx->xform, dd_vec4(c.x, c.y, c.z, 1.0));
+  for (int32_t i = 0; i < 6; ++i)
+  {
+    float dot = dd_vec4_dot(xc, ctx->frustum_planes[i]);
+    if (dot <= -radius)
+    {
+      DBGDRAW_STATS(ctx->stats.culled_sphere_count++);
+      return false;
+    }
+  }
+  return true;
+}
+
+int32_t
+dd__frustum_aabb_test(dd_ctx_t* ctx, dd_vec3_t min, dd_vec3_t max)
+{
+  if (!ctx->frustum_cull) { return true; }
+  dd_vec4_t min_pt =
+    dd_mat4_vec4_mul(ctx->xform, dd_vec4(min.x, min.y, min.z, 1.0));
+  dd_vec4_t max_pt =
+    dd_mat4_vec4_mul(ctx->xform, dd_vec4(max.x, max.y, max.z, 1.0));
+  for (int32_t i = 0; i < 6; ++i)
+  {
+    const dd_vec4_t plane = ctx->frustum_planes[i];
+    float d               = DD_MAX(min_pt.x * plane.x, max_pt.x * plane.x) +
+              DD_MAX(min_pt.y * plane.y, max_pt.y * plane.y) +
+              DD_MAX(min_pt.z * plane.z, max_pt.z * plane.z) + plane.w;
+
+    if (d < 0.0f)
+    {
+      DBGDRAW_STATS(ctx->stats.culled_aabb_count++);
+      return false;
+    }
+  }
+  return true;
+}
+
+int32_t
+dd__frustum_obb_test(dd_ctx_t* ctx, dd_vec3_t c, dd_mat3_t axes)
+{
+  if (!ctx->frustum_cull) { return true; }
+
+  dd_vec4_t xc = dd_mat4_vec4_mul(ctx->xform, dd_vec4(c.x, c.y, c.z, 1.0));
+  dd_vec4_t xu =
+    dd_mat4_vec4_mul(ctx->xform,
+                     dd_vec4(axes.col[0].x, axes.col[0].y, axes.col[0].z, 0.0));
+  dd_vec4_t xv =
+    dd_mat4_vec4_mul(ctx->xform,
+                     dd_vec4(axes.col[1].x, axes.col[1].y, axes.col[1].z, 0.0));
+  dd_vec4_t xn =
+    dd_mat4_vec4_mul(ctx->xform,
+                     dd_vec4(axes.col[2].x, axes.col[2].y, axes.col[2].z, 0.0));
+  for (int32_t i = 0; i < 6; ++i)
+  {
+    const dd_vec4_t plane = ctx->frustum_planes[i];
+
+    float pdotu = DD_ABS(dd_vec4_dot(plane, xu));
+    float pdotv = DD_ABS(dd_vec4_dot(plane, xv));
+    float pdotn = DD_ABS(dd_vec4_dot(plane, xn));
+
+    float effective_radius = (pdotu + pdotv + pdotn);
+
+    float dot = dd_vec4_dot(xc, ctx->frustum_planes[i]);
+    if (dot <= -effective_radius)
+    {
+      DBGDRAW_STATS(ctx->stats.culled_obb_count++);
+      return false;
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper functions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float
+dd__pixels_to_world_size(dd_ctx_t* ctx, dd_vec3_t pos, float pixels)
+{
+  DBGDRAW_ASSERT(ctx);
+
+  dd_vec3_t v           = dd_vec3_sub(pos, ctx->view_origin);
+  float dist            = ctx->is_ortho ? 1.0f : dd_vec3_norm(v);
+  float viewport_height = ctx->viewport.w;
+  float projected_size  = ctx->proj_scale_y * (pixels / viewport_height);
+  return dist * projected_size;
+}
+
+float
+dd__world_size_to_pixels(dd_ctx_t* ctx, dd_vec3_t pos, float size)
+{
+  DBGDRAW_ASSERT(ctx);
+
+  float dist =
+    ctx->is_ortho ? 1.0f : dd_vec3_norm(dd_vec3_sub(pos, ctx->view_origin));
+  float viewport_height = ctx->viewport.w - ctx->viewport.y;
+  return (size * viewport_height) / dist / ctx->proj_scale_y;
+}
+
+void
+dd__transform_verts(dd_mat4_t xform,
+                    dd_vertex_t* start,
+                    dd_vertex_t* end,
+                    bool normals)
+{
+  dd_mat4_t normal_mat = dd_mat4_identity();
+  if (normals) normal_mat = dd_mat4_transpose(dd_mat4_se3_inverse(xform));
+  for (dd_vertex_t* it = start; it != end; it++)
+  {
+    dd_vec3_t pos = dd_mat4_vec3_mul(xform, dd_vec4_to_vec3(it->pos_size), 1);
+    it->pos_size  = dd_vec4(pos.x, pos.y, pos.z, it->pos_size.w);
+    if (normals)
+    {
+      dd_vec3_t normal = dd_mat4_vec3_mul(normal_mat, it->normal, 0);
+      it->normal       = normal;
+    }
+  }
+}
+
+dd_mat3_t
+dd__get_view_aligned_basis(dd_ctx_t* ctx, dd_vec3_t p)
+{
+  DBGDRAW_ASSERT(ctx);
+  dd_mat3_t m;
+  dd_mat4_t inv_view = dd_mat4_se3_inverse(ctx->view);
+
+  if (!ctx->is_ortho)
+  {
+    dd_vec3_t u = dd_vec4_to_vec3(inv_view.col[1]);
+    dd_vec3_t v = dd_vec4_to_vec3(inv_view.col[3]);
+
+    m.col[2] = dd_vec3_normalize(dd_vec3_sub(v, p));
+
+    m.col[0] = dd_vec3_normalize(dd_vec3_cross(u, m.col[2]));
+    m.col[1] = dd_vec3_cross(m.col[0], m.col[2]);
+  }
+  else
+  {
+    m        = dd_mat4_to_mat3(inv_view);
+    m.col[1] = dd_vec3_invert(m.col[1]);
+  }
+  return m;
+}
+
+// NOTE(maciej):
+// Idea here is to calculate transformation that will map a cylinder with ends
+// at (0,0,0) and (0,1,0) and radius 1 to a cylinder with endpoints q0 and q1
+// and radius "radius"
+dd_mat4_t
+dd__generate_cone_orientation(dd_vec3_t q0, dd_vec3_t q1)
+{
+  dd_vec3_t n  = dd_vec3_sub(q1, q0);
+  dd_vec3_t u0 = dd_vec3(n.z, n.z, -n.x - n.y);
+  dd_vec3_t u1 = dd_vec3(-n.y - n.z, n.x, n.x);
+  dd_vec3_t u  = ((n.z != 0) && (-n.x != n.y)) ? u0 : u1;
+  dd_vec3_t v  = dd_vec3_cross(u, n);
+
+  n = dd_vec3_normalize(n);
+  u = dd_vec3_normalize(u);
+  v = dd_vec3_normalize(v);
+
+  dd_mat4_t rot = dd_mat4_identity();
+  rot.col[0]    = dd_vec3_to_vec4(u);
+  rot.col[1]    = dd_vec3_to_vec4(n);
+  rot.col[2]    = dd_vec3_to_vec4(v);
+  float det     = dd_mat4_determinant(rot);
+  rot.col[2]    = dd_vec4_scalar_mul(rot.col[2], det);
+
+  return rot;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Private Draw Commands
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void
+dd__vertex(dd_ctx_t* ctx, dd_vec3_t* pt)
+{
+  float sz             = ctx->primitive_size;
+  dd_color_t out_color = ctx->color;
+
+  if (ctx->fill_type == DBGDRAW_FILL_LINEAR_GRADIENT)
+  {
+    dd_vec3_t ba  = dd_vec3_sub(ctx->gradient_b_pt, ctx->gradient_a_pt);
+    dd_vec3_t pa  = dd_vec3_sub(*pt, ctx->gradient_a_pt);
+    float dot     = dd_vec3_dot(pa, ba);
+    float ba_norm = dd_vec3_norm_sq(ba);
+    float t       = DD_MAX(DD_MIN(dot / ba_norm, 1.0f), 0.0f);
+    dd_color_t gradient_color =
+      dd_interpolate_color(ctx->gradient_a_col, ctx->gradient_b_col, t);
+    out_color = gradient_color;
+  }
+  ctx->verts_data[ctx->verts_len++] =
+    (dd_vertex_t) {.pos_size = {{pt->x, pt->y, pt->z, sz}}, .col = out_color};
+  ctx->cur_cmd->vertex_count++;
+}
+
+void
+dd__vertex2d(dd_ctx_t* ctx, dd_vec2_t* pt)
+{
+  float sz             = ctx->primitive_size;
+  dd_color_t out_color = ctx->color;
+
+  if (ctx->fill_type == DBGDRAW_FILL_LINEAR_GRADIENT)
+  {
+    dd_vec2_t grad_a_pt2d = dd_vec2(ctx->gradient_a_pt.x, ctx->gradient_a_pt.y);
+    dd_vec2_t grad_b_pt2d = dd_vec2(ctx->gradient_b_pt.x, ctx->gradient_b_pt.y);
+    dd_vec2_t ba          = dd_vec2_sub(grad_b_pt2d, grad_a_pt2d);
+    dd_vec2_t pa          = dd_vec2_sub(*pt, grad_a_pt2d);
+    float dot             = dd_vec2_dot(pa, ba);
+    float ba_norm         = dd_vec2_norm_sq(ba);
+    float t               = DD_MAX(DD_MIN(dot / ba_norm, 1.0f), 0.0f);
+    dd_color_t gradient_color =
+      dd_interpolate_color(ctx->gradient_a_col, ctx->gradient_b_col, t);
+    out_color = gradient_color;
+  }
+  ctx->verts_data[ctx->verts_len++] =
+    (dd_vertex_t) {.pos_size = {{pt->x, pt->y, 0.0, sz}}, .col = out_color};
+  ctx->cur_cmd->vertex_count++;
+}
+
+void
+dd__vertex_normal(dd_ctx_t* ctx, dd_vec3_t* pt, dd_vec3_t* nor)
+{
+  float sz                          = ctx->primitive_size;
+  ctx->verts_data[ctx->verts_len++] = (dd_vertex_t) {
+    .pos_size = {{pt->x, pt->y, pt->z, sz}},
+    .normal   = {{nor->x, nor->y, nor->z}},
+    .col      = ctx->color,
+  };
+  ctx->cur_cmd->vertex_count++;
+}
+
+void
+dd__vertex_text(dd_ctx_t* ctx, dd_vec3_t* pt, dd_vec2_t* uv)
+{
+  dd_color_t c = ctx->color;
+  float sz     = ctx->primitive_size;
+  dd_vertex_t* v = ctx->verts_data + ctx->verts_len++;
+  *v             = (dd_vertex_t) {.pos_size = {{pt->x, pt->y, pt->z, sz}},
+                                  .uv       = {{uv->x, uv->y}},
+                                  .col      = c};
+  v->font        = (float)ctx->active_font_idx;
+  ctx->cur_cmd->vertex_count++;
+}
+
+void
+dd__line(dd_ctx_t* ctx, dd_vec3_t* pt_a, dd_vec3_t* pt_b)
+{
+  dd__vertex(ctx, pt_a);
+  dd__vertex(ctx, pt_b);
+}
+
+void
+dd__triangle(dd_ctx_t* ctx, dd_vec3_t* pt_a, dd_vec3_t* pt_b, dd_vec3_t* pt_c)
+{
+  dd__vertex(ctx, pt_a);
+  dd__vertex(ctx, pt_b);
+  dd__vertex(ctx, pt_c);
+}
+
+void
+dd__triangle_normal(dd_ctx_t* ctx,
+                    dd_vec3_t* pt_a,
+                    dd_vec3_t* pt_b,
+                    dd_vec3_t* pt_c,
+                    dd_vec3_t* normal)
+{
+  dd__vertex_normal(ctx, pt_a, normal);
+  dd__vertex_normal(ctx, pt_b, normal);
+  dd__vertex_normal(ctx, pt_c, normal);
+}
+
+void
+dd__quad_point(dd_ctx_t* ctx,
+               dd_vec3_t* pt_a,
+               dd_vec3_t* pt_b,
+               dd_vec3_t* pt_c,
+               dd_vec3_t* pt_d)
+{
+  dd__vertex(ctx, pt_a);
+  dd__vertex(ctx, pt_b);
+  dd__vertex(ctx, pt_c);
+  dd__vertex(ctx, pt_d);
+}
+
+void
+dd__quad_stroke(dd_ctx_t* ctx,
+                dd_vec3_t* pt_a,
+                dd_vec3_t* pt_b,
+                dd_vec3_t* pt_c,
+                dd_vec3_t* pt_d)
+{
+  dd__line(ctx, pt_a, pt_b);
+  dd__line(ctx, pt_b, pt_c);
+  dd__line(ctx, pt_c, pt_d);
+  dd__line(ctx, pt_d, pt_a);
+}
+
+void
+dd__quad_fill(dd_ctx_t* ctx,
+              dd_vec3_t* pt_a,
+              dd_vec3_t* pt_b,
+              dd_vec3_t* pt_c,
+              dd_vec3_t* pt_d)
+{
+  switch (ctx->cur_cmd->shading_type)
+  {
+    case DBGDRAW_SHADING_SOLID:
+    {
+      dd_vec3_t normal = dd_vec3_normalize(
+        dd_vec3_cross(dd_vec3_sub(*pt_c, *pt_a), dd_vec3_sub(*pt_b, *pt_a)));
+      dd__triangle_normal(ctx, pt_a, pt_b, pt_c, &normal);
+      dd__triangle_normal(ctx, pt_a, pt_c, pt_d, &normal);
+    }
+    break;
+
+    default:
+    {
+      dd__triangle(ctx, pt_a, pt_b, pt_c);
+      dd__triangle(ctx, pt_a, pt_c, pt_d);
+    }
+    break;
+  }
+}
+
+void
+dd__quad(dd_ctx_t* ctx,
+         dd_vec3_t* pt_a,
+         dd_vec3_t* pt_b,
+         dd_vec3_t* pt_c,
+         dd_vec3_t* pt_d)
+{
+  switch (ctx->cur_cmd->draw_mode)
+  {
+    case DBGDRAW_MODE_POINT:
+      dd__quad_point(ctx, pt_a, pt_b, pt_c, pt_d);
+      break;
+    case DBGDRAW_MODE_STROKE:
+      dd__quad_stroke(ctx, pt_a, pt_b, pt_c, pt_d);
+      break;
+    case DBGDRAW_MODE_FILL:
+      dd__quad_fill(ctx, pt_a, pt_b, pt_c, pt_d);
+      break;
+    default:
+      break;
+  }
+}
+
+void
+dd__box_point(dd_ctx_t* ctx, dd_vec3_t* pts)
+{
+  dd__vertex(ctx, pts + 0);
+  dd__vertex(ctx, pts + 1);
+  dd__vertex(ctx, pts + 2);
+  dd__vertex(ctx, pts + 3);
+
+  dd__vertex(ctx, pts + 4);
+  dd__vertex(ctx, pts + 5);
+  dd__vertex(ctx, pts + 6);
+  dd__vertex(ctx, pts + 7);
+}
+
+void
+dd__box_stroke(dd_ctx_t* ctx, dd_vec3_t* pts)
+{
+  dd__quad_stroke(ctx, pts + 0, pts + 1, pts + 2, pts + 3);
+  dd__quad_stroke(ctx, pts + 4, pts + 5, pts + 6, pts + 7);
+
+  dd__line(ctx, pts + 0, pts + 5);
+  dd__line(ctx, pts + 1, pts + 4);
+  dd__line(ctx, pts + 2, pts + 7);
+  dd__line(ctx, pts + 3, pts + 6);
+}
+
+void
+dd__box_fill(dd_ctx_t* ctx, dd_vec3_t* pts)
+{
+  dd__quad_fill(ctx, pts + 0, pts + 1, pts + 2, pts + 3);
+  dd__quad_fill(ctx, pts + 4, pts + 5, pts + 6, pts + 7);
+
+  dd__quad_fill(ctx, pts + 5, pts + 4, pts + 1, pts + 0);
+  dd__quad_fill(ctx, pts + 5, pts + 0, pts + 3, pts + 6);
+  dd__quad_fill(ctx, pts + 7, pts + 6, pts + 3, pts + 2);
+  dd__quad_fill(ctx, pts + 1, pts + 4, pts + 7, pts + 2);
+}
+
+void
+dd__box(dd_ctx_t* ctx, dd_vec3_t* pts)
+{
+  switch (ctx->cur_cmd->draw_mode)
+  {
+    case DBGDRAW_MODE_POINT:
+      dd__box_point(ctx, pts);
+      break;
+    case DBGDRAW_MODE_STROKE:
+      dd__box_stroke(ctx, pts);
+      break;
+    case DBGDRAW_MODE_FILL:
+      dd__box_fill(ctx, pts);
+      break;
+    default:
+      break;
+  }
+}
+
+void
+dd__arc_point(dd_ctx_t* ctx,
+              dd_vec3_t* center,
+              float radius,
+              float theta,
+              int32_t resolution)
+{
+  resolution          = DD_MAX(4, resolution);
+  float d_theta       = theta / resolution;
+  int32_t full_circle = (int32_t)(!(theta < DBGDRAW_TWO_PI));
+
+  if (!full_circle) { dd__vertex(ctx, center); }
+
+#if 0
+//TODO(maciej): Since transcendentals are so slow, we could precompute some data
+// using simd instructions
+  __m128 wide_x = _mm_set_ps(0.0f, 1.57f, 3.143f, 0.707f);
+  __m128 wide_cosx;
+  __m128 wide_sinx = _mm_sincos_ps(&wide_cosx, wide_x);
+  float sin_x[4];
+  float cos_x[4];
+  _mm_store_ps(sin_x, wide_sinx);
+  _mm_store_ps(cos_x, wide_cosx);
+#endif
+
+  float theta1;
+  float ox1 = 0.0f, oy1 = 0.0f;
+  int32_t final_res = full_circle ? resolution : resolution + 1;
+  dd_vec3_t pt      = dd_vec3(0.0f, 0.0f, center->z);
+  for (int32_t i = 0; i < final_res; ++i)
+  {
+    theta1 = i * d_theta;
+    ox1    = radius * DBGDRAW_SIN(theta1);
+    oy1    = radius * DBGDRAW_COS(theta1);
+
+    pt.x = center->x + ox1;
+    pt.y = center->y + oy1;
+    dd__vertex(ctx, &pt);
+  }
+}
+
+void
+dd__arc_stroke(dd_ctx_t* ctx,
+               dd_vec3_t* center,
+               float radius,
+               float theta,
+               int32_t resolution)
+{
+  dd_vec3_t pt_a = dd_vec3(center->x, center->y, center->z);
+  dd_vec3_t pt_b = dd_vec3(center->x, center->y + radius, center->z);
+
+  int32_t init_offset = ctx->cur_cmd->base_index + ctx->cur_cmd->vertex_count;
+  int32_t full_circle = (int32_t)(!(theta < DBGDRAW_TWO_PI));
+  if (!full_circle) { dd__line(ctx, &pt_a, &pt_b); }
+  else
+  {
+    resolution += 1;
+  }
+
+  int32_t mod   = full_circle ? -1 : 0;
+  float d_theta = theta / (resolution + mod);
+
+  float theta1, theta2;
+  float ox1, ox2, oy1, oy2;
+  ox1 = ox2 = oy1 = oy2 = 0.0f;
+  for (int32_t i = 0; i < resolution; ++i)
+  {
+    theta1 = i * d_theta;
+    theta2 = (i + 1) * d_theta;
+    ox1    = radius * DBGDRAW_SIN(theta1);
+    ox2    = radius * DBGDRAW_SIN(theta2);
+    oy1    = radius * DBGDRAW_COS(theta1);
+    oy2    = radius * DBGDRAW_COS(theta2);
+
+    pt_a.x = center->x + ox1;
+    pt_a.y = center->y + oy1;
+    pt_b.x = center->x + ox2;
+    pt_b.y = center->y + oy2;
+    dd__line(ctx, &pt_a, &pt_b);
+  }
+
+  if (!full_circle)
+  {
+    pt_a.x = center->x;
+    pt_a.y = center->y;
+    pt_b.x = center->x + ox2;
+    pt_b.y = center->y + oy2;
+    dd__line(ctx, &pt_b, &pt_a);
+  }
+  else
+  {
+    /* This is an ugly fix to allow non-broken lines.
+       We add an extra segment, and we modify its positions to lie on a segment,
+       not vertex. */
+    dd_vertex_t* v1 = ctx->verts_data + init_offset;
+    dd_vertex_t* v2 = v1 + 1;
+    dd_vec3_t p1    = v1->pos;
+    dd_vec3_t p2    = v2->pos;
+    v1->pos =
+      dd_vec3(0.5f * (p1.x + p2.x), 0.5f * (p1.y + p2.y), 0.5f * (p1.z + p2.z));
+
+    v1 = ctx->verts_data + ctx->cur_cmd->base_index +
+         ctx->cur_cmd->vertex_count - 2;
+    v2 = v1 + 1;
+    p1 = v1->pos;
+    p2 = v2->pos;
+    v2->pos =
+      dd_vec3(0.5f * (p1.x + p2.x), 0.5f * (p1.y + p2.y), 0.5f * (p1.z + p2.z));
+  }
+}
+
+void
+dd__arc_fill(dd_ctx_t* ctx,
+             dd_vec3_t* center,
+             float radius,
+             float theta,
+             int32_t resolution,
+             uint8_t flip)
+{
+  float d_theta = theta / resolution;
+
+  float theta1, theta2;
+  float ox1, ox2, oy1, oy2;
+  ox1 = ox2 = oy1 = oy2 = 0.0f;
+  dd_vec3_t pt_a        = dd_vec3(0.0f, 0.0f, center->z);
+  dd_vec3_t pt_b        = dd_vec3(0.0f, 0.0f, center->z);
+  dd_vec3_t normal;
+  for (int32_t i = 0; i < resolution; ++i)
+  {
+    theta1 = i * d_theta;
+    theta2 = (i + 1) * d_theta;
+    ox1    = radius * DBGDRAW_SIN(theta1);
+    ox2    = radius * DBGDRAW_SIN(theta2);
+    oy1    = radius * DBGDRAW_COS(theta1);
+    oy2    = radius * DBGDRAW_COS(theta2);
+
+    pt_a.x = center->x + ox2;
+    pt_a.y = center->y + oy2;
+    pt_b.x = center->x + ox1;
+    pt_b.y = center->y + oy1;
+    if (i == 0 && ctx->cur_cmd->shading_type)
+    {
+      normal = dd_vec3_normalize(
+        dd_vec3_cross(dd_vec3_sub(pt_b, *center), dd_vec3_sub(pt_a, *center)));
+      if (flip) { normal = dd_vec3(-normal.x, -normal.y, -normal.z); }
+    }
+
+    if (flip)
+    {
+      if (ctx->cur_cmd->shading_type)
+      {
+        dd__triangle_normal(ctx, center, &pt_b, &pt_a, &normal);
+      }
+      else
+      {
+        dd__triangle(ctx, center, &pt_b, &pt_a);
+      }
+    }
+    else
+    {
+      if (ctx->cur_cmd->shading_type)
+      {
+        dd__triangle_normal(ctx, center, &pt_a, &pt_b, &normal);
+      }
+      else
+      {
+        dd__triangle(ctx, center, &pt_a, &pt_b);
+      }
+    }
+  }
+  // printf("%f %f %f\n", normal.x, normal.y, normal.y);
+}
+
+void
+dd__arc(dd_ctx_t* ctx,
+        dd_vec3_t* center,
+        float radius,
+        float theta,
+        int32_t resolution,
+        uint8_t flip)
+{
+  switch (ctx->cur_cmd->draw_mode)
+  {
+    case DBGDRAW_MODE_POINT:
+      dd__arc_point(ctx, center, radius, theta, resolution >> 1);
+      break;
+    case DBGDRAW_MODE_STROKE:
+      dd__arc_stroke(ctx, center, radius, theta, resolution);
+      break;
+    case DBGDRAW_MODE_FILL:
+      dd__arc_fill(ctx, center, radius, theta, resolution, flip);
+      break;
+    default:
+      break;
+  }
+}
+
+// NOTE(maciej): dd_arc(...) deals with both points and strokes
+void
+dd__sphere_point_stroke(dd_ctx_t* ctx,
+                        dd_vec3_t* center,
+                        float radius,
+                        int32_t resolution)
+{
+  /* Store initial state */
+  const int32_t n_rings = 3;
+  dd_vertex_t* base_ptr = ctx->verts_data + ctx->verts_len;
+
+  /* Create unit circle, and get data boundaries */
+  dd_vertex_t* start_ptr = base_ptr;
+  dd_vec3_t zero_pt      = dd_vec3(0.0f, 0.0f, 0.0f);
+  dd__arc(ctx, &zero_pt, 1.0f, (float)DBGDRAW_TWO_PI, resolution, 0);
+  dd_vertex_t* end_ptr = ctx->verts_data + ctx->verts_len;
+  int32_t len          = (int32_t)(end_ptr - start_ptr);
+  int32_t new_verts    = n_rings * len;
+
+  /* Copy the memory, so that we have all the rings we need. */
+  for (int32_t i = 1; i < n_rings; ++i)
+  {
+    memcpy(end_ptr, start_ptr, len * sizeof(dd_vertex_t));
+    end_ptr += len;
+    start_ptr += len;
+  }
+
+  dd_mat4_t xform;
+
+  /* Circle A */
+  xform     = dd_pre_scale(dd_mat4_identity(), dd_vec3(radius, radius, radius));
+  xform     = dd_pre_translate(xform, *center);
+  start_ptr = base_ptr;
+  end_ptr   = start_ptr + len;
+  dd__transform_verts(xform, start_ptr, end_ptr, 0);
+
+  /* Circle B */
+  xform = dd_pre_scale(dd_mat4_identity(), dd_vec3(radius, radius, radius));
+  xform = dd_pre_rotate(xform, (float)DBGDRAW_PI_OVER_TWO, dd_vec3(1, 0, 0));
+  xform = dd_pre_translate(xform, *center);
+  start_ptr = end_ptr;
+  end_ptr   = start_ptr + len;
+  dd__transform_verts(xform, start_ptr, end_ptr, 0);
+
+  /* Circle C */
+  xform = dd_pre_scale(dd_mat4_identity(), dd_vec3(radius, radius, radius));
+  xform = dd_pre_rotate(xform, (float)DBGDRAW_PI_OVER_TWO, dd_vec3(0, 1, 0));
+  xform = dd_pre_translate(xform, *center);
+  start_ptr = end_ptr;
+  end_ptr   = start_ptr + len;
+  dd__transform_verts(xform, start_ptr, end_ptr, 0);
+
+  /* Tell the context that there is new vertex data */
+  ctx->verts_len += (new_verts - (int32_t)len);
+  ctx->cur_cmd->vertex_count += (new_verts - (int32_t)len);
+}
+
+void
+dd__sphere_fill(dd_ctx_t* ctx, dd_vec3_t* c, float radius, int32_t resolution)
+{
+  float half_pi  = (float)DBGDRAW_PI_OVER_TWO;
+  float half_res = (float)(resolution >> 1);
+  float prev_y   = -1.0;
+  float prev_r   = 0.0f;
+  dd_vec3_t pt_a, pt_b, pt_c;
+  dd_vec3_t normal;
+
+  for (int32_t i = 1; i <= half_res; ++i)
+  {
+    float phi    = ((i / half_res) * 2.0f - 1.0f) * half_pi;
+    float curr_r = DBGDRAW_COS(phi) * radius;
+    float curr_y = DBGDRAW_SIN(phi);
+
+    float prev_x = 1.0f;
+    float prev_z = 0.0f;
+
+    for (int32_t j = 1; j <= resolution; ++j)
+    {
+      float theta  = (j / (float)resolution) * (float)DBGDRAW_TWO_PI;
+      float curr_z = DBGDRAW_SIN(theta);
+      float curr_x = DBGDRAW_COS(theta);
+
+      pt_a = dd_vec3(c->x + prev_x * prev_r,
+                     c->y + prev_y * radius,
+                     c->z + prev_z * prev_r);
+      pt_b = dd_vec3(c->x + prev_x * curr_r,
+                     c->y + curr_y * radius,
+                     c->z + prev_z * curr_r);
+      pt_c = dd_vec3(c->x + curr_x * curr_r,
+                     c->y + curr_y * radius,
+                     c->z + curr_z * curr_r);
+
+      if (ctx->cur_cmd->shading_type != DBGDRAW_SHADING_NONE)
+      {
+        if (i != half_res)
+        {
+          normal = dd_vec3_normalize(
+            dd_vec3_cross(dd_vec3_sub(pt_c, pt_a), dd_vec3_sub(pt_b, pt_a)));
+        }
+        dd__triangle_normal(ctx, &pt_a, &pt_b, &pt_c, &normal);
+      }
+      else
+      {
+        dd__triangle(ctx, &pt_a, &pt_b, &pt_c);
+      }
+
+      pt_a = dd_vec3(c->x + prev_x * prev_r,
+                     c->y + prev_y * radius,
+                     c->z + prev_z * prev_r);
+      pt_b = dd_vec3(c->x + curr_x * curr_r,
+                     c->y + curr_y * radius,
+                     c->z + curr_z * curr_r);
+      pt_c = dd_vec3(c->x + curr_x * prev_r,
+                     c->y + prev_y * radius,
+                     c->z + curr_z * prev_r);
+
+      if (ctx->cur_cmd->shading_type != DBGDRAW_SHADING_NONE)
+      {
+        if (i == half_res)
+        {
+          normal = dd_vec3_normalize(
+            dd_vec3_cross(dd_vec3_sub(pt_c, pt_a), dd_vec3_sub(pt_b, pt_a)));
+        }
+        dd__triangle_normal(ctx, &pt_a, &pt_b, &pt_c, &normal);
+      }
+      else
+      {
+        dd__triangle(ctx, &pt_a, &pt_b, &pt_c);
+      }
+
+      prev_x = curr_x;
+      prev_z = curr_z;
+    }
+    prev_y = curr_y;
+    prev_r = curr_r;
+  }
+}
+
+void
+dd__sphere(dd_ctx_t* ctx, dd_vec3_t* center, float radius, int32_t resolution)
+{
+  switch (ctx->cur_cmd->draw_mode)
+  {
+    case DBGDRAW_MODE_POINT:
+    case DBGDRAW_MODE_STROKE:
+      dd__sphere_point_stroke(ctx, center, radius, resolution);
+      break;
+    case DBGDRAW_MODE_FILL:
+      dd__sphere_fill(ctx, center, radius, resolution);
+      break;
+    default:
+      break;
+  }
+}
+
+// NOTE(maciej): This transformation will transform a cone with a radius 1 base
+// at (0,0,0) and apex at (0, 0, 1) to a
+//               cone that has base at p and oriented as specified by rot, with
+//               height and radius controlled by parameters.
+dd_mat4_t
+dd__get_cone_xform(dd_vec3_t p, dd_mat4_t rot, float radius, float height)
+{
+  dd_mat4_t xform = dd_pre_rotate(dd_mat4_identity(),
+                                  (float)DBGDRAW_PI_OVER_TWO,
+                                  dd_vec3(-1.0f, 0.0f, 0.0f));
+  xform           = dd_pre_scale(xform, dd_vec3(radius, height, radius));
+  xform           = dd_mat4_mul(rot, xform);
+
+  xform = dd_pre_translate(xform, p);
+  return xform;
+}
+
+void
+dd__cone(dd_ctx_t* ctx,
+         dd_vec3_t a,
+         dd_vec3_t b,
+         float radius,
+         int32_t resolution)
+{
+  dd_mat4_t rot    = dd__generate_cone_orientation(a, b);
+  float height     = dd_vec3_norm(dd_vec3_sub(a, b));
+  bool has_normals = ctx->cur_cmd->draw_mode == DBGDRAW_MODE_FILL &&
+                     ctx->cur_cmd->shading_type != DBGDRAW_SHADING_NONE;
+
+  dd_mat4_t xform = dd__get_cone_xform(a, rot, radius, height);
+
+  dd_vec3_t zero_pt      = dd_vec3(0.0f, 0.0f, 0.0f);
+  dd_vertex_t* start_ptr = ctx->verts_data + ctx->verts_len;
+  dd__arc(ctx, &zero_pt, 1.0, (float)DBGDRAW_TWO_PI, resolution, 1);
+  dd_vertex_t* end_ptr = ctx->verts_data + ctx->verts_len;
+  dd__transform_verts(xform, start_ptr, end_ptr, has_normals);
+
+  dd_vec3_t apex = dd_mat4_vec3_mul(xform, dd_vec3(0.0, 0.0, 1.0), 1);
+
+  switch (ctx->cur_cmd->draw_mode)
+  {
+    case DBGDRAW_MODE_POINT:
+      dd__vertex(ctx, &apex);
+      break;
+    case DBGDRAW_MODE_STROKE:
+      for (int32_t i = 0; i < (resolution >> 1); ++i)
+      {
+        dd_vec3_t pt = dd_vec4_to_vec3(start_ptr->pos_size);
+        dd__line(ctx, &pt, &apex);
+        start_ptr += 4;
+      }
+      break;
+    case DBGDRAW_MODE_FILL:
+      for (int32_t i = 0; i < resolution; ++i)
+      {
+        start_ptr++;
+        dd_vec3_t p1 = dd_vec4_to_vec3(start_ptr->pos_size);
+        start_ptr++;
+        dd_vec3_t p2 = dd_vec4_to_vec3(start_ptr->pos_size);
+        start_ptr++;
+        if (has_normals)
+        {
+          dd_vec3_t normal = dd_vec3_normalize(
+            dd_vec3_cross(dd_vec3_sub(p1, apex), dd_vec3_sub(p2, apex)));
+          dd__triangle_normal(ctx, &p2, &p1, &apex, &normal);
+        }
+        else
+        {
+          dd__triangle(ctx, &p2, &p1, &apex);
+        }
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void
+dd__conical_frustum(dd_ctx_t* ctx,
+                    dd_vec3_t a,
+                    dd_vec3_t b,
+                    float radius_a,
+                    float radius_b,
+                    int32_t resolution)
+{
+  dd_mat4_t rot    = dd__generate_cone_orientation(a, b);
+  float height     = dd_vec3_norm(dd_vec3_sub(a, b));
+  bool has_normals = ctx->cur_cmd->draw_mode == DBGDRAW_MODE_FILL &&
+                     ctx->cur_cmd->shading_type != DBGDRAW_SHADING_NONE;
+  dd_vec3_t pt_bottom = dd_vec3(0.0f, 0.0f, 0.0f);
+  dd_vec3_t pt_top    = dd_vec3(0.0f, 0.0f, 1.0f);
+
+  dd_mat4_t xform_a = dd__get_cone_xform(a, rot, radius_a, height);
+  dd_mat4_t xform_b = dd__get_cone_xform(a, rot, radius_b, height);
+
+  dd_vertex_t* start_ptr_1 = ctx->verts_data + ctx->verts_len;
+  dd__arc(ctx, &pt_bottom, 1.0f, (float)DBGDRAW_TWO_PI, resolution, 1);
+  dd_vertex_t* end_ptr_1 = ctx->verts_data + ctx->verts_len;
+  dd__transform_verts(xform_a, start_ptr_1, end_ptr_1, 0);
+
+  // NOTE(maciej): We do not transform normals above, as it contains schale.
+  //               Instead we will just recompute the normal and set it.
+  if (has_normals)
+  {
+    dd_vec3_t pos_1_a = dd_vec4_to_vec3(start_ptr_1->pos_size);
+    dd_vec3_t pos_1_b = dd_vec4_to_vec3((start_ptr_1 + 1)->pos_size);
+    dd_vec3_t pos_1_c = dd_vec4_to_vec3((start_ptr_1 + 2)->pos_size);
+    dd_vec3_t normal_1 =
+      dd_vec3_normalize(dd_vec3_cross(dd_vec3_sub(pos_1_c, pos_1_a),
+                                      dd_vec3_sub(pos_1_b, pos_1_a)));
+    for (dd_vertex_t* it = start_ptr_1; it != end_ptr_1; ++it)
+    {
+      it->normal = normal_1;
+    }
+  }
+
+  dd_vertex_t* start_ptr_2 = ctx->verts_data + ctx->verts_len;
+  dd__arc(ctx, &pt_top, 1.0f, (float)DBGDRAW_TWO_PI, resolution, 0);
+  dd_vertex_t* end_ptr_2 = ctx->verts_data + ctx->verts_len;
+  dd__transform_verts(xform_b, start_ptr_2, end_ptr_2, 0);
+
+  if (has_normals)
+  {
+    dd_vec3_t pos_2_a = dd_vec4_to_vec3(start_ptr_2->pos_size);
+    dd_vec3_t pos_2_b = dd_vec4_to_vec3((start_ptr_2 + 1)->pos_size);
+    dd_vec3_t pos_2_c = dd_vec4_to_vec3((start_ptr_2 + 2)->pos_size);
+    dd_vec3_t normal_2 =
+      dd_vec3_normalize(dd_vec3_cross(dd_vec3_sub(pos_2_c, pos_2_a),
+                                      dd_vec3_sub(pos_2_b, pos_2_a)));
+    for (dd_vertex_t* it = start_ptr_2; it != end_ptr_2; ++it)
+    {
+      it->normal = normal_2;
+    }
+  }
+
+  switch (ctx->cur_cmd->draw_mode)
+  {
+    case DBGDRAW_MODE_POINT:
+      break;
+    case DBGDRAW_MODE_STROKE:
+      for (int32_t i = 0; i < resolution >> 1; ++i)
+      {
+        dd_vec3_t p1 = dd_vec4_to_vec3(start_ptr_1->pos_size);
+        dd_vec3_t p2 = dd_vec4_to_vec3(start_ptr_2->pos_size);
+        dd__line(ctx, &p1, &p2);
+        start_ptr_1 += 4;
+        start_ptr_2 += 4;
+      }
+      break;
+    case DBGDRAW_MODE_FILL:
+      for (int32_t i = 0; i < resolution; ++i)
+      {
+        start_ptr_1++;
+        start_ptr_2++;
+        dd_vec3_t p1 = dd_vec4_to_vec3(start_ptr_1->pos_size);
+        start_ptr_1++;
+        dd_vec3_t p2 = dd_vec4_to_vec3(start_ptr_1->pos_size);
+        dd_vec3_t p3 = dd_vec4_to_vec3(start_ptr_2->pos_size);
+        start_ptr_2++;
+        dd_vec3_t p4 = dd_vec4_to_vec3(start_ptr_2->pos_size);
+        start_ptr_1++;
+        start_ptr_2++;
+        if (has_normals)
+        {
+          dd_vec3_t normal = dd_vec3_normalize(
+            dd_vec3_cross(dd_vec3_sub(p2, p1), dd_vec3_sub(p3, p1)));
+          dd__triangle_normal(ctx, &p2, &p1, &p3, &normal);
+          dd__triangle_normal(ctx, &p3, &p1, &p4, &normal);
+        }
+        else
+        {
+          dd__triangle(ctx, &p2, &p1, &p3);
+          dd__triangle(ctx, &p3, &p1, &p4);
+        }
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void
+dd__torus_point_stroke(dd_ctx_t* ctx,
+                       dd_vec3_t center,
+                       float radius_a,
+                       float radius_b,
+                       int32_t resolution,
+                       int32_t n_small_rings)
+{
+  /* Store useful data */
+  dd_vertex_t* base_ptr = ctx->verts_data + ctx->verts_len;
+  dd_mat4_t xform       = dd_mat4_identity();
+  dd_mat4_t rotx =
+    dd_pre_rotate(xform, (float)DBGDRAW_PI_OVER_TWO, dd_vec3(1.0f, 0.0f, 0.0f));
+  float radius           = 1.0f;
+  dd_vertex_t* start_ptr = base_ptr;
+  dd_vertex_t* end_ptr   = base_ptr;
+  size_t len;
+  dd_vec3_t zero_pt = dd_vec3(0.0f, 0.0f, 0.0f);
+  /* We do large circles only for stroke mode */
+  if (ctx->cur_cmd->draw_mode == DBGDRAW_MODE_STROKE)
+  {
+    /* create unit circle, and get data boundaries */
+    start_ptr = base_ptr;
+    dd__arc(ctx, &zero_pt, 1.0f, (float)DBGDRAW_TWO_PI, resolution, 0);
+    end_ptr = ctx->verts_data + ctx->verts_len;
+    len     = end_ptr - start_ptr;
+
+    /* copy the memory, so that we have all the rings we need. Also make sure to
+     * move verts_len accordingly */
+    for (int32_t i = 1; i < 4; ++i)
+    {
+      memcpy(end_ptr, start_ptr, len * sizeof(dd_vertex_t));
+      end_ptr += len;
+      start_ptr += len;
+    }
+
+    /* Large outer circle */
+    radius    = radius_a + radius_b;
+    xform     = dd_pre_scale(rotx, dd_vec3(radius, radius, radius));
+    xform     = dd_pre_translate(xform, center);
+    start_ptr = base_ptr;
+    end_ptr   = start_ptr + len;
+    dd__transform_verts(xform, start_ptr, end_ptr, 0);
+
+    /* Smaller inner circle */
+    radius    = radius_a - radius_b;
+    xform     = dd_pre_scale(rotx, dd_vec3(radius, radius, radius));
+    xform     = dd_pre_translate(xform, center);
+    start_ptr = end_ptr;
+    end_ptr   = start_ptr + len;
+    dd__transform_verts(xform, start_ptr, end_ptr, 0);
+
+    /* Medium top circle */
+    xform = dd_pre_scale(rotx, dd_vec3(radius_a, radius_a, radius_a));
+    xform =
+      dd_pre_translate(xform,
+                       dd_vec3_add(dd_vec3(0.0f, radius_b, 0.0f), center));
+    start_ptr = end_ptr;
+    end_ptr   = start_ptr + len;
+    dd__transform_verts(xform, start_ptr, end_ptr, 0);
+
+    /* Medium bottom circle */
+    xform = dd_pre_scale(rotx, dd_vec3(radius_a, radius_a, radius_a));
+    xform =
+      dd_pre_translate(xform,
+                       dd_vec3_add(center, dd_vec3(0.0f, -radius_b, 0.0f)));
+    start_ptr = end_ptr;
+    end_ptr   = start_ptr + len;
+    dd__transform_verts(xform, start_ptr, end_ptr, 0);
+
+    ctx->verts_len += (int32_t)len * 3;
+    ctx->cur_cmd->vertex_count += (int32_t)len * 3;
+  }
+
+  /* create data for small circles, and get data boundaries */
+  base_ptr    = end_ptr;
+  start_ptr   = base_ptr;
+  int32_t res = DD_MAX(resolution >> 1, 4);
+  dd__arc(ctx, &zero_pt, 1.0f, (float)DBGDRAW_TWO_PI, res, 0);
+  end_ptr = ctx->verts_data + ctx->verts_len;
+  len     = end_ptr - start_ptr;
+
+  /* copy the memory, so that we have all the rings we need. Also make sure to
+   * move verts_len accordingly */
+  for (int32_t i = 1; i < n_small_rings; ++i)
+  {
+    memcpy(end_ptr, start_ptr, len * sizeof(dd_vertex_t));
+    end_ptr += len;
+    start_ptr += len;
+  }
+  start_ptr = base_ptr;
+  end_ptr   = start_ptr + len;
+
+  /* small circles around the torus */
+  float theta = (float)DBGDRAW_TWO_PI / n_small_rings;
+  xform       = dd_pre_scale(rotx, dd_vec3(radius_b, radius_b, radius_b));
+  xform =
+    dd_pre_rotate(xform, (float)DBGDRAW_PI_OVER_TWO, dd_vec3(1.0f, 0.0f, 0.0f));
+  xform = dd_pre_translate(xform, dd_vec3(radius_a, 0.0f, 0.0f));
+  for (int32_t i = 0; i < n_small_rings; ++i)
+  {
+    xform            = dd_pre_rotate(xform, theta, dd_vec3(0.0f, 1.0f, 0.0f));
+    dd_mat4_t cxform = dd_pre_translate(xform, center);
+
+    dd__transform_verts(cxform, start_ptr, end_ptr, 0);
+    start_ptr = end_ptr;
+    end_ptr   = start_ptr + len;
+  }
+
+  /* Tell the context that there is new vertex data */
+  ctx->verts_len += (int32_t)len * (n_small_rings - 1);
+  ctx->cur_cmd->vertex_count += (int32_t)len * (n_small_rings - 1);
+}
+
+void
+dd__torus_fill(dd_ctx_t* ctx,
+               dd_vec3_t center,
+               float radius_a,
+               float radius_b,
+               int32_t resolution,
+               int32_t n_small_rings)
+{
+  (void)n_small_rings;
+
+  bool has_normals = ctx->cur_cmd->draw_mode == DBGDRAW_MODE_FILL &&
+                     ctx->cur_cmd->shading_type != DBGDRAW_SHADING_NONE;
+  int32_t res_a = resolution;
+  int32_t res_b = DD_MAX(4, resolution >> 1);
+  float step_a  = (float)DBGDRAW_TWO_PI / res_a;
+  float step_b  = (float)DBGDRAW_TWO_PI / res_b;
+  float ax      = radius_a;
+  float ay      = 0.0f;
+  float az      = 0.0f;
+  dd_vec3_t p1, p2, p3;
+  dd_vec3_t normal;
+  for (int32_t i = 0; i < res_a; ++i)
+  {
+    float c1 = DBGDRAW_COS(i * step_a);
+    float c2 = DBGDRAW_COS((i + 1) * step_a);
+    float s1 = DBGDRAW_SIN(i * step_a);
+    float s2 = DBGDRAW_SIN((i + 1) * step_a);
+
+    float s1az = s1 * az;
+    float c1az = c1 * az;
+    float s2az = s2 * az;
+    float c2az = c2 * az;
+
+    for (int32_t j = 0; j < res_b; ++j)
+    {
+      float bx0 = (ax + radius_b * DBGDRAW_COS(j * step_b));
+      float by0 = (ay + radius_b * DBGDRAW_SIN(j * step_b));
+
+      float bx1 = (ax + radius_b * DBGDRAW_COS((j + 1) * step_b));
+      float by1 = (ay + radius_b * DBGDRAW_SIN((j + 1) * step_b));
+
+      float bx2 = c1 * bx0 - s1az;
+      float bz2 = s1 * bx0 + c1az;
+
+      float bx3 = c1 * bx1 - s1az;
+      float bz3 = s1 * bx1 + c1az;
+
+      float bx4 = c2 * bx0 - s2az;
+      float bz4 = s2 * bx0 + c2az;
+
+      float bx5 = c2 * bx1 - s2az;
+      float bz5 = s2 * bx1 + c2az;
+
+      p1.x = bx2;
+      p1.y = by0, p1.z = bz2;
+      p2.x = bx4;
+      p2.y = by0, p2.z = bz4;
+      p3.x = bx3;
+      p3.y = by1, p3.z = bz3;
+      p1 = dd_vec3_add(p1, center);
+      p2 = dd_vec3_add(p2, center);
+      p3 = dd_vec3_add(p3, center);
+      if (has_normals)
+      {
+        normal = dd_vec3_normalize(
+          dd_vec3_cross(dd_vec3_sub(p2, p1), dd_vec3_sub(p3, p1)));
+        dd__triangle_normal(ctx, &p2, &p1, &p3, &normal);
+      }
+      else
+      {
+        dd__triangle(ctx, &p2, &p1, &p3);
+      }
+
+      p1.x = bx3;
+      p1.y = by1, p1.z = bz3;
+      p2.x = bx4;
+      p2.y = by0, p2.z = bz4;
+      p3.x = bx5;
+      p3.y = by1, p3.z = bz5;
+      p1 = dd_vec3_add(p1, center);
+      p2 = dd_vec3_add(p2, center);
+      p3 = dd_vec3_add(p3, center);
+      if (has_normals) { dd__triangle_normal(ctx, &p2, &p1, &p3, &normal); }
+      else
+      {
+        dd__triangle(ctx, &p2, &p1, &p3);
+      }
+    }
+  }
+}
+
+// Procedural shapes are tessellated by the backend as a (res_u x res_v) grid of
+// quads, where res_u matches the resolution used by the cpu path, and res_v is
+// the number of segments in the revolved profile. Impostors do not contribute,
+// as their proxy geometry is fixed.
+int32_t
+dd__procedural_vertex_count(uint32_t type, uint32_t detail_level)
+{
+  int32_t res_u = 1 << (detail_level + 2);
+  int32_t res_v = 1;
+  switch (type)
+  {
+    case DBGDRAW_PROCEDURAL_SPHERE:
+      res_v = res_u >> 1;
+      break;
+    case DBGDRAW_PROCEDURAL_TORUS:
+      res_v = DD_MAX(4, res_u >> 1);
+      break;
+    case DBGDRAW_PROCEDURAL_CONICAL_FRUSTUM:
+      res_v = 3;
+      break;
+    case DBGDRAW_PROCEDURAL_IMPOSTOR_SPHERE:
+    case DBGDRAW_PROCEDURAL_IMPOSTOR_CAPSULE:
+    case DBGDRAW_PROCEDURAL_IMPOSTOR_CYLINDER:
+      return 0;
+    default:
+      res_v = 1;
+      break;
+  }
+  return 6 * res_u * res_v;
+}
+
+bool
+dd__procedural_enabled(dd_ctx_t* ctx)
+{
+  return ctx->procedural &&
+         (ctx->backend_caps & DBGDRAW_BACKEND_CAPS_PROCEDURAL) &&
+         ctx->cur_cmd->draw_mode == DBGDRAW_MODE_FILL &&
+         ctx->cur_cmd->instance_count == 0 &&
+         ctx->fill_type == DBGDRAW_FILL_FLAT;
+}
+
+bool
+dd__impostors_enabled(dd_ctx_t* ctx)
+{
+  return ctx->impostors &&
+         (ctx->backend_caps & DBGDRAW_BACKEND_CAPS_IMPOSTORS) &&
+         ctx->cur_cmd->draw_mode == DBGDRAW_MODE_FILL &&
+         ctx->cur_cmd->instance_count == 0 &&
+         ctx->fill_type == DBGDRAW_FILL_FLAT;
+}
+
+int32_t
+dd__procedural_prim(dd_ctx_t* ctx,
+                    dd_procedural_type_t type,
+                    dd_vec3_t center,
+                    dd_vec3_t axis,
+                    float radius_a,
+                    float radius_b)
+{
+  DD_GROW(ctx,
+          ctx->procedural_data,
+          ctx->procedural_len + 1,
+          ctx->procedural_cap,
+          sizeof(dd_procedural_prim_t));
+
+  ctx->procedural_data[ctx->procedural_len++] = (dd_procedural_prim_t) {
+    .center       = center,
+    .radius_a     = radius_a,
+    .axis         = axis,
+    .radius_b     = radius_b,
+    .color        = ctx->color,
+    .type         = (uint32_t)type,
+    .detail_level = ctx->detail_level,
+  };
+
+  int32_t vertex_count = dd__procedural_vertex_count(type, ctx->detail_level);
+  ctx->cur_cmd->procedural_count++;
+  ctx->cur_cmd->procedural_types |= 1u << type;
+  ctx->cur_cmd->procedural_vertex_count =
+    DD_MAX(ctx->cur_cmd->procedural_vertex_count, vertex_count);
+
+  return DBGDRAW_ERR_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Public Draw Commands
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int32_t
+dd__point_ex(dd_ctx_t* ctx, float* a, uint8_t is_3d)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(a);
+
+  int32_t new_verts = 1;
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  dd_vec3_t pt_a = dd_vec3(a[0], a[1], is_3d ? a[2] : 0.0f);
+  if (!dd__clip_points_test(ctx, &pt_a, 1)) { return DBGDRAW_ERR_CULLED; }
+  dd__vertex(ctx, &pt_a);
+
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_point(dd_ctx_t* ctx, float* a)
+{
+  return dd__point_ex(ctx, a, 1);
+}
+
+int32_t
+dd_point2d(dd_ctx_t* ctx, float* a)
+{
+  return dd__point_ex(ctx, a, 0);
+}
+
+int32_t
+dd__line_ex(dd_ctx_t* ctx, float* a, float* b, uint8_t is_3d)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(a);
+  DBGDRAW_ASSERT(b);
+
+  int32_t new_verts = 2;
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  dd_vec3_t pts[2] = {dd_vec3(a[0], a[1], is_3d ? a[2] : 0.0f),
+                      dd_vec3(b[0], b[1], is_3d ? b[2] : 0.0f)};
+  if (!dd__clip_points_test(ctx, pts, 2)) { return DBGDRAW_ERR_CULLED; }
+  dd__line(ctx, &pts[0], &pts[1]);
+
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_line(dd_ctx_t* ctx, float* a, float* b)
+{
+  return dd__line_ex(ctx, a, b, 1);
+}
+
+int32_t
+dd_line2d(dd_ctx_t* ctx, float* a, float* b)
+{
+  return dd__line_ex(ctx, a, b, 0);
+}
+
+int32_t
+dd__quad_ex(dd_ctx_t* ctx,
+            float* a,
+            float* b,
+            float* c,
+            float* d,
+            uint8_t is_3d)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(a);
+  DBGDRAW_ASSERT(b);
+  DBGDRAW_ASSERT(c);
+  DBGDRAW_ASSERT(d);
+
+  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
+  mode_vert_count[DBGDRAW_MODE_POINT]  = 4;
+  mode_vert_count[DBGDRAW_MODE_STROKE] = 8;
+  mode_vert_count[DBGDRAW_MODE_FILL]   = 6;
+  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  dd_vec3_t pt_a = dd_vec3(a[0], a[1], is_3d ? a[2] : 0.0f);
+  dd_vec3_t pt_b = dd_vec3(b[0], b[1], is_3d ? b[2] : 0.0f);
+  dd_vec3_t pt_c = dd_vec3(c[0], c[1], is_3d ? c[2] : 0.0f);
+  dd_vec3_t pt_d = dd_vec3(d[0], d[1], is_3d ? d[2] : 0.0f);
+
+  dd_vec3_t pts[4] = {pt_a, pt_b, pt_c, pt_d};
+  if (!dd__clip_points_test(ctx, pts, 4)) { return DBGDRAW_ERR_CULLED; }
+  dd__quad(ctx, &pt_a, &pt_b, &pt_c, &pt_d);
+
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_quad(dd_ctx_t* ctx, float* a, float* b, float* c, float* d)
+{
+  return dd__quad_ex(ctx, a, b, c, d, 1);
+}
+
+int32_t
+dd_quad2d(dd_ctx_t* ctx, float* a, float* b, float* c, float* d)
+{
+  return dd__quad_ex(ctx, a, b, c, d, 0);
+}
+
+int32_t
+dd__rect_ex(dd_ctx_t* ctx, float* a, float* b, uint8_t is_3d)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(a);
+  DBGDRAW_ASSERT(b);
+
+  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
+  mode_vert_count[DBGDRAW_MODE_POINT]  = 4;
+  mode_vert_count[DBGDRAW_MODE_STROKE] = 8;
+  mode_vert_count[DBGDRAW_MODE_FILL]   = 6;
+  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  dd_vec3_t pt_a = dd_vec3(a[0], a[1], is_3d ? a[2] : 0.0f);
+  dd_vec3_t pt_b = dd_vec3(a[0], b[1], is_3d ? a[2] : 0.0f);
+  dd_vec3_t pt_d = dd_vec3(b[0], a[1], is_3d ? b[2] : 0.0f);
+  dd_vec3_t pt_c = dd_vec3(b[0], b[1], is_3d ? b[2] : 0.0f);
+
+  dd_vec3_t pts[4] = {pt_a, pt_b, pt_c, pt_d};
+  if (!dd__clip_points_test(ctx, pts, 4)) { return DBGDRAW_ERR_CULLED; }
+  dd__quad(ctx, &pt_a, &pt_b, &pt_c, &pt_d);
+
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_rect(dd_ctx_t* ctx, float* a, float* b)
+{
+  return dd__rect_ex(ctx, a, b, 1);
+}
+
+int32_t
+dd_rect2d(dd_ctx_t* ctx, float* a, float* b)
+{
+  return dd__rect_ex(ctx, a, b, 0);
+}
+
+int32_t
+dd_rounded_rect2d_ex(dd_ctx_t* ctx, float* a, float* b, float* radii)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(a);
+
+  int32_t resolution = 1 << (ctx->detail_level + 2);
+  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
+  mode_vert_count[DBGDRAW_MODE_POINT]  = resolution + 4;
+  mode_vert_count[DBGDRAW_MODE_STROKE] = 2 * resolution + 8;
+  mode_vert_count[DBGDRAW_MODE_FILL]   = 3 * resolution + 6;
+  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  dd_vec3_t corners[4] = {dd_vec3(a[0], a[1], 0.0f),
+                          dd_vec3(a[0], b[1], 0.0f),
+                          dd_vec3(b[0], b[1], 0.0f),
+                          dd_vec3(b[0], a[1], 0.0f)};
+  if (!dd__clip_points_test(ctx, corners, 4)) { return DBGDRAW_ERR_CULLED; }
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  float d_theta = (float)DBGDRAW_TWO_PI / resolution;
+
+  float w            = (b[0] - a[0]);
+  float h            = (b[1] - a[1]);
+  float offsets_x[4] = {w - (radii[0] + radii[3]),
+                        -radii[1],
+                        -(w - (radii[1] + radii[2])),
+                        radii[3]};
+  float offsets_y[4] = {-radii[0],
+                        -(h - (radii[0] + radii[1])),
+                        radii[2],
+                        h - (radii[2] + radii[3])};
+  dd_vec3_t pt0      = dd_vec3(a[0] + radii[3], b[1], 0.0f);
+
+  if (ctx->cur_cmd->draw_mode == DBGDRAW_MODE_FILL)
+  {
+    dd_vec3_t corners[4] = {0};
+    for (int i = 0; i < 4; ++i)
+    {
+      float r          = radii[i];
+      float init_theta = i * (float)DBGDRAW_PI_OVER_TWO;
+      dd_vec3_t pt1    = dd_vec3(0.0f, 0.0f, 0.0f);
+      corners[i]       = dd_vec3(pt0.x, pt0.y, 0.0f);
+
+      for (int32_t j = 0; j < resolution / 4; ++j)
+      {
+        float theta = init_theta + j * d_theta;
+        float ox1   = offsets_x[i] + r * sinf(theta);
+        float ox2   = offsets_x[i] + r * sinf(theta + d_theta);
+        float oy1   = offsets_y[i] + r * cosf(theta);
+        float oy2   = offsets_y[i] + r * cosf(theta + d_theta);
+
+        dd__vertex(ctx, &pt0);
+        pt1.x = pt0.x + ox1;
+        pt1.y = pt0.y + oy1;
+        dd__vertex(ctx, &pt1);
+        pt1.x = pt0.x + ox2;
+        pt1.y = pt0.y + oy2;
+        dd__vertex(ctx, &pt1);
+      }
+      pt0 = pt1;
+    }
+
+    dd__triangle(ctx, &corners[0], &corners[2], &corners[1]);
+    dd__triangle(ctx, &corners[2], &corners[0], &corners[3]);
+  }
+  else if (ctx->cur_cmd->draw_mode == DBGDRAW_MODE_STROKE)
+  {
+    for (int i = 0; i < 4; ++i)
+    {
+      float init_theta = i * (float)DBGDRAW_PI_OVER_TWO;
+      dd_vec3_t pt1    = pt0;
+      float r          = radii[i];
+      for (int32_t j = 0; j < resolution / 4 + 1; ++j)
+      {
+        float theta = init_theta + j * d_theta;
+        float ox1   = offsets_x[i] + r * sinf(theta);
+        float oy1   = offsets_y[i] + r * cosf(theta);
+        dd__vertex(ctx, &pt1);
+        pt1.x = pt0.x + ox1;
+        pt1.y = pt0.y + oy1;
+        dd__vertex(ctx, &pt1);
+      }
+      pt0 = pt1;
+    }
+  }
+  else if (ctx->cur_cmd->draw_mode == DBGDRAW_MODE_POINT)
+  {
+    for (int i = 0; i < 4; ++i)
+    {
+      float r          = radii[i];
+      float init_theta = i * (float)DBGDRAW_PI_OVER_TWO;
+      dd_vec3_t pt1    = dd_vec3(0.0f, 0.0f, 0.0f);
+      for (int32_t j = 0; j < resolution / 4 + 1; ++j)
+      {
+        float theta = init_theta + j * d_theta;
+        float ox1   = offsets_x[i] + r * sinf(theta);
+        float oy1   = offsets_y[i] + r * cosf(theta);
+        pt1.x       = pt0.x + ox1;
+        pt1.y       = pt0.y + oy1;
+        dd__vertex(ctx, &pt1);
+      }
+      pt0 = pt1;
+    }
+  }
+
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_rounded_rect2d(dd_ctx_t* ctx, float* a, float* b, float rounding)
+{
+  float all_corners_rounding[4] = {rounding, rounding, rounding, rounding};
+  return dd_rounded_rect2d_ex(ctx, a, b, all_corners_rounding);
+}
+
+// TODO(maciej): Sizes should be in pixels...
+int32_t
+dd_billboard_rect(dd_ctx_t* ctx, float* p, float width, float height)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(p);
+
+  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
+  mode_vert_count[DBGDRAW_MODE_POINT]  = 4;
+  mode_vert_count[DBGDRAW_MODE_STROKE] = 8;
+  mode_vert_count[DBGDRAW_MODE_FILL]   = 6;
+  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  dd_vec3_t pt = dd_vec3(p[0], p[1], p[2]);
+  dd_mat3_t m  = dd__get_view_aligned_basis(ctx, pt);
+  m.col[0]     = dd_vec3_scalar_mul(m.col[0], width * 0.5f);
+  m.col[1]     = dd_vec3_scalar_mul(m.col[1], height * 0.5f);
+
+  dd_vec3_t pt_a = dd_vec3_sub(pt, dd_vec3_add(m.col[0], m.col[1]));
+  dd_vec3_t pt_b = dd_vec3_add(pt, dd_vec3_sub(m.col[0], m.col[1]));
+  dd_vec3_t pt_c = dd_vec3_add(pt, dd_vec3_add(m.col[0], m.col[1]));
+  dd_vec3_t pt_d = dd_vec3_sub(pt, dd_vec3_sub(m.col[0], m.col[1]));
+
+  dd__quad(ctx, &pt_a, &pt_b, &pt_c, &pt_d);
+
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd__circle_ex(dd_ctx_t* ctx, float* center, float radius, uint8_t is_3d)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(center);
+
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  dd_vec3_t center_pt = dd_vec3(center[0], center[1], is_3d ? center[2] : 0.0f);
+  if (!dd__clip_sphere_test(ctx, center_pt, radius))
+  {
+    return DBGDRAW_ERR_CULLED;
+  }
+  if (is_3d && dd__procedural_enabled(ctx))
+  {
+    return dd__procedural_prim(ctx,
+                               DBGDRAW_PROCEDURAL_CIRCLE,
+                               dd_vec3(center[0], center[1], center[2]),
+                               dd_vec3(0.0f, 0.0f, 1.0f),
+                               radius,
+                               radius);
+  }
+
+  int32_t resolution = 1 << (ctx->detail_level + 2);
+  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
+  mode_vert_count[DBGDRAW_MODE_POINT]  = resolution;
+  mode_vert_count[DBGDRAW_MODE_STROKE] = 2 * resolution + 2;
+  mode_vert_count[DBGDRAW_MODE_FILL]   = 3 * resolution;
+  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  dd__arc(ctx, &center_pt, radius, (float)DBGDRAW_TWO_PI, resolution, !is_3d);
+
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_circle(dd_ctx_t* ctx, float* center, float radius)
+{
+  return dd__circle_ex(ctx, center, radius, 1);
+}
+
+int32_t
+dd_circle2d(dd_ctx_t* ctx, float* center, float radius)
+{
+  return dd__circle_ex(ctx, center, radius, 0);
+}
+
+int32_t
+dd_billboard_circle(dd_ctx_t* ctx, float* center, float radius)
+{
+  DBGDRAW_ASSERT(ctx);
+  if (!ctx->cur_cmd) { return DBGDRAW_ERR_NO_ACTIVE_CMD; }
+  bool has_normals = ctx->cur_cmd->draw_mode == DBGDRAW_MODE_FILL &&
+                     ctx->cur_cmd->shading_type != DBGDRAW_SHADING_NONE;
+
+  int32_t resolution = 1 << (ctx->detail_level + 2);
+  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
+  mode_vert_count[DBGDRAW_MODE_POINT]  = resolution;
+  mode_vert_count[DBGDRAW_MODE_STROKE] = 2 * resolution + 2;
+  mode_vert_count[DBGDRAW_MODE_FILL]   = 3 * resolution;
+  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  dd_vec3_t zero_pt  = dd_vec3(0.0f, 0.0f, 0.0f);
+  dd_vertex_t* start = ctx->verts_data + ctx->verts_len;
+  dd__arc(ctx, &zero_pt, radius, (float)DBGDRAW_TWO_PI, resolution, 0);
+  dd_vertex_t* end = ctx->verts_data + ctx->verts_len;
+
+  dd_vec3_t cp    = dd_vec3(center[0], center[1], center[2]);
+  dd_mat3_t m     = dd__get_view_aligned_basis(ctx, cp);
+  dd_mat4_t xform = dd_mat4_identity();
+  xform.col[0]    = dd_vec3_to_vec4(m.col[0]);
+  xform.col[1]    = dd_vec3_to_vec4(m.col[1]);
+  xform.col[2]    = dd_vec3_to_vec4(m.col[2]);
+  xform.col[3]    = dd_vec3_to_vec4(cp);
+  xform.col[3].w  = 1.0f;
+  dd__transform_verts(xform, start, end, has_normals);
+
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd__arc_ex(dd_ctx_t* ctx,
+           float* center,
+           float radius,
+           float theta,
+           uint8_t is_3d)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(center);
+
+  int32_t resolution = 1 << (ctx->detail_level + 2);
+  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
+  mode_vert_count[DBGDRAW_MODE_POINT]  = DD_MAX(4, resolution >> 1) + 2;
+  mode_vert_count[DBGDRAW_MODE_STROKE] = 2 * resolution + 4;
+  mode_vert_count[DBGDRAW_MODE_FILL]   = 3 * resolution;
+  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  dd_vec3_t center_pt = dd_vec3(center[0], center[1], is_3d ? center[2] : 0.0f);
+  if (!dd__clip_sphere_test(ctx, center_pt, radius))
+  {
+    return DBGDRAW_ERR_CULLED;
+  }
+  dd__arc(ctx, &center_pt, radius, theta, resolution, 0);
+
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_arc(dd_ctx_t* ctx, float* center, float radius, float theta)
+{
+  return dd__arc_ex(ctx, center, radius, theta, 1);
+}
+
+int32_t
+dd_arc2d(dd_ctx_t* ctx, float* center, float radius, float theta)
+{
+  return dd__arc_ex(ctx, center, radius, theta, 0);
+}
+
+int32_t
+dd_aabb(dd_ctx_t* ctx, float* a, float* b)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(a);
+  DBGDRAW_ASSERT(b);
+
+  dd_vec3_t pt_a = dd_vec3(a[0], a[1], a[2]);
+  dd_vec3_t pt_b = dd_vec3(b[0], b[1], b[2]);
+  if (!dd__frustum_aabb_test(ctx, pt_a, pt_b)) { return DBGDRAW_ERR_CULLED; }
+
+  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
+  mode_vert_count[DBGDRAW_MODE_POINT]  = 8;
+  mode_vert_count[DBGDRAW_MODE_STROKE] = 24;
+  mode_vert_count[DBGDRAW_MODE_FILL]   = 36;
+  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  dd_vec3_t pts[8] = {
+    dd_vec3(a[0], a[1], a[2]),
+    dd_vec3(b[0], a[1], a[2]),
+    dd_vec3(b[0], a[1], b[2]),
+    dd_vec3(a[0], a[1], b[2]),
+
+    dd_vec3(b[0], b[1], a[2]),
+    dd_vec3(a[0], b[1], a[2]),
+    dd_vec3(a[0], b[1], b[2]),
+    dd_vec3(b[0], b[1], b[2]),
+  };
+
+  dd__box(ctx, pts);
+
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_obb(dd_ctx_t* ctx, float* c, float* m)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(c);
+  DBGDRAW_ASSERT(m);
+
+  dd_vec3_t center_pt = dd_vec3(c[0], c[1], c[2]);
+  dd_mat3_t axes;
+  memcpy(axes.data, m, sizeof(axes));
+
+  if (!dd__frustum_obb_test(ctx, center_pt, axes))
+  {
+    return DBGDRAW_ERR_CULLED;
+  }
+
+  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
+  mode_vert_count[DBGDRAW_MODE_POINT]  = 8;
+  mode_vert_count[DBGDRAW_MODE_STROKE] = 24;
+  mode_vert_count[DBGDRAW_MODE_FILL]   = 36;
+  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  dd_vec3_t v1 = axes.col[0];
+  dd_vec3_t v2 = axes.col[1];
+  dd_vec3_t v3 = axes.col[2];
+
+  dd_vec3_t pts[8] = {
+    dd_vec3(center_pt.x + v1.x - v2.x + v3.x,
+            center_pt.y + v1.y - v2.y + v3.y,
+            center_pt.z + v1.z - v2.z + v3.z),
+    dd_vec3(center_pt.x - v1.x - v2.x + v3.x,
+            center_pt.y - v1.y - v2.y + v3.y,
+            center_pt.z - v1.z - v2.z + v3.z),
+    dd_vec3(center_pt.x - v1.x - v2.x - v3.x,
+            center_pt.y - v1.y - v2.y - v3.y,
+            center_pt.z - v1.z - v2.z - v3.z),
+    dd_vec3(center_pt.x + v1.x - v2.x - v3.x,
+            center_pt.y + v1.y - v2.y - v3.y,
+            center_pt.z + v1.z - v2.z - v3.z),
+
+    dd_vec3(center_pt.x - v1.x + v2.x + v3.x,
+            center_pt.y - v1.y + v2.y + v3.y,
+            center_pt.z - v1.z + v2.z + v3.z),
+    dd_vec3(center_pt.x + v1.x + v2.x + v3.x,
+            center_pt.y + v1.y + v2.y + v3.y,
+            center_pt.z + v1.z + v2.z + v3.z),
+    dd_vec3(center_pt.x + v1.x + v2.x - v3.x,
+            center_pt.y + v1.y + v2.y - v3.y,
+            center_pt.z + v1.z + v2.z - v3.z),
+    dd_vec3(center_pt.x - v1.x + v2.x - v3.x,
+            center_pt.y - v1.y + v2.y - v3.y,
+            center_pt.z - v1.z + v2.z - v3.z),
+  };
+
+  dd__box(ctx, pts);
+
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_frustum(dd_ctx_t* ctx, float* view_matrix, float* proj_matrix)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(view_matrix);
+  DBGDRAW_ASSERT(proj_matrix);
+
+  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
+  mode_vert_count[DBGDRAW_MODE_POINT]  = 8;
+  mode_vert_count[DBGDRAW_MODE_STROKE] = 24;
+  mode_vert_count[DBGDRAW_MODE_FILL]   = 36;
+  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
 
-      pt_a = dd_vec3(c->x + prev_x * prev_r,
-                     c->y + prev_y * radius,
-                     c->z + prev_z * prev_r);
-      pt_b = dd_vec3(c->x + prev_x * curr_r,
-                     c->y + curr_y * radius,
-                     c->z + prev_z * curr_r);
-      pt_c = dd_vec3(c->x + curr_x * curr_r,
-                     c->y + curr_y * radius,
-                     c->z + curr_z * curr_r);
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
 
-      if (ctx->cur_cmd->shading_type != DBGDRAW_SHADING_NONE)
-      {
-        if (i != half_res)
-        {
-          normal = dd_vec3_normalize(
-            dd_vec3_cross(dd_vec3_sub(pt_c, pt_a), dd_vec3_sub(pt_b, pt_a)));
-        }
-        dd__triangle_normal(ctx, &pt_a, &pt_b, &pt_c, &normal);
-      }
-      else
-      {
-        dd__triangle(ctx, &pt_a, &pt_b, &pt_c);
-      }
+  dd_mat4_t proj, view;
+  memcpy(proj.data, proj_matrix, sizeof(dd_mat4_t));
+  memcpy(view.data, view_matrix, sizeof(dd_mat4_t));
 
-      pt_a = dd_vec3(c->x + prev_x * prev_r,
-                     c->y + prev_y * radius,
-                     c->z + prev_z * prev_r);
-      pt_b = dd_vec3(c->x + curr_x * curr_r,
-                     c->y + curr_y * radius,
-                     c->z + curr_z * curr_r);
-      pt_c = dd_vec3(c->x + curr_x * prev_r,
-                     c->y + prev_y * radius,
-                     c->z + curr_z * prev_r);
+  dd_mat4_t inv_clip = dd_mat4_inverse(dd_mat4_mul(proj, view));
 
-      if (ctx->cur_cmd->shading_type != DBGDRAW_SHADING_NONE)
-      {
-        if (i == half_res)
-        {
-          normal = dd_vec3_normalize(
-            dd_vec3_cross(dd_vec3_sub(pt_c, pt_a), dd_vec3_sub(pt_b, pt_a)));
-        }
-        dd__triangle_normal(ctx, &pt_a, &pt_b, &pt_c, &normal);
-      }
-      else
-      {
-        dd__triangle(ctx, &pt_a, &pt_b, &pt_c);
-      }
+  dd_vec4_t pts_a[8] = {
+    dd_vec4(1.0f, -1.0f, 1.0f, 1.0f),
+    dd_vec4(-1.0f, -1.0f, 1.0f, 1.0f),
+    dd_vec4(-1.0f, 1.0f, 1.0f, 1.0f),
+    dd_vec4(1.0f, 1.0f, 1.0f, 1.0f),
 
-      prev_x = curr_x;
-      prev_z = curr_z;
-    }
-    prev_y = curr_y;
-    prev_r = curr_r;
+    dd_vec4(-1.0f, -1.0f, -1.0f, 1.0f),
+    dd_vec4(1.0f, -1.0f, -1.0f, 1.0f),
+    dd_vec4(1.0f, 1.0f, -1.0f, 1.0f),
+    dd_vec4(-1.0f, 1.0f, -1.0f, 1.0f),
+
+  };
+
+  dd_vec3_t pts_b[8];
+  for (int32_t i = 0; i < 8; ++i)
+  {
+    pts_a[i] = dd_mat4_vec4_mul(inv_clip, pts_a[i]);
+    pts_b[i] = dd_vec4_to_vec3(pts_a[i]);
+    pts_b[i] = dd_vec3_scalar_div(pts_b[i], pts_a[i].w);
   }
+
+  dd__box(ctx, pts_b);
+
+  return DBGDRAW_ERR_OK;
 }
 
-void
-dd__sphere(dd_ctx_t* ctx, dd_vec3_t* center, float radius, int32_t resolution)
+int32_t
+dd_sphere(dd_ctx_t* ctx, float* c, float radius)
 {
-  switch (ctx->cur_cmd->draw_mode)
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(c);
+
+  dd_vec3_t center_pt = dd_vec3(c[0], c[1], c[2]);
+  if (!dd__frustum_sphere_test(ctx, center_pt, radius))
   {
-    case DBGDRAW_MODE_POINT:
-    case DBGDRAW_MODE_STROKE:
-      dd__sphere_point_stroke(ctx, center, radius, resolution);
-      break;
-    case DBGDRAW_MODE_FILL:
-      dd__sphere_fill(ctx, center, radius, resolution);
-      break;
-    default:
-      break;
+    return DBGDRAW_ERR_CULLED;
+  }
+
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  if (dd__impostors_enabled(ctx))
+  {
+    return dd__procedural_prim(ctx,
+                               DBGDRAW_PROCEDURAL_IMPOSTOR_SPHERE,
+                               center_pt,
+                               dd_vec3(0.0f, 1.0f, 0.0f),
+                               radius,
+                               radius);
   }
+  if (dd__procedural_enabled(ctx))
+  {
+    return dd__procedural_prim(ctx,
+                               DBGDRAW_PROCEDURAL_SPHERE,
+                               center_pt,
+                               dd_vec3(0.0f, 1.0f, 0.0f),
+                               radius,
+                               radius);
+  }
+
+  int32_t resolution = 1 << (ctx->detail_level + 2);
+  int32_t n_rings    = 3;
+
+  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
+  mode_vert_count[DBGDRAW_MODE_POINT]  = n_rings * resolution;
+  mode_vert_count[DBGDRAW_MODE_STROKE] = n_rings * (resolution + 1) * 2;
+  mode_vert_count[DBGDRAW_MODE_FILL]   = resolution * resolution * 3;
+  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_sphere");
+  dd__sphere(ctx, &center_pt, radius, resolution);
+  DBGDRAW_TRACE_END(ctx, "dd_sphere");
+
+  return DBGDRAW_ERR_OK;
 }
 
-// NOTE(maciej): This transformation will transform a cone with a radius 1 base
-// at (0,0,0) and apex at (0, 0, 1) to a
-//               cone that has base at p and oriented as specified by rot, with
-//               height and radius controlled by parameters.
-dd_mat4_t
-dd__get_cone_xform(dd_vec3_t p, dd_mat4_t rot, float radius, float height)
+int32_t
+dd_cone(dd_ctx_t* ctx, float* a, float* b, float radius)
 {
-  dd_mat4_t xform = dd_pre_rotate(dd_mat4_identity(),
-                                  (float)DBGDRAW_PI_OVER_TWO,
-                                  dd_vec3(-1.0f, 0.0f, 0.0f));
-  xform           = dd_pre_scale(xform, dd_vec3(radius, height, radius));
-  xform           = dd_mat4_mul(rot, xform);
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(a);
+  DBGDRAW_ASSERT(b);
 
-  xform = dd_pre_translate(xform, p);
-  return xform;
+  dd_vec3_t pt_a     = dd_vec3(a[0], a[1], a[2]);
+  dd_vec3_t pt_b     = dd_vec3(b[0], b[1], b[2]);
+  int32_t resolution = 1 << (ctx->detail_level + 2);
+
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  if (dd__procedural_enabled(ctx))
+  {
+    return dd__procedural_prim(ctx,
+                               DBGDRAW_PROCEDURAL_CONICAL_FRUSTUM,
+                               pt_a,
+                               dd_vec3_sub(pt_b, pt_a),
+                               radius,
+                               0.0f);
+  }
+
+  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
+  mode_vert_count[DBGDRAW_MODE_POINT]  = DD_MAX(4, resolution >> 1) + 1;
+  mode_vert_count[DBGDRAW_MODE_STROKE] = 3 * resolution + 2;
+  mode_vert_count[DBGDRAW_MODE_FILL]   = 6 * resolution;
+  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  dd__cone(ctx, pt_a, pt_b, radius, resolution);
+
+  return DBGDRAW_ERR_OK;
 }
 
-void
-dd__cone(dd_ctx_t* ctx,
-         dd_vec3_t a,
-         dd_vec3_t b,
-         float radius,
-         int32_t resolution)
+int32_t
+dd_conical_frustum(dd_ctx_t* ctx,
+                   float* a,
+                   float* b,
+                   float radius_a,
+                   float radius_b)
 {
-  dd_mat4_t rot    = dd__generate_cone_orientation(a, b);
-  float height     = dd_vec3_norm(dd_vec3_sub(a, b));
-  bool has_normals = ctx->cur_cmd->draw_mode == DBGDRAW_MODE_FILL &&
-                     ctx->cur_cmd->shading_type != DBGDRAW_SHADING_NONE;
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(a);
+  DBGDRAW_ASSERT(b);
 
-  dd_mat4_t xform = dd__get_cone_xform(a, rot, radius, height);
+  dd_vec3_t pt_a     = dd_vec3(a[0], a[1], a[2]);
+  dd_vec3_t pt_b     = dd_vec3(b[0], b[1], b[2]);
+  int32_t resolution = 1 << (ctx->detail_level + 2);
 
-  dd_vec3_t zero_pt      = dd_vec3(0.0f, 0.0f, 0.0f);
-  dd_vertex_t* start_ptr = ctx->verts_data + ctx->verts_len;
-  dd__arc(ctx, &zero_pt, 1.0, (float)DBGDRAW_TWO_PI, resolution, 1);
-  dd_vertex_t* end_ptr = ctx->verts_data + ctx->verts_len;
-  dd__transform_verts(xform, start_ptr, end_ptr, has_normals);
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  if (radius_a == radius_b && dd__impostors_enabled(ctx))
+  {
+    return dd__procedural_prim(ctx,
+                               DBGDRAW_PROCEDURAL_IMPOSTOR_CYLINDER,
+                               pt_a,
+                               dd_vec3_sub(pt_b, pt_a),
+                               radius_a,
+                               radius_b);
+  }
+  if (dd__procedural_enabled(ctx))
+  {
+    return dd__procedural_prim(ctx,
+                               DBGDRAW_PROCEDURAL_CONICAL_FRUSTUM,
+                               pt_a,
+                               dd_vec3_sub(pt_b, pt_a),
+                               radius_a,
+                               radius_b);
+  }
 
-  dd_vec3_t apex = dd_mat4_vec3_mul(xform, dd_vec3(0.0, 0.0, 1.0), 1);
+  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
+  mode_vert_count[DBGDRAW_MODE_POINT]  = 2 * DD_MAX(4, resolution >> 1);
+  mode_vert_count[DBGDRAW_MODE_STROKE] = 5 * resolution + 4;
+  mode_vert_count[DBGDRAW_MODE_FILL]   = 12 * resolution;
+  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
 
-  switch (ctx->cur_cmd->draw_mode)
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  dd__conical_frustum(ctx, pt_a, pt_b, radius_a, radius_b, resolution);
+
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_cylinder(dd_ctx_t* ctx, float* a, float* b, float radius)
+{
+  return dd_conical_frustum(ctx, a, b, radius, radius);
+}
+
+int32_t
+dd_capsule(dd_ctx_t* ctx, float* a, float* b, float radius)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(a);
+  DBGDRAW_ASSERT(b);
+
+  dd_vec3_t pt_a = dd_vec3(a[0], a[1], a[2]);
+  dd_vec3_t pt_b = dd_vec3(b[0], b[1], b[2]);
+  dd_vec3_t v    = dd_vec3_sub(pt_b, pt_a);
+  dd_vec3_t pt_c = dd_vec3_add(pt_a, dd_vec3_scalar_mul(v, 0.5f));
+  if (!dd__frustum_sphere_test(ctx, pt_c, 0.5f * dd_vec3_norm(v) + radius))
   {
-    case DBGDRAW_MODE_POINT:
-      dd__vertex(ctx, &apex);
-      break;
-    case DBGDRAW_MODE_STROKE:
-      for (int32_t i = 0; i < (resolution >> 1); ++i)
-      {
-        dd_vec3_t pt = dd_vec4_to_vec3(start_ptr->pos_size);
-        dd__line(ctx, &pt, &apex);
-        start_ptr += 4;
-      }
-      break;
-    case DBGDRAW_MODE_FILL:
-      for (int32_t i = 0; i < resolution; ++i)
-      {
-        start_ptr++;
-        dd_vec3_t p1 = dd_vec4_to_vec3(start_ptr->pos_size);
-        start_ptr++;
-        dd_vec3_t p2 = dd_vec4_to_vec3(start_ptr->pos_size);
-        start_ptr++;
-        if (has_normals)
-        {
-          dd_vec3_t normal = dd_vec3_normalize(
-            dd_vec3_cross(dd_vec3_sub(p1, apex), dd_vec3_sub(p2, apex)));
-          dd__triangle_normal(ctx, &p2, &p1, &apex, &normal);
-        }
-        else
-        {
-          dd__triangle(ctx, &p2, &p1, &apex);
-        }
-      }
-      break;
-    default:
-      break;
+    return DBGDRAW_ERR_CULLED;
   }
-}
 
-void
-dd__conical_frustum(dd_ctx_t* ctx,
-                    dd_vec3_t a,
-                    dd_vec3_t b,
-                    float radius_a,
-                    float radius_b,
-                    int32_t resolution)
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  if (dd__impostors_enabled(ctx))
+  {
+    return dd__procedural_prim(ctx,
+                               DBGDRAW_PROCEDURAL_IMPOSTOR_CAPSULE,
+                               pt_a,
+                               v,
+                               radius,
+                               radius);
+  }
+
+  // Without impostor support capsule is composed of a cylinder and two spheres.
+  int32_t error = dd_cylinder(ctx, pt_a.data, pt_b.data, radius);
+  if (error && error != DBGDRAW_ERR_CULLED) { return error; }
+  error = dd_sphere(ctx, pt_a.data, radius);
+  if (error && error != DBGDRAW_ERR_CULLED) { return error; }
+  error = dd_sphere(ctx, pt_b.data, radius);
+  if (error && error != DBGDRAW_ERR_CULLED) { return error; }
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_arrow(dd_ctx_t* ctx,
+         float* a,
+         float* b,
+         float radius,
+         float head_radius,
+         float head_length)
 {
-  dd_mat4_t rot    = dd__generate_cone_orientation(a, b);
-  float height     = dd_vec3_norm(dd_vec3_sub(a, b));
-  bool has_normals = ctx->cur_cmd->draw_mode == DBGDRAW_MODE_FILL &&
-                     ctx->cur_cmd->shading_type != DBGDRAW_SHADING_NONE;
-  dd_vec3_t pt_bottom = dd_vec3(0.0f, 0.0f, 0.0f);
-  dd_vec3_t pt_top    = dd_vec3(0.0f, 0.0f, 1.0f);
+  dd_vec3_t pt_a = dd_vec3(a[0], a[1], a[2]);
+  dd_vec3_t pt_b = dd_vec3(b[0], b[1], b[2]);
+  dd_vec3_t v    = dd_vec3_sub(pt_b, pt_a);
+  dd_vec3_t pt_c = dd_vec3_add(pt_a, dd_vec3_scalar_mul(v, head_length));
 
-  dd_mat4_t xform_a = dd__get_cone_xform(a, rot, radius_a, height);
-  dd_mat4_t xform_b = dd__get_cone_xform(a, rot, radius_b, height);
+  bool error = dd_cone(ctx, pt_c.data, pt_b.data, head_radius);
+  if (error) { return error; }
+  return dd_conical_frustum(ctx, pt_a.data, pt_c.data, radius, radius);
+}
 
-  dd_vertex_t* start_ptr_1 = ctx->verts_data + ctx->verts_len;
-  dd__arc(ctx, &pt_bottom, 1.0f, (float)DBGDRAW_TWO_PI, resolution, 1);
-  dd_vertex_t* end_ptr_1 = ctx->verts_data + ctx->verts_len;
-  dd__transform_verts(xform_a, start_ptr_1, end_ptr_1, 0);
+int32_t
+dd_torus(dd_ctx_t* ctx, float* center, float radius_a, float radius_b)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(center);
 
-  // NOTE(maciej): We do not transform normals above, as it contains schale.
-  //               Instead we will just recompute the normal and set it.
-  if (has_normals)
+  dd_mat3_t axes      = dd_mat3_identity();
+  axes.col[0].x       = radius_a * 2;
+  axes.col[1].y       = radius_b * 2;
+  axes.col[2].z       = radius_a * 2;
+  dd_vec3_t center_pt = dd_vec3(center[0], center[1], center[2]);
+  if (!dd__frustum_obb_test(ctx, center_pt, axes))
   {
-    dd_vec3_t pos_1_a = dd_vec4_to_vec3(start_ptr_1->pos_size);
-    dd_vec3_t pos_1_b = dd_vec4_to_vec3((start_ptr_1 + 1)->pos_size);
-    dd_vec3_t pos_1_c = dd_vec4_to_vec3((start_ptr_1 + 2)->pos_size);
-    dd_vec3_t normal_1 =
-      dd_vec3_normalize(dd_vec3_cross(dd_vec3_sub(pos_1_c, pos_1_a),
-                                      dd_vec3_sub(pos_1_b, pos_1_a)));
-    for (dd_vertex_t* it = start_ptr_1; it != end_ptr_1; ++it)
-    {
-      it->normal = normal_1;
-    }
+    return DBGDRAW_ERR_CULLED;
   }
 
-  dd_vertex_t* start_ptr_2 = ctx->verts_data + ctx->verts_len;
-  dd__arc(ctx, &pt_top, 1.0f, (float)DBGDRAW_TWO_PI, resolution, 0);
-  dd_vertex_t* end_ptr_2 = ctx->verts_data + ctx->verts_len;
-  dd__transform_verts(xform_b, start_ptr_2, end_ptr_2, 0);
-
-  if (has_normals)
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  if (dd__procedural_enabled(ctx))
   {
-    dd_vec3_t pos_2_a = dd_vec4_to_vec3(start_ptr_2->pos_size);
-    dd_vec3_t pos_2_b = dd_vec4_to_vec3((start_ptr_2 + 1)->pos_size);
-    dd_vec3_t pos_2_c = dd_vec4_to_vec3((start_ptr_2 + 2)->pos_size);
-    dd_vec3_t normal_2 =
-      dd_vec3_normalize(dd_vec3_cross(dd_vec3_sub(pos_2_c, pos_2_a),
-                                      dd_vec3_sub(pos_2_b, pos_2_a)));
-    for (dd_vertex_t* it = start_ptr_2; it != end_ptr_2; ++it)
-    {
-      it->normal = normal_2;
-    }
+    return dd__procedural_prim(ctx,
+                               DBGDRAW_PROCEDURAL_TORUS,
+                               center_pt,
+                               dd_vec3(0.0f, 1.0f, 0.0f),
+                               radius_a,
+                               radius_b);
   }
 
+  int32_t resolution    = 1 << (ctx->detail_level + 2);
+  int32_t n_big_rings   = 4;
+  int32_t n_small_rings = resolution >> 1;
+  int32_t n_rings       = n_big_rings + n_small_rings;
+  int32_t small_res     = DD_MAX(4, resolution >> 1);
+
+  // Full circles in stroke mode have an extra segment, see dd__arc_stroke
+  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
+  mode_vert_count[DBGDRAW_MODE_POINT]  = n_rings * resolution;
+  mode_vert_count[DBGDRAW_MODE_STROKE] = n_big_rings * (resolution + 1) * 2 +
+                                         n_small_rings * (small_res + 1) * 2;
+  mode_vert_count[DBGDRAW_MODE_FILL]   = small_res * resolution * 2 * 3;
+  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+
+  DD_GROW(ctx,
+          ctx->verts_data,
+          ctx->verts_len + new_verts,
+          ctx->verts_cap,
+          sizeof(dd_vertex_t));
+
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_torus");
   switch (ctx->cur_cmd->draw_mode)
   {
     case DBGDRAW_MODE_POINT:
+      dd__torus_point_stroke(ctx,
+                             center_pt,
+                             radius_a,
+                             radius_b,
+                             resolution >> 1,
+                             n_small_rings);
       break;
     case DBGDRAW_MODE_STROKE:
-      for (int32_t i = 0; i < resolution >> 1; ++i)
-      {
-        dd_vec3_t p1 = dd_vec4_to_vec3(start_ptr_1->pos_size);
-        dd_vec3_t p2 = dd_vec4_to_vec3(start_ptr_2->pos_size);
-        dd__line(ctx, &p1, &p2);
-        start_ptr_1 += 4;
-        start_ptr_2 += 4;
-      }
-      break;
-    case DBGDRAW_MODE_FILL:
-      for (int32_t i = 0; i < resolution; ++i)
-      {
-        start_ptr_1++;
-        start_ptr_2++;
-        dd_vec3_t p1 = dd_vec4_to_vec3(start_ptr_1->pos_size);
-        start_ptr_1++;
-        dd_vec3_t p2 = dd_vec4_to_vec3(start_ptr_1->pos_size);
-        dd_vec3_t p3 = dd_vec4_to_vec3(start_ptr_2->pos_size);
-        start_ptr_2++;
-        dd_vec3_t p4 = dd_vec4_to_vec3(start_ptr_2->pos_size);
-        start_ptr_1++;
-        start_ptr_2++;
-        if (has_normals)
-        {
-          dd_vec3_t normal = dd_vec3_normalize(
-            dd_vec3_cross(dd_vec3_sub(p2, p1), dd_vec3_sub(p3, p1)));
-          dd__triangle_normal(ctx, &p2, &p1, &p3, &normal);
-          dd__triangle_normal(ctx, &p3, &p1, &p4, &normal);
-        }
-        else
-        {
-          dd__triangle(ctx, &p2, &p1, &p3);
-          dd__triangle(ctx, &p3, &p1, &p4);
-        }
-      }
+      dd__torus_point_stroke(ctx,
+                             center_pt,
+                             radius_a,
+                             radius_b,
+                             resolution,
+                             n_small_rings);
       break;
     default:
+      dd__torus_fill(ctx,
+                     center_pt,
+                     radius_a,
+                     radius_b,
+                     resolution,
+                     n_small_rings);
       break;
   }
-}
-
-void
-dd__torus_point_stroke(dd_ctx_t* ctx,
-                       dd_vec3_t center,
-                       float radius_a,
-                       float radius_b,
-                       int32_t resolution,
-                       int32_t n_small_rings)
-{
-  /* Store useful data */
-  dd_vertex_t* base_ptr = ctx->verts_data + ctx->verts_len;
-  dd_mat4_t xform       = dd_mat4_identity();
-  dd_mat4_t rotx =
-    dd_pre_rotate(xform, (float)DBGDRAW_PI_OVER_TWO, dd_vec3(1.0f, 0.0f, 0.0f));
-  float radius           = 1.0f;
-  dd_vertex_t* start_ptr = base_ptr;
-  dd_vertex_t* end_ptr   = base_ptr;
-  size_t len;
-  dd_vec3_t zero_pt = dd_vec3(0.0f, 0.0f, 0.0f);
-  /* We do large circles only for stroke mode */
-  if (ctx->cur_cmd->draw_mode == DBGDRAW_MODE_STROKE)
-  {
-    /* create unit circle, and get data boundaries */
-    start_ptr = base_ptr;
-    dd__arc(ctx, &zero_pt, 1.0f, (float)DBGDRAW_TWO_PI, resolution, 0);
-    end_ptr = ctx->verts_data + ctx->verts_len;
-    len     = end_ptr - start_ptr;
-
-    /* copy the memory, so that we have all the rings we need. Also make sure to
-     * move verts_len accordingly */
-    for (int32_t i = 1; i < 4; ++i)
-    {
-      memcpy(end_ptr, start_ptr, len * sizeof(dd_vertex_t));
-      end_ptr += len;
-      start_ptr += len;
-    }
+  DBGDRAW_TRACE_END(ctx, "dd_torus");
 
-    /* Large outer circle */
-    radius    = radius_a + radius_b;
-    xform     = dd_pre_scale(rotx, dd_vec3(radius, radius, radius));
-    xform     = dd_pre_translate(xform, center);
-    start_ptr = base_ptr;
-    end_ptr   = start_ptr + len;
-    dd__transform_verts(xform, start_ptr, end_ptr, 0);
+  return DBGDRAW_ERR_OK;
+}
 
-    /* Smaller inner circle */
-    radius    = radius_a - radius_b;
-    xform     = dd_pre_scale(rotx, dd_vec3(radius, radius, radius));
-    xform     = dd_pre_translate(xform, center);
-    start_ptr = end_ptr;
-    end_ptr   = start_ptr + len;
-    dd__transform_verts(xform, start_ptr, end_ptr, 0);
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Font Loading
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    /* Medium top circle */
-    xform = dd_pre_scale(rotx, dd_vec3(radius_a, radius_a, radius_a));
-    xform =
-      dd_pre_translate(xform,
-                       dd_vec3_add(dd_vec3(0.0f, radius_b, 0.0f), center));
-    start_ptr = end_ptr;
-    end_ptr   = start_ptr + len;
-    dd__transform_verts(xform, start_ptr, end_ptr, 0);
+#if DBGDRAW_HAS_TEXT_SUPPORT
 
-    /* Medium bottom circle */
-    xform = dd_pre_scale(rotx, dd_vec3(radius_a, radius_a, radius_a));
-    xform =
-      dd_pre_translate(xform,
-                       dd_vec3_add(center, dd_vec3(0.0f, -radius_b, 0.0f)));
-    start_ptr = end_ptr;
-    end_ptr   = start_ptr + len;
-    dd__transform_verts(xform, start_ptr, end_ptr, 0);
+// stb_truetype does not need the size of the font data, so the size is taken
+// from the table directory - the end of the furthest table
+uint32_t
+dd__read_u32_be(const uint8_t* data)
+{
+  return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+         ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
 
-    ctx->verts_len += (int32_t)len * 3;
-    ctx->cur_cmd->vertex_count += (int32_t)len * 3;
+size_t
+dd__ttf_size(const uint8_t* ttf_data)
+{
+  size_t size        = 12;
+  int32_t num_tables = (ttf_data[4] << 8) | ttf_data[5];
+  for (int32_t i = 0; i < num_tables; ++i)
+  {
+    const uint8_t* record = ttf_data + 12 + 16 * i;
+    size_t table_end =
+      (size_t)dd__read_u32_be(record + 8) + dd__read_u32_be(record + 12);
+    size = DD_MAX(size, table_end);
   }
+  return size;
+}
 
-  /* create data for small circles, and get data boundaries */
-  base_ptr    = end_ptr;
-  start_ptr   = base_ptr;
-  int32_t res = DD_MAX(resolution >> 1, 4);
-  dd__arc(ctx, &zero_pt, 1.0f, (float)DBGDRAW_TWO_PI, res, 0);
-  end_ptr = ctx->verts_data + ctx->verts_len;
-  len     = end_ptr - start_ptr;
+void
+dd__free_font(dd_font_data_t* font)
+{
+  DBGDRAW_FREE(font->name);
+  DBGDRAW_FREE(font->ttf_data);
+  DBGDRAW_FREE(font->bitmap);
+  DBGDRAW_FREE(font->glyphs);
+  DBGDRAW_FREE(font->glyph_table);
+  DBGDRAW_FREE(font->ascii_glyphs);
+  memset(font, 0, sizeof(dd_font_data_t));
+}
 
-  /* copy the memory, so that we have all the rings we need. Also make sure to
-   * move verts_len accordingly */
-  for (int32_t i = 1; i < n_small_rings; ++i)
-  {
-    memcpy(end_ptr, start_ptr, len * sizeof(dd_vertex_t));
-    end_ptr += len;
-    start_ptr += len;
-  }
-  start_ptr = base_ptr;
-  end_ptr   = start_ptr + len;
+// Inflates the ttf data of the default font, other fonts always have it
+int32_t
+dd__load_font_ttf(dd_font_data_t* font)
+{
+  if (font->ttf_data) { return DBGDRAW_ERR_OK; }
+#ifdef DBGDRAW_USE_DEFAULT_FONT
+  font->ttf_data = DBGDRAW_MALLOC(font->ttf_size);
+  if (!font->ttf_data) { return DBGDRAW_ERR_FAILED_ALLOC; }
+  int32_t size =
+    dbgdraw__inflate(font->ttf_data, font->deflated_ttf, font->deflated_size);
+  DBGDRAW_ASSERT(size == font->ttf_size);
+  (void)size; /* Silence warning in release */
+  stbtt_InitFont(&font->info, font->ttf_data, 0);
+  return DBGDRAW_ERR_OK;
+#else
+  return DBGDRAW_ERR_FAILED_ALLOC;
+#endif
+}
 
-  /* small circles around the torus */
-  float theta = (float)DBGDRAW_TWO_PI / n_small_rings;
-  xform       = dd_pre_scale(rotx, dd_vec3(radius_b, radius_b, radius_b));
-  xform =
-    dd_pre_rotate(xform, (float)DBGDRAW_PI_OVER_TWO, dd_vec3(1.0f, 0.0f, 0.0f));
-  xform = dd_pre_translate(xform, dd_vec3(radius_a, 0.0f, 0.0f));
-  for (int32_t i = 0; i < n_small_rings; ++i)
-  {
-    xform            = dd_pre_rotate(xform, theta, dd_vec3(0.0f, 1.0f, 0.0f));
-    dd_mat4_t cxform = dd_pre_translate(xform, center);
+uint32_t
+dd__glyph_hash(uint32_t codepoint)
+{
+  // Knuth's multiplicative hash
+  return codepoint * 2654435761u;
+}
 
-    dd__transform_verts(cxform, start_ptr, end_ptr, 0);
-    start_ptr = end_ptr;
-    end_ptr   = start_ptr + len;
+int32_t
+dd__find_glyph(dd_font_data_t* font, uint32_t codepoint)
+{
+  uint32_t mask = font->glyph_table_mask;
+  for (uint32_t i = dd__glyph_hash(codepoint) & mask;; i = (i + 1) & mask)
+  {
+    int32_t glyph_idx = font->glyph_table[i];
+    if (glyph_idx < 0) { return -1; }
+    if (font->glyphs[glyph_idx].codepoint == codepoint) { return glyph_idx; }
   }
+}
 
-  /* Tell the context that there is new vertex data */
-  ctx->verts_len += (int32_t)len * (n_small_rings - 1);
-  ctx->cur_cmd->vertex_count += (int32_t)len * (n_small_rings - 1);
+void
+dd__insert_glyph(dd_font_data_t* font, int32_t glyph_idx)
+{
+  uint32_t mask = font->glyph_table_mask;
+  uint32_t i    = dd__glyph_hash(font->glyphs[glyph_idx].codepoint) & mask;
+  while (font->glyph_table[i] >= 0) { i = (i + 1) & mask; }
+  font->glyph_table[i] = glyph_idx;
 }
 
+// Linear probing, so instead of leaving a tombstone, following entries are
+// shifted back into the hole if it is on their probe sequence
 void
-dd__torus_fill(dd_ctx_t* ctx,
-               dd_vec3_t center,
-               float radius_a,
-               float radius_b,
-               int32_t resolution,
-               int32_t n_small_rings)
+dd__remove_glyph(dd_font_data_t* font, int32_t glyph_idx)
 {
-  (void)n_small_rings;
+  uint32_t mask = font->glyph_table_mask;
+  uint32_t hole = dd__glyph_hash(font->glyphs[glyph_idx].codepoint) & mask;
+  while (font->glyph_table[hole] != glyph_idx) { hole = (hole + 1) & mask; }
 
-  bool has_normals = ctx->cur_cmd->draw_mode == DBGDRAW_MODE_FILL &&
-                     ctx->cur_cmd->shading_type != DBGDRAW_SHADING_NONE;
-  int32_t res_a = resolution;
-  int32_t res_b = DD_MAX(4, resolution >> 1);
-  float step_a  = (float)DBGDRAW_TWO_PI / res_a;
-  float step_b  = (float)DBGDRAW_TWO_PI / res_b;
-  float ax      = radius_a;
-  float ay      = 0.0f;
-  float az      = 0.0f;
-  dd_vec3_t p1, p2, p3;
-  dd_vec3_t normal;
-  for (int32_t i = 0; i < res_a; ++i)
+  for (uint32_t i = (hole + 1) & mask; font->glyph_table[i] >= 0;
+       i          = (i + 1) & mask)
   {
-    float c1 = DBGDRAW_COS(i * step_a);
-    float c2 = DBGDRAW_COS((i + 1) * step_a);
-    float s1 = DBGDRAW_SIN(i * step_a);
-    float s2 = DBGDRAW_SIN((i + 1) * step_a);
-
-    float s1az = s1 * az;
-    float c1az = c1 * az;
-    float s2az = s2 * az;
-    float c2az = c2 * az;
-
-    for (int32_t j = 0; j < res_b; ++j)
+    dd_glyph_t* glyph = font->glyphs + font->glyph_table[i];
+    uint32_t home     = dd__glyph_hash(glyph->codepoint) & mask;
+    if (((i - home) & mask) >= ((i - hole) & mask))
     {
-      float bx0 = (ax + radius_b * DBGDRAW_COS(j * step_b));
-      float by0 = (ay + radius_b * DBGDRAW_SIN(j * step_b));
+      font->glyph_table[hole] = font->glyph_table[i];
+      hole                    = i;
+    }
+  }
+  font->glyph_table[hole] = -1;
+}
 
-      float bx1 = (ax + radius_b * DBGDRAW_COS((j + 1) * step_b));
-      float by1 = (ay + radius_b * DBGDRAW_SIN((j + 1) * step_b));
+// Uploads are not merged into a single rectangle, since with pipelined
+// rendering, cells next to the new glyph might be rewritten by the recording
+// thread while the upload reads them
+int32_t
+dd__queue_glyph_upload(dd_ctx_t* ctx,
+                       int32_t font_idx,
+                       int32_t x0,
+                       int32_t y0,
+                       int32_t x1,
+                       int32_t y1)
+{
+  DD_GROW(ctx,
+          ctx->glyph_uploads,
+          ctx->glyph_uploads_len + 1,
+          ctx->glyph_uploads_cap,
+          sizeof(dd_glyph_upload_t));
+  ctx->glyph_uploads[ctx->glyph_uploads_len++] =
+    (dd_glyph_upload_t) {font_idx, x0, y0, x1, y1};
+  return DBGDRAW_ERR_OK;
+}
 
-      float bx2 = c1 * bx0 - s1az;
-      float bz2 = s1 * bx0 + c1az;
+int32_t
+dd__flush_glyph_uploads(dd_ctx_t* ctx)
+{
+  int32_t error = DBGDRAW_ERR_OK;
+  for (int32_t i = 0; i < ctx->glyph_uploads_len && !error; ++i)
+  {
+    dd_glyph_upload_t* upload = ctx->glyph_uploads + i;
+    dd_font_data_t* font      = ctx->fonts + upload->font_idx;
+    error = dd_backend_update_font_texture(ctx,
+                                           font->bitmap,
+                                           font->bitmap_width,
+                                           font->bitmap_height,
+                                           upload->x0,
+                                           upload->y0,
+                                           upload->x1 - upload->x0,
+                                           upload->y1 - upload->y0,
+                                           &font->tex_id);
+  }
+  ctx->glyph_uploads_len = 0;
+  return error;
+}
 
-      float bx3 = c1 * bx1 - s1az;
-      float bz3 = s1 * bx1 + c1az;
+// Returns the cell for a new glyph, or -1 if every glyph is still in use
+int32_t
+dd__alloc_glyph(dd_ctx_t* ctx, dd_font_data_t* font)
+{
+  if (font->glyphs_len < font->glyphs_cap) { return font->glyphs_len++; }
 
-      float bx4 = c2 * bx0 - s2az;
-      float bz4 = s2 * bx0 + c2az;
+  // Frames that were submitted, but not rendered yet, still refer to the glyphs
+  // they used
+  uint32_t frames_in_flight = ctx->frame_ring ? ctx->frame_ring->depth : 0;
+  int32_t lru_idx           = -1;
+  for (int32_t i = 0; i < font->glyphs_cap; ++i)
+  {
+    dd_glyph_t* glyph = font->glyphs + i;
+    if (glyph->last_used_frame + frames_in_flight < ctx->frame_idx &&
+        (lru_idx < 0 ||
+         glyph->last_used_frame < font->glyphs[lru_idx].last_used_frame))
+    {
+      lru_idx = i;
+    }
+  }
+  if (lru_idx >= 0)
+  {
+    dd__remove_glyph(font, lru_idx);
+    font->generation++;
+  }
+  return lru_idx;
+}
 
-      float bx5 = c2 * bx1 - s2az;
-      float bz5 = s2 * bx1 + c2az;
+// Distance fields extend DD_SDF_PADDING pixels to both sides of the outline,
+// which is at 128. Shaders expect the same values.
+#define DD_SDF_PADDING 4
 
-      p1.x = bx2;
-      p1.y = by0, p1.z = bz2;
-      p2.x = bx4;
-      p2.y = by0, p2.z = bz4;
-      p3.x = bx3;
-      p3.y = by1, p3.z = bz3;
-      p1 = dd_vec3_add(p1, center);
-      p2 = dd_vec3_add(p2, center);
-      p3 = dd_vec3_add(p3, center);
-      if (has_normals)
-      {
-        normal = dd_vec3_normalize(
-          dd_vec3_cross(dd_vec3_sub(p2, p1), dd_vec3_sub(p3, p1)));
-        dd__triangle_normal(ctx, &p2, &p1, &p3, &normal);
-      }
-      else
-      {
-        dd__triangle(ctx, &p2, &p1, &p3);
-      }
+// Bitmap glyphs are rasterized at this many texels per pixel in both directions
+#define DD_GLYPH_OVERSAMPLING 2
 
-      p1.x = bx3;
-      p1.y = by1, p1.z = bz3;
-      p2.x = bx4;
-      p2.y = by0, p2.z = bz4;
-      p3.x = bx5;
-      p3.y = by1, p3.z = bz5;
-      p1 = dd_vec3_add(p1, center);
-      p2 = dd_vec3_add(p2, center);
-      p3 = dd_vec3_add(p3, center);
-      if (has_normals) { dd__triangle_normal(ctx, &p2, &p1, &p3, &normal); }
-      else
-      {
-        dd__triangle(ctx, &p2, &p1, &p3);
-      }
-    }
+void
+dd__rasterize_sdf_glyph(dd_font_data_t* font,
+                        uint32_t codepoint,
+                        uint8_t* cell,
+                        dd_glyph_t* glyph)
+{
+  float scale = stbtt_ScaleForPixelHeight(&font->info, (float)font->size);
+  int32_t w = 0, h = 0, xoff = 0, yoff = 0;
+  uint8_t* sdf = stbtt_GetCodepointSDF(&font->info,
+                                       scale,
+                                       codepoint,
+                                       DD_SDF_PADDING,
+                                       128,
+                                       128.0f / DD_SDF_PADDING,
+                                       &w,
+                                       &h,
+                                       &xoff,
+                                       &yoff);
+
+  // Glyphs without an outline, like space, only advance
+  int32_t cell_w = sdf ? DD_MIN(w, font->cell_width) : 0;
+  int32_t cell_h = sdf ? DD_MIN(h, font->cell_height) : 0;
+  for (int32_t y = 0; y < cell_h; ++y)
+  {
+    memcpy(cell + y * font->bitmap_width, sdf + y * w, cell_w);
   }
-}
+  stbtt_FreeSDF(sdf, NULL);
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Public Draw Commands
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  int32_t advance, lsb;
+  stbtt_GetCodepointHMetrics(&font->info, codepoint, &advance, &lsb);
+  glyph->quad.x1       = (unsigned short)cell_w;
+  glyph->quad.y1       = (unsigned short)cell_h;
+  glyph->quad.xoff     = (float)xoff;
+  glyph->quad.yoff     = (float)yoff;
+  glyph->quad.xoff2    = (float)(xoff + cell_w);
+  glyph->quad.yoff2    = (float)(yoff + cell_h);
+  glyph->quad.xadvance = scale * advance;
+}
 
-int32_t
-dd__point_ex(dd_ctx_t* ctx, float* a, uint8_t is_3d)
+// Rasterizes the codepoint into the cell of 'glyph_idx' and adds it to the glyph
+// table. Touches only the font, so it also runs on the async loading threads
+void
+dd__rasterize_glyph(dd_font_data_t* font, int32_t glyph_idx, uint32_t codepoint)
 {
-  DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(a);
+  int32_t cells_per_row = font->bitmap_width / font->cell_width;
+  int32_t x0            = (glyph_idx % cells_per_row) * font->cell_width;
+  int32_t y0            = (glyph_idx / cells_per_row) * font->cell_height;
+  uint8_t* cell         = font->bitmap + y0 * font->bitmap_width + x0;
+  for (int32_t y = 0; y < font->cell_height; ++y)
+  {
+    memset(cell + y * font->bitmap_width, 0, font->cell_width);
+  }
 
-  int32_t new_verts = 1;
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
+  dd_glyph_t* glyph = font->glyphs + glyph_idx;
+  memset(glyph, 0, sizeof(dd_glyph_t));
+  glyph->codepoint = codepoint;
 
-  dd_vec3_t pt_a = dd_vec3(a[0], a[1], is_3d ? a[2] : 0.0f);
-  dd__vertex(ctx, &pt_a);
+  if (font->is_sdf) { dd__rasterize_sdf_glyph(font, codepoint, cell, glyph); }
+  else
+  {
+    // Packing into a single cell, with the atlas row stride
+    stbtt_pack_context spc = {0};
+    stbtt_PackBegin(&spc,
+                    cell,
+                    font->cell_width,
+                    font->cell_height,
+                    font->bitmap_width,
+                    1,
+                    NULL);
+    stbtt_PackSetOversampling(
+      &spc, DD_GLYPH_OVERSAMPLING, DD_GLYPH_OVERSAMPLING);
+    stbtt_PackFontRange(&spc,
+                        font->ttf_data,
+                        0,
+                        (float)font->size,
+                        codepoint,
+                        1,
+                        &glyph->quad);
+    stbtt_PackEnd(&spc);
+  }
+  glyph->quad.x0 += x0;
+  glyph->quad.x1 += x0;
+  glyph->quad.y0 += y0;
+  glyph->quad.y1 += y0;
 
-  return DBGDRAW_ERR_OK;
+  dd__insert_glyph(font, glyph_idx);
 }
 
+// Returns the glyph for the codepoint, rasterizing it if needed. -1 if the
+// atlas has no room left for it in this frame
 int32_t
-dd_point(dd_ctx_t* ctx, float* a)
+dd__get_glyph(dd_ctx_t* ctx, int32_t font_idx, uint32_t codepoint)
 {
-  return dd__point_ex(ctx, a, 1);
+  dd_font_data_t* font = ctx->fonts + font_idx;
+  int32_t glyph_idx    = dd__find_glyph(font, codepoint);
+  if (glyph_idx < 0)
+  {
+    if (dd__load_font_ttf(font)) { return -1; }
+    glyph_idx = dd__alloc_glyph(ctx, font);
+    if (glyph_idx < 0) { return -1; }
+
+    dd__rasterize_glyph(font, glyph_idx, codepoint);
+
+    int32_t cells_per_row = font->bitmap_width / font->cell_width;
+    int32_t x0            = (glyph_idx % cells_per_row) * font->cell_width;
+    int32_t y0            = (glyph_idx / cells_per_row) * font->cell_height;
+    if (dd__queue_glyph_upload(ctx,
+                               font_idx,
+                               x0,
+                               y0,
+                               x0 + font->cell_width,
+                               y0 + font->cell_height))
+    {
+      return -1;
+    }
+  }
+  font->glyphs[glyph_idx].last_used_frame = ctx->frame_idx;
+  return glyph_idx;
 }
 
+// Fills the quad of the glyph, advances 'x' and returns the glyph. Returns -1 if
+// the glyph could not be placed in the atlas, in which case only 'x' is advanced
 int32_t
-dd_point2d(dd_ctx_t* ctx, float* a)
+dd__get_glyph_quad(dd_ctx_t* ctx,
+                   int32_t font_idx,
+                   uint32_t codepoint,
+                   float* x,
+                   float* y,
+                   stbtt_aligned_quad* q)
 {
-  return dd__point_ex(ctx, a, 0);
+  dd_font_data_t* font = ctx->fonts + font_idx;
+  int32_t glyph_idx    = dd__get_glyph(ctx, font_idx, codepoint);
+  if (glyph_idx < 0)
+  {
+    if (font->ttf_data)
+    {
+      int32_t advance, lsb;
+      stbtt_GetCodepointHMetrics(&font->info, codepoint, &advance, &lsb);
+      *x +=
+        advance * stbtt_ScaleForPixelHeight(&font->info, (float)font->size);
+    }
+    return -1;
+  }
+  stbtt_GetPackedQuad(&font->glyphs[glyph_idx].quad,
+                      font->bitmap_width,
+                      font->bitmap_height,
+                      0,
+                      x,
+                      y,
+                      q,
+                      0);
+  return glyph_idx;
+}
+
+#ifdef DBGDRAW_FONT_CACHE_DIR
+// Cache files hold the header, the glyphs and the rows of the atlas that the
+// glyphs occupy. The key covers the font data and everything that changes how
+// glyphs are rasterized.
+#define DD_FONT_CACHE_MAGIC   0x43464444
+#define DD_FONT_CACHE_VERSION 1
+
+typedef struct dd_font_cache_header
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+  float ascent, descent, line_gap;
+  int32_t cell_width, cell_height;
+  int32_t glyphs_len;
+  int32_t bitmap_rows;
+  int32_t padding;
+} dd_font_cache_header_t;
+
+uint64_t
+dd__font_cache_key(dd_font_data_t* font, const void* ttf_buf, size_t size)
+{
+  // FNV-1a
+  int32_t params[7] = {(int32_t)font->size,
+                       font->bitmap_width,
+                       font->bitmap_height,
+                       font->is_sdf,
+                       DD_GLYPH_OVERSAMPLING,
+                       DD_SDF_PADDING,
+                       (int32_t)sizeof(dd_glyph_t)};
+  uint64_t hash        = 14695981039346656037ull;
+  const uint8_t* bytes = (const uint8_t*)ttf_buf;
+  for (size_t i = 0; i < size; ++i)
+  {
+    hash = (hash ^ bytes[i]) * 1099511628211ull;
+  }
+  bytes = (const uint8_t*)params;
+  for (size_t i = 0; i < sizeof(params); ++i)
+  {
+    hash = (hash ^ bytes[i]) * 1099511628211ull;
+  }
+  return hash;
+}
+
+void
+dd__font_cache_path(uint64_t key, char* path, size_t size)
+{
+  snprintf(path,
+           size,
+           "%s/dbgdraw_font_%016llx.bin",
+           DBGDRAW_FONT_CACHE_DIR,
+           (unsigned long long)key);
+}
+
+// Restores metrics, glyphs and the atlas of the font. On failure the font is
+// left as it was
+bool
+dd__read_font_cache(dd_font_data_t* font, uint64_t key, uint32_t frame_idx)
+{
+  char path[512];
+  dd__font_cache_path(key, path, sizeof(path));
+  FILE* fp = fopen(path, "rb");
+  if (!fp) { return false; }
+
+  dd_font_cache_header_t header;
+  bool valid = fread(&header, sizeof(header), 1, fp) == 1 &&
+               header.magic == DD_FONT_CACHE_MAGIC &&
+               header.version == DD_FONT_CACHE_VERSION && header.key == key &&
+               header.cell_width > 0 && header.cell_height > 0 &&
+               header.cell_width <= font->bitmap_width &&
+               header.cell_height <= font->bitmap_height &&
+               header.bitmap_rows >= 0 &&
+               header.bitmap_rows <= font->bitmap_height;
+  int32_t glyphs_cap = valid ? (font->bitmap_width / header.cell_width) *
+                                 (font->bitmap_height / header.cell_height)
+                             : 0;
+  valid = valid && header.glyphs_len >= 0 && header.glyphs_len <= glyphs_cap;
+
+  dd_glyph_t* glyphs = NULL;
+  if (valid)
+  {
+    glyphs = DBGDRAW_MALLOC(glyphs_cap * sizeof(dd_glyph_t));
+    valid  = glyphs &&
+            fread(glyphs, sizeof(dd_glyph_t), header.glyphs_len, fp) ==
+              (size_t)header.glyphs_len &&
+            fread(font->bitmap,
+                  font->bitmap_width,
+                  header.bitmap_rows,
+                  fp) == (size_t)header.bitmap_rows;
+  }
+  fclose(fp);
+  if (!valid)
+  {
+    DBGDRAW_FREE(glyphs);
+    memset(font->bitmap, 0, font->bitmap_width * font->bitmap_height);
+    return false;
+  }
+
+  font->ascent      = header.ascent;
+  font->descent     = header.descent;
+  font->line_gap    = header.line_gap;
+  font->cell_width  = header.cell_width;
+  font->cell_height = header.cell_height;
+  font->glyphs      = glyphs;
+  font->glyphs_len  = header.glyphs_len;
+  font->glyphs_cap  = glyphs_cap;
+  for (int32_t i = 0; i < font->glyphs_len; ++i)
+  {
+    font->glyphs[i].last_used_frame = frame_idx;
+  }
+  return true;
 }
 
+void
+dd__write_font_cache(dd_font_data_t* font, uint64_t key)
+{
+  int32_t cells_per_row = font->bitmap_width / font->cell_width;
+  int32_t cell_rows = (font->glyphs_len + cells_per_row - 1) / cells_per_row;
+
+  dd_font_cache_header_t header;
+  memset(&header, 0, sizeof(header));
+  header.magic       = DD_FONT_CACHE_MAGIC;
+  header.version     = DD_FONT_CACHE_VERSION;
+  header.key         = key;
+  header.ascent      = font->ascent;
+  header.descent     = font->descent;
+  header.line_gap    = font->line_gap;
+  header.cell_width  = font->cell_width;
+  header.cell_height = font->cell_height;
+  header.glyphs_len  = font->glyphs_len;
+  header.bitmap_rows = cell_rows * font->cell_height;
+
+  char path[512];
+  dd__font_cache_path(key, path, sizeof(path));
+  FILE* fp = fopen(path, "wb");
+  if (!fp) { return; }
+  fwrite(&header, sizeof(header), 1, fp);
+  fwrite(font->glyphs, sizeof(dd_glyph_t), font->glyphs_len, fp);
+  fwrite(font->bitmap, font->bitmap_width, header.bitmap_rows, fp);
+  fclose(fp);
+}
+#endif /* DBGDRAW_FONT_CACHE_DIR */
+
+// Fits the cells to the bounding box of the font, and allocates the glyphs
 int32_t
-dd__line_ex(dd_ctx_t* ctx, float* a, float* b, uint8_t is_3d)
+dd__init_font_glyphs(dd_font_data_t* font)
 {
-  DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(a);
-  DBGDRAW_ASSERT(b);
+  float to_pixel_scale =
+    stbtt_ScaleForPixelHeight(&font->info, (float)font->size);
 
-  int32_t new_verts = 2;
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
+  int32_t ascent, descent, line_gap;
+  stbtt_GetFontVMetrics(&font->info, &ascent, &descent, &line_gap);
+  font->ascent   = to_pixel_scale * ascent;
+  font->descent  = to_pixel_scale * descent;
+  font->line_gap = to_pixel_scale * line_gap;
+
+  // Cells fit any glyph of the font, with oversampling and padding, or
+  // with the distance field around it
+  int32_t x0, y0, x1, y1;
+  stbtt_GetFontBoundingBox(&font->info, &x0, &y0, &x1, &y1);
+  float cell_scale =
+    font->is_sdf ? to_pixel_scale : DD_GLYPH_OVERSAMPLING * to_pixel_scale;
+  int32_t cell_extra = font->is_sdf ? 2 * DD_SDF_PADDING + 2 : 3;
+  int32_t cell_width = (int32_t)ceilf(cell_scale * (x1 - x0)) + cell_extra;
+  int32_t cell_height = (int32_t)ceilf(cell_scale * (y1 - y0)) + cell_extra;
+  font->cell_width    = DD_MIN(font->bitmap_width, cell_width);
+  font->cell_height   = DD_MIN(font->bitmap_height, cell_height);
+  font->glyphs_cap    = (font->bitmap_width / font->cell_width) *
+                     (font->bitmap_height / font->cell_height);
+  font->glyphs = DBGDRAW_MALLOC(font->glyphs_cap * sizeof(dd_glyph_t));
+  return font->glyphs ? DBGDRAW_ERR_OK : DBGDRAW_ERR_FAILED_ALLOC;
+}
+
+// Fills the font and rasterizes its atlas, but does not create the texture.
+// Like dd__rasterize_glyph it does not use the context. On failure the font is
+// cleared. 'is_sdf' has to be resolved against the backend caps already.
+int32_t
+dd__build_font(dd_font_data_t* font,
+               const void* ttf_buf,
+               int32_t ttf_size,
+               int32_t deflated_size,
+               const char* name,
+               int32_t font_size,
+               int32_t width,
+               int32_t height,
+               bool is_sdf,
+               uint32_t frame_idx)
+{
+  memset(font, 0, sizeof(dd_font_data_t));
+  font->bitmap_width  = width;
+  font->bitmap_height = height;
+  font->size          = font_size;
+  font->is_sdf        = is_sdf;
+  size_t name_len     = strnlen(name, 4096);
+  font->name          = DBGDRAW_MALLOC(name_len + 1);
+  font->bitmap        = DBGDRAW_MALLOC(width * height);
+  if (!font->name || !font->bitmap)
+  {
+    dd__free_font(font);
+    return DBGDRAW_ERR_FAILED_ALLOC;
+  }
+  memcpy(font->name, name, name_len);
+  font->name[name_len] = 0;
+  memset(font->bitmap, 0, width * height);
+
+  // Glyphs are rasterized long after this call returns, so the font keeps its
+  // own copy of the ttf data
+  font->ttf_size = ttf_size;
+  if (deflated_size > 0)
+  {
+    font->deflated_ttf  = (const uint8_t*)ttf_buf;
+    font->deflated_size = deflated_size;
+  }
+  else
+  {
+    font->ttf_data = DBGDRAW_MALLOC(ttf_size);
+    if (!font->ttf_data)
+    {
+      dd__free_font(font);
+      return DBGDRAW_ERR_FAILED_ALLOC;
+    }
+    memcpy(font->ttf_data, ttf_buf, ttf_size);
+    stbtt_InitFont(&font->info, font->ttf_data, 0);
+  }
 
-  dd_vec3_t pt_a = dd_vec3(a[0], a[1], is_3d ? a[2] : 0.0f);
-  dd_vec3_t pt_b = dd_vec3(b[0], b[1], is_3d ? b[2] : 0.0f);
-  dd__line(ctx, &pt_a, &pt_b);
+  int32_t error  = DBGDRAW_ERR_OK;
+  bool is_cached = false;
+#ifdef DBGDRAW_FONT_CACHE_DIR
+  uint64_t cache_key = dd__font_cache_key(
+    font, ttf_buf, deflated_size > 0 ? deflated_size : ttf_size);
+  is_cached = dd__read_font_cache(font, cache_key, frame_idx);
+#endif
+  if (!is_cached)
+  {
+    error = dd__load_font_ttf(font);
+    if (!error) { error = dd__init_font_glyphs(font); }
+    if (error)
+    {
+      dd__free_font(font);
+      return error;
+    }
+  }
+
+  uint32_t table_cap = 16;
+  while (table_cap < 2 * (uint32_t)font->glyphs_cap) { table_cap *= 2; }
+  font->glyph_table_mask = table_cap - 1;
+  font->glyph_table      = DBGDRAW_MALLOC(table_cap * sizeof(int32_t));
+  if (!font->glyph_table)
+  {
+    dd__free_font(font);
+    return DBGDRAW_ERR_FAILED_ALLOC;
+  }
+  memset(font->glyph_table, 0xff, table_cap * sizeof(int32_t));
 
+  if (is_cached)
+  {
+    for (int32_t i = 0; i < font->glyphs_len; ++i) { dd__insert_glyph(font, i); }
+  }
+  else
+  {
+    // Printable ASCII is rasterized up front, so the most common labels never
+    // miss, and are laid out the same way in every context. The whole atlas is
+    // uploaded with the texture, so no upload is queued for them
+    for (uint32_t cp = 32; cp < 127 && font->glyphs_len < font->glyphs_cap;
+         ++cp)
+    {
+      int32_t glyph_idx = font->glyphs_len++;
+      dd__rasterize_glyph(font, glyph_idx, cp);
+      font->glyphs[glyph_idx].last_used_frame = frame_idx;
+    }
+#ifdef DBGDRAW_FONT_CACHE_DIR
+    dd__write_font_cache(font, cache_key);
+#endif
+  }
   return DBGDRAW_ERR_OK;
 }
 
+// With 'deflated_size' > 0, 'ttf_buf' is deflated and has to outlive the
+// context, like the embedded default font
 int32_t
-dd_line(dd_ctx_t* ctx, float* a, float* b)
+dd__init_font_from_memory(dd_ctx_t* ctx,
+                          const void* ttf_buf,
+                          int32_t ttf_size,
+                          int32_t deflated_size,
+                          const char* name,
+                          int32_t font_size,
+                          int32_t width,
+                          int32_t height,
+                          bool is_sdf,
+                          int32_t* font_idx)
 {
-  return dd__line_ex(ctx, a, b, 1);
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(ttf_buf);
+  DBGDRAW_ASSERT(name);
+  DBGDRAW_ASSERT(font_idx);
+
+  DBGDRAW_VALIDATE(ctx->fonts_len < ctx->fonts_cap,
+                   DBGDRAW_ERR_FONT_LIMIT_REACHED);
+  dd_font_data_t* font = ctx->fonts + ctx->fonts_len;
+  is_sdf = is_sdf && (ctx->backend_caps & DBGDRAW_BACKEND_CAPS_SDF_TEXT) != 0;
+  int32_t error = dd__build_font(font,
+                                 ttf_buf,
+                                 ttf_size,
+                                 deflated_size,
+                                 name,
+                                 font_size,
+                                 width,
+                                 height,
+                                 is_sdf,
+                                 ctx->frame_idx);
+  if (error) { return error; }
+
+  error = dd_backend_init_font_texture(
+    ctx, font->bitmap, width, height, &font->tex_id);
+  if (error)
+  {
+    dd__free_font(font);
+    return error;
+  }
+
+  *font_idx = ctx->fonts_len++;
+  return DBGDRAW_ERR_OK;
 }
 
 int32_t
-dd_line2d(dd_ctx_t* ctx, float* a, float* b)
+dd_init_font_from_memory(dd_ctx_t* ctx,
+                         const void* ttf_buf,
+                         const char* name,
+                         int32_t font_size,
+                         int32_t width,
+                         int32_t height,
+                         int32_t* font_idx)
 {
-  return dd__line_ex(ctx, a, b, 0);
+  int32_t ttf_size = (int32_t)dd__ttf_size((const uint8_t*)ttf_buf);
+  return dd__init_font_from_memory(
+    ctx, ttf_buf, ttf_size, 0, name, font_size, width, height, false, font_idx);
 }
 
 int32_t
-dd__quad_ex(dd_ctx_t* ctx,
-            float* a,
-            float* b,
-            float* c,
-            float* d,
-            uint8_t is_3d)
+dd_init_sdf_font_from_memory(dd_ctx_t* ctx,
+                             const void* ttf_buf,
+                             const char* name,
+                             int32_t font_size,
+                             int32_t width,
+                             int32_t height,
+                             int32_t* font_idx)
 {
-  DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(a);
-  DBGDRAW_ASSERT(b);
-  DBGDRAW_ASSERT(c);
-  DBGDRAW_ASSERT(d);
-
-  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
-  mode_vert_count[DBGDRAW_MODE_POINT]  = 4;
-  mode_vert_count[DBGDRAW_MODE_STROKE] = 8;
-  mode_vert_count[DBGDRAW_MODE_FILL]   = 6;
-  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
+  int32_t ttf_size = (int32_t)dd__ttf_size((const uint8_t*)ttf_buf);
+  return dd__init_font_from_memory(
+    ctx, ttf_buf, ttf_size, 0, name, font_size, width, height, true, font_idx);
+}
 
-  dd_vec3_t pt_a = dd_vec3(a[0], a[1], is_3d ? a[2] : 0.0f);
-  dd_vec3_t pt_b = dd_vec3(b[0], b[1], is_3d ? b[2] : 0.0f);
-  dd_vec3_t pt_c = dd_vec3(c[0], c[1], is_3d ? c[2] : 0.0f);
-  dd_vec3_t pt_d = dd_vec3(d[0], d[1], is_3d ? d[2] : 0.0f);
+/*UTF-8 decoder by Bjoern Hoehrmann. See end of file for licensing*/
+#define DD_UTF8_ACCEPT 0
+#define DD_UTF8_REJECT 12
 
-  dd__quad(ctx, &pt_a, &pt_b, &pt_c, &pt_d);
+// clang-format off
+static const uint8_t dd_utf8d_table[] = {
+  // The first part of the table maps bytes to character classes that
+  // to reduce the size of the transition table and create bitmasks.
+   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+   1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+   7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,  7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
+   8,8,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
+  10,3,3,3,3,3,3,3,3,3,3,3,3,4,3,3, 11,6,6,6,5,8,8,8,8,8,8,8,8,8,8,8,
 
-  return DBGDRAW_ERR_OK;
-}
+  // The second part is a transition table that maps a combination
+  // of a state of the automaton and a character class to a state.
+   0,12,24,36,60,96,84,12,12,12,48,72, 12,12,12,12,12,12,12,12,12,12,12,12,
+  12, 0,12,12,12,12,12, 0,12, 0,12,12, 12,24,12,12,12,12,12,24,12,24,12,12,
+  12,12,12,12,12,12,12,24,12,12,12,12, 12,24,12,12,12,12,12,12,12,24,12,12,
+  12,12,12,12,12,12,12,36,12,36,12,12, 12,36,12,12,12,12,12,36,12,36,12,12,
+  12,36,12,12,12,12,12,12,12,12,12,12, 
+};
+// clang-format on
 
-int32_t
-dd_quad(dd_ctx_t* ctx, float* a, float* b, float* c, float* d)
+static inline uint32_t
+dd__utf8_decode(uint32_t* state, uint32_t* codep, uint32_t byte)
 {
-  return dd__quad_ex(ctx, a, b, c, d, 1);
-}
+  uint32_t type = dd_utf8d_table[byte];
 
-int32_t
-dd_quad2d(dd_ctx_t* ctx, float* a, float* b, float* c, float* d)
-{
-  return dd__quad_ex(ctx, a, b, c, d, 0);
+  *codep = (*state != DD_UTF8_ACCEPT) ? (byte & 0x3fu) | (*codep << 6)
+                                      : (0xff >> type) & (byte);
+
+  *state = dd_utf8d_table[256 + *state + type];
+  return *state;
 }
 
-int32_t
-dd__rect_ex(dd_ctx_t* ctx, float* a, float* b, uint8_t is_3d)
+const char*
+dd__decode_char(const char* str, uint32_t* cp)
 {
-  DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(a);
-  DBGDRAW_ASSERT(b);
+  uint32_t state = 0;
 
-  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
-  mode_vert_count[DBGDRAW_MODE_POINT]  = 4;
-  mode_vert_count[DBGDRAW_MODE_STROKE] = 8;
-  mode_vert_count[DBGDRAW_MODE_FILL]   = 6;
-  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
+  int32_t count       = 0;
+  const uint8_t* ustr = (const uint8_t*)str;
+  for (; *ustr; ++ustr)
+  {
+    count++;
+    if (!dd__utf8_decode(&state, cp, *ustr)) { break; }
+  }
+  str += count;
 
-  dd_vec3_t pt_a = dd_vec3(a[0], a[1], is_3d ? a[2] : 0.0f);
-  dd_vec3_t pt_b = dd_vec3(a[0], b[1], is_3d ? a[2] : 0.0f);
-  dd_vec3_t pt_d = dd_vec3(b[0], a[1], is_3d ? b[2] : 0.0f);
-  dd_vec3_t pt_c = dd_vec3(b[0], b[1], is_3d ? b[2] : 0.0f);
+  if (state != DD_UTF8_ACCEPT) { return NULL; }
 
-  dd__quad(ctx, &pt_a, &pt_b, &pt_c, &pt_d);
+  return str;
+}
 
-  return DBGDRAW_ERR_OK;
+uint64_t
+dd__text_hash(const char* str, int32_t font_idx, int32_t* len)
+{
+  // FNV-1a, seeded with the font
+  uint64_t hash = (14695981039346656037ull ^ (uint32_t)font_idx) *
+                  1099511628211ull;
+  const uint8_t* ustr = (const uint8_t*)str;
+  int32_t i           = 0;
+  for (; ustr[i]; ++i)
+  {
+    hash ^= ustr[i];
+    hash *= 1099511628211ull;
+  }
+  *len = i;
+  return hash;
 }
 
-int32_t
-dd_rect(dd_ctx_t* ctx, float* a, float* b)
+void
+dd__text_cache_insert(dd_text_cache_t* cache, int32_t layout_idx)
 {
-  return dd__rect_ex(ctx, a, b, 1);
+  uint32_t mask = cache->table_mask;
+  uint32_t i    = (uint32_t)cache->layouts[layout_idx].hash & mask;
+  while (cache->table[i] >= 0) { i = (i + 1) & mask; }
+  cache->table[i] = layout_idx;
 }
 
+// Rebuilds the hash table, with room for at least 'count' layouts. Like other
+// buffers, the table never shrinks
 int32_t
-dd_rect2d(dd_ctx_t* ctx, float* a, float* b)
+dd__text_cache_rehash(dd_text_cache_t* cache, int32_t count)
 {
-  return dd__rect_ex(ctx, a, b, 0);
+  uint32_t table_cap = cache->table ? cache->table_mask + 1 : 64;
+  while (table_cap < 2 * (uint32_t)count) { table_cap *= 2; }
+  if (!cache->table || table_cap != cache->table_mask + 1)
+  {
+    int32_t* table =
+      DBGDRAW_REALLOC(cache->table, table_cap * sizeof(int32_t));
+    if (!table) { return DBGDRAW_ERR_FAILED_ALLOC; }
+    cache->table      = table;
+    cache->table_mask = table_cap - 1;
+  }
+  memset(cache->table, 0xff, table_cap * sizeof(int32_t));
+  for (int32_t i = 0; i < cache->layouts_len; ++i)
+  {
+    dd__text_cache_insert(cache, i);
+  }
+  return DBGDRAW_ERR_OK;
 }
 
+// Lays out the string in font space, appending its glyphs to the pool. Glyphs
+// missing from the atlas are left out, and the layout is redone next time
 int32_t
-dd_rounded_rect2d_ex(dd_ctx_t* ctx, float* a, float* b, float* radii)
-{
-  DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(a);
+dd__layout_text(dd_ctx_t* ctx, dd_text_layout_t* layout, const char* str)
+{
+  dd_text_cache_t* cache = &ctx->text_cache;
+  dd_font_data_t* font   = ctx->fonts + layout->font_idx;
+
+  // Every glyph takes at least one byte of the string
+  DD_GROW(ctx,
+          cache->glyphs,
+          cache->glyphs_len + layout->str_len,
+          cache->glyphs_cap,
+          sizeof(dd_layout_glyph_t));
+  layout->glyphs_offset = cache->glyphs_len;
+  layout->glyphs_len    = 0;
+  layout->is_complete   = 1;
+
+  dd_layout_glyph_t* glyphs = cache->glyphs + layout->glyphs_offset;
+  float x = 0.0f, y = 0.0f;
+  uint32_t cp = 0, state = DD_UTF8_ACCEPT;
+  for (const uint8_t* ustr = (const uint8_t*)str; *ustr; ++ustr)
+  {
+    if (dd__utf8_decode(&state, &cp, *ustr) != DD_UTF8_ACCEPT) { continue; }
 
-  int32_t resolution = 1 << (ctx->detail_level + 2);
-  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
-  mode_vert_count[DBGDRAW_MODE_POINT]  = resolution + 4;
-  mode_vert_count[DBGDRAW_MODE_STROKE] = 2 * resolution + 8;
-  mode_vert_count[DBGDRAW_MODE_FILL]   = 3 * resolution + 6;
-  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+    dd_layout_glyph_t* glyph = glyphs + layout->glyphs_len;
+    glyph->glyph_idx =
+      dd__get_glyph_quad(ctx, layout->font_idx, cp, &x, &y, &glyph->q);
+    if (glyph->glyph_idx < 0) { layout->is_complete = 0; }
+    else { layout->glyphs_len++; }
+  }
 
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
+  // Malformed strings are not drawn
+  if (state != DD_UTF8_ACCEPT)
+  {
+    layout->glyphs_len = 0;
+    x                  = 0.0f;
+  }
+  cache->glyphs_len += layout->glyphs_len;
+  layout->width           = x;
+  layout->font_generation = font->generation;
+  return DBGDRAW_ERR_OK;
+}
 
-  float d_theta = (float)DBGDRAW_TWO_PI / resolution;
+// Finds the layout of the string, laying it out if it is not cached yet, or
+// if any glyph of its font was evicted since
+int32_t
+dd__get_text_layout(dd_ctx_t* ctx,
+                    int32_t font_idx,
+                    const char* str,
+                    dd_text_layout_t** out_layout)
+{
+  dd_text_cache_t* cache = &ctx->text_cache;
+  dd_font_data_t* font   = ctx->fonts + font_idx;
+  if (!cache->table && dd__text_cache_rehash(cache, 0))
+  {
+    return DBGDRAW_ERR_FAILED_ALLOC;
+  }
 
-  float w            = (b[0] - a[0]);
-  float h            = (b[1] - a[1]);
-  float offsets_x[4] = {w - (radii[0] + radii[3]),
-                        -radii[1],
-                        -(w - (radii[1] + radii[2])),
-                        radii[3]};
-  float offsets_y[4] = {-radii[0],
-                        -(h - (radii[0] + radii[1])),
-                        radii[2],
-                        h - (radii[2] + radii[3])};
-  dd_vec3_t pt0      = dd_vec3(a[0] + radii[3], b[1], 0.0f);
+  int32_t str_len;
+  uint64_t hash = dd__text_hash(str, font_idx, &str_len);
 
-  if (ctx->cur_cmd->draw_mode == DBGDRAW_MODE_FILL)
+  dd_text_layout_t* layout = NULL;
+  uint32_t mask            = cache->table_mask;
+  for (uint32_t i = (uint32_t)hash & mask; cache->table[i] >= 0;
+       i          = (i + 1) & mask)
   {
-    dd_vec3_t corners[4] = {0};
-    for (int i = 0; i < 4; ++i)
+    dd_text_layout_t* candidate = cache->layouts + cache->table[i];
+    if (candidate->hash == hash && candidate->font_idx == font_idx &&
+        candidate->str_len == str_len &&
+        !memcmp(cache->chars + candidate->str_offset, str, str_len))
     {
-      float r          = radii[i];
-      float init_theta = i * (float)DBGDRAW_PI_OVER_TWO;
-      dd_vec3_t pt1    = dd_vec3(0.0f, 0.0f, 0.0f);
-      corners[i]       = dd_vec3(pt0.x, pt0.y, 0.0f);
-
-      for (int32_t j = 0; j < resolution / 4; ++j)
-      {
-        float theta = init_theta + j * d_theta;
-        float ox1   = offsets_x[i] + r * sinf(theta);
-        float ox2   = offsets_x[i] + r * sinf(theta + d_theta);
-        float oy1   = offsets_y[i] + r * cosf(theta);
-        float oy2   = offsets_y[i] + r * cosf(theta + d_theta);
-
-        dd__vertex(ctx, &pt0);
-        pt1.x = pt0.x + ox1;
-        pt1.y = pt0.y + oy1;
-        dd__vertex(ctx, &pt1);
-        pt1.x = pt0.x + ox2;
-        pt1.y = pt0.y + oy2;
-        dd__vertex(ctx, &pt1);
-      }
-      pt0 = pt1;
+      layout = candidate;
+      break;
     }
+  }
 
-    dd__triangle(ctx, &corners[0], &corners[2], &corners[1]);
-    dd__triangle(ctx, &corners[2], &corners[0], &corners[3]);
+  if (!layout)
+  {
+    if (2 * (uint32_t)(cache->layouts_len + 1) > cache->table_mask + 1 &&
+        dd__text_cache_rehash(cache, cache->layouts_len + 1))
+    {
+      return DBGDRAW_ERR_FAILED_ALLOC;
+    }
+    DD_GROW(ctx,
+            cache->layouts,
+            cache->layouts_len + 1,
+            cache->layouts_cap,
+            sizeof(dd_text_layout_t));
+    DD_GROW(ctx,
+            cache->chars,
+            cache->chars_len + str_len,
+            cache->chars_cap,
+            sizeof(char));
+    layout = cache->layouts + cache->layouts_len;
+    memset(layout, 0, sizeof(dd_text_layout_t));
+    layout->hash       = hash;
+    layout->font_idx   = font_idx;
+    layout->str_offset = cache->chars_len;
+    layout->str_len    = str_len;
+    memcpy(cache->chars + cache->chars_len, str, str_len);
+    cache->chars_len += str_len;
+    dd__text_cache_insert(cache, cache->layouts_len++);
+    int32_t error = dd__layout_text(ctx, layout, str);
+    if (error) { return error; }
+    DBGDRAW_STATS(ctx->stats.text_cache_miss_count++);
   }
-  else if (ctx->cur_cmd->draw_mode == DBGDRAW_MODE_STROKE)
+  else if (!layout->is_complete || layout->font_generation != font->generation)
   {
-    for (int i = 0; i < 4; ++i)
+    int32_t error = dd__layout_text(ctx, layout, str);
+    if (error) { return error; }
+    DBGDRAW_STATS(ctx->stats.text_cache_miss_count++);
+  }
+  else
+  {
+    // Glyphs of the layout are not looked up, so they are marked as used here,
+    // to keep them from being evicted
+    dd_layout_glyph_t* glyphs = cache->glyphs + layout->glyphs_offset;
+    for (int32_t i = 0; i < layout->glyphs_len; ++i)
     {
-      float init_theta = i * (float)DBGDRAW_PI_OVER_TWO;
-      dd_vec3_t pt1    = pt0;
-      float r          = radii[i];
-      for (int32_t j = 0; j < resolution / 4 + 1; ++j)
-      {
-        float theta = init_theta + j * d_theta;
-        float ox1   = offsets_x[i] + r * sinf(theta);
-        float oy1   = offsets_y[i] + r * cosf(theta);
-        dd__vertex(ctx, &pt1);
-        pt1.x = pt0.x + ox1;
-        pt1.y = pt0.y + oy1;
-        dd__vertex(ctx, &pt1);
-      }
-      pt0 = pt1;
+      font->glyphs[glyphs[i].glyph_idx].last_used_frame = ctx->frame_idx;
     }
+    DBGDRAW_STATS(ctx->stats.text_cache_hit_count++);
   }
-  else if (ctx->cur_cmd->draw_mode == DBGDRAW_MODE_POINT)
+  layout->last_used_frame = ctx->frame_idx;
+  *out_layout             = layout;
+  return DBGDRAW_ERR_OK;
+}
+
+// Called every DBGDRAW_TEXT_CACHE_MAX_AGE frames. Layouts that were not drawn
+// since the previous call are dropped, and the rest is copied into new pools of
+// the same size, which leaves out glyphs of old layouts.
+void
+dd__text_cache_evict(dd_ctx_t* ctx)
+{
+  dd_text_cache_t* cache = &ctx->text_cache;
+  if (!cache->layouts_len) { return; }
+
+  dd_layout_glyph_t* glyphs =
+    DBGDRAW_MALLOC(cache->glyphs_cap * sizeof(dd_layout_glyph_t));
+  char* chars = DBGDRAW_MALLOC(cache->chars_cap);
+  if ((!glyphs && cache->glyphs_cap) || (!chars && cache->chars_cap))
   {
-    for (int i = 0; i < 4; ++i)
+    DBGDRAW_FREE(glyphs);
+    DBGDRAW_FREE(chars);
+    return;
+  }
+
+  int32_t layouts_len = 0, glyphs_len = 0, chars_len = 0;
+  for (int32_t i = 0; i < cache->layouts_len; ++i)
+  {
+    dd_text_layout_t* layout = cache->layouts + i;
+    if (layout->last_used_frame + DBGDRAW_TEXT_CACHE_MAX_AGE < ctx->frame_idx)
     {
-      float r          = radii[i];
-      float init_theta = i * (float)DBGDRAW_PI_OVER_TWO;
-      dd_vec3_t pt1    = dd_vec3(0.0f, 0.0f, 0.0f);
-      for (int32_t j = 0; j < resolution / 4 + 1; ++j)
-      {
-        float theta = init_theta + j * d_theta;
-        float ox1   = offsets_x[i] + r * sinf(theta);
-        float oy1   = offsets_y[i] + r * cosf(theta);
-        pt1.x       = pt0.x + ox1;
-        pt1.y       = pt0.y + oy1;
-        dd__vertex(ctx, &pt1);
-      }
-      pt0 = pt1;
+      continue;
     }
+    memcpy(glyphs + glyphs_len,
+           cache->glyphs + layout->glyphs_offset,
+           layout->glyphs_len * sizeof(dd_layout_glyph_t));
+    memcpy(chars + chars_len, cache->chars + layout->str_offset, layout->str_len);
+    layout->glyphs_offset = glyphs_len;
+    layout->str_offset    = chars_len;
+    glyphs_len += layout->glyphs_len;
+    chars_len += layout->str_len;
+    cache->layouts[layouts_len++] = *layout;
   }
 
-  return DBGDRAW_ERR_OK;
+  DBGDRAW_FREE(cache->glyphs);
+  DBGDRAW_FREE(cache->chars);
+  cache->glyphs      = glyphs;
+  cache->chars       = chars;
+  cache->glyphs_len  = glyphs_len;
+  cache->chars_len   = chars_len;
+  cache->layouts_len = layouts_len;
+  dd__text_cache_rehash(cache, layouts_len);
 }
 
-int32_t
-dd_rounded_rect2d(dd_ctx_t* ctx, float* a, float* b, float rounding)
+void
+dd__text_cache_term(dd_text_cache_t* cache)
 {
-  float all_corners_rounding[4] = {rounding, rounding, rounding, rounding};
-  return dd_rounded_rect2d_ex(ctx, a, b, all_corners_rounding);
+  DBGDRAW_FREE(cache->layouts);
+  DBGDRAW_FREE(cache->table);
+  DBGDRAW_FREE(cache->glyphs);
+  DBGDRAW_FREE(cache->chars);
+  memset(cache, 0, sizeof(dd_text_cache_t));
 }
 
-// TODO(maciej): Sizes should be in pixels...
-int32_t
-dd_billboard_rect(dd_ctx_t* ctx, float* p, float width, float height)
+void
+dd_get_text_size_font_space(dd_ctx_t* ctx,
+                            int32_t font_idx,
+                            const char* str,
+                            int32_t strlen,
+                            float* width,
+                            float* height)
 {
   DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(p);
-
-  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
-  mode_vert_count[DBGDRAW_MODE_POINT]  = 4;
-  mode_vert_count[DBGDRAW_MODE_STROKE] = 8;
-  mode_vert_count[DBGDRAW_MODE_FILL]   = 6;
-  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
+  DBGDRAW_ASSERT(str);
+  DBGDRAW_VALIDATE(font_idx < ctx->fonts_cap, DBGDRAW_ERR_OUT_OF_BOUNDS_ACCESS);
 
-  dd_vec3_t pt = dd_vec3(p[0], p[1], p[2]);
-  dd_mat3_t m  = dd__get_view_aligned_basis(ctx, pt);
-  m.col[0]     = dd_vec3_scalar_mul(m.col[0], width * 0.5f);
-  m.col[1]     = dd_vec3_scalar_mul(m.col[1], height * 0.5f);
+  dd_font_data_t* font = ctx->fonts + font_idx;
+  *width               = 0;
+  *height              = font->ascent - font->descent;
+  if (font->status) { return; }
+  for (int32_t i = 0; i < strlen; ++i)
+  {
+    uint32_t cp;
+    str = dd__decode_char(str, &cp);
+    stbtt_aligned_quad q;
+    float dummy = 0.0f;
+    dd__get_glyph_quad(ctx, font_idx, cp, width, &dummy, &q);
+  }
+}
 
-  dd_vec3_t pt_a = dd_vec3_sub(pt, dd_vec3_add(m.col[0], m.col[1]));
-  dd_vec3_t pt_b = dd_vec3_add(pt, dd_vec3_sub(m.col[0], m.col[1]));
-  dd_vec3_t pt_c = dd_vec3_add(pt, dd_vec3_add(m.col[0], m.col[1]));
-  dd_vec3_t pt_d = dd_vec3_sub(pt, dd_vec3_sub(m.col[0], m.col[1]));
+#ifndef DBGDRAW_NO_STDIO
+int32_t
+dd__read_font_file(const char* font_path, uint8_t** ttf_buffer, size_t* size)
+{
+  FILE* fp = fopen(font_path, "rb");
+  if (!fp) { return DBGDRAW_ERR_FONT_FILE_NOT_FOUND; }
 
-  dd__quad(ctx, &pt_a, &pt_b, &pt_c, &pt_d);
+  fseek(fp, 0L, SEEK_END);
+  *size = ftell(fp);
+  rewind(fp);
 
+  *ttf_buffer = DBGDRAW_MALLOC(*size);
+  if (!*ttf_buffer)
+  {
+    fclose(fp);
+    return DBGDRAW_ERR_FAILED_ALLOC;
+  }
+  fread(*ttf_buffer, 1, *size, fp);
+  fclose(fp);
   return DBGDRAW_ERR_OK;
 }
 
 int32_t
-dd__circle_ex(dd_ctx_t* ctx, float* center, float radius, uint8_t is_3d)
+dd__init_font_from_file(dd_ctx_t* ctx,
+                        const char* font_path,
+                        const char* font_name,
+                        int32_t font_size,
+                        int32_t width,
+                        int32_t height,
+                        bool is_sdf,
+                        int32_t* font_idx)
 {
   DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(center);
-
-  int32_t resolution = 1 << (ctx->detail_level + 2);
-  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
-  mode_vert_count[DBGDRAW_MODE_POINT]  = resolution;
-  mode_vert_count[DBGDRAW_MODE_STROKE] = 2 * resolution;
-  mode_vert_count[DBGDRAW_MODE_FILL]   = 3 * resolution;
-  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
-
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
-
-  dd_vec3_t center_pt = dd_vec3(center[0], center[1], is_3d ? center[2] : 0.0f);
-  dd__arc(ctx, &center_pt, radius, (float)DBGDRAW_TWO_PI, resolution, !is_3d);
-
+  DBGDRAW_ASSERT(font_path);
+  DBGDRAW_ASSERT(font_idx);
+  if (font_path)
+  {
+    size_t size         = 0;
+    uint8_t* ttf_buffer = NULL;
+    int32_t error       = dd__read_font_file(font_path, &ttf_buffer, &size);
+    if (error) { return error; }
+
+    error = dd__init_font_from_memory(ctx,
+                                      ttf_buffer,
+                                      (int32_t)size,
+                                      0,
+                                      font_name,
+                                      font_size,
+                                      width,
+                                      height,
+                                      is_sdf,
+                                      font_idx);
+    DBGDRAW_FREE(ttf_buffer);
+    if (error) { return error; }
+  }
   return DBGDRAW_ERR_OK;
 }
 
 int32_t
-dd_circle(dd_ctx_t* ctx, float* center, float radius)
+dd_init_font_from_file(dd_ctx_t* ctx,
+                       const char* font_path,
+                       const char* font_name,
+                       int32_t font_size,
+                       int32_t width,
+                       int32_t height,
+                       int32_t* font_idx)
 {
-  return dd__circle_ex(ctx, center, radius, 1);
+  return dd__init_font_from_file(
+    ctx, font_path, font_name, font_size, width, height, false, font_idx);
 }
 
 int32_t
-dd_circle2d(dd_ctx_t* ctx, float* center, float radius)
+dd_init_sdf_font_from_file(dd_ctx_t* ctx,
+                           const char* font_path,
+                           const char* font_name,
+                           int32_t font_size,
+                           int32_t width,
+                           int32_t height,
+                           int32_t* font_idx)
 {
-  return dd__circle_ex(ctx, center, radius, 0);
+  return dd__init_font_from_file(
+    ctx, font_path, font_name, font_size, width, height, true, font_idx);
 }
+#endif
 
-int32_t
-dd_billboard_circle(dd_ctx_t* ctx, float* center, float radius)
+#ifdef DBGDRAW_ASYNC_FONTS
+// Font loaded by dd_init_font_from_file_async. The worker fills 'font' on its
+// own, and the context reads it only once 'is_done' is set
+typedef struct dd_font_job
 {
-  DBGDRAW_ASSERT(ctx);
-  if (!ctx->cur_cmd) { return DBGDRAW_ERR_NO_ACTIVE_CMD; }
-  bool has_normals = ctx->cur_cmd->draw_mode == DBGDRAW_MODE_FILL &&
-                     ctx->cur_cmd->shading_type != DBGDRAW_SHADING_NONE;
-
-  int32_t resolution = 1 << (ctx->detail_level + 2);
-  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
-  mode_vert_count[DBGDRAW_MODE_POINT]  = resolution;
-  mode_vert_count[DBGDRAW_MODE_STROKE] = 2 * resolution;
-  mode_vert_count[DBGDRAW_MODE_FILL]   = 3 * resolution;
-  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+  dd_font_data_t font;
+  const char* path;
+  const char* name;
+  int32_t font_idx;
+  int32_t font_size;
+  int32_t width, height;
+  bool is_sdf;
+  uint32_t frame_idx;
+  int32_t error;
+  uint32_t is_done;
+  dd__thread_t thread;
+} dd_font_job_t;
 
-  if (ctx->verts_len + new_verts >= ctx->verts_cap)
+void
+dd__run_font_job(dd_font_job_t* job)
+{
+  size_t size         = 0;
+  uint8_t* ttf_buffer = NULL;
+  job->error          = dd__read_font_file(job->path, &ttf_buffer, &size);
+  if (!job->error)
   {
-    return DBGDRAW_ERR_OUT_OF_VERTEX_BUFFER;
+    job->error = dd__build_font(&job->font,
+                                ttf_buffer,
+                                (int32_t)size,
+                                0,
+                                job->name,
+                                job->font_size,
+                                job->width,
+                                job->height,
+                                job->is_sdf,
+                                job->frame_idx);
+    DBGDRAW_FREE(ttf_buffer);
   }
+  DD_ATOMIC_STORE(&job->is_done, 1);
+}
 
-  dd_vec3_t zero_pt  = dd_vec3(0.0f, 0.0f, 0.0f);
-  dd_vertex_t* start = ctx->verts_data + ctx->verts_len;
-  dd__arc(ctx, &zero_pt, radius, (float)DBGDRAW_TWO_PI, resolution, 0);
-  dd_vertex_t* end = ctx->verts_data + ctx->verts_len;
-
-  dd_vec3_t cp    = dd_vec3(center[0], center[1], center[2]);
-  dd_mat3_t m     = dd__get_view_aligned_basis(ctx, cp);
-  dd_mat4_t xform = dd_mat4_identity();
-  xform.col[0]    = dd_vec3_to_vec4(m.col[0]);
-  xform.col[1]    = dd_vec3_to_vec4(m.col[1]);
-  xform.col[2]    = dd_vec3_to_vec4(m.col[2]);
-  xform.col[3]    = dd_vec3_to_vec4(cp);
-  xform.col[3].w  = 1.0f;
-  dd__transform_verts(xform, start, end, has_normals);
+#if defined(_WIN32)
+DWORD WINAPI
+dd__font_job_main(LPVOID param)
+{
+  dd__run_font_job((dd_font_job_t*)param);
+  return 0;
+}
+#else
+void*
+dd__font_job_main(void* param)
+{
+  dd__run_font_job((dd_font_job_t*)param);
+  return NULL;
+}
+#endif
 
-  return DBGDRAW_ERR_OK;
+void
+dd__join_font_job(dd_font_job_t* job)
+{
+#if defined(_WIN32)
+  WaitForSingleObject(job->thread, INFINITE);
+  CloseHandle(job->thread);
+#else
+  pthread_join(job->thread, NULL);
+#endif
 }
 
+// The slot of the font is taken right away, so its index and name are valid
+// while loading. It has no glyphs or bitmap until the job finishes.
 int32_t
-dd__arc_ex(dd_ctx_t* ctx,
-           float* center,
-           float radius,
-           float theta,
-           uint8_t is_3d)
+dd__init_font_from_file_async(dd_ctx_t* ctx,
+                              const char* font_path,
+                              const char* font_name,
+                              int32_t font_size,
+                              int32_t width,
+                              int32_t height,
+                              bool is_sdf,
+                              int32_t* font_idx)
 {
   DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(center);
-
-  int32_t resolution = 1 << (ctx->detail_level + 2);
-  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
-  mode_vert_count[DBGDRAW_MODE_POINT]  = resolution + 1;
-  mode_vert_count[DBGDRAW_MODE_STROKE] = 2 * resolution;
-  mode_vert_count[DBGDRAW_MODE_FILL]   = 3 * resolution;
-  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+  DBGDRAW_ASSERT(font_path);
+  DBGDRAW_ASSERT(font_name);
+  DBGDRAW_ASSERT(font_idx);
 
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
+  DBGDRAW_VALIDATE(ctx->fonts_len < ctx->fonts_cap,
+                   DBGDRAW_ERR_FONT_LIMIT_REACHED);
+  DD_GROW(ctx,
+          ctx->font_jobs,
+          ctx->font_jobs_len + 1,
+          ctx->font_jobs_cap,
+          sizeof(dd_font_job_t*));
+  if (!ctx->font_jobs) { return DBGDRAW_ERR_FAILED_ALLOC; }
+
+  // The path is kept after the job, the name is the one of the slot
+  size_t path_len    = strnlen(font_path, 4096);
+  size_t name_len    = strnlen(font_name, 4096);
+  dd_font_job_t* job = DBGDRAW_MALLOC(sizeof(dd_font_job_t) + path_len + 1);
+  char* name         = DBGDRAW_MALLOC(name_len + 1);
+  if (!job || !name)
+  {
+    DBGDRAW_FREE(job);
+    DBGDRAW_FREE(name);
+    return DBGDRAW_ERR_FAILED_ALLOC;
+  }
+  memcpy(name, font_name, name_len);
+  name[name_len] = 0;
+
+  memset(job, 0, sizeof(dd_font_job_t));
+  char* path = (char*)(job + 1);
+  memcpy(path, font_path, path_len);
+  path[path_len] = 0;
+  job->path      = path;
+  job->name      = name;
+  job->font_idx  = ctx->fonts_len;
+  job->font_size = font_size;
+  job->width     = width;
+  job->height    = height;
+  job->is_sdf = is_sdf && (ctx->backend_caps & DBGDRAW_BACKEND_CAPS_SDF_TEXT);
+  job->frame_idx = ctx->frame_idx;
 
-  dd_vec3_t center_pt = dd_vec3(center[0], center[1], is_3d ? center[2] : 0.0f);
-  dd__arc(ctx, &center_pt, radius, theta, resolution, 0);
+  dd_font_data_t* font = ctx->fonts + ctx->fonts_len;
+  memset(font, 0, sizeof(dd_font_data_t));
+  font->name   = name;
+  font->size   = font_size;
+  font->is_sdf = job->is_sdf;
+  font->status = DBGDRAW_ERR_FONT_LOADING;
+
+#if defined(_WIN32)
+  job->thread = CreateThread(NULL, 0, dd__font_job_main, job, 0, NULL);
+  bool is_started = job->thread != NULL;
+#else
+  bool is_started = !pthread_create(&job->thread, NULL, dd__font_job_main, job);
+#endif
+  if (!is_started)
+  {
+    dd__free_font(font);
+    DBGDRAW_FREE(job);
+    return DBGDRAW_ERR_FAILED_ALLOC;
+  }
 
+  ctx->font_jobs[ctx->font_jobs_len++] = job;
+  *font_idx                            = ctx->fonts_len++;
   return DBGDRAW_ERR_OK;
 }
 
 int32_t
-dd_arc(dd_ctx_t* ctx, float* center, float radius, float theta)
+dd_init_font_from_file_async(dd_ctx_t* ctx,
+                             const char* font_path,
+                             const char* font_name,
+                             int32_t font_size,
+                             int32_t width,
+                             int32_t height,
+                             int32_t* font_idx)
 {
-  return dd__arc_ex(ctx, center, radius, theta, 1);
+  return dd__init_font_from_file_async(
+    ctx, font_path, font_name, font_size, width, height, false, font_idx);
 }
 
 int32_t
-dd_arc2d(dd_ctx_t* ctx, float* center, float radius, float theta)
+dd_init_sdf_font_from_file_async(dd_ctx_t* ctx,
+                                 const char* font_path,
+                                 const char* font_name,
+                                 int32_t font_size,
+                                 int32_t width,
+                                 int32_t height,
+                                 int32_t* font_idx)
 {
-  return dd__arc_ex(ctx, center, radius, theta, 0);
+  return dd__init_font_from_file_async(
+    ctx, font_path, font_name, font_size, width, height, true, font_idx);
 }
 
+// Moves fonts that finished loading into their slots. Called from dd_render, as
+// creating the texture is the one part of loading that needs the backend
 int32_t
-dd_aabb(dd_ctx_t* ctx, float* a, float* b)
+dd__finish_font_jobs(dd_ctx_t* ctx)
 {
-  DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(a);
-  DBGDRAW_ASSERT(b);
-
-  dd_vec3_t pt_a = dd_vec3(a[0], a[1], a[2]);
-  dd_vec3_t pt_b = dd_vec3(b[0], b[1], b[2]);
-  if (!dd__frustum_aabb_test(ctx, pt_a, pt_b)) { return DBGDRAW_ERR_CULLED; }
-
-  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
-  mode_vert_count[DBGDRAW_MODE_POINT]  = 8;
-  mode_vert_count[DBGDRAW_MODE_STROKE] = 24;
-  mode_vert_count[DBGDRAW_MODE_FILL]   = 36;
-  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
-
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
-
-  dd_vec3_t pts[8] = {
-    dd_vec3(a[0], a[1], a[2]),
-    dd_vec3(b[0], a[1], a[2]),
-    dd_vec3(b[0], a[1], b[2]),
-    dd_vec3(a[0], a[1], b[2]),
-
-    dd_vec3(b[0], b[1], a[2]),
-    dd_vec3(a[0], b[1], a[2]),
-    dd_vec3(a[0], b[1], b[2]),
-    dd_vec3(b[0], b[1], b[2]),
-  };
+  for (int32_t i = 0; i < ctx->font_jobs_len;)
+  {
+    dd_font_job_t* job = ctx->font_jobs[i];
+    if (!DD_ATOMIC_LOAD(&job->is_done))
+    {
+      i++;
+      continue;
+    }
+    dd__join_font_job(job);
 
-  dd__box(ctx, pts);
+    // The texture is created before the font is moved into its slot, since
+    // backends may upload the bitmaps of all fonts in the process
+    dd_font_data_t* font = ctx->fonts + job->font_idx;
+    if (!job->error)
+    {
+      job->error = dd_backend_init_font_texture(ctx,
+                                                job->font.bitmap,
+                                                job->font.bitmap_width,
+                                                job->font.bitmap_height,
+                                                &job->font.tex_id);
+    }
+    if (job->error)
+    {
+      dd__free_font(&job->font);
+      font->status = job->error;
+    }
+    else
+    {
+      dd__free_font(font);
+      *font = job->font;
+      if (ctx->pending_font_idx == job->font_idx)
+      {
+        ctx->active_font_idx  = job->font_idx;
+        ctx->pending_font_idx = -1;
+      }
+    }
 
+    DBGDRAW_FREE(job);
+    ctx->font_jobs[i] = ctx->font_jobs[--ctx->font_jobs_len];
+  }
   return DBGDRAW_ERR_OK;
 }
 
-int32_t
-dd_obb(dd_ctx_t* ctx, float* c, float* m)
+void
+dd__term_font_jobs(dd_ctx_t* ctx)
 {
-  DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(c);
-  DBGDRAW_ASSERT(m);
-
-  dd_vec3_t center_pt = dd_vec3(c[0], c[1], c[2]);
-  dd_mat3_t axes;
-  memcpy(axes.data, m, sizeof(axes));
-
-  if (!dd__frustum_obb_test(ctx, center_pt, axes))
+  for (int32_t i = 0; i < ctx->font_jobs_len; ++i)
   {
-    return DBGDRAW_ERR_CULLED;
+    dd_font_job_t* job = ctx->font_jobs[i];
+    dd__join_font_job(job);
+    dd__free_font(&job->font);
+    DBGDRAW_FREE(job);
   }
-
-  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
-  mode_vert_count[DBGDRAW_MODE_POINT]  = 8;
-  mode_vert_count[DBGDRAW_MODE_STROKE] = 24;
-  mode_vert_count[DBGDRAW_MODE_FILL]   = 36;
-  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
-
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
-
-  dd_vec3_t v1 = axes.col[0];
-  dd_vec3_t v2 = axes.col[1];
-  dd_vec3_t v3 = axes.col[2];
-
-  dd_vec3_t pts[8] = {
-    dd_vec3(center_pt.x + v1.x - v2.x + v3.x,
-            center_pt.y + v1.y - v2.y + v3.y,
-            center_pt.z + v1.z - v2.z + v3.z),
-    dd_vec3(center_pt.x - v1.x - v2.x + v3.x,
-            center_pt.y - v1.y - v2.y + v3.y,
-            center_pt.z - v1.z - v2.z + v3.z),
-    dd_vec3(center_pt.x - v1.x - v2.x - v3.x,
-            center_pt.y - v1.y - v2.y - v3.y,
-            center_pt.z - v1.z - v2.z - v3.z),
-    dd_vec3(center_pt.x + v1.x - v2.x - v3.x,
-            center_pt.y + v1.y - v2.y - v3.y,
-            center_pt.z + v1.z - v2.z - v3.z),
-
-    dd_vec3(center_pt.x - v1.x + v2.x + v3.x,
-            center_pt.y - v1.y + v2.y + v3.y,
-            center_pt.z - v1.z + v2.z + v3.z),
-    dd_vec3(center_pt.x + v1.x + v2.x + v3.x,
-            center_pt.y + v1.y + v2.y + v3.y,
-            center_pt.z + v1.z + v2.z + v3.z),
-    dd_vec3(center_pt.x + v1.x + v2.x - v3.x,
-            center_pt.y + v1.y + v2.y - v3.y,
-            center_pt.z + v1.z + v2.z - v3.z),
-    dd_vec3(center_pt.x - v1.x + v2.x - v3.x,
-            center_pt.y - v1.y + v2.y - v3.y,
-            center_pt.z - v1.z + v2.z - v3.z),
-  };
-
-  dd__box(ctx, pts);
-
-  return DBGDRAW_ERR_OK;
+  DBGDRAW_FREE(ctx->font_jobs);
+  ctx->font_jobs     = NULL;
+  ctx->font_jobs_len = 0;
+  ctx->font_jobs_cap = 0;
 }
+#endif /* DBGDRAW_ASYNC_FONTS */
 
+// NOTE(maciej): I do not expect to have more like 5 fonts, so it is just pure
+// search over an array
 int32_t
-dd_frustum(dd_ctx_t* ctx, float* view_matrix, float* proj_matrix)
+dd_find_font(dd_ctx_t* ctx, char* font_name)
 {
-  DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(view_matrix);
-  DBGDRAW_ASSERT(proj_matrix);
-
-  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
-  mode_vert_count[DBGDRAW_MODE_POINT]  = 8;
-  mode_vert_count[DBGDRAW_MODE_STROKE] = 24;
-  mode_vert_count[DBGDRAW_MODE_FILL]   = 36;
-  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
-
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
-
-  dd_mat4_t proj, view;
-  memcpy(proj.data, proj_matrix, sizeof(dd_mat4_t));
-  memcpy(view.data, view_matrix, sizeof(dd_mat4_t));
-
-  dd_mat4_t inv_clip = dd_mat4_inverse(dd_mat4_mul(proj, view));
-
-  dd_vec4_t pts_a[8] = {
-    dd_vec4(1.0f, -1.0f, 1.0f, 1.0f),
-    dd_vec4(-1.0f, -1.0f, 1.0f, 1.0f),
-    dd_vec4(-1.0f, 1.0f, 1.0f, 1.0f),
-    dd_vec4(1.0f, 1.0f, 1.0f, 1.0f),
-
-    dd_vec4(-1.0f, -1.0f, -1.0f, 1.0f),
-    dd_vec4(1.0f, -1.0f, -1.0f, 1.0f),
-    dd_vec4(1.0f, 1.0f, -1.0f, 1.0f),
-    dd_vec4(-1.0f, 1.0f, -1.0f, 1.0f),
-
-  };
-
-  dd_vec3_t pts_b[8];
-  for (int32_t i = 0; i < 8; ++i)
+  for (int32_t i = 0; i < ctx->fonts_len; ++i)
   {
-    pts_a[i] = dd_mat4_vec4_mul(inv_clip, pts_a[i]);
-    pts_b[i] = dd_vec4_to_vec3(pts_a[i]);
-    pts_b[i] = dd_vec3_scalar_div(pts_b[i], pts_a[i].w);
+    if (strncmp(font_name, ctx->fonts[i].name, 4096) == 0) { return i; }
   }
-
-  dd__box(ctx, pts_b);
-
-  return DBGDRAW_ERR_OK;
+  return -1;
 }
 
 int32_t
-dd_sphere(dd_ctx_t* ctx, float* c, float radius)
+dd_set_font(dd_ctx_t* ctx, int32_t font_idx)
 {
   DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(c);
-
-  dd_vec3_t center_pt = dd_vec3(c[0], c[1], c[2]);
-  if (!dd__frustum_sphere_test(ctx, center_pt, radius))
-  {
-    return DBGDRAW_ERR_CULLED;
-  }
-
-  int32_t resolution = 1 << (ctx->detail_level + 2);
-  int32_t n_rings    = 3;
-
-  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
-  mode_vert_count[DBGDRAW_MODE_POINT]  = n_rings * resolution;
-  mode_vert_count[DBGDRAW_MODE_STROKE] = n_rings * resolution * 2;
-  mode_vert_count[DBGDRAW_MODE_FILL]   = resolution * resolution * 3;
-  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
-
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
-
-  dd__sphere(ctx, &center_pt, radius, resolution);
-
+  DBGDRAW_VALIDATE(font_idx >= 0 && font_idx < ctx->fonts_len,
+                   DBGDRAW_ERR_INVALID_FONT_REQUESTED);
+#ifdef DBGDRAW_ASYNC_FONTS
+  // Text uses the default font until the font is loaded, then dd_render
+  // switches to it
+  ctx->pending_font_idx = -1;
+  if (ctx->fonts[font_idx].status == DBGDRAW_ERR_FONT_LOADING)
+  {
+    ctx->pending_font_idx = font_idx;
+  }
+#endif
+#ifdef DBGDRAW_USE_DEFAULT_FONT
+  if (ctx->fonts[font_idx].status && ctx->default_font_idx >= 0)
+  {
+    font_idx = ctx->default_font_idx;
+  }
+#endif
+  ctx->active_font_idx = font_idx;
   return DBGDRAW_ERR_OK;
 }
 
 int32_t
-dd_cone(dd_ctx_t* ctx, float* a, float* b, float radius)
+dd_get_font_status(dd_ctx_t* ctx, int32_t font_idx)
 {
   DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(a);
-  DBGDRAW_ASSERT(b);
-
-  dd_vec3_t pt_a     = dd_vec3(a[0], a[1], a[2]);
-  dd_vec3_t pt_b     = dd_vec3(b[0], b[1], b[2]);
-  int32_t resolution = 1 << (ctx->detail_level + 2);
-
-  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
-  mode_vert_count[DBGDRAW_MODE_POINT]  = resolution / 2 + 1;
-  mode_vert_count[DBGDRAW_MODE_STROKE] = 3 * resolution;
-  mode_vert_count[DBGDRAW_MODE_FILL]   = 6 * resolution;
-  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
-
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
-
-  dd__cone(ctx, pt_a, pt_b, radius, resolution);
-
-  return DBGDRAW_ERR_OK;
+  if (font_idx < 0 || font_idx >= ctx->fonts_len)
+  {
+    return DBGDRAW_ERR_INVALID_FONT_REQUESTED;
+  }
+  return ctx->fonts[font_idx].status;
 }
 
 int32_t
-dd_conical_frustum(dd_ctx_t* ctx,
-                   float* a,
-                   float* b,
-                   float radius_a,
-                   float radius_b)
+dd_set_text_size(dd_ctx_t* ctx, float text_size)
 {
   DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(a);
-  DBGDRAW_ASSERT(b);
-
-  dd_vec3_t pt_a     = dd_vec3(a[0], a[1], a[2]);
-  dd_vec3_t pt_b     = dd_vec3(b[0], b[1], b[2]);
-  int32_t resolution = 1 << (ctx->detail_level + 2);
-  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
-  mode_vert_count[DBGDRAW_MODE_POINT]  = resolution;
-  mode_vert_count[DBGDRAW_MODE_STROKE] = 5 * resolution;
-  mode_vert_count[DBGDRAW_MODE_FILL]   = 12 * resolution;
-  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
-
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
-
-  dd__conical_frustum(ctx, pt_a, pt_b, radius_a, radius_b, resolution);
-
+  ctx->text_size = text_size;
   return DBGDRAW_ERR_OK;
 }
 
 int32_t
-dd_cylinder(dd_ctx_t* ctx, float* a, float* b, float radius)
+dd_set_text_declutter(dd_ctx_t* ctx, uint8_t enable)
 {
-  return dd_conical_frustum(ctx, a, b, radius, radius);
+  DBGDRAW_ASSERT(ctx);
+  ctx->text_declutter = enable;
+  return DBGDRAW_ERR_OK;
 }
 
 int32_t
-dd_arrow(dd_ctx_t* ctx,
-         float* a,
-         float* b,
-         float radius,
-         float head_radius,
-         float head_length)
+dd_set_text_priority(dd_ctx_t* ctx, float priority)
 {
-  dd_vec3_t pt_a = dd_vec3(a[0], a[1], a[2]);
-  dd_vec3_t pt_b = dd_vec3(b[0], b[1], b[2]);
-  dd_vec3_t v    = dd_vec3_sub(pt_b, pt_a);
-  dd_vec3_t pt_c = dd_vec3_add(pt_a, dd_vec3_scalar_mul(v, head_length));
-
-  bool error = dd_cone(ctx, pt_c.data, pt_b.data, head_radius);
-  if (error) { return error; }
-  return dd_conical_frustum(ctx, pt_a.data, pt_c.data, radius, radius);
+  DBGDRAW_ASSERT(ctx);
+  ctx->text_priority = priority;
+  return DBGDRAW_ERR_OK;
 }
 
+// Places glyphs laid out in font space, 'advance' is the width of the line
 int32_t
-dd_torus(dd_ctx_t* ctx, float* center, float radius_a, float radius_b)
-{
-  DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(center);
+dd__text_line(dd_ctx_t* ctx,
+              dd_vec3_t p,
+              const dd_layout_glyph_t* glyphs,
+              int32_t glyphs_len,
+              float advance,
+              dd_text_info_t* info)
+{
+  dd_font_data_t* font = ctx->fonts + ctx->active_font_idx;
+
+  // Text vertices store their font, so backends with a font array draw any mix
+  // of fonts in one command. Others bind the font of the command, which is
+  // split when the font changes.
+  if (ctx->cur_cmd->font_idx >= 0 &&
+      ctx->cur_cmd->font_idx != ctx->active_font_idx &&
+      !(ctx->backend_caps & DBGDRAW_BACKEND_CAPS_FONT_ARRAY))
+  {
+    int32_t error = dd__split_cmd(ctx);
+    if (error) { return error; }
+  }
+  ctx->cur_cmd->font_idx = ctx->active_font_idx;
 
-  dd_mat3_t axes      = dd_mat3_identity();
-  axes.col[0].x       = radius_a * 2;
-  axes.col[1].y       = radius_b * 2;
-  axes.col[2].z       = radius_a * 2;
-  dd_vec3_t center_pt = dd_vec3(center[0], center[1], center[2]);
-  if (!dd__frustum_obb_test(ctx, center_pt, axes))
+  uint8_t do_clipping =
+    info && (info->clip_rect.w > 0 && info->clip_rect.h > 0);
+
+  // Clipped text, instanced commands and captured frames are drawn from
+  // vertices, on any backend
+  uint8_t use_glyph_instances =
+    (ctx->backend_caps & DBGDRAW_BACKEND_CAPS_GLYPH_INSTANCES) &&
+    !do_clipping && ctx->cur_cmd->instance_count == 0;
+#ifndef DBGDRAW_NO_STDIO
+  use_glyph_instances = use_glyph_instances && !ctx->capture;
+#endif
+
+  if (use_glyph_instances)
   {
-    return DBGDRAW_ERR_CULLED;
+    DD_GROW(ctx,
+            ctx->glyph_instances,
+            ctx->glyph_instances_len + glyphs_len,
+            ctx->glyph_instances_cap,
+            sizeof(dd_glyph_instance_t));
+    DD_GROW(ctx,
+            ctx->text_anchors,
+            ctx->text_anchors_len + 1,
+            ctx->text_anchors_cap,
+            sizeof(dd_text_anchor_t));
+    if (!ctx->glyph_instances || !ctx->text_anchors)
+    {
+      return DBGDRAW_ERR_FAILED_ALLOC;
+    }
+  }
+  else
+  {
+    int32_t new_verts = 6 * glyphs_len;
+    DD_GROW(ctx,
+            ctx->verts_data,
+            ctx->verts_len + new_verts,
+            ctx->verts_cap,
+            sizeof(dd_vertex_t));
   }
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_text_line");
 
-  int32_t resolution    = 1 << (ctx->detail_level + 2);
-  int32_t n_big_rings   = 4;
-  int32_t n_small_rings = resolution >> 1;
-  int32_t n_rings       = n_big_rings + n_small_rings;
+  // Layouts are in pixels of the font size, which are scaled to world units of
+  // the requested text size
+  float text_size  = ctx->text_size > 0.0f ? ctx->text_size : (float)font->size;
+  float world_size = dd__pixels_to_world_size(ctx, p, text_size);
+  float scale      = fabsf(world_size / font->size);
 
-  int32_t mode_vert_count[DBGDRAW_MODE_COUNT];
-  mode_vert_count[DBGDRAW_MODE_POINT]  = n_rings * resolution,
-  mode_vert_count[DBGDRAW_MODE_STROKE] = n_rings * resolution * 2,
-  mode_vert_count[DBGDRAW_MODE_FILL]   = n_small_rings * resolution * 2 * 3;
-  int32_t new_verts = mode_vert_count[ctx->cur_cmd->draw_mode];
+  ctx->cur_cmd->min_depth = dd_mat4_vec3_mul(ctx->cur_cmd->xform, p, 1).z;
 
-  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
+  dd_mat3_t m;
+  if (!ctx->is_ortho) { m = dd__get_view_aligned_basis(ctx, p); }
 
-  switch (ctx->cur_cmd->draw_mode)
+  float width, height;
+  if (info && info->width > 0)
   {
-    case DBGDRAW_MODE_POINT:
-      dd__torus_point_stroke(ctx,
-                             center_pt,
-                             radius_a,
-                             radius_b,
-                             resolution >> 1,
-                             n_small_rings);
+    width  = info->width;
+    height = info->height;
+  }
+  else
+  {
+    width  = scale * advance;
+    height = scale * (font->ascent - font->descent);
+  }
+
+  dd_text_valign_t vert_align = DBGDRAW_TEXT_BASELINE;
+  dd_text_halign_t horz_align = DBGDRAW_TEXT_LEFT;
+  if (info)
+  {
+    vert_align   = info->vert_align;
+    horz_align   = info->horz_align;
+    info->width  = width;
+    info->height = height;
+  }
+
+  float vert_offset = 0.0, horz_offset = 0.0;
+  switch (horz_align)
+  {
+    case DBGDRAW_TEXT_LEFT:
+      horz_offset = 0.0f;
       break;
-    case DBGDRAW_MODE_STROKE:
-      dd__torus_point_stroke(ctx,
-                             center_pt,
-                             radius_a,
-                             radius_b,
-                             resolution,
-                             n_small_rings);
+    case DBGDRAW_TEXT_RIGHT:
+      horz_offset = -width;
       break;
+    case DBGDRAW_TEXT_CENTER:
     default:
-      dd__torus_fill(ctx,
-                     center_pt,
-                     radius_a,
-                     radius_b,
-                     resolution,
-                     n_small_rings);
+      horz_offset = -width * 0.5f;
       break;
   }
 
-  return DBGDRAW_ERR_OK;
-}
+  float sign = 1.0;
+  if (ctx->is_ortho && ctx->proj.col[1].y >= 0.0) { sign = -1.0f; }
+  switch (vert_align)
+  {
+    case DBGDRAW_TEXT_BASELINE:
+      vert_offset = 0.0f;
+      break;
+    case DBGDRAW_TEXT_BOTTOM:
+      vert_offset = sign * scale * font->descent;
+      break;
+    case DBGDRAW_TEXT_TOP:
+      vert_offset = sign * scale * font->ascent;
+      break;
+    case DBGDRAW_TEXT_MIDDLE:
+    default:
+      vert_offset = sign * scale * 0.5f * (font->ascent + font->descent);
+      break;
+  }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Font Loading
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  p.x += horz_offset;
+  p.y += vert_offset;
 
-#if DBGDRAW_HAS_TEXT_SUPPORT
+  uint32_t anchor_idx = (uint32_t)ctx->text_anchors_len;
+  int32_t glyph_count = 0;
+  if (use_glyph_instances)
+  {
+    dd_vec3_t axis_x = dd_vec3(scale, 0.0f, 0.0f);
+    dd_vec3_t axis_y = dd_vec3(0.0f, sign * scale, 0.0f);
+    if (!ctx->is_ortho)
+    {
+      axis_x = dd_vec3_scalar_mul(m.col[0], scale);
+      axis_y = dd_vec3_scalar_mul(m.col[1], sign * scale);
+    }
+    float texel_size = font->is_sdf ? 1.0f : 1.0f / DD_GLYPH_OVERSAMPLING;
+
+    dd_text_anchor_t* anchor = ctx->text_anchors + ctx->text_anchors_len++;
+    anchor->origin           = dd_vec4(p.x, p.y, p.z, 0.0f);
+    anchor->axis_x           = dd_vec4(axis_x.x, axis_x.y, axis_x.z, 0.0f);
+    anchor->axis_y           = dd_vec4(axis_y.x, axis_y.y, axis_y.z, 0.0f);
+    anchor->atlas            = dd_vec4(1.0f / font->bitmap_width,
+                            1.0f / font->bitmap_height,
+                            texel_size,
+                            (float)ctx->active_font_idx);
+  }
 
-int32_t
-dd_init_font_from_memory(dd_ctx_t* ctx,
-                         const void* ttf_buf,
-                         const char* name,
-                         int32_t font_size,
-                         int32_t width,
-                         int32_t height,
-                         int32_t* font_idx)
-{
-  DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(ttf_buf);
-  DBGDRAW_ASSERT(name);
-  DBGDRAW_ASSERT(font_idx);
+  float start_x      = 1e9;
+  uint8_t is_clipped = ctx->cur_cmd->clip_rect.z > 0.0f;
 
-  DBGDRAW_VALIDATE(ctx->fonts_len < ctx->fonts_cap,
-                   DBGDRAW_ERR_FONT_LIMIT_REACHED);
-  dd_font_data_t* font = ctx->fonts + ctx->fonts_len;
-  font->bitmap_width   = width;
-  font->bitmap_height  = height;
-  font->size           = font_size;
-  size_t name_len      = strnlen(name, 4096);
-  font->name           = DBGDRAW_MALLOC(name_len);
-  strncpy(font->name, name, name_len);
+  // The layout is in font space, so only the placement depends on the frame
+  dd_vec3_t pt_a, pt_b, pt_c;
+  dd_vec2_t uv_a, uv_b, uv_c;
+  dd_vertex_t* start = ctx->verts_data + ctx->verts_len;
+  for (int32_t i = 0; i < glyphs_len; ++i)
+  {
+    stbtt_aligned_quad q = glyphs[i].q;
 
-  uint8_t* pixel_buf = DBGDRAW_MALLOC(width * height);
-  memset(pixel_buf, 0, width * height);
+    dd_vec3_t min_pt = dd_vec3(scale * q.x0, sign * scale * q.y1, 0.0);
+    dd_vec3_t max_pt = dd_vec3(scale * q.x1, sign * scale * q.y0, 0.0);
+    if (ctx->is_ortho)
+    {
+      min_pt = dd_vec3_add(p, min_pt);
+      max_pt = dd_vec3_add(p, max_pt);
+    }
 
-  stbtt_InitFont(&font->info, ttf_buf, 0);
-  float to_pixel_scale =
-    stbtt_ScaleForPixelHeight(&font->info, (float)font->size);
+    if (do_clipping)
+    {
+      float min_x = min_pt.x;
+      float max_x = max_pt.x;
+      float min_y = min_pt.y;
+      float max_y = max_pt.y;
 
-  int32_t ascent, descent, line_gap;
-  stbtt_GetFontVMetrics(&font->info, &ascent, &descent, &line_gap);
-  font->ascent            = to_pixel_scale * ascent;
-  font->descent           = to_pixel_scale * descent;
-  font->line_gap          = to_pixel_scale * line_gap;
-  int32_t num_latin_chars = 127 - 32;
-  int32_t num_greek_chars = 0x3C9 - 0x391;
-  stbtt_pack_context spc  = {0};
-  stbtt_PackBegin(&spc, pixel_buf, width, height, 0, 1, NULL);
-  stbtt_PackSetOversampling(&spc, 2, 2);
-  stbtt_PackFontRange(&spc,
-                      (void*)ttf_buf,
-                      0,
-                      (float)font->size,
-                      32,
-                      num_latin_chars,
-                      font->char_data);
-  stbtt_PackFontRange(&spc,
-                      (void*)ttf_buf,
-                      0,
-                      (float)font->size,
-                      0x391,
-                      num_greek_chars,
-                      font->char_data + num_latin_chars);
-  stbtt_PackEnd(&spc);
+      float w1 = max_x - min_x;
+      float h1 = max_pt.y - min_pt.y;
+
+      // Clip from top
+      if (min_y >= info->clip_rect.y + info->clip_rect.h) { continue; }
+      if (max_y >= info->clip_rect.y + info->clip_rect.h)
+      {
+        max_pt.y = DD_MIN(max_y, info->clip_rect.y + info->clip_rect.h);
+        float t1 = max_pt.y - min_y;
+        float h2 = q.t1 - q.t0;
+        float t2 = (t1 * h2) / h1;
+        q.t0     = q.t1 - t2;
+      }
 
-  dd_backend_init_font_texture(ctx, pixel_buf, width, height, &font->tex_id);
+      // Clip from bottom
+      if (max_y < info->clip_rect.y) { continue; }
+      if (min_y < info->clip_rect.y)
+      {
+        min_pt.y = DD_MAX(min_y, info->clip_rect.y);
+        float t1 = max_y - min_pt.y;
+        float h2 = q.t1 - q.t0;
+        float t2 = (t1 * h2) / h1;
+        q.t1     = q.t0 + t2;
+      }
 
-  DBGDRAW_FREE(pixel_buf);
+      // Clip from right
+      if (min_x >= info->clip_rect.x + info->clip_rect.w) { continue; }
+      if (max_x >= info->clip_rect.x + info->clip_rect.w)
+      {
+        max_pt.x = DD_MIN(max_x, info->clip_rect.x + info->clip_rect.w);
+        float t1 = max_pt.x - min_x;
+        float w2 = q.s1 - q.s0;
+        float t2 = (t1 * w2) / w1;
+        q.s1     = q.s0 + t2;
+      }
 
-  *font_idx = ctx->fonts_len++;
-  return DBGDRAW_ERR_OK;
-}
+      // Clip from left
+      if (max_x < info->clip_rect.x) { continue; }
+      if (min_x < info->clip_rect.x)
+      {
+        min_pt.x = DD_MAX(min_x, info->clip_rect.x);
+        float t1 = max_x - min_pt.x;
+        float w2 = q.s1 - q.s0;
+        float t2 = (t1 * w2) / w1;
+        q.s0     = q.s1 - t2;
+      }
+    }
 
-/*UTF-8 decoder by Bjoern Hoehrmann. See end of file for licensing*/
-#define DD_UTF8_ACCEPT 0
-#define DD_UTF8_REJECT 12
+    start_x = DD_MIN(start_x, min_pt.x);
 
-// clang-format off
-static const uint8_t dd_utf8d_table[] = {
-  // The first part of the table maps bytes to character classes that
-  // to reduce the size of the transition table and create bitmasks.
-   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-   1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
-   7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,  7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
-   8,8,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
-  10,3,3,3,3,3,3,3,3,3,3,3,3,4,3,3, 11,6,6,6,5,8,8,8,8,8,8,8,8,8,8,8,
+    // Glyphs fully outside of the clip rect of the command are dropped, the
+    // rest is cut by the backend
+    if (is_clipped)
+    {
+      dd_vec3_t c  = dd_vec3_scalar_mul(dd_vec3_add(min_pt, max_pt), 0.5f);
+      float radius = 0.5f * dd_vec3_norm(dd_vec3_sub(max_pt, min_pt));
+      if (!ctx->is_ortho)
+      {
+        c = dd_vec3_add(p,
+                        dd_vec3_add(dd_vec3_scalar_mul(m.col[0], c.x),
+                                    dd_vec3_scalar_mul(m.col[1], c.y)));
+      }
+      if (!dd__clip_sphere_test(ctx, c, radius)) { continue; }
+    }
 
-  // The second part is a transition table that maps a combination
-  // of a state of the automaton and a character class to a state.
-   0,12,24,36,60,96,84,12,12,12,48,72, 12,12,12,12,12,12,12,12,12,12,12,12,
-  12, 0,12,12,12,12,12, 0,12, 0,12,12, 12,24,12,12,12,12,12,24,12,24,12,12,
-  12,12,12,12,12,12,12,24,12,12,12,12, 12,24,12,12,12,12,12,12,12,24,12,12,
-  12,12,12,12,12,12,12,36,12,36,12,12, 12,36,12,12,12,12,12,36,12,36,12,12,
-  12,36,12,12,12,12,12,12,12,12,12,12, 
-};
-// clang-format on
+    if (use_glyph_instances)
+    {
+      // Glyphs without an outline, like space, only advance
+      if (q.x1 <= q.x0 || q.y1 <= q.y0) { continue; }
+      dd_glyph_instance_t* glyph =
+        ctx->glyph_instances + ctx->glyph_instances_len++;
+      glyph->x      = q.x0;
+      glyph->y      = q.y0;
+      glyph->s0     = (uint16_t)(q.s0 * font->bitmap_width + 0.5f);
+      glyph->t0     = (uint16_t)(q.t0 * font->bitmap_height + 0.5f);
+      glyph->s1     = (uint16_t)(q.s1 * font->bitmap_width + 0.5f);
+      glyph->t1     = (uint16_t)(q.t1 * font->bitmap_height + 0.5f);
+      glyph->anchor = anchor_idx;
+      glyph->col    = ctx->color;
+      glyph_count++;
+      continue;
+    }
 
-uint32_t inline dd__utf8_decode(uint32_t* state, uint32_t* codep, uint32_t byte)
-{
-  uint32_t type = dd_utf8d_table[byte];
+    pt_a = dd_vec3(min_pt.x, max_pt.y, 0.0);
+    uv_a = dd_vec2(q.s0, q.t0);
+    pt_b = dd_vec3(max_pt.x, min_pt.y, 0.0);
+    uv_b = dd_vec2(q.s1, q.t1);
+    pt_c = dd_vec3(max_pt.x, max_pt.y, 0.0);
+    uv_c = dd_vec2(q.s1, q.t0);
 
-  *codep = (*state != DD_UTF8_ACCEPT) ? (byte & 0x3fu) | (*codep << 6)
-                                      : (0xff >> type) & (byte);
+    dd__vertex_text(ctx, &pt_a, &uv_a);
+    dd__vertex_text(ctx, &pt_b, &uv_b);
+    dd__vertex_text(ctx, &pt_c, &uv_c);
 
-  *state = dd_utf8d_table[256 + *state + type];
-  return *state;
-}
+    pt_a = dd_vec3(min_pt.x, max_pt.y, 0.0);
+    uv_a = dd_vec2(q.s0, q.t0);
+    pt_b = dd_vec3(min_pt.x, min_pt.y, 0.0);
+    uv_b = dd_vec2(q.s0, q.t1);
+    pt_c = dd_vec3(max_pt.x, min_pt.y, 0.0);
+    uv_c = dd_vec2(q.s1, q.t1);
 
-const char*
-dd__decode_char(const char* str, uint32_t* cp)
-{
-  uint32_t state = 0;
+    dd__vertex_text(ctx, &pt_a, &uv_a);
+    dd__vertex_text(ctx, &pt_b, &uv_b);
+    dd__vertex_text(ctx, &pt_c, &uv_c);
+  }
+  dd_vertex_t* end = ctx->verts_data + ctx->verts_len;
+  ctx->cur_cmd->glyph_count += glyph_count;
+  glyph_count += (int32_t)(end - start) / 6;
+  DBGDRAW_STATS(ctx->stats.glyph_count += glyph_count);
 
-  int32_t count       = 0;
-  const uint8_t* ustr = (const uint8_t*)str;
-  for (; *ustr; ++ustr)
+  if (!ctx->is_ortho)
   {
-    count++;
-    if (!dd__utf8_decode(&state, cp, *ustr)) { break; }
+    dd_mat4_t xform = dd_mat4_identity();
+    xform.col[0]    = dd_vec3_to_vec4(m.col[0]);
+    xform.col[1]    = dd_vec3_to_vec4(m.col[1]);
+    xform.col[2]    = dd_vec3_to_vec4(m.col[2]);
+    xform.col[3]    = dd_vec3_to_vec4(p);
+    xform.col[3].w  = 1.0f;
+    dd__transform_verts(xform, start, end, 0);
   }
-  str += count;
 
-  if (state != DD_UTF8_ACCEPT) { return NULL; }
+  if (info)
+  {
+    info->anchor = dd_vec3(start_x, p.y + scale * font->descent, p.z);
+    info->anchor.x += horz_offset;
+    info->anchor.y += vert_offset;
+  }
 
-  return str;
+  DBGDRAW_TRACE_END(ctx, "dd_text_line");
+  return DBGDRAW_ERR_OK;
 }
 
+// The rectangle of a label spans the advance of its glyphs and the ascent and
+// descent of its font, aligned around the projected position the way
+// dd__text_line aligns the glyphs. Text is upright on screen, so this is done
+// in pixels with y pointing down. Labels behind the camera or outside of the
+// viewport are dropped here.
 int32_t
-dd__codepoint_to_index(uint32_t codepoint)
+dd__defer_text_label(dd_ctx_t* ctx,
+                     dd_vec3_t p,
+                     dd_text_layout_t* layout,
+                     dd_text_info_t* info)
 {
-  int shift = 0xf000 - 151;
-  if (codepoint < 0xf000)
+  dd_declutter_t* dc   = &ctx->declutter;
+  dd_font_data_t* font = ctx->fonts + ctx->active_font_idx;
+
+  float text_size  = ctx->text_size > 0.0f ? ctx->text_size : (float)font->size;
+  float world_size = dd__pixels_to_world_size(ctx, p, text_size);
+  float scale      = fabsf(world_size / font->size);
+  float px_scale   = text_size / font->size;
+
+  DD_GROW(ctx,
+          dc->labels,
+          dc->labels_len + 1,
+          dc->labels_cap,
+          sizeof(dd_text_label_t));
+  if (!dc->labels) { return DBGDRAW_ERR_FAILED_ALLOC; }
+  dd_text_label_t* label = dc->labels + dc->labels_len;
+  label->has_info        = info != NULL;
+  if (info) { label->info = *info; }
+
+  float width  = scale * layout->width;
+  float height = scale * (font->ascent - font->descent);
+  if (info && info->width > 0)
   {
-    if (codepoint < 128) { shift = 32; }
-    else
-    {
-      shift = (0x391 - 95);
-    }
+    width  = info->width;
+    height = info->height;
+  }
+  if (info)
+  {
+    info->width  = width;
+    info->height = height;
   }
-  // int32_t shift = (codepoint < 128) ? 32 : (0x391 - 95);
-  return codepoint - shift;
-}
 
-int32_t
-dd__strlen(const char* str)
-{
-  uint32_t cp;
-  uint32_t state = 0;
+  dd_vec4_t clip = dd_vec4(p.x, p.y, p.z, 1.0f);
+  clip           = dd_mat4_vec4_mul(ctx->cur_cmd->xform, clip);
+  clip           = dd_mat4_vec4_mul(ctx->view, clip);
+  clip           = dd_mat4_vec4_mul(ctx->proj, clip);
+  if (clip.w <= 0.0f)
+  {
+    DBGDRAW_STATS(ctx->stats.decluttered_label_count++);
+    return DBGDRAW_ERR_OK;
+  }
 
-  int32_t count       = 0;
-  const uint8_t* ustr = (const uint8_t*)str;
-  for (; *ustr; ++ustr)
+  float viewport_width  = ctx->viewport.z;
+  float viewport_height = ctx->viewport.w;
+  float x = (0.5f + 0.5f * clip.x / clip.w) * viewport_width;
+  float y = (0.5f - 0.5f * clip.y / clip.w) * viewport_height;
+
+  float advance     = px_scale * layout->width;
+  float align_width = scale > 0.0f ? width * px_scale / scale : advance;
+  dd_text_halign_t horz_align = DBGDRAW_TEXT_LEFT;
+  dd_text_valign_t vert_align = DBGDRAW_TEXT_BASELINE;
+  if (info)
+  {
+    horz_align = label->info.horz_align;
+    vert_align = label->info.vert_align;
+  }
+  switch (horz_align)
+  {
+    case DBGDRAW_TEXT_LEFT:
+      break;
+    case DBGDRAW_TEXT_RIGHT:
+      x -= align_width;
+      break;
+    case DBGDRAW_TEXT_CENTER:
+    default:
+      x -= 0.5f * align_width;
+      break;
+  }
+  switch (vert_align)
   {
-    if (!dd__utf8_decode(&state, &cp, *ustr)) { count++; }
+    case DBGDRAW_TEXT_BASELINE:
+      break;
+    case DBGDRAW_TEXT_BOTTOM:
+      y += px_scale * font->descent;
+      break;
+    case DBGDRAW_TEXT_TOP:
+      y += px_scale * font->ascent;
+      break;
+    case DBGDRAW_TEXT_MIDDLE:
+    default:
+      y += px_scale * 0.5f * (font->ascent + font->descent);
+      break;
   }
 
-  if (state != DD_UTF8_ACCEPT) { count = 0; }
+  label->x0 = DD_MAX(x, 0.0f);
+  label->x1 = DD_MIN(x + advance, viewport_width);
+  label->y0 = DD_MAX(y - px_scale * font->ascent, 0.0f);
+  label->y1 = DD_MIN(y - px_scale * font->descent, viewport_height);
+  if (label->x0 >= label->x1 || label->y0 >= label->y1)
+  {
+    DBGDRAW_STATS(ctx->stats.decluttered_label_count++);
+    return DBGDRAW_ERR_OK;
+  }
 
-  return count;
+  label->pos        = p;
+  label->layout_idx = (int32_t)(layout - ctx->text_cache.layouts);
+  label->font_idx   = ctx->active_font_idx;
+  label->text_size  = ctx->text_size;
+  label->priority   = ctx->text_priority;
+  label->color      = ctx->color;
+  label->is_kept    = 0;
+  dc->labels_len++;
+  return DBGDRAW_ERR_OK;
 }
 
-void
-dd_get_text_size_font_space(dd_ctx_t* ctx,
-                            int32_t font_idx,
-                            const char* str,
-                            int32_t strlen,
-                            float* width,
-                            float* height)
+// Higher priority first, and labels of equal priority in the order they were
+// drawn
+int32_t
+dd__label_key_cmp(const void* a, const void* b)
 {
-  DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(str);
-  DBGDRAW_VALIDATE(font_idx < ctx->fonts_cap, DBGDRAW_ERR_OUT_OF_BOUNDS_ACCESS);
+  const dd_label_key_t* key_a = (const dd_label_key_t*)a;
+  const dd_label_key_t* key_b = (const dd_label_key_t*)b;
 
-  dd_font_data_t* font = ctx->fonts + font_idx;
-  *width               = 0;
-  *height              = font->ascent - font->descent;
-  for (int32_t i = 0; i < strlen; ++i)
+  if (key_a->priority != key_b->priority)
   {
-    uint32_t cp, idx;
-    str = dd__decode_char(str, &cp);
-    idx = dd__codepoint_to_index(cp);
-    stbtt_aligned_quad q;
-    float dummy;
-    stbtt_GetPackedQuad(font->char_data,
-                        font->bitmap_width,
-                        font->bitmap_height,
-                        idx,
-                        width,
-                        &dummy,
-                        &q,
-                        0);
+    return key_a->priority < key_b->priority ? 1 : -1;
   }
+  return key_a->label_idx - key_b->label_idx;
 }
 
-#ifndef DBGDRAW_NO_STDIO
 int32_t
-dd_init_font_from_file(dd_ctx_t* ctx,
-                       const char* font_path,
-                       const char* font_name,
-                       int32_t font_size,
-                       int32_t width,
-                       int32_t height,
-                       int32_t* font_idx)
-{
-  DBGDRAW_ASSERT(ctx);
-  DBGDRAW_ASSERT(font_path);
-  DBGDRAW_ASSERT(font_idx);
-  if (font_path)
+dd__draw_text_labels(dd_ctx_t* ctx)
+{
+  dd_declutter_t* dc = &ctx->declutter;
+  DBGDRAW_TRACE_BEGIN(ctx, "dd__draw_text_labels");
+
+  int32_t cell_size = DBGDRAW_DECLUTTER_CELL_SIZE;
+  int32_t cols      = (int32_t)ctx->viewport.z / cell_size + 1;
+  int32_t rows      = (int32_t)ctx->viewport.w / cell_size + 1;
+  DD_GROW(ctx,
+          dc->keys,
+          dc->labels_len,
+          dc->keys_cap,
+          sizeof(dd_label_key_t));
+  DD_GROW(ctx,
+          dc->cells,
+          cols * rows,
+          dc->cells_cap,
+          sizeof(int32_t));
+  if (!dc->keys || !dc->cells)
   {
-    FILE* fp = fopen(font_path, "rb");
-    if (!fp) { return DBGDRAW_ERR_FONT_FILE_NOT_FOUND; }
-    else
+    dc->labels_len = 0;
+    DBGDRAW_TRACE_END(ctx, "dd__draw_text_labels");
+    return DBGDRAW_ERR_FAILED_ALLOC;
+  }
+
+  for (int32_t i = 0; i < dc->labels_len; ++i)
+  {
+    dc->keys[i].priority  = dc->labels[i].priority;
+    dc->keys[i].label_idx = i;
+  }
+  qsort(dc->keys, dc->labels_len, sizeof(dd_label_key_t), dd__label_key_cmp);
+  memset(dc->cells, 0xff, cols * rows * sizeof(int32_t));
+  dc->nodes_len = 0;
+
+  int32_t error = DBGDRAW_ERR_OK;
+  for (int32_t i = 0; i < dc->labels_len && !error; ++i)
+  {
+    dd_text_label_t* label = dc->labels + dc->keys[i].label_idx;
+    int32_t col0           = (int32_t)label->x0 / cell_size;
+    int32_t col1           = (int32_t)label->x1 / cell_size;
+    int32_t row0           = (int32_t)label->y0 / cell_size;
+    int32_t row1           = (int32_t)label->y1 / cell_size;
+
+    uint8_t overlaps = 0;
+    for (int32_t row = row0; row <= row1 && !overlaps; ++row)
+    {
+      for (int32_t col = col0; col <= col1 && !overlaps; ++col)
+      {
+        int32_t node_idx = dc->cells[row * cols + col];
+        for (; node_idx >= 0; node_idx = dc->nodes[node_idx].next)
+        {
+          dd_text_label_t* other = dc->labels + dc->nodes[node_idx].label_idx;
+          if (label->x0 < other->x1 && other->x0 < label->x1 &&
+              label->y0 < other->y1 && other->y0 < label->y1)
+          {
+            overlaps = 1;
+            break;
+          }
+        }
+      }
+    }
+    if (overlaps)
+    {
+      DBGDRAW_STATS(ctx->stats.decluttered_label_count++);
+      continue;
+    }
+
+    int32_t cell_count = (row1 - row0 + 1) * (col1 - col0 + 1);
+    DD_GROW(ctx,
+            dc->nodes,
+            dc->nodes_len + cell_count,
+            dc->nodes_cap,
+            sizeof(dd_label_node_t));
+    if (!dc->nodes)
     {
-      fseek(fp, 0L, SEEK_END);
-      size_t size = ftell(fp);
-      rewind(fp);
-
-      uint8_t* ttf_buffer = DBGDRAW_MALLOC(size);
-      fread(ttf_buffer, 1, size, fp);
-      fclose(fp);
-
-      dd_init_font_from_memory(ctx,
-                               ttf_buffer,
-                               font_name,
-                               font_size,
-                               width,
-                               height,
-                               font_idx);
+      error = DBGDRAW_ERR_FAILED_ALLOC;
+      break;
+    }
+    for (int32_t row = row0; row <= row1; ++row)
+    {
+      for (int32_t col = col0; col <= col1; ++col)
+      {
+        int32_t cell_idx      = row * cols + col;
+        dd_label_node_t* node = dc->nodes + dc->nodes_len;
+        node->label_idx       = dc->keys[i].label_idx;
+        node->next            = dc->cells[cell_idx];
+        dc->cells[cell_idx]   = dc->nodes_len++;
+      }
     }
+    label->is_kept = 1;
   }
-  return DBGDRAW_ERR_OK;
-}
-#endif
 
-// NOTE(maciej): I do not expect to have more like 5 fonts, so it is just pure
-// search over an array
-int32_t
-dd_find_font(dd_ctx_t* ctx, char* font_name)
-{
-  for (int32_t i = 0; i < ctx->fonts_len; ++i)
+  // Kept labels are drawn in the order they were submitted, so backends that
+  // bind one font per command split the command as often as they would without
+  // decluttering
+  dd_color_t color    = ctx->color;
+  int32_t active_font = ctx->active_font_idx;
+  float text_size     = ctx->text_size;
+  for (int32_t i = 0; i < dc->labels_len && !error; ++i)
   {
-    if (strncmp(font_name, ctx->fonts[i].name, 4096) == 0) { return i; }
+    dd_text_label_t* label = dc->labels + i;
+    if (!label->is_kept) { continue; }
+    ctx->color           = label->color;
+    ctx->active_font_idx = label->font_idx;
+    ctx->text_size       = label->text_size;
+    dd_text_layout_t* layout = ctx->text_cache.layouts + label->layout_idx;
+    dd_text_info_t* info     = label->has_info ? &label->info : NULL;
+    error = dd__text_line(ctx,
+                          label->pos,
+                          ctx->text_cache.glyphs + layout->glyphs_offset,
+                          layout->glyphs_len,
+                          layout->width,
+                          info);
   }
-  return -1;
-}
+  ctx->color           = color;
+  ctx->active_font_idx = active_font;
+  ctx->text_size       = text_size;
 
-int32_t
-dd_set_font(dd_ctx_t* ctx, int32_t font_idx)
-{
-  DBGDRAW_ASSERT(ctx);
-  DBGDRAW_VALIDATE(ctx->cur_cmd == NULL, DBGDRAW_ERR_PREV_CMD_NOT_ENDED);
-  DBGDRAW_VALIDATE(font_idx >= 0 && font_idx < ctx->fonts_len,
-                   DBGDRAW_ERR_INVALID_FONT_REQUESTED);
-  ctx->active_font_idx = font_idx;
-  return DBGDRAW_ERR_OK;
+  dc->labels_len = 0;
+  DBGDRAW_TRACE_END(ctx, "dd__draw_text_labels");
+  return error;
 }
 
-// NOTE(maciej): "Decoding" below" is even worse, as it relies on the fact that
-// we only requested latin and greek chars. The real deal needs a hashtable most
-// likely
 int32_t
 dd_text_line(dd_ctx_t* ctx, float* pos, const char* str, dd_text_info_t* info)
 {
@@ -3435,228 +7417,657 @@ dd_text_line(dd_ctx_t* ctx, float* pos, const char* str, dd_text_info_t* info)
                    DBGDRAW_ERR_INVALID_MODE);
   DBGDRAW_VALIDATE(ctx->cur_cmd->shading_type == DBGDRAW_SHADING_TEXT,
                    DBGDRAW_ERR_INVALID_SHADING);
-  ctx->cur_cmd->font_idx = ctx->active_font_idx;
-  dd_font_data_t* font   = ctx->fonts + ctx->active_font_idx;
-  DBGDRAW_VALIDATE(font->name != NULL, DBGDRAW_ERR_USING_TEXT_WITHOUT_FONT);
+  DBGDRAW_VALIDATE(ctx->fonts[ctx->active_font_idx].name != NULL,
+                   DBGDRAW_ERR_USING_TEXT_WITHOUT_FONT);
+  int32_t status = ctx->fonts[ctx->active_font_idx].status;
+  if (status) { return status; }
+
+  dd_text_layout_t* layout = NULL;
+  status = dd__get_text_layout(ctx, ctx->active_font_idx, str, &layout);
+  if (status) { return status; }
+
+  dd_vec3_t p = dd_vec3(pos[0], pos[1], pos[2]);
+  if (ctx->text_declutter)
+  {
+    return dd__defer_text_label(ctx, p, layout, info);
+  }
+  return dd__text_line(ctx,
+                       p,
+                       ctx->text_cache.glyphs + layout->glyphs_offset,
+                       layout->glyphs_len,
+                       layout->width,
+                       info);
+}
+
+// A small subset of printf for dd_text_fmt and dd_text_number. Integers are
+// written two digits at a time. For %f the fraction of a float is scaled to
+// 'precision' digits, and for %e and %g the value is scaled to an integer of
+// the requested significant digits. Both are scaled with exact products, and
+// rounded once, so they match printf except in the last digit of an exact tie,
+// which is rounded away from zero. Values of 2^64 and above are written in the
+// exponent form, even with %f.
+typedef struct dd_format_spec
+{
+  int32_t width;
+  int32_t precision;
+  uint8_t left_align;
+  uint8_t zero_pad;
+  uint8_t alternate;
+  char sign;
+  char conv;
+} dd_format_spec_t;
+
+typedef struct dd_format_buf
+{
+  char* data;
+  int32_t len;
+  int32_t cap;
+} dd_format_buf_t;
+
+static const char dd__digit_pairs[] = "00010203040506070809"
+                                      "10111213141516171819"
+                                      "20212223242526272829"
+                                      "30313233343536373839"
+                                      "40414243444546474849"
+                                      "50515253545556575859"
+                                      "60616263646566676869"
+                                      "70717273747576777879"
+                                      "80818283848586878889"
+                                      "90919293949596979899";
+
+// Powers of ten that are exact in a double
+static const double dd__pow10[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                    1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                    1e18, 1e19, 1e20, 1e21, 1e22 };
+
+#define DD_FORMAT_MAX_PRECISION 17
+
+void
+dd__format_putc(dd_format_buf_t* buf, char c)
+{
+  if (buf->len < buf->cap) { buf->data[buf->len++] = c; }
+}
+
+// Writes the digits of 'value' backwards from 'end', returns the first digit
+char*
+dd__format_uint(char* end, uint64_t value, uint32_t base, bool upper)
+{
+  const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  if (base != 10)
+  {
+    do {
+      *--end = digits[value % base];
+      value /= base;
+    } while (value);
+    return end;
+  }
+  while (value >= 100)
+  {
+    uint32_t pair = (uint32_t)(value % 100) * 2;
+    value /= 100;
+    *--end = dd__digit_pairs[pair + 1];
+    *--end = dd__digit_pairs[pair];
+  }
+  if (value >= 10)
+  {
+    uint32_t pair = (uint32_t)value * 2;
+    *--end        = dd__digit_pairs[pair + 1];
+    *--end        = dd__digit_pairs[pair];
+  }
+  else { *--end = (char)('0' + value); }
+  return end;
+}
+
+// Returns the integer part of the sum 'hi' + 'lo' >= 0, where 'lo' is at most
+// half an ulp of 'hi', and sets 'round_up' if the rest is half or more. From
+// 2^52 on 'hi' is an integer, and 'lo' holds the rest.
+uint64_t
+dd__format_trunc(double hi, double lo, bool* round_up)
+{
+  uint64_t n;
+  double frac;
+  if (hi < 4503599627370496.0)
+  {
+    n    = (uint64_t)hi;
+    frac = hi - (double)n;
+  }
+  else
+  {
+    double lo_int = floor(lo);
+    n             = (uint64_t)hi + (uint64_t)(int64_t)lo_int;
+    frac          = lo - lo_int;
+    lo            = 0.0;
+  }
+  double diff = frac - 0.5;
+  *round_up   = diff > 0.0 || (diff == 0.0 && lo >= 0.0);
+  return n;
+}
+
+// Writes 'value' >= 0 with 'precision' digits after the point, returns the
+// length, or -1 if its integer part does not fit in 64 bits. The point is kept
+// without digits after it if 'point' is set
+int32_t
+dd__format_fixed(char* out, double value, int32_t precision, bool point)
+{
+  double integer = floor(value);
+  if (integer >= 18446744073709551615.0) { return -1; }
+
+  // The fraction is exact, and so is the error of its scaled value
+  double scale      = dd__pow10[precision];
+  double rest       = value - integer;
+  double scaled     = rest * scale;
+  double err        = fma(rest, scale, -scaled);
+  bool round_up     = false;
+  uint64_t one      = (uint64_t)scale;
+  uint64_t int_part = (uint64_t)integer;
+  uint64_t fraction = dd__format_trunc(scaled, err, &round_up) + round_up;
+  if (fraction >= one)
+  {
+    fraction -= one;
+    int_part++;
+  }
 
-  // NOTE(maciej): Only handles valid UTF-8 characters between cps U+0000 and
-  // U+07FF! It's awful!!
-  int32_t n_chars = dd__strlen(str);
-  uint8_t do_clipping =
-    info && (info->clip_rect.w > 0 && info->clip_rect.h > 0);
+  char tmp[24];
+  char* end   = tmp + sizeof(tmp);
+  char* start = dd__format_uint(end, int_part, 10, false);
+  int32_t len = (int32_t)(end - start);
+  memcpy(out, start, len);
+  if (precision == 0)
+  {
+    if (point) { out[len++] = '.'; }
+    return len;
+  }
 
-  int32_t new_verts = 6 * n_chars;
-  DBGDRAW_HANDLE_OUT_OF_MEMORY(ctx->verts_data,
-                               ctx->verts_len + new_verts,
-                               ctx->verts_cap,
-                               sizeof(dd_vertex_t));
+  out[len++] = '.';
+  start      = dd__format_uint(end, fraction, 10, false);
+  for (int32_t i = (int32_t)(end - start); i < precision; ++i)
+  {
+    out[len++] = '0';
+  }
+  memcpy(out + len, start, end - start);
+  return len + (int32_t)(end - start);
+}
 
-  dd_vec3_t p      = dd_vec3(pos[0], pos[1], pos[2]);
-  float world_size = dd__pixels_to_world_size(ctx, p, (float)font->size);
-  float scale      = fabsf(world_size / font->size);
-  // scale = 0.05f;
+// Rounds 'value' > 0 to 'digits' significant digits, returned in 'mantissa',
+// and returns the decimal exponent of the first one. The value is scaled by
+// exact powers of ten and kept as the sum 'hi' + 'lo' of the rounded result
+// and its error, so it is rounded to the digits once.
+int32_t
+dd__format_round(double value, int32_t digits, uint64_t* mantissa)
+{
+  uint64_t lower = (uint64_t)dd__pow10[digits - 1];
+  uint64_t upper = (uint64_t)dd__pow10[digits];
+  int32_t exp10  = (int32_t)floor(log10(value));
+  uint64_t n     = 0;
+  for (int32_t attempt = 0; attempt < 3; ++attempt)
+  {
+    double hi = value, lo = 0.0;
+    for (int32_t k = digits - 1 - exp10; k != 0;)
+    {
+      int32_t step = DD_MAX(DD_MIN(k, 22), -22);
+      double scale = dd__pow10[DD_ABS(step)];
+      double next, err;
+      if (step > 0)
+      {
+        next = hi * scale;
+        err  = fma(hi, scale, -next) + lo * scale;
+      }
+      else
+      {
+        next = hi / scale;
+        err  = (fma(-next, scale, hi) + lo) / scale;
+      }
+      hi = next + err;
+      lo = err - (hi - next);
+      k -= step;
+    }
 
-  ctx->cur_cmd->min_depth = dd_mat4_vec3_mul(ctx->cur_cmd->xform, p, 1).z;
+    bool round_up = false;
+    n             = dd__format_trunc(hi, lo, &round_up);
 
-  dd_mat3_t m;
-  if (!ctx->is_ortho) { m = dd__get_view_aligned_basis(ctx, p); }
+    // The exponent from log10 may be off by one
+    if (n >= upper && attempt < 2) { exp10++; continue; }
+    if (n < lower && attempt < 2) { exp10--; continue; }
 
-  float width, height;
-  if (info && info->width > 0)
-  {
-    width  = info->width;
-    height = info->height;
+    if (round_up) { n++; }
+    if (n >= upper)
+    {
+      n /= 10;
+      exp10++;
+    }
+    break;
   }
-  else
+  *mantissa = n;
+  return exp10;
+}
+
+// Writes the 'digits' digits of 'mantissa' with 'int_digits' of them before the
+// point, or -'int_digits' zeros after it. Trailing zeros of the fraction are
+// removed if 'strip' is set, and a point without digits after it if 'point' is
+// not
+int32_t
+dd__format_digits(char* out,
+                  uint64_t mantissa,
+                  int32_t digits,
+                  int32_t int_digits,
+                  bool strip,
+                  bool point)
+{
+  char tmp[24];
+  char* end   = tmp + sizeof(tmp);
+  char* start = dd__format_uint(end, mantissa, 10, false);
+  while (end - start < digits) { *--start = '0'; }
+
+  int32_t len = 0;
+  if (int_digits <= 0) { out[len++] = '0'; }
+  for (int32_t i = 0; i < int_digits; ++i) { out[len++] = start[i]; }
+  int32_t point_idx = len;
+  out[len++]        = '.';
+  for (int32_t i = int_digits; i < 0; ++i) { out[len++] = '0'; }
+  for (int32_t i = DD_MAX(int_digits, 0); i < digits; ++i)
   {
-    dd_get_text_size_font_space(ctx,
-                                ctx->cur_cmd->font_idx,
-                                str,
-                                n_chars,
-                                &width,
-                                &height);
-    width *= scale;
-    height *= scale;
+    out[len++] = start[i];
   }
 
-  dd_text_valign_t vert_align = DBGDRAW_TEXT_BASELINE;
-  dd_text_halign_t horz_align = DBGDRAW_TEXT_LEFT;
-  if (info)
+  if (strip)
   {
-    vert_align   = info->vert_align;
-    horz_align   = info->horz_align;
-    info->width  = width;
-    info->height = height;
+    while (len > point_idx + 1 && out[len - 1] == '0') { len--; }
   }
+  if (len == point_idx + 1 && !point) { len--; }
+  return len;
+}
 
-  float vert_offset = 0.0, horz_offset = 0.0;
-  switch (horz_align)
+int32_t
+dd__format_exp(char* out,
+               uint64_t mantissa,
+               int32_t digits,
+               int32_t exp10,
+               bool upper,
+               bool strip,
+               bool point)
+{
+  int32_t len = dd__format_digits(out, mantissa, digits, 1, strip, point);
+  out[len++]  = upper ? 'E' : 'e';
+  out[len++]  = exp10 < 0 ? '-' : '+';
+  char tmp[8];
+  char* end   = tmp + sizeof(tmp);
+  char* start = dd__format_uint(end, (uint64_t)DD_ABS(exp10), 10, false);
+  if (end - start < 2) { out[len++] = '0'; }
+  memcpy(out + len, start, end - start);
+  return len + (int32_t)(end - start);
+}
+
+void
+dd__format_padded(dd_format_buf_t* buf,
+                  const dd_format_spec_t* spec,
+                  char sign,
+                  const char* body,
+                  int32_t body_len)
+{
+  int32_t pad = spec->width - body_len - (sign ? 1 : 0);
+  if (!spec->left_align && !spec->zero_pad)
   {
-    case DBGDRAW_TEXT_LEFT:
-      horz_offset = 0.0f;
-      break;
-    case DBGDRAW_TEXT_RIGHT:
-      horz_offset = -width;
-      break;
-    case DBGDRAW_TEXT_CENTER:
-    default:
-      horz_offset = -width * 0.5f;
-      break;
+    for (; pad > 0; --pad) { dd__format_putc(buf, ' '); }
+  }
+  if (sign) { dd__format_putc(buf, sign); }
+  if (!spec->left_align && spec->zero_pad)
+  {
+    for (; pad > 0; --pad) { dd__format_putc(buf, '0'); }
   }
+  for (int32_t i = 0; i < body_len; ++i) { dd__format_putc(buf, body[i]); }
+  for (; pad > 0; --pad) { dd__format_putc(buf, ' '); }
+}
 
-  float sign = 1.0;
-  if (ctx->is_ortho && ctx->proj.col[1].y >= 0.0) { sign = -1.0f; }
-  switch (vert_align)
+void
+dd__format_integer(dd_format_buf_t* buf,
+                   dd_format_spec_t* spec,
+                   uint64_t value,
+                   bool is_negative)
+{
+  char tmp[72];
+  char* end    = tmp + sizeof(tmp);
+  bool upper   = spec->conv == 'X';
+  uint32_t base = (spec->conv == 'x' || spec->conv == 'X') ? 16 : 10;
+  char* start  = end;
+  if (value || spec->precision != 0)
   {
-    case DBGDRAW_TEXT_BASELINE:
-      vert_offset = 0.0f;
-      break;
-    case DBGDRAW_TEXT_BOTTOM:
-      vert_offset = sign * scale * font->descent;
-      break;
-    case DBGDRAW_TEXT_TOP:
-      vert_offset = sign * scale * font->ascent;
-      break;
-    case DBGDRAW_TEXT_MIDDLE:
-    default:
-      vert_offset = sign * scale * 0.5f * (font->ascent + font->descent);
-      break;
+    start = dd__format_uint(end, value, base, upper);
   }
+  int32_t precision = DD_MIN(spec->precision, 64);
+  while (end - start < precision) { *--start = '0'; }
+  if (spec->precision >= 0) { spec->zero_pad = 0; }
 
-  p.x += horz_offset;
-  p.y += vert_offset;
+  char sign = is_negative ? '-' : spec->sign;
+  if (base == 16) { sign = 0; }
+  dd__format_padded(buf, spec, sign, start, (int32_t)(end - start));
+}
 
-  float x       = 0;
-  float y       = 0;
-  float start_x = 1e9;
+void
+dd__format_double(dd_format_buf_t* buf, dd_format_spec_t* spec, double value)
+{
+  char sign = spec->sign;
+  if (signbit(value))
+  {
+    sign  = '-';
+    value = -value;
+  }
 
-  dd_vec3_t pt_a, pt_b, pt_c;
-  dd_vec2_t uv_a, uv_b, uv_c;
-  dd_vertex_t* start = ctx->verts_data + ctx->verts_len;
-  for (int32_t i = 0; i < n_chars; ++i)
+  char body[64];
+  int32_t len = 0;
+  bool upper  = spec->conv == 'F' || spec->conv == 'E' || spec->conv == 'G';
+  if (isnan(value) || isinf(value))
   {
-    uint32_t cp = 0;
-    str         = dd__decode_char(str, &cp);
-    int32_t idx = dd__codepoint_to_index(cp);
+    const char* name = isnan(value) ? "nan" : "inf";
+    for (len = 0; len < 3; ++len)
+    {
+      body[len] = upper ? (char)(name[len] - 'a' + 'A') : name[len];
+    }
+    spec->zero_pad = 0;
+    dd__format_padded(buf, spec, sign, body, len);
+    return;
+  }
 
-    stbtt_aligned_quad q;
-    stbtt_GetPackedQuad(font->char_data,
-                        font->bitmap_width,
-                        font->bitmap_height,
-                        idx,
-                        &x,
-                        &y,
-                        &q,
-                        0);
+  int32_t precision = spec->precision < 0 ? 6 : spec->precision;
+  precision         = DD_MIN(precision, DD_FORMAT_MAX_PRECISION);
+  bool point        = spec->alternate;
+  if (spec->conv == 'g' || spec->conv == 'G')
+  {
+    // Fixed notation when the exponent of the rounded value is in
+    // [-4, precision), without trailing zeros unless the '#' flag is given
+    if (precision == 0) { precision = 1; }
+    uint64_t mantissa = 0;
+    int32_t exp10     = 0;
+    if (value > 0.0) { exp10 = dd__format_round(value, precision, &mantissa); }
+    if (exp10 >= -4 && exp10 < precision)
+    {
+      len = dd__format_digits(
+        body, mantissa, precision, exp10 + 1, !point, point);
+    }
+    else
+    {
+      len = dd__format_exp(
+        body, mantissa, precision, exp10, upper, !point, point);
+    }
+  }
+  else
+  {
+    len = -1;
+    if (spec->conv == 'f' || spec->conv == 'F')
+    {
+      len = dd__format_fixed(body, value, precision, point);
+    }
+    if (len < 0)
+    {
+      uint64_t mantissa = 0;
+      int32_t exp10     = 0;
+      if (value > 0.0)
+      {
+        exp10 = dd__format_round(value, precision + 1, &mantissa);
+      }
+      len = dd__format_exp(
+        body, mantissa, precision + 1, exp10, upper, false, point);
+    }
+  }
+  dd__format_padded(buf, spec, sign, body, len);
+}
 
-    dd_vec3_t min_pt = dd_vec3(scale * q.x0, sign * scale * q.y1, 0.0);
-    dd_vec3_t max_pt = dd_vec3(scale * q.x1, sign * scale * q.y0, 0.0);
-    if (ctx->is_ortho)
+// Formats into 'out', which holds 'cap' bytes, and returns the length of the
+// result, which is cut to 'cap' - 1 characters
+int32_t
+dd__vformat(char* out, int32_t cap, const char* fmt, va_list args)
+{
+  dd_format_buf_t buf = { .data = out, .len = 0, .cap = cap - 1 };
+  for (const char* c = fmt; *c; ++c)
+  {
+    if (*c != '%')
     {
-      min_pt = dd_vec3_add(p, min_pt);
-      max_pt = dd_vec3_add(p, max_pt);
+      dd__format_putc(&buf, *c);
+      continue;
     }
 
-    if (do_clipping)
+    dd_format_spec_t spec = { .precision = -1 };
+    for (c++;; c++)
     {
-      float min_x = min_pt.x;
-      float max_x = max_pt.x;
-      float min_y = min_pt.y;
-      float max_y = max_pt.y;
+      if (*c == '-') { spec.left_align = 1; }
+      else if (*c == '0') { spec.zero_pad = 1; }
+      else if (*c == '#') { spec.alternate = 1; }
+      else if (*c == '+') { spec.sign = '+'; }
+      else if (*c == ' ' && !spec.sign) { spec.sign = ' '; }
+      else if (*c != ' ') { break; }
+    }
+    if (*c == '*')
+    {
+      spec.width = va_arg(args, int);
+      if (spec.width < 0)
+      {
+        spec.left_align = 1;
+        spec.width      = -spec.width;
+      }
+      c++;
+    }
+    for (; *c >= '0' && *c <= '9'; ++c)
+    {
+      spec.width = 10 * spec.width + (*c - '0');
+    }
+    if (*c == '.')
+    {
+      c++;
+      spec.precision = 0;
+      if (*c == '*')
+      {
+        spec.precision = va_arg(args, int);
+        c++;
+      }
+      for (; *c >= '0' && *c <= '9'; ++c)
+      {
+        spec.precision = 10 * spec.precision + (*c - '0');
+      }
+    }
 
-      float w1 = max_x - min_x;
-      float h1 = max_pt.y - min_pt.y;
+    // Length modifiers - 1 is long, 2 is long long and 3 is size_t, since
+    // long is 32 bits on windows
+    int32_t length = 0;
+    for (; *c == 'h' || *c == 'l' || *c == 'z' || *c == 'j' || *c == 't'; ++c)
+    {
+      if (*c == 'l') { length++; }
+      else if (*c == 'j') { length = 2; }
+      else if (*c != 'h') { length = 3; }
+    }
 
-      // Clip from top
-      if (min_y >= info->clip_rect.y + info->clip_rect.h) { continue; }
-      if (max_y >= info->clip_rect.y + info->clip_rect.h)
+    spec.conv = *c;
+    switch (*c)
+    {
+      case 'd':
+      case 'i':
       {
-        max_pt.y = DD_MIN(max_y, info->clip_rect.y + info->clip_rect.h);
-        float t1 = max_pt.y - min_y;
-        float h2 = q.t1 - q.t0;
-        float t2 = (t1 * h2) / h1;
-        q.t0     = q.t1 - t2;
+        int64_t value;
+        if (length == 0) { value = va_arg(args, int); }
+        else if (length == 1) { value = va_arg(args, long); }
+        else if (length == 2) { value = va_arg(args, long long); }
+        else { value = va_arg(args, ptrdiff_t); }
+        uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+        dd__format_integer(&buf, &spec, magnitude, value < 0);
       }
-
-      // Clip from bottom
-      if (max_y < info->clip_rect.y) { continue; }
-      if (min_y < info->clip_rect.y)
+      break;
+      case 'u':
+      case 'x':
+      case 'X':
       {
-        min_pt.y = DD_MAX(min_y, info->clip_rect.y);
-        float t1 = max_y - min_pt.y;
-        float h2 = q.t1 - q.t0;
-        float t2 = (t1 * h2) / h1;
-        q.t1     = q.t0 + t2;
+        uint64_t value;
+        if (length == 0) { value = va_arg(args, unsigned int); }
+        else if (length == 1) { value = va_arg(args, unsigned long); }
+        else if (length == 2) { value = va_arg(args, unsigned long long); }
+        else { value = va_arg(args, size_t); }
+        spec.sign = 0;
+        dd__format_integer(&buf, &spec, value, false);
       }
-
-      // Clip from right
-      if (min_x >= info->clip_rect.x + info->clip_rect.w) { continue; }
-      if (max_x >= info->clip_rect.x + info->clip_rect.w)
+      break;
+      case 'p':
       {
-        max_pt.x = DD_MIN(max_x, info->clip_rect.x + info->clip_rect.w);
-        float t1 = max_pt.x - min_x;
-        float w2 = q.s1 - q.s0;
-        float t2 = (t1 * w2) / w1;
-        q.s1     = q.s0 + t2;
+        uint64_t value = (uint64_t)(uintptr_t)va_arg(args, void*);
+        spec.conv      = 'x';
+        dd__format_putc(&buf, '0');
+        dd__format_putc(&buf, 'x');
+        dd__format_integer(&buf, &spec, value, false);
       }
-
-      // Clip from left
-      if (max_x < info->clip_rect.x) { continue; }
-      if (min_x < info->clip_rect.x)
+      break;
+      case 'f':
+      case 'F':
+      case 'e':
+      case 'E':
+      case 'g':
+      case 'G':
+        dd__format_double(&buf, &spec, va_arg(args, double));
+        break;
+      case 'c':
       {
-        min_pt.x = DD_MAX(min_x, info->clip_rect.x);
-        float t1 = max_x - min_pt.x;
-        float w2 = q.s1 - q.s0;
-        float t2 = (t1 * w2) / w1;
-        q.s0     = q.s1 - t2;
+        char value    = (char)va_arg(args, int);
+        spec.zero_pad = 0;
+        dd__format_padded(&buf, &spec, 0, &value, 1);
+      }
+      break;
+      case 's':
+      {
+        const char* value = va_arg(args, const char*);
+        if (!value) { value = "(null)"; }
+        int32_t len = 0;
+        while (value[len] && (spec.precision < 0 || len < spec.precision))
+        {
+          len++;
+        }
+        spec.zero_pad = 0;
+        dd__format_padded(&buf, &spec, 0, value, len);
       }
+      break;
+      case '%':
+        dd__format_putc(&buf, '%');
+        break;
+      case '\0':
+        c--;
+        break;
+      default:
+        dd__format_putc(&buf, '%');
+        dd__format_putc(&buf, *c);
+        break;
     }
+  }
+  out[buf.len] = 0;
+  return buf.len;
+}
 
-    start_x = DD_MIN(start_x, min_pt.x);
-
-    pt_a = dd_vec3(min_pt.x, max_pt.y, 0.0);
-    uv_a = dd_vec2(q.s0, q.t0);
-    pt_b = dd_vec3(max_pt.x, min_pt.y, 0.0);
-    uv_b = dd_vec2(q.s1, q.t1);
-    pt_c = dd_vec3(max_pt.x, max_pt.y, 0.0);
-    uv_c = dd_vec2(q.s1, q.t0);
+// Lays out a line of printable ASCII from the quads cached in the font. Any
+// other text, and text that is decluttered, goes through dd_text_line
+int32_t
+dd__text_ascii(dd_ctx_t* ctx,
+               float* pos,
+               const char* str,
+               int32_t len,
+               dd_text_info_t* info)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(pos);
 
-    dd__vertex_text(ctx, &pt_a, &uv_a);
-    dd__vertex_text(ctx, &pt_b, &uv_b);
-    dd__vertex_text(ctx, &pt_c, &uv_c);
+  DBGDRAW_VALIDATE(ctx->cur_cmd != NULL, DBGDRAW_ERR_NO_ACTIVE_CMD);
+  DBGDRAW_VALIDATE(ctx->cur_cmd->draw_mode == DBGDRAW_MODE_FILL,
+                   DBGDRAW_ERR_INVALID_MODE);
+  DBGDRAW_VALIDATE(ctx->cur_cmd->shading_type == DBGDRAW_SHADING_TEXT,
+                   DBGDRAW_ERR_INVALID_SHADING);
+  DBGDRAW_VALIDATE(ctx->fonts[ctx->active_font_idx].name != NULL,
+                   DBGDRAW_ERR_USING_TEXT_WITHOUT_FONT);
+  int32_t status = ctx->fonts[ctx->active_font_idx].status;
+  if (status) { return status; }
 
-    pt_a = dd_vec3(min_pt.x, max_pt.y, 0.0);
-    uv_a = dd_vec2(q.s0, q.t0);
-    pt_b = dd_vec3(min_pt.x, min_pt.y, 0.0);
-    uv_b = dd_vec2(q.s0, q.t1);
-    pt_c = dd_vec3(max_pt.x, min_pt.y, 0.0);
-    uv_c = dd_vec2(q.s1, q.t1);
+  bool is_ascii = !ctx->text_declutter;
+  for (int32_t i = 0; i < len && is_ascii; ++i)
+  {
+    is_ascii = str[i] >= ' ' && str[i] <= '~';
+  }
+  if (!is_ascii) { return dd_text_line(ctx, pos, str, info); }
 
-    dd__vertex_text(ctx, &pt_a, &uv_a);
-    dd__vertex_text(ctx, &pt_b, &uv_b);
-    dd__vertex_text(ctx, &pt_c, &uv_c);
+  int32_t font_idx     = ctx->active_font_idx;
+  dd_font_data_t* font = ctx->fonts + font_idx;
+  if (!font->ascii_glyphs)
+  {
+    int32_t count      = '~' - ' ' + 1;
+    font->ascii_glyphs = DBGDRAW_MALLOC(count * sizeof(dd_ascii_glyph_t));
+    if (!font->ascii_glyphs) { return DBGDRAW_ERR_FAILED_ALLOC; }
+    for (int32_t i = 0; i < count; ++i)
+    {
+      font->ascii_glyphs[i].glyph_idx  = -1;
+      font->ascii_glyphs[i].generation = font->generation;
+    }
   }
-  dd_vertex_t* end = ctx->verts_data + ctx->verts_len;
 
-  if (!ctx->is_ortho)
+  dd_layout_glyph_t glyphs[DBGDRAW_TEXT_FMT_MAX];
+  int32_t glyphs_len = 0;
+  float x            = 0.0f;
+  for (int32_t i = 0; i < len && glyphs_len < DBGDRAW_TEXT_FMT_MAX; ++i)
   {
-    dd_mat4_t xform = dd_mat4_identity();
-    xform.col[0]    = dd_vec3_to_vec4(m.col[0]);
-    xform.col[1]    = dd_vec3_to_vec4(m.col[1]);
-    xform.col[2]    = dd_vec3_to_vec4(m.col[2]);
-    xform.col[3]    = dd_vec3_to_vec4(p);
-    xform.col[3].w  = 1.0f;
-    dd__transform_verts(xform, start, end, 0);
+    dd_ascii_glyph_t* ascii = font->ascii_glyphs + (str[i] - ' ');
+    if (ascii->glyph_idx < 0 || ascii->generation != font->generation)
+    {
+      float advance = 0.0f, y = 0.0f;
+      ascii->glyph_idx =
+        dd__get_glyph_quad(ctx, font_idx, str[i], &advance, &y, &ascii->q);
+      ascii->advance    = advance;
+      ascii->generation = font->generation;
+    }
+    else { font->glyphs[ascii->glyph_idx].last_used_frame = ctx->frame_idx; }
+
+    if (ascii->glyph_idx >= 0)
+    {
+      dd_layout_glyph_t* glyph = glyphs + glyphs_len++;
+      glyph->q                 = ascii->q;
+      glyph->q.x0 += x;
+      glyph->q.x1 += x;
+      glyph->glyph_idx = ascii->glyph_idx;
+    }
+    x += ascii->advance;
   }
 
-  if (info)
+  dd_vec3_t p = dd_vec3(pos[0], pos[1], pos[2]);
+  return dd__text_line(ctx, p, glyphs, glyphs_len, x, info);
+}
+
+int32_t
+dd_text_number(dd_ctx_t* ctx,
+               float* pos,
+               double value,
+               int32_t precision,
+               dd_text_info_t* info)
+{
+  DBGDRAW_ASSERT(ctx);
+
+  char str[DBGDRAW_TEXT_FMT_MAX];
+  dd_format_buf_t buf   = { .data = str, .len = 0, .cap = sizeof(str) - 1 };
+  dd_format_spec_t spec = { .precision = precision, .conv = 'f' };
+  if (precision < 0)
   {
-    info->anchor = dd_vec3(start_x, p.y + scale * font->descent, p.z);
-    info->anchor.x += horz_offset;
-    info->anchor.y += vert_offset;
+    spec.precision = 6;
+    spec.conv      = 'g';
   }
+  dd__format_double(&buf, &spec, value);
+  str[buf.len] = 0;
+  return dd__text_ascii(ctx, pos, str, buf.len, info);
+}
 
-  return DBGDRAW_ERR_OK;
+int32_t
+dd_text_fmt(dd_ctx_t* ctx,
+            float* pos,
+            dd_text_info_t* info,
+            const char* fmt,
+            ...)
+{
+  DBGDRAW_ASSERT(ctx);
+  DBGDRAW_ASSERT(fmt);
+
+  char str[DBGDRAW_TEXT_FMT_MAX];
+  va_list args;
+  va_start(args, fmt);
+  int32_t len = dd__vformat(str, sizeof(str), fmt, args);
+  va_end(args);
+  return dd__text_ascii(ctx, pos, str, len, info);
 }
 
 #endif /* DBGDRAW_HAS_TEXT_SUPPORT */
@@ -3721,6 +8132,28 @@ dd_error_message(int32_t error_code)
       return "[DBGDRAW ERROR] Text rendering is only supported when using text "
              "shading mode (DBGDRAW_SHADING_TEXT))";
       break;
+    case DBGDRAW_ERR_INVALID_IMAGE:
+      return "[DBGDRAW ERROR] Invalid image. Make sure that width and height "
+             "are positive and pixels point to width * height * 4 bytes";
+      break;
+    case DBGDRAW_ERR_FILE_OPEN_FAILED:
+      return "[DBGDRAW ERROR] Failed to open file.";
+      break;
+    case DBGDRAW_ERR_INVALID_CAPTURE:
+      return "[DBGDRAW ERROR] Capture file is corrupted or was written by an "
+             "incompatible version of dbgdraw.";
+      break;
+    case DBGDRAW_ERR_NO_FREE_FRAME:
+      return "[DBGDRAW ERROR] All submitted frames are still waiting for "
+             "'dd_render_submitted'. Submit again once the render thread "
+             "catches up, or increase '.pipeline_depth'.";
+      break;
+    case DBGDRAW_ERR_NO_SUBMITTED_FRAME:
+      return "[DBGDRAW INFO] No submitted frame to render";
+      break;
+    case DBGDRAW_ERR_FONT_LOADING:
+      return "[DBGDRAW INFO] Font is still being loaded on a worker thread";
+      break;
     default:
       return "[DBGDRAW ERROR] Unknown error";
       break;
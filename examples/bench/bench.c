@@ -0,0 +1,299 @@
+#define MSH_VEC_MATH_INCLUDE_LIBC_HEADERS
+#define MSH_VEC_MATH_IMPLEMENTATION
+#define DBGDRAW_USE_DEFAULT_FONT
+
+#include <string.h>
+
+#include "msh_vec_math.h"
+#include "stb_truetype.h"
+#include "dbgdraw.h"
+#include "dbgdraw_null.h"
+
+// Measures how long each primitive generator takes on the CPU. Every public
+// primitive is recorded in every draw mode and shading type that it accepts,
+// and at every detail level if its output depends on it. The results are
+// written as JSON, one line per combination, so that runs of different library
+// versions can be diffed. Frames are rendered with the null backend, which
+// checksums the generated data, so changes in geometry show up in the diff
+// even if the vertex count stays the same. Usage:
+//   dd_bench [--min-ms N] [--filter name] [-o output.json]
+// --min-ms sets how long each combination is measured for (default 5ms),
+// --filter only runs primitives whose name contains the given string.
+
+#define BATCH_SIZE   64
+#define RUN_COUNT    3
+#define DETAIL_COUNT 5
+
+typedef int32_t (*bench_fn_t)( dd_ctx_t* ctx, int32_t i );
+
+enum
+{
+  BENCH_DETAIL = 1 << 0, // Output depends on the detail level
+  BENCH_TEXT   = 1 << 1  // Requires DBGDRAW_MODE_FILL and DBGDRAW_SHADING_TEXT
+};
+
+typedef struct bench_prim_t {
+  const char* name;
+  bench_fn_t fn;
+  uint32_t flags;
+} bench_prim_t;
+
+typedef struct bench_result_t {
+  int32_t vertex_count;
+  uint64_t checksum;
+  double ns_per_prim;
+} bench_result_t;
+
+static msh_mat4_t view, proj;
+
+// Primitives are laid out on a grid, so consecutive calls do not emit the same
+// data
+static msh_vec3_t bench_pos( int32_t i, float y )
+{
+  return msh_vec3( (float)( i & 7 ) - 3.5f, y, (float)( i >> 3 ) - 3.5f );
+}
+
+static int32_t bench_point( dd_ctx_t* ctx, int32_t i ) { return dd_point( ctx, bench_pos( i, 0.0f ).data ); }
+static int32_t bench_line( dd_ctx_t* ctx, int32_t i ) { return dd_line( ctx, bench_pos( i, 0.0f ).data, bench_pos( i, 1.0f ).data ); }
+static int32_t bench_quad( dd_ctx_t* ctx, int32_t i )
+{
+  msh_vec3_t p = bench_pos( i, 0.0f );
+  msh_vec3_t a = msh_vec3( p.x - 0.4f, p.y, p.z - 0.4f ), b = msh_vec3( p.x + 0.4f, p.y, p.z - 0.4f );
+  msh_vec3_t c = msh_vec3( p.x + 0.4f, p.y, p.z + 0.4f ), d = msh_vec3( p.x - 0.4f, p.y, p.z + 0.4f );
+  return dd_quad( ctx, a.data, b.data, c.data, d.data );
+}
+static int32_t bench_rect( dd_ctx_t* ctx, int32_t i ) { return dd_rect( ctx, bench_pos( i, 0.0f ).data, bench_pos( i + 9, 0.5f ).data ); }
+static int32_t bench_circle( dd_ctx_t* ctx, int32_t i ) { return dd_circle( ctx, bench_pos( i, 0.0f ).data, 0.4f ); }
+static int32_t bench_arc( dd_ctx_t* ctx, int32_t i ) { return dd_arc( ctx, bench_pos( i, 0.0f ).data, 0.4f, 4.0f ); }
+static int32_t bench_aabb( dd_ctx_t* ctx, int32_t i )
+{
+  msh_vec3_t p = bench_pos( i, 0.0f );
+  return dd_aabb( ctx, msh_vec3_sub( p, msh_vec3_value( 0.4f ) ).data, msh_vec3_add( p, msh_vec3_value( 0.4f ) ).data );
+}
+static int32_t bench_obb( dd_ctx_t* ctx, int32_t i )
+{
+  msh_mat4_t xform = msh_post_rotate( msh_pre_scale( msh_mat4_identity(), msh_vec3_value( 0.4f ) ), 0.1f * i, msh_vec3_posy() );
+  msh_mat3_t axes = msh_mat4_to_mat3( xform );
+  return dd_obb( ctx, bench_pos( i, 0.0f ).data, axes.data );
+}
+static int32_t bench_frustum( dd_ctx_t* ctx, int32_t i ) { (void)i; return dd_frustum( ctx, view.data, proj.data ); }
+static int32_t bench_sphere( dd_ctx_t* ctx, int32_t i ) { return dd_sphere( ctx, bench_pos( i, 0.0f ).data, 0.4f ); }
+static int32_t bench_torus( dd_ctx_t* ctx, int32_t i ) { return dd_torus( ctx, bench_pos( i, 0.0f ).data, 0.4f, 0.1f ); }
+static int32_t bench_cone( dd_ctx_t* ctx, int32_t i ) { return dd_cone( ctx, bench_pos( i, 0.0f ).data, bench_pos( i, 1.0f ).data, 0.3f ); }
+static int32_t bench_cylinder( dd_ctx_t* ctx, int32_t i ) { return dd_cylinder( ctx, bench_pos( i, 0.0f ).data, bench_pos( i, 1.0f ).data, 0.3f ); }
+static int32_t bench_capsule( dd_ctx_t* ctx, int32_t i ) { return dd_capsule( ctx, bench_pos( i, 0.0f ).data, bench_pos( i, 1.0f ).data, 0.3f ); }
+static int32_t bench_conical_frustum( dd_ctx_t* ctx, int32_t i ) { return dd_conical_frustum( ctx, bench_pos( i, 0.0f ).data, bench_pos( i, 1.0f ).data, 0.3f, 0.1f ); }
+static int32_t bench_arrow( dd_ctx_t* ctx, int32_t i ) { return dd_arrow( ctx, bench_pos( i, 0.0f ).data, bench_pos( i, 1.0f ).data, 0.05f, 0.15f, 0.7f ); }
+static int32_t bench_billboard_rect( dd_ctx_t* ctx, int32_t i ) { return dd_billboard_rect( ctx, bench_pos( i, 0.0f ).data, 0.8f, 0.4f ); }
+static int32_t bench_billboard_circle( dd_ctx_t* ctx, int32_t i ) { return dd_billboard_circle( ctx, bench_pos( i, 0.0f ).data, 0.4f ); }
+
+static msh_vec3_t bench_pos2d( int32_t i )
+{
+  return msh_vec3( 40.0f + 80.0f * ( i & 7 ), 40.0f + 80.0f * ( i >> 3 ), 0.0f );
+}
+static int32_t bench_point2d( dd_ctx_t* ctx, int32_t i ) { return dd_point2d( ctx, bench_pos2d( i ).data ); }
+static int32_t bench_line2d( dd_ctx_t* ctx, int32_t i ) { return dd_line2d( ctx, bench_pos2d( i ).data, bench_pos2d( i + 9 ).data ); }
+static int32_t bench_quad2d( dd_ctx_t* ctx, int32_t i )
+{
+  msh_vec3_t p = bench_pos2d( i );
+  msh_vec3_t a = msh_vec3( p.x - 30.0f, p.y - 30.0f, 0.0f ), b = msh_vec3( p.x + 30.0f, p.y - 30.0f, 0.0f );
+  msh_vec3_t c = msh_vec3( p.x + 30.0f, p.y + 30.0f, 0.0f ), d = msh_vec3( p.x - 30.0f, p.y + 30.0f, 0.0f );
+  return dd_quad2d( ctx, a.data, b.data, c.data, d.data );
+}
+static int32_t bench_rect2d( dd_ctx_t* ctx, int32_t i ) { return dd_rect2d( ctx, bench_pos2d( i ).data, bench_pos2d( i + 9 ).data ); }
+static int32_t bench_circle2d( dd_ctx_t* ctx, int32_t i ) { return dd_circle2d( ctx, bench_pos2d( i ).data, 30.0f ); }
+static int32_t bench_arc2d( dd_ctx_t* ctx, int32_t i ) { return dd_arc2d( ctx, bench_pos2d( i ).data, 30.0f, 4.0f ); }
+static int32_t bench_rounded_rect2d( dd_ctx_t* ctx, int32_t i ) { return dd_rounded_rect2d( ctx, bench_pos2d( i ).data, bench_pos2d( i + 9 ).data, 10.0f ); }
+static int32_t bench_rounded_rect2d_ex( dd_ctx_t* ctx, int32_t i )
+{
+  float rounding[4] = { 0.0f, 5.0f, 10.0f, 15.0f };
+  return dd_rounded_rect2d_ex( ctx, bench_pos2d( i ).data, bench_pos2d( i + 9 ).data, rounding );
+}
+static int32_t bench_text_line( dd_ctx_t* ctx, int32_t i ) { return dd_text_line( ctx, bench_pos2d( i ).data, "The quick brown fox", NULL ); }
+// Decimals that lie just below a rounding boundary (0.15 is 0.1499999...), so
+// the checksum changes if dd_text_number stops rounding them like printf does
+static int32_t bench_text_number( dd_ctx_t* ctx, int32_t i )
+{
+  static const double values[] = { 0.15, 0.35, 0.95, 1.115, 16.665 };
+  static const int32_t precisions[] = { 1, 1, 1, 2, 2 };
+  return dd_text_number( ctx, bench_pos2d( i ).data, values[i % 5], precisions[i % 5], NULL );
+}
+
+static bench_prim_t prims[] =
+{
+  { "dd_point", bench_point, 0 },
+  { "dd_line", bench_line, 0 },
+  { "dd_quad", bench_quad, 0 },
+  { "dd_rect", bench_rect, 0 },
+  { "dd_circle", bench_circle, BENCH_DETAIL },
+  { "dd_arc", bench_arc, BENCH_DETAIL },
+  { "dd_aabb", bench_aabb, 0 },
+  { "dd_obb", bench_obb, 0 },
+  { "dd_frustum", bench_frustum, 0 },
+  { "dd_sphere", bench_sphere, BENCH_DETAIL },
+  { "dd_torus", bench_torus, BENCH_DETAIL },
+  { "dd_cone", bench_cone, BENCH_DETAIL },
+  { "dd_cylinder", bench_cylinder, BENCH_DETAIL },
+  { "dd_capsule", bench_capsule, BENCH_DETAIL },
+  { "dd_conical_frustum", bench_conical_frustum, BENCH_DETAIL },
+  { "dd_arrow", bench_arrow, BENCH_DETAIL },
+  { "dd_billboard_rect", bench_billboard_rect, 0 },
+  { "dd_billboard_circle", bench_billboard_circle, BENCH_DETAIL },
+  { "dd_point2d", bench_point2d, 0 },
+  { "dd_line2d", bench_line2d, 0 },
+  { "dd_quad2d", bench_quad2d, 0 },
+  { "dd_rect2d", bench_rect2d, 0 },
+  { "dd_circle2d", bench_circle2d, BENCH_DETAIL },
+  { "dd_arc2d", bench_arc2d, BENCH_DETAIL },
+  { "dd_rounded_rect2d", bench_rounded_rect2d, BENCH_DETAIL },
+  { "dd_rounded_rect2d_ex", bench_rounded_rect2d_ex, BENCH_DETAIL },
+  { "dd_text_line", bench_text_line, BENCH_TEXT },
+  { "dd_text_number", bench_text_number, BENCH_TEXT },
+};
+
+static const char* mode_names[DBGDRAW_MODE_COUNT] = { "fill", "stroke", "point" };
+static const char* shading_names[DBGDRAW_SHADING_COUNT] = { "none", "solid", "text" };
+
+// Records a single batch of primitives. Returns the time spent recording, or a
+// negative number if the primitive does not accept this combination.
+static double
+bench_frame( dd_ctx_t* ctx, bench_prim_t* prim, dd_mode_t mode, dd_shading_t shading, int32_t detail_level )
+{
+  msh_vec4_t viewport = msh_vec4( 0.0f, 0.0f, 640.0f, 640.0f );
+  dd_new_frame_info_t info = {
+    .view_matrix       = view.data,
+    .projection_matrix = proj.data,
+    .viewport_size     = viewport.data,
+    .vertical_fov      = 1.0472f,
+    .projection_type   = DBGDRAW_PERSPECTIVE };
+  dd_new_frame( ctx, &info );
+  dd_set_detail_level( ctx, (uint8_t)detail_level );
+  dd_set_shading_type( ctx, shading );
+
+  int32_t error = 0;
+  double t0 = dd_time_ms();
+  dd_begin_cmd( ctx, mode );
+  for( int32_t i = 0; i < BATCH_SIZE; ++i ) { error |= prim->fn( ctx, i ); }
+  dd_end_cmd( ctx );
+  double elapsed = dd_time_ms() - t0;
+
+  if( error ) { elapsed = -1.0; }
+  return elapsed;
+}
+
+static int32_t
+bench_run( dd_ctx_t* ctx, bench_prim_t* prim, dd_mode_t mode, dd_shading_t shading, int32_t detail_level,
+           double min_ms, bench_result_t* result )
+{
+  // Warm up, and find out whether this combination is valid at all
+  if( bench_frame( ctx, prim, mode, shading, detail_level ) < 0.0 ) { dd_render( ctx ); return 1; }
+  result->vertex_count = ctx->verts_len;
+  dd_render( ctx );
+  dd_null_stats_t stats;
+  dd_null_get_stats( ctx, &stats );
+  result->checksum = stats.vertex_checksum ^ stats.command_checksum;
+
+  // Report the fastest run, as it is the least disturbed by the rest of the system
+  result->ns_per_prim = 0.0;
+  for( int32_t r = 0; r < RUN_COUNT; ++r )
+  {
+    double total_ms = 0.0;
+    int64_t prim_count = 0;
+    while( total_ms < min_ms )
+    {
+      total_ms += bench_frame( ctx, prim, mode, shading, detail_level );
+      prim_count += BATCH_SIZE;
+      dd_render( ctx );
+    }
+    double ns_per_prim = total_ms * 1e6 / prim_count;
+    if( r == 0 || ns_per_prim < result->ns_per_prim ) { result->ns_per_prim = ns_per_prim; }
+  }
+  return 0;
+}
+
+int32_t
+main( int32_t argc, char** argv )
+{
+  const char* filter = NULL;
+  const char* output = NULL;
+  double min_ms = 5.0;
+  for( int32_t i = 1; i < argc; ++i )
+  {
+    if( !strcmp( argv[i], "--min-ms" ) && i + 1 < argc ) { min_ms = atof( argv[++i] ); }
+    else if( !strcmp( argv[i], "--filter" ) && i + 1 < argc ) { filter = argv[++i]; }
+    else if( !strcmp( argv[i], "-o" ) && i + 1 < argc ) { output = argv[++i]; }
+    else
+    {
+      fprintf( stderr, "Usage: %s [--min-ms N] [--filter name] [-o output.json]\n", argv[0] );
+      return 1;
+    }
+  }
+
+  FILE* fp = output ? fopen( output, "w" ) : stdout;
+  if( !fp )
+  {
+    fprintf( stderr, "[ERROR] Failed to open %s!\n", output );
+    return 1;
+  }
+
+  view = msh_look_at( msh_vec3( 0.0f, 6.0f, 8.0f ), msh_vec3_zeros(), msh_vec3_posy() );
+  proj = msh_perspective( 1.0472f, 1.0f, 0.1f, 100.0f );
+
+  dd_ctx_t dd_ctx = {0};
+  dd_ctx_desc_t desc =
+  {
+    .max_vertices = 1024,
+    .max_commands = 16,
+    .enable_default_font = 1
+  };
+  if( dd_init( &dd_ctx, &desc ) )
+  {
+    fprintf( stderr, "[ERROR] Failed to initialize dbgdraw library!\n" );
+    return 1;
+  }
+  dd_null_enable_checksums( &dd_ctx, 1 );
+
+  // Everything that does not depend on timing comes first, so that diffs of
+  // two runs show changes in the generated geometry separately
+  fprintf( fp, "{\n" );
+  fprintf( fp, "  \"benchmark\": \"dd_bench\",\n" );
+  fprintf( fp, "  \"format_version\": 1,\n" );
+  fprintf( fp, "  \"vertex_size\": %d,\n", (int32_t)sizeof(dd_vertex_t) );
+  fprintf( fp, "  \"batch_size\": %d,\n", BATCH_SIZE );
+  fprintf( fp, "  \"results\": [" );
+  int32_t result_count = 0;
+  for( size_t p = 0; p < sizeof(prims) / sizeof(prims[0]); ++p )
+  {
+    bench_prim_t* prim = prims + p;
+    if( filter && !strstr( prim->name, filter ) ) { continue; }
+    for( int32_t m = 0; m < DBGDRAW_MODE_COUNT; ++m )
+    {
+      if( ( prim->flags & BENCH_TEXT ) && m != DBGDRAW_MODE_FILL ) { continue; }
+      for( int32_t s = 0; s < DBGDRAW_SHADING_COUNT; ++s )
+      {
+        if( ( s == DBGDRAW_SHADING_TEXT ) != !!( prim->flags & BENCH_TEXT ) ) { continue; }
+        int32_t detail_count = ( prim->flags & BENCH_DETAIL ) ? DETAIL_COUNT : 1;
+        for( int32_t d = 0; d < detail_count; ++d )
+        {
+          bench_result_t result;
+          if( bench_run( &dd_ctx, prim, (dd_mode_t)m, (dd_shading_t)s, d, min_ms, &result ) ) { continue; }
+
+          double verts_per_prim = (double)result.vertex_count / BATCH_SIZE;
+          double verts_per_sec = result.ns_per_prim > 0.0 ? verts_per_prim * 1e9 / result.ns_per_prim : 0.0;
+          fprintf( fp, "%s\n    {\"primitive\": \"%s\", \"mode\": \"%s\", \"shading\": \"%s\", \"detail_level\": %d, "
+                       "\"vertices_per_primitive\": %.2f, \"bytes_per_primitive\": %.0f, \"checksum\": \"%016llx\", "
+                       "\"ns_per_primitive\": %.1f, \"vertices_per_second\": %.0f}",
+                   result_count ? "," : "", prim->name, mode_names[m], shading_names[s], d,
+                   verts_per_prim, verts_per_prim * sizeof(dd_vertex_t), (unsigned long long)result.checksum,
+                   result.ns_per_prim, verts_per_sec );
+          result_count++;
+        }
+      }
+    }
+  }
+  fprintf( fp, "\n  ]\n}\n" );
+
+  dd_term( &dd_ctx );
+  if( output ) { fclose( fp ); }
+  return 0;
+}
@@ -97,6 +97,15 @@ int32_t dd_backend_init_font_texture(dd_ctx_t* ctx,
                                      int32_t width,
                                      int32_t height,
                                      uint32_t* tex_id);
+int32_t dd_backend_update_font_texture(dd_ctx_t* ctx,
+                                       const uint8_t* data,
+                                       int32_t width,
+                                       int32_t height,
+                                       int32_t x,
+                                       int32_t y,
+                                       int32_t w,
+                                       int32_t h,
+                                       uint32_t* tex_id);
 
 int32_t
 dd_backend_init(dd_ctx_t* ctx)
@@ -329,6 +338,7 @@ dd_backend_render(dd_ctx_t* ctx)
   if (!ctx->commands_len) { return DBGDRAW_ERR_OK; }
 
   // Update the data buffer
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_backend_upload");
   if (backend->vertex_buffer_size < ctx->verts_cap * sizeof(dd_vertex_t))
   {
     backend->vertex_buffer_size = ctx->verts_cap * sizeof(dd_vertex_t);
@@ -342,6 +352,7 @@ dd_backend_render(dd_ctx_t* ctx)
       backend->vertex_buffer_size,
       ((ctx->verts_cap * sizeof(dd_vertex_t)) / 4),
       D3D11_BIND_VERTEX_BUFFER);
+    DBGDRAW_STATS(ctx->stats.grow_count++);
   }
 
   // TODO(maciej): Set vertex data dirty somehow?
@@ -358,6 +369,9 @@ dd_backend_render(dd_ctx_t* ctx)
   ID3D11DeviceContext_Unmap(d3d11->device_context,
                             (ID3D11Resource*)backend->vertex_buffer,
                             0);
+  DBGDRAW_STATS(ctx->stats.bytes_uploaded +=
+                ctx->verts_len * sizeof(dd_vertex_t));
+  DBGDRAW_TRACE_END(ctx, "dd_backend_upload");
 
   // Setup the required state
   FLOAT blend_color[] = {1.0f, 1.0f, 1.0f, 1.0f};
@@ -383,6 +397,7 @@ dd_backend_render(dd_ctx_t* ctx)
   for (int32_t i = 0; i < ctx->commands_len; ++i)
   {
     dd_cmd_t* cmd = ctx->commands + i;
+    DBGDRAW_TRACE_BEGIN(ctx, "dd_backend_submit");
     dd_mat4_t mvp = dd_mat4_mul(ctx->proj, dd_mat4_mul(ctx->view, cmd->xform));
     dd_mat4_t normal_matrix = dd_mat4_mul(
       ctx->proj,
@@ -405,6 +420,7 @@ dd_backend_render(dd_ctx_t* ctx)
           backend->instance_buffer_size,
           ((ctx->instance_cap * sizeof(dd_instance_data_t)) / 4),
           D3D11_BIND_VERTEX_BUFFER);
+        DBGDRAW_STATS(ctx->stats.grow_count++);
       }
       D3D11_MAPPED_SUBRESOURCE instance_buffer_data = {0};
       ID3D11DeviceContext_Map(d3d11->device_context,
@@ -419,6 +435,8 @@ dd_backend_render(dd_ctx_t* ctx)
       ID3D11DeviceContext_Unmap(d3d11->device_context,
                                 (ID3D11Resource*)backend->instance_buffer,
                                 0);
+      DBGDRAW_STATS(ctx->stats.bytes_uploaded +=
+                    cmd->instance_count * sizeof(dd_instance_data_t));
     }
 
     // Update the constant buffer
@@ -568,6 +586,8 @@ dd_backend_render(dd_ctx_t* ctx)
                                  0);
       }
     }
+    DBGDRAW_STATS(ctx->drawcall_count++);
+    DBGDRAW_TRACE_END(ctx, "dd_backend_submit");
   }
   return DBGDRAW_ERR_OK;
 }
@@ -623,7 +643,7 @@ dd_backend_init_font_texture(dd_ctx_t* ctx,
     .ArraySize  = 1,   // Would have to redesign api to make use of this
     .Format     = DXGI_FORMAT_R8_UNORM,
     .SampleDesc = {.Count = 1},
-    .Usage      = D3D11_USAGE_IMMUTABLE,
+    .Usage      = D3D11_USAGE_DEFAULT, // Glyphs are added as they are used
     .BindFlags  = D3D11_BIND_SHADER_RESOURCE};
 
   D3D11_SUBRESOURCE_DATA texture_data = {
@@ -647,6 +667,39 @@ dd_backend_init_font_texture(dd_ctx_t* ctx,
 
   return DBGDRAW_ERR_OK;
 }
+
+int32_t
+dd_backend_update_font_texture(dd_ctx_t* ctx,
+                               const uint8_t* data,
+                               int32_t width,
+                               int32_t height,
+                               int32_t x,
+                               int32_t y,
+                               int32_t w,
+                               int32_t h,
+                               uint32_t* tex_id)
+{
+  dd_render_backend_t* backend = ctx->render_backend;
+  const d3d11_ctx_t* d3d11     = backend->d3d11;
+  (void)height;
+
+  D3D11_BOX box = {.left   = x,
+                   .top    = y,
+                   .front  = 0,
+                   .right  = x + w,
+                   .bottom = y + h,
+                   .back   = 1};
+  ID3D11DeviceContext_UpdateSubresource(
+    d3d11->device_context,
+    (ID3D11Resource*)backend->font_textures[*tex_id],
+    0,
+    &box,
+    data + (size_t)y * width + x,
+    width,
+    0);
+
+  return DBGDRAW_ERR_OK;
+}
 #endif
 
 #define DBGDRAW_D3D11_STRINGIFY(x)  #x
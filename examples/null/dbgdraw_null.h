@@ -0,0 +1,268 @@
+#ifndef DBGDRAW_NULL_H
+#define DBGDRAW_NULL_H
+
+#include <assert.h>
+#include <string.h>
+
+// Backend that accepts every command and draws nothing. It needs no graphics
+// API, so debug drawing can stay compiled in where there is no display
+// (servers, tests, benchmarks) at the cost of recording only. Optionally, it
+// checksums the data it receives, which lets tests compare the output of
+// dbgdraw between runs without rendering and reading back images.
+
+// Capabilities reported to dbgdraw. By default the null backend claims to
+// support everything, so procedural primitives and impostors are kept as
+// parameter records, which is the cheapest option.
+#ifndef DBGDRAW_NULL_BACKEND_CAPS
+#define DBGDRAW_NULL_BACKEND_CAPS                                              \
+  (DBGDRAW_BACKEND_CAPS_PROCEDURAL | DBGDRAW_BACKEND_CAPS_IMPOSTORS |          \
+   DBGDRAW_BACKEND_CAPS_SDF_TEXT | DBGDRAW_BACKEND_CAPS_FONT_ARRAY |         \
+   DBGDRAW_BACKEND_CAPS_GLYPH_INSTANCES | DBGDRAW_BACKEND_CAPS_CLIP_RECT)
+#endif
+
+// Totals are accumulated over all frames since dd_backend_init. Checksums are
+// 64-bit FNV-1a hashes of the most recent frame, and are zero unless enabled
+// with dd_null_enable_checksums. 'vertex_checksum' covers vertices, procedural
+// primitives, glyphs and instance data, 'command_checksum' covers the command
+// records (everything but the pointer to instance data).
+typedef struct dd_null_stats
+{
+  int64_t frame_count;
+  int64_t command_count;
+  int64_t vertex_count;
+  int64_t procedural_count;
+  int64_t instance_count;
+  int64_t drawcall_count;
+  int64_t bytes_received;
+
+  uint64_t vertex_checksum;
+  uint64_t command_checksum;
+} dd_null_stats_t;
+
+typedef struct dd_render_backend
+{
+  uint8_t enable_checksums;
+  uint32_t font_count;
+  dd_null_stats_t stats;
+} dd_render_backend_t;
+
+int32_t dd_null_enable_checksums(dd_ctx_t* ctx, uint8_t enable);
+int32_t dd_null_get_stats(dd_ctx_t* ctx, dd_null_stats_t* stats);
+
+int32_t
+dd_backend_init(dd_ctx_t* ctx)
+{
+  dd_render_backend_t* backend = DBGDRAW_MALLOC(sizeof(dd_render_backend_t));
+  if (!backend) { return DBGDRAW_ERR_FAILED_ALLOC; }
+  memset(backend, 0, sizeof(dd_render_backend_t));
+  ctx->render_backend = backend;
+  ctx->backend_caps |= DBGDRAW_NULL_BACKEND_CAPS;
+  return DBGDRAW_ERR_OK;
+}
+
+uint64_t
+dd__null_hash(uint64_t hash, const void* data, size_t size)
+{
+  const uint8_t* bytes = (const uint8_t*)data;
+  for (size_t i = 0; i < size; ++i)
+  {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+uint64_t
+dd__null_hash_cmd(uint64_t hash, const dd_cmd_t* cmd)
+{
+  // Hashed field by field, to skip padding and the pointer
+  hash = dd__null_hash(hash, &cmd->base_index, sizeof(cmd->base_index));
+  hash = dd__null_hash(hash, &cmd->vertex_count, sizeof(cmd->vertex_count));
+  hash = dd__null_hash(hash, &cmd->instance_count, sizeof(cmd->instance_count));
+  hash = dd__null_hash(hash,
+                       &cmd->procedural_base_index,
+                       sizeof(cmd->procedural_base_index));
+  hash =
+    dd__null_hash(hash, &cmd->procedural_count, sizeof(cmd->procedural_count));
+  hash = dd__null_hash(hash,
+                       &cmd->procedural_vertex_count,
+                       sizeof(cmd->procedural_vertex_count));
+  hash =
+    dd__null_hash(hash, &cmd->procedural_types, sizeof(cmd->procedural_types));
+  hash = dd__null_hash(hash, &cmd->xform, sizeof(cmd->xform));
+  hash = dd__null_hash(hash, &cmd->min_depth, sizeof(cmd->min_depth));
+  hash = dd__null_hash(hash, &cmd->draw_mode, sizeof(cmd->draw_mode));
+  hash = dd__null_hash(hash, &cmd->shading_type, sizeof(cmd->shading_type));
+  hash = dd__null_hash(hash, &cmd->aa_radius, sizeof(cmd->aa_radius));
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  hash = dd__null_hash(hash, &cmd->font_idx, sizeof(cmd->font_idx));
+  hash =
+    dd__null_hash(hash, &cmd->glyph_base_index, sizeof(cmd->glyph_base_index));
+  hash = dd__null_hash(hash, &cmd->glyph_count, sizeof(cmd->glyph_count));
+#endif
+  return hash;
+}
+
+int32_t
+dd_backend_render(dd_ctx_t* ctx)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend = ctx->render_backend;
+  dd_null_stats_t* stats       = &backend->stats;
+
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_backend_upload");
+  size_t bytes = ctx->verts_len * sizeof(dd_vertex_t) +
+                 ctx->procedural_len * sizeof(dd_procedural_prim_t);
+  uint64_t vertex_checksum  = 0xcbf29ce484222325ULL;
+  uint64_t command_checksum = 0xcbf29ce484222325ULL;
+  if (backend->enable_checksums)
+  {
+    vertex_checksum = dd__null_hash(vertex_checksum,
+                                    ctx->verts_data,
+                                    ctx->verts_len * sizeof(dd_vertex_t));
+    vertex_checksum =
+      dd__null_hash(vertex_checksum,
+                    ctx->procedural_data,
+                    ctx->procedural_len * sizeof(dd_procedural_prim_t));
+  }
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  size_t glyph_bytes  = ctx->glyph_instances_len * sizeof(dd_glyph_instance_t);
+  size_t anchor_bytes = ctx->text_anchors_len * sizeof(dd_text_anchor_t);
+  bytes += glyph_bytes + anchor_bytes;
+  if (backend->enable_checksums)
+  {
+    vertex_checksum =
+      dd__null_hash(vertex_checksum, ctx->glyph_instances, glyph_bytes);
+    vertex_checksum =
+      dd__null_hash(vertex_checksum, ctx->text_anchors, anchor_bytes);
+  }
+#endif
+
+  for (int32_t i = 0; i < ctx->commands_len; ++i)
+  {
+    dd_cmd_t* cmd = ctx->commands + i;
+    if (backend->enable_checksums)
+    {
+      command_checksum = dd__null_hash_cmd(command_checksum, cmd);
+    }
+    if (cmd->instance_count && cmd->instance_data)
+    {
+      size_t instance_bytes = cmd->instance_count * sizeof(dd_instance_data_t);
+      if (backend->enable_checksums)
+      {
+        vertex_checksum =
+          dd__null_hash(vertex_checksum, cmd->instance_data, instance_bytes);
+      }
+      bytes += instance_bytes;
+      stats->instance_count += cmd->instance_count;
+    }
+
+    // Count draw calls the way the other backends issue them - one for
+    // tessellated vertices, one for procedural primitives and one for glyphs
+    if (cmd->vertex_count) { DBGDRAW_STATS(ctx->drawcall_count++); }
+    if (cmd->procedural_count) { DBGDRAW_STATS(ctx->drawcall_count++); }
+    stats->drawcall_count += (cmd->vertex_count > 0);
+    stats->drawcall_count += (cmd->procedural_count > 0);
+#if DBGDRAW_HAS_TEXT_SUPPORT
+    if (cmd->glyph_count) { DBGDRAW_STATS(ctx->drawcall_count++); }
+    stats->drawcall_count += (cmd->glyph_count > 0);
+#endif
+  }
+  DBGDRAW_TRACE_END(ctx, "dd_backend_upload");
+
+  DBGDRAW_STATS(ctx->stats.bytes_uploaded += bytes);
+  stats->frame_count++;
+  stats->command_count += ctx->commands_len;
+  stats->vertex_count += ctx->verts_len;
+  stats->procedural_count += ctx->procedural_len;
+  stats->bytes_received += bytes;
+  if (backend->enable_checksums)
+  {
+    stats->vertex_checksum  = vertex_checksum;
+    stats->command_checksum = command_checksum;
+  }
+
+  return DBGDRAW_ERR_OK;
+}
+
+#if DBGDRAW_HAS_TEXT_SUPPORT
+int32_t
+dd_backend_init_font_texture(dd_ctx_t* ctx,
+                             const uint8_t* data,
+                             int32_t width,
+                             int32_t height,
+                             uint32_t* tex_id)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend = ctx->render_backend;
+  (void)data;
+  (void)width;
+  (void)height;
+
+  *tex_id = ++backend->font_count;
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_backend_update_font_texture(dd_ctx_t* ctx,
+                               const uint8_t* data,
+                               int32_t width,
+                               int32_t height,
+                               int32_t x,
+                               int32_t y,
+                               int32_t w,
+                               int32_t h,
+                               uint32_t* tex_id)
+{
+  (void)ctx;
+  (void)data;
+  (void)width;
+  (void)height;
+  (void)x;
+  (void)y;
+  (void)w;
+  (void)h;
+  (void)tex_id;
+  return DBGDRAW_ERR_OK;
+}
+#endif
+
+int32_t
+dd_backend_term(dd_ctx_t* ctx)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  DBGDRAW_FREE(ctx->render_backend);
+  ctx->render_backend = NULL;
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_null_enable_checksums(dd_ctx_t* ctx, uint8_t enable)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend = ctx->render_backend;
+  backend->enable_checksums    = enable;
+  if (!enable)
+  {
+    backend->stats.vertex_checksum  = 0;
+    backend->stats.command_checksum = 0;
+  }
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_null_get_stats(dd_ctx_t* ctx, dd_null_stats_t* stats)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  assert(stats);
+  dd_render_backend_t* backend = ctx->render_backend;
+  *stats                       = backend->stats;
+  return DBGDRAW_ERR_OK;
+}
+
+#endif
@@ -1,21 +1,122 @@
 #ifndef DBGDRAW_OPENGL33_H
 #define DBGDRAW_OPENGL33_H
 
-typedef struct dd_render_backend
+#include <stddef.h>
+
+// Number of frames that can be in flight when rendering to image.
+#ifndef DBGDRAW_READBACK_RING_SIZE
+#define DBGDRAW_READBACK_RING_SIZE 3
+#endif
+
+// GPU timings are read back after at most this many frames.
+#ifndef DBGDRAW_TIMER_FRAMES
+#define DBGDRAW_TIMER_FRAMES 4
+#endif
+
+// Upper bound on (mode, shading) changes timed per frame; later commands are
+// attributed to the last timed bucket.
+#ifndef DBGDRAW_MAX_TIMER_QUERIES
+#define DBGDRAW_MAX_TIMER_QUERIES 32
+#endif
+
+// Fonts of a context are described to the base shader by an array of this size,
+// so it is not configurable.
+#define DBGDRAW_GL_MAX_FONTS 16
+
+// Upper bound on distinct font atlases, the layers of the font texture array
+// in dd_shared_resources_t.
+#ifndef DBGDRAW_GL_MAX_SHARED_FONTS
+#define DBGDRAW_GL_MAX_SHARED_FONTS 64
+#endif
+
+// Programs and font atlases do not depend on the context they are used with.
+// Contexts initialized with the same 'shared_resources' in dd_ctx_desc_t
+// compile the programs once and upload each distinct font atlas once, as a
+// layer of one texture array, while buffers, vertex arrays and offscreen
+// targets stay per context. Their GL contexts have to be the same or in one
+// share group. Zero-initialize the pool before the first dd_init; GL objects
+// are deleted when the last context using them is terminated. Without a pool,
+// every context gets a private one.
+typedef struct dd_shared_resources
 {
   GLuint base_program;
   GLuint lines_program;
+  GLuint impostor_program;
+  GLuint glyph_program;
+  GLuint font_tex_attrib_loc;
+
+  GLuint font_array;
+  int32_t font_array_width;
+  int32_t font_array_height;
+  int32_t font_array_layers;
+  uint64_t font_hashes[DBGDRAW_GL_MAX_SHARED_FONTS];
+  int32_t font_ref_counts[DBGDRAW_GL_MAX_SHARED_FONTS];
+
+  int32_t ref_count;
+  bool owned;
+} dd_shared_resources_t;
+
+typedef struct dd_render_backend
+{
+  dd_shared_resources_t* shared;
+  int32_t font_refs[DBGDRAW_GL_MAX_SHARED_FONTS];
+
   GLuint vao;
   GLuint vbo;
   GLuint ibo;
-  GLuint font_tex_attrib_loc;
-  GLuint font_tex_ids[16];
 
   GLuint line_data_texture_id;
+  GLuint impostor_buffer;
+  GLuint impostor_data_texture_id;
+  GLuint glyph_buffer;
+  GLuint glyph_data_texture_id;
+  GLuint anchor_buffer;
+  GLuint anchor_data_texture_id;
+  int32_t font_count;
   size_t vbo_size;
   size_t ibo_size;
+  size_t impostor_buffer_size;
+  size_t glyph_buffer_size;
+  size_t anchor_buffer_size;
+
+  GLuint image_fbo;
+  GLuint image_color_rb;
+  GLuint image_depth_rb;
+  GLuint readback_pbos[DBGDRAW_READBACK_RING_SIZE];
+  GLsync readback_fences[DBGDRAW_READBACK_RING_SIZE];
+  int32_t readback_frame_idx[DBGDRAW_READBACK_RING_SIZE];
+  int32_t readback_head;
+  int32_t readback_len;
+  int32_t image_frame_count;
+  int32_t image_width;
+  int32_t image_height;
+
+  GLuint timer_queries[DBGDRAW_TIMER_FRAMES][DBGDRAW_MAX_TIMER_QUERIES];
+  uint8_t timer_buckets[DBGDRAW_TIMER_FRAMES][DBGDRAW_MAX_TIMER_QUERIES];
+  int32_t timer_query_count[DBGDRAW_TIMER_FRAMES];
+  int32_t timer_frame_idx[DBGDRAW_TIMER_FRAMES];
+  int32_t timer_frame_count;
+  int32_t timer_slot;
+  int32_t timer_bucket;
 } dd_render_backend_t;
 
+// Offscreen rendering. The frame is rendered into an offscreen target of the
+// requested size and read back asynchronously, through a ring of pixel buffers.
+// 'pixels' must hold width * height * 4 bytes (RGBA, top row first). On return
+// 'frame_idx' is the index of the frame that was written to 'pixels', or -1 if
+// no frame was ready yet. Use dd_flush_image to read back remaining frames.
+typedef struct dd_image
+{
+  int32_t width;
+  int32_t height;
+  dd_color_t clear_color;
+  uint8_t* pixels;
+  int32_t frame_idx;
+} dd_image_t;
+
+int32_t dd_render_to_image(dd_ctx_t* ctx, dd_image_t* image);
+int32_t dd_flush_image(dd_ctx_t* ctx, dd_image_t* image);
+
 void
 dd__gl_check(const char* filename, uint32_t lineno)
 {
@@ -121,56 +222,141 @@ void dd__init_base_shaders_source(const char** vert_shdr,
                                   const char** frag_shdr_src);
 void dd__init_line_shaders_source(const char** vert_shdr_src,
                                   const char** frag_shdr_src);
+void dd__init_impostor_shaders_source(const char** vert_shdr_src,
+                                      const char** frag_shdr_src);
+void dd__init_glyph_shaders_source(const char** vert_shdr_src,
+                                   const char** frag_shdr_src);
+
+// Line, impostor and glyph programs are only compiled once the first command
+// that needs them is rendered, to keep startup short.
+GLuint
+dd__gl_lines_program(dd_shared_resources_t* shared)
+{
+  if (!shared->lines_program)
+  {
+    const char* vert_shdr_src = NULL;
+    const char* frag_shdr_src = NULL;
+    dd__init_line_shaders_source(&vert_shdr_src, &frag_shdr_src);
+
+    GLuint vertex_shader =
+      dd__gl_compile_shader_src(GL_VERTEX_SHADER, vert_shdr_src);
+    GLuint fragment_shader =
+      dd__gl_compile_shader_src(GL_FRAGMENT_SHADER, frag_shdr_src);
+    shared->lines_program =
+      dd__gl_link_program(vertex_shader, 0, fragment_shader);
+  }
+  return shared->lines_program;
+}
+
+GLuint
+dd__gl_impostor_program(dd_shared_resources_t* shared)
+{
+  if (!shared->impostor_program)
+  {
+    const char* vert_shdr_src = NULL;
+    const char* frag_shdr_src = NULL;
+    dd__init_impostor_shaders_source(&vert_shdr_src, &frag_shdr_src);
+
+    GLuint vertex_shader =
+      dd__gl_compile_shader_src(GL_VERTEX_SHADER, vert_shdr_src);
+    GLuint fragment_shader =
+      dd__gl_compile_shader_src(GL_FRAGMENT_SHADER, frag_shdr_src);
+    shared->impostor_program =
+      dd__gl_link_program(vertex_shader, 0, fragment_shader);
+  }
+  return shared->impostor_program;
+}
+
+uint64_t
+dd__gl_hash_bytes(uint64_t hash, const void* data, size_t size)
+{
+  // FNV-1a, identifies font atlases that are already uploaded
+  const uint8_t* bytes = (const uint8_t*)data;
+  for (size_t i = 0; i < size; ++i)
+  {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+GLuint
+dd__gl_glyph_program(dd_shared_resources_t* shared)
+{
+  if (!shared->glyph_program)
+  {
+    const char* vert_shdr_src = NULL;
+    const char* frag_shdr_src = NULL;
+    dd__init_glyph_shaders_source(&vert_shdr_src, &frag_shdr_src);
+
+    GLuint vertex_shader =
+      dd__gl_compile_shader_src(GL_VERTEX_SHADER, vert_shdr_src);
+    GLuint fragment_shader =
+      dd__gl_compile_shader_src(GL_FRAGMENT_SHADER, frag_shdr_src);
+    shared->glyph_program =
+      dd__gl_link_program(vertex_shader, 0, fragment_shader);
+  }
+  return shared->glyph_program;
+}
 
 int32_t
 dd_backend_init(dd_ctx_t* ctx)
 {
-  static dd_render_backend_t backend = {0};
-  ctx->render_backend                = &backend;
+  dd_shared_resources_t* shared = ctx->shared_resources;
+  if (!shared)
+  {
+    shared = calloc(1, sizeof(dd_shared_resources_t));
+    if (!shared) { return DBGDRAW_ERR_FAILED_ALLOC; }
+    shared->owned = true;
+  }
 
-  const char* base_vert_shdr_src = NULL;
-  const char* base_frag_shdr_src = NULL;
-  dd__init_base_shaders_source(&base_vert_shdr_src, &base_frag_shdr_src);
-
-  GLuint vertex_shader =
-    dd__gl_compile_shader_src(GL_VERTEX_SHADER, base_vert_shdr_src);
-  GLuint fragment_shader =
-    dd__gl_compile_shader_src(GL_FRAGMENT_SHADER, base_frag_shdr_src);
-  backend.base_program = dd__gl_link_program(vertex_shader, 0, fragment_shader);
-
-  const char* line_vert_shdr_src = NULL;
-  const char* line_frag_shdr_src = NULL;
-  dd__init_line_shaders_source(&line_vert_shdr_src, &line_frag_shdr_src);
-
-  GLuint vertex_shader2 =
-    dd__gl_compile_shader_src(GL_VERTEX_SHADER, line_vert_shdr_src);
-  GLuint fragment_shader2 =
-    dd__gl_compile_shader_src(GL_FRAGMENT_SHADER, line_frag_shdr_src);
-  backend.lines_program =
-    dd__gl_link_program(vertex_shader2, 0, fragment_shader2);
+  dd_render_backend_t* backend = calloc(1, sizeof(dd_render_backend_t));
+  if (!backend)
+  {
+    if (shared->owned) { free(shared); }
+    return DBGDRAW_ERR_FAILED_ALLOC;
+  }
+  ctx->render_backend = backend;
+  backend->shared     = shared;
+  shared->ref_count++;
+
+  if (!shared->base_program)
+  {
+    const char* base_vert_shdr_src = NULL;
+    const char* base_frag_shdr_src = NULL;
+    dd__init_base_shaders_source(&base_vert_shdr_src, &base_frag_shdr_src);
+
+    GLuint vertex_shader =
+      dd__gl_compile_shader_src(GL_VERTEX_SHADER, base_vert_shdr_src);
+    GLuint fragment_shader =
+      dd__gl_compile_shader_src(GL_FRAGMENT_SHADER, base_frag_shdr_src);
+    shared->base_program =
+      dd__gl_link_program(vertex_shader, 0, fragment_shader);
+    shared->font_tex_attrib_loc =
+      glGetUniformLocation(shared->base_program, "tex");
+  }
 
   GLuint pos_size_loc =
-    glGetAttribLocation(backend.base_program, "in_position_and_size");
+    glGetAttribLocation(shared->base_program, "in_position_and_size");
   GLuint uv_or_normal_loc =
-    glGetAttribLocation(backend.base_program, "in_uv_or_normal");
-  GLuint color_loc = glGetAttribLocation(backend.base_program, "in_color");
+    glGetAttribLocation(shared->base_program, "in_uv_or_normal");
+  GLuint color_loc = glGetAttribLocation(shared->base_program, "in_color");
 
   GLuint instance_pos_loc =
-    glGetAttribLocation(backend.base_program, "in_instance_pos");
+    glGetAttribLocation(shared->base_program, "in_instance_pos");
   GLuint instance_col_loc =
-    glGetAttribLocation(backend.base_program, "in_instance_col");
+    glGetAttribLocation(shared->base_program, "in_instance_col");
 
-  GLCHECK(glGenVertexArrays(1, &backend.vao));
+  GLCHECK(glGenVertexArrays(1, &backend->vao));
 
-  GLCHECK(glGenBuffers(1, &backend.vbo));
-  GLCHECK(glGenBuffers(1, &backend.ibo));
+  GLCHECK(glGenBuffers(1, &backend->vbo));
+  GLCHECK(glGenBuffers(1, &backend->ibo));
 
-  GLCHECK(glBindVertexArray(backend.vao));
+  GLCHECK(glBindVertexArray(backend->vao));
 
-  backend.vbo_size = ctx->verts_cap * sizeof(dd_vertex_t);
-  GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, backend.vbo));
+  backend->vbo_size = ctx->verts_cap * sizeof(dd_vertex_t);
+  GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, backend->vbo));
   GLCHECK(
-    glBufferData(GL_ARRAY_BUFFER, backend.vbo_size, NULL, GL_DYNAMIC_DRAW));
+    glBufferData(GL_ARRAY_BUFFER, backend->vbo_size, NULL, GL_DYNAMIC_DRAW));
 
   GLCHECK(glEnableVertexAttribArray(pos_size_loc));
   GLCHECK(glEnableVertexAttribArray(uv_or_normal_loc));
@@ -195,10 +381,10 @@ dd_backend_init(dd_ctx_t* ctx)
                                 sizeof(dd_vertex_t),
                                 (void*)offsetof(dd_vertex_t, col)));
 
-  backend.ibo_size = ctx->instance_cap * sizeof(dd_instance_data_t);
-  GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, backend.ibo));
+  backend->ibo_size = ctx->instance_cap * sizeof(dd_instance_data_t);
+  GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, backend->ibo));
   GLCHECK(
-    glBufferData(GL_ARRAY_BUFFER, backend.ibo_size, NULL, GL_DYNAMIC_DRAW));
+    glBufferData(GL_ARRAY_BUFFER, backend->ibo_size, NULL, GL_DYNAMIC_DRAW));
 
   GLCHECK(glEnableVertexAttribArray(instance_pos_loc));
   GLCHECK(glEnableVertexAttribArray(instance_col_loc));
@@ -222,14 +408,186 @@ dd_backend_init(dd_ctx_t* ctx)
   GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
   GLCHECK(glBindVertexArray(0));
 
-  glGenTextures(1, &backend.line_data_texture_id);
-  glBindTexture(GL_TEXTURE_BUFFER, backend.line_data_texture_id);
-  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, backend.vbo);
+  glGenTextures(1, &backend->line_data_texture_id);
+  glBindTexture(GL_TEXTURE_BUFFER, backend->line_data_texture_id);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, backend->vbo);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+  // Impostor records are read through a texture buffer, three texels each
+  backend->impostor_buffer_size =
+    ctx->procedural_cap * sizeof(dd_procedural_prim_t);
+  GLCHECK(glGenBuffers(1, &backend->impostor_buffer));
+  GLCHECK(glBindBuffer(GL_TEXTURE_BUFFER, backend->impostor_buffer));
+  GLCHECK(glBufferData(GL_TEXTURE_BUFFER,
+                       backend->impostor_buffer_size,
+                       NULL,
+                       GL_DYNAMIC_DRAW));
+  GLCHECK(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+
+  glGenTextures(1, &backend->impostor_data_texture_id);
+  glBindTexture(GL_TEXTURE_BUFFER, backend->impostor_data_texture_id);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, backend->impostor_buffer);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  // Glyph records span three texels and line anchors four
+  backend->glyph_buffer_size =
+    ctx->glyph_instances_cap * sizeof(dd_glyph_instance_t);
+  GLCHECK(glGenBuffers(1, &backend->glyph_buffer));
+  GLCHECK(glBindBuffer(GL_TEXTURE_BUFFER, backend->glyph_buffer));
+  GLCHECK(glBufferData(GL_TEXTURE_BUFFER,
+                       backend->glyph_buffer_size,
+                       NULL,
+                       GL_DYNAMIC_DRAW));
+
+  backend->anchor_buffer_size =
+    ctx->text_anchors_cap * sizeof(dd_text_anchor_t);
+  GLCHECK(glGenBuffers(1, &backend->anchor_buffer));
+  GLCHECK(glBindBuffer(GL_TEXTURE_BUFFER, backend->anchor_buffer));
+  GLCHECK(glBufferData(GL_TEXTURE_BUFFER,
+                       backend->anchor_buffer_size,
+                       NULL,
+                       GL_DYNAMIC_DRAW));
+  GLCHECK(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+
+  glGenTextures(1, &backend->glyph_data_texture_id);
+  glBindTexture(GL_TEXTURE_BUFFER, backend->glyph_data_texture_id);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, backend->glyph_buffer);
+  glGenTextures(1, &backend->anchor_data_texture_id);
+  glBindTexture(GL_TEXTURE_BUFFER, backend->anchor_data_texture_id);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, backend->anchor_buffer);
   glBindTexture(GL_TEXTURE_BUFFER, 0);
+  ctx->backend_caps |= DBGDRAW_BACKEND_CAPS_GLYPH_INSTANCES;
+#endif
+  ctx->backend_caps |= DBGDRAW_BACKEND_CAPS_IMPOSTORS;
+  ctx->backend_caps |= DBGDRAW_BACKEND_CAPS_SDF_TEXT;
+  ctx->backend_caps |= DBGDRAW_BACKEND_CAPS_FONT_ARRAY;
+  ctx->backend_caps |= DBGDRAW_BACKEND_CAPS_CLIP_RECT;
 
   return DBGDRAW_ERR_OK;
 }
 
+// Results are only collected once available, so reading them never stalls. Slot
+// that is still in flight is not reused, that frame simply goes untimed.
+void
+dd__gl_collect_timers(dd_ctx_t* ctx, dd_render_backend_t* backend)
+{
+  // Oldest frame first, so that latest results end up in timings
+  for (int32_t i = 0; i < DBGDRAW_TIMER_FRAMES; ++i)
+  {
+    int32_t slot = (backend->timer_frame_count + i) % DBGDRAW_TIMER_FRAMES;
+    int32_t query_count = backend->timer_query_count[slot];
+    if (!query_count) { continue; }
+
+    GLint available = 0;
+    GLCHECK(glGetQueryObjectiv(backend->timer_queries[slot][query_count - 1],
+                               GL_QUERY_RESULT_AVAILABLE,
+                               &available));
+    if (!available) { break; }
+
+    dd_frame_timings_t* timings = &ctx->timings;
+    float* bucket_ms            = &timings->gpu_bucket_ms[0][0];
+    timings->gpu_ms             = 0.0f;
+    for (int32_t j = 0; j < DBGDRAW_MODE_COUNT * DBGDRAW_SHADING_COUNT; ++j)
+    {
+      bucket_ms[j] = 0.0f;
+    }
+    for (int32_t j = 0; j < query_count; ++j)
+    {
+      GLuint64 elapsed_ns = 0;
+      GLCHECK(glGetQueryObjectui64v(backend->timer_queries[slot][j],
+                                    GL_QUERY_RESULT,
+                                    &elapsed_ns));
+      bucket_ms[backend->timer_buckets[slot][j]] += elapsed_ns * 1e-6f;
+      timings->gpu_ms += elapsed_ns * 1e-6f;
+    }
+    timings->gpu_latency =
+      backend->timer_frame_count - backend->timer_frame_idx[slot];
+    backend->timer_query_count[slot] = 0;
+  }
+}
+
+void
+dd__gl_begin_timers(dd_ctx_t* ctx, dd_render_backend_t* backend)
+{
+  backend->timer_slot   = -1;
+  backend->timer_bucket = -1;
+  if (!ctx->enable_timings) { return; }
+
+  if (!backend->timer_queries[0][0])
+  {
+    GLCHECK(glGenQueries(DBGDRAW_TIMER_FRAMES * DBGDRAW_MAX_TIMER_QUERIES,
+                         &backend->timer_queries[0][0]));
+  }
+
+  dd__gl_collect_timers(ctx, backend);
+  int32_t slot = backend->timer_frame_count % DBGDRAW_TIMER_FRAMES;
+  if (!backend->timer_query_count[slot])
+  {
+    backend->timer_slot            = slot;
+    backend->timer_frame_idx[slot] = backend->timer_frame_count;
+  }
+}
+
+void
+dd__gl_time_bucket(dd_render_backend_t* backend, dd_cmd_t* cmd)
+{
+  int32_t slot   = backend->timer_slot;
+  int32_t bucket = cmd->draw_mode * DBGDRAW_SHADING_COUNT + cmd->shading_type;
+  if (slot < 0 || bucket == backend->timer_bucket ||
+      backend->timer_query_count[slot] >= DBGDRAW_MAX_TIMER_QUERIES)
+  {
+    return;
+  }
+
+  if (backend->timer_bucket >= 0) { GLCHECK(glEndQuery(GL_TIME_ELAPSED)); }
+  int32_t query_idx = backend->timer_query_count[slot]++;
+  backend->timer_buckets[slot][query_idx] = (uint8_t)bucket;
+  backend->timer_bucket                   = bucket;
+  GLCHECK(
+    glBeginQuery(GL_TIME_ELAPSED, backend->timer_queries[slot][query_idx]));
+}
+
+void
+dd__gl_end_timers(dd_ctx_t* ctx, dd_render_backend_t* backend)
+{
+  if (!ctx->enable_timings) { return; }
+  if (backend->timer_bucket >= 0) { GLCHECK(glEndQuery(GL_TIME_ELAPSED)); }
+  backend->timer_frame_count++;
+}
+
+// Clip rects are in pixels of the viewport passed to dd_new_frame, from its top
+// left corner. Scissor boxes are in pixels of the GL viewport, from its bottom
+// left corner, and it is smaller when rendering to an image. Like
+// rasterization, a pixel is kept when its center is inside the rect.
+void
+dd__gl_apply_clip_rect(dd_ctx_t* ctx,
+                       dd_cmd_t* cmd,
+                       const GLint* viewport,
+                       bool* is_scissored)
+{
+  dd_vec4_t rect = cmd->clip_rect;
+  if (rect.z <= 0.0f)
+  {
+    if (*is_scissored) { GLCHECK(glDisable(GL_SCISSOR_TEST)); }
+    *is_scissored = false;
+    return;
+  }
+
+  float sx = ctx->viewport.z > 0.0f ? viewport[2] / ctx->viewport.z : 1.0f;
+  float sy = ctx->viewport.w > 0.0f ? viewport[3] / ctx->viewport.w : 1.0f;
+  GLint x0 = (GLint)ceilf(rect.x * sx - 0.5f);
+  GLint x1 = (GLint)ceilf((rect.x + rect.z) * sx - 0.5f);
+  GLint y0 = (GLint)ceilf(rect.y * sy - 0.5f);
+  GLint y1 = (GLint)ceilf((rect.y + rect.w) * sy - 0.5f);
+  if (!*is_scissored) { GLCHECK(glEnable(GL_SCISSOR_TEST)); }
+  *is_scissored = true;
+  GLCHECK(glScissor(viewport[0] + x0,
+                    viewport[1] + viewport[3] - y1,
+                    DD_MAX(x1 - x0, 0),
+                    DD_MAX(y1 - y0, 0)));
+}
+
 int32_t
 dd_backend_render(dd_ctx_t* ctx)
 {
@@ -239,19 +597,96 @@ dd_backend_render(dd_ctx_t* ctx)
 
   if (!ctx->commands_len) { return DBGDRAW_ERR_OK; }
 
+  double upload_start_ms = ctx->enable_timings ? dd_time_ms() : 0.0;
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_backend_upload");
+
   GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, backend->vbo));
   if (backend->vbo_size < ctx->verts_cap * sizeof(dd_vertex_t))
   {
     backend->vbo_size = ctx->verts_cap * sizeof(dd_vertex_t);
     GLCHECK(
       glBufferData(GL_ARRAY_BUFFER, backend->vbo_size, NULL, GL_DYNAMIC_DRAW));
+    DBGDRAW_STATS(ctx->stats.grow_count++);
   }
   GLCHECK(glBufferSubData(GL_ARRAY_BUFFER,
                           0,
                           ctx->verts_len * sizeof(dd_vertex_t),
                           ctx->verts_data));
+  DBGDRAW_STATS(ctx->stats.bytes_uploaded +=
+                ctx->verts_len * sizeof(dd_vertex_t));
   GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
 
+  if (ctx->procedural_len)
+  {
+    GLCHECK(glBindBuffer(GL_TEXTURE_BUFFER, backend->impostor_buffer));
+    size_t impostor_size = ctx->procedural_cap * sizeof(dd_procedural_prim_t);
+    if (backend->impostor_buffer_size < impostor_size)
+    {
+      backend->impostor_buffer_size = impostor_size;
+      GLCHECK(glBufferData(GL_TEXTURE_BUFFER,
+                           backend->impostor_buffer_size,
+                           NULL,
+                           GL_DYNAMIC_DRAW));
+      DBGDRAW_STATS(ctx->stats.grow_count++);
+    }
+    GLCHECK(glBufferSubData(GL_TEXTURE_BUFFER,
+                            0,
+                            ctx->procedural_len * sizeof(dd_procedural_prim_t),
+                            ctx->procedural_data));
+    DBGDRAW_STATS(ctx->stats.bytes_uploaded +=
+                  ctx->procedural_len * sizeof(dd_procedural_prim_t));
+    GLCHECK(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+  }
+
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  if (ctx->glyph_instances_len)
+  {
+    GLCHECK(glBindBuffer(GL_TEXTURE_BUFFER, backend->glyph_buffer));
+    size_t glyph_size = ctx->glyph_instances_cap * sizeof(dd_glyph_instance_t);
+    if (backend->glyph_buffer_size < glyph_size)
+    {
+      backend->glyph_buffer_size = glyph_size;
+      GLCHECK(glBufferData(GL_TEXTURE_BUFFER,
+                           backend->glyph_buffer_size,
+                           NULL,
+                           GL_DYNAMIC_DRAW));
+      DBGDRAW_STATS(ctx->stats.grow_count++);
+    }
+    GLCHECK(
+      glBufferSubData(GL_TEXTURE_BUFFER,
+                      0,
+                      ctx->glyph_instances_len * sizeof(dd_glyph_instance_t),
+                      ctx->glyph_instances));
+
+    GLCHECK(glBindBuffer(GL_TEXTURE_BUFFER, backend->anchor_buffer));
+    size_t anchor_size = ctx->text_anchors_cap * sizeof(dd_text_anchor_t);
+    if (backend->anchor_buffer_size < anchor_size)
+    {
+      backend->anchor_buffer_size = anchor_size;
+      GLCHECK(glBufferData(GL_TEXTURE_BUFFER,
+                           backend->anchor_buffer_size,
+                           NULL,
+                           GL_DYNAMIC_DRAW));
+      DBGDRAW_STATS(ctx->stats.grow_count++);
+    }
+    GLCHECK(glBufferSubData(GL_TEXTURE_BUFFER,
+                            0,
+                            ctx->text_anchors_len * sizeof(dd_text_anchor_t),
+                            ctx->text_anchors));
+    DBGDRAW_STATS(ctx->stats.bytes_uploaded +=
+                  ctx->glyph_instances_len * sizeof(dd_glyph_instance_t) +
+                  ctx->text_anchors_len * sizeof(dd_text_anchor_t));
+    GLCHECK(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+  }
+#endif
+
+  if (ctx->enable_timings)
+  {
+    ctx->timings.upload_ms += (float)(dd_time_ms() - upload_start_ms);
+  }
+  DBGDRAW_TRACE_END(ctx, "dd_backend_upload");
+  dd__gl_begin_timers(ctx, backend);
+
   // Setup required ogl state
   if (ctx->enable_depth_test) { GLCHECK(glEnable(GL_DEPTH_TEST)); }
   GLCHECK(glEnable(GL_BLEND));
@@ -262,6 +697,32 @@ dd_backend_render(dd_ctx_t* ctx)
   GLCHECK(glEnable(GL_POLYGON_OFFSET_FILL));
   GLCHECK(glPolygonOffset(1.0, 1.0));
 
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  // Per font: its size relative to the layers, whether it is a distance field
+  // and its layer. Text vertices index this with their font.
+  if (backend->font_count)
+  {
+    dd_shared_resources_t* shared = backend->shared;
+    float fonts[DBGDRAW_GL_MAX_FONTS][4];
+    int32_t fonts_len = DD_MIN(ctx->fonts_len, DBGDRAW_GL_MAX_FONTS);
+    for (int32_t i = 0; i < fonts_len; ++i)
+    {
+      dd_font_data_t* font = ctx->fonts + i;
+      fonts[i][0] = (float)font->bitmap_width / shared->font_array_width;
+      fonts[i][1] = (float)font->bitmap_height / shared->font_array_height;
+      fonts[i][2] = font->is_sdf;
+      fonts[i][3] = (float)font->tex_id;
+    }
+    GLCHECK(glUseProgram(backend->shared->base_program));
+    GLCHECK(glUniform4fv(10, fonts_len, &fonts[0][0]));
+    if (ctx->glyph_instances_len)
+    {
+      GLCHECK(glUseProgram(dd__gl_glyph_program(backend->shared)));
+      GLCHECK(glUniform4fv(10, fonts_len, &fonts[0][0]));
+    }
+  }
+#endif
+
   dd_vec2_t viewport_size =
     dd_vec2(ctx->viewport.data[2], ctx->viewport.data[3]);
 
@@ -270,6 +731,10 @@ dd_backend_render(dd_ctx_t* ctx)
   gl_modes[DBGDRAW_MODE_STROKE] = GL_LINES;
   gl_modes[DBGDRAW_MODE_POINT]  = GL_POINTS;
 
+  GLint gl_viewport[4];
+  GLCHECK(glGetIntegerv(GL_VIEWPORT, gl_viewport));
+  bool is_scissored = false;
+
   for (int32_t i = 0; i < ctx->commands_len; ++i)
   {
     dd_cmd_t* cmd = ctx->commands + i;
@@ -278,10 +743,16 @@ dd_backend_render(dd_ctx_t* ctx)
       ctx->proj,
       dd_mat4_mul(ctx->view, dd_mat4_transpose(dd_mat4_inverse(cmd->xform))));
 
+    DBGDRAW_TRACE_BEGIN(ctx, "dd_backend_submit");
+    dd__gl_time_bucket(backend, cmd);
+    dd__gl_apply_clip_rect(ctx, cmd, gl_viewport, &is_scissored);
+
     if (cmd->instance_count && cmd->instance_data)
     {
+      upload_start_ms = ctx->enable_timings ? dd_time_ms() : 0.0;
+      DBGDRAW_TRACE_BEGIN(ctx, "dd_backend_upload");
       GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, backend->ibo));
-      if (backend->ibo_size < ctx->instance_cap * sizeof(dd_instance_data_t))
+      if (backend->ibo_size < cmd->instance_count * sizeof(dd_instance_data_t))
       {
         ctx->instance_cap = cmd->instance_count;
         backend->ibo_size = ctx->instance_cap * sizeof(dd_instance_data_t);
@@ -289,48 +760,110 @@ dd_backend_render(dd_ctx_t* ctx)
                              backend->ibo_size,
                              NULL,
                              GL_DYNAMIC_DRAW));
+        DBGDRAW_STATS(ctx->stats.grow_count++);
       }
       GLCHECK(glBufferSubData(GL_ARRAY_BUFFER,
                               0,
-                              backend->ibo_size,
+                              cmd->instance_count * sizeof(dd_instance_data_t),
                               cmd->instance_data));
+      DBGDRAW_STATS(ctx->stats.bytes_uploaded +=
+                    cmd->instance_count * sizeof(dd_instance_data_t));
       GLCHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+      if (ctx->enable_timings)
+      {
+        ctx->timings.upload_ms += (float)(dd_time_ms() - upload_start_ms);
+      }
+      DBGDRAW_TRACE_END(ctx, "dd_backend_upload");
     }
 
     if (cmd->draw_mode == DBGDRAW_MODE_FILL)
     {
-      GLCHECK(glUseProgram(backend->base_program));
+      GLCHECK(glUseProgram(backend->shared->base_program));
       GLCHECK(glUniformMatrix4fv(0, 1, GL_FALSE, &mvp.data[0]));
       GLCHECK(glUniformMatrix4fv(6, 1, GL_FALSE, &normal_matrix.data[0]));
       GLCHECK(glUniform1i(1, cmd->shading_type));
       GLCHECK(glUniform1i(2, (cmd->instance_count > 0)));
 
 #if DBGDRAW_HAS_TEXT_SUPPORT
-      if (cmd->font_idx >= 0)
+      if (cmd->shading_type == DBGDRAW_SHADING_TEXT)
       {
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, ctx->fonts[cmd->font_idx].tex_id);
-        glUniform1i(backend->font_tex_attrib_loc, 0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, backend->shared->font_array);
+        glUniform1i(backend->shared->font_tex_attrib_loc, 0);
       }
 #endif
-      if (cmd->instance_count <= 0)
+      if (cmd->instance_count <= 0 && cmd->vertex_count > 0)
       {
         GLCHECK(glDrawArrays(gl_modes[cmd->draw_mode],
                              cmd->base_index,
                              cmd->vertex_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
       }
-      else
+      else if (cmd->instance_count > 0)
       {
         GLCHECK(glDrawArraysInstanced(gl_modes[cmd->draw_mode],
                                       cmd->base_index,
                                       cmd->vertex_count,
                                       cmd->instance_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
       }
+
+      // Impostors are drawn as a quad (spheres) or a box (capsules and
+      // cylinders) per record, and the fragment shader ray-casts the surface
+      uint32_t impostor_box_types =
+        (1u << DBGDRAW_PROCEDURAL_IMPOSTOR_CAPSULE) |
+        (1u << DBGDRAW_PROCEDURAL_IMPOSTOR_CYLINDER);
+      uint32_t impostor_types =
+        impostor_box_types | (1u << DBGDRAW_PROCEDURAL_IMPOSTOR_SPHERE);
+      if (cmd->procedural_types & impostor_types)
+      {
+        dd_mat4_t model_view = dd_mat4_mul(ctx->view, cmd->xform);
+        GLCHECK(glActiveTexture(GL_TEXTURE0));
+        GLCHECK(
+          glBindTexture(GL_TEXTURE_BUFFER, backend->impostor_data_texture_id));
+        GLCHECK(glUseProgram(dd__gl_impostor_program(backend->shared)));
+        GLCHECK(glUniform1i(1, cmd->shading_type));
+        GLCHECK(glUniform1i(3, cmd->procedural_base_index));
+        GLCHECK(glUniform1i(4, 0));
+        GLCHECK(glUniformMatrix4fv(7, 1, GL_FALSE, &model_view.data[0]));
+        GLCHECK(glUniformMatrix4fv(8, 1, GL_FALSE, &ctx->proj.data[0]));
+        GLCHECK(glEnable(GL_CULL_FACE));
+        GLCHECK(glDrawArraysInstanced(
+          GL_TRIANGLES,
+          0,
+          (cmd->procedural_types & impostor_box_types) ? 36 : 6,
+          cmd->procedural_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
+        GLCHECK(glDisable(GL_CULL_FACE));
+      }
+
+#if DBGDRAW_HAS_TEXT_SUPPORT
+      // Glyph records are expanded into quads, one instance each. The font
+      // array stays bound to the first unit.
+      if (cmd->glyph_count > 0)
+      {
+        GLCHECK(glActiveTexture(GL_TEXTURE1));
+        GLCHECK(
+          glBindTexture(GL_TEXTURE_BUFFER, backend->glyph_data_texture_id));
+        GLCHECK(glActiveTexture(GL_TEXTURE2));
+        GLCHECK(
+          glBindTexture(GL_TEXTURE_BUFFER, backend->anchor_data_texture_id));
+        GLCHECK(glActiveTexture(GL_TEXTURE0));
+        GLCHECK(glUseProgram(dd__gl_glyph_program(backend->shared)));
+        GLCHECK(glUniformMatrix4fv(0, 1, GL_FALSE, &mvp.data[0]));
+        GLCHECK(glUniform1i(1, cmd->shading_type));
+        GLCHECK(glUniform1i(3, cmd->glyph_base_index));
+        GLCHECK(glUniform1i(4, 1));
+        GLCHECK(glUniform1i(5, 2));
+        GLCHECK(glDrawArraysInstanced(GL_TRIANGLES, 0, 6, cmd->glyph_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
+      }
+#endif
     }
 
     else if (cmd->draw_mode == DBGDRAW_MODE_POINT)
     {
-      GLCHECK(glUseProgram(backend->base_program));
+      GLCHECK(glUseProgram(backend->shared->base_program));
       GLCHECK(glUniform1i(1, 0));
       GLCHECK(glUniform1i(2, (int)(cmd->instance_count > 0)));
 
@@ -339,6 +872,7 @@ dd_backend_render(dd_ctx_t* ctx)
         GLCHECK(glDrawArrays(gl_modes[cmd->draw_mode],
                              cmd->base_index,
                              cmd->vertex_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
       }
       else
       {
@@ -346,6 +880,7 @@ dd_backend_render(dd_ctx_t* ctx)
                                       cmd->base_index,
                                       cmd->vertex_count,
                                       cmd->instance_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
       }
     }
 
@@ -354,7 +889,7 @@ dd_backend_render(dd_ctx_t* ctx)
       GLCHECK(glActiveTexture(GL_TEXTURE0));
       GLCHECK(glBindTexture(GL_TEXTURE_BUFFER, backend->line_data_texture_id));
 
-      GLCHECK(glUseProgram(backend->lines_program));
+      GLCHECK(glUseProgram(dd__gl_lines_program(backend->shared)));
 
       GLCHECK(glUniformMatrix4fv(0, 1, GL_FALSE, mvp.data));
       GLCHECK(glUniform2fv(1, 1, viewport_size.data));
@@ -367,6 +902,7 @@ dd_backend_render(dd_ctx_t* ctx)
       if (cmd->instance_count <= 0)
       {
         GLCHECK(glDrawArrays(GL_TRIANGLES, 0, 3 * cmd->vertex_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
       }
       else
       {
@@ -374,11 +910,15 @@ dd_backend_render(dd_ctx_t* ctx)
                                       0,
                                       3 * cmd->vertex_count,
                                       cmd->instance_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
       }
     }
+    DBGDRAW_TRACE_END(ctx, "dd_backend_submit");
   }
+  dd__gl_end_timers(ctx, backend);
 
   // Reset ogl state
+  if (is_scissored) { GLCHECK(glDisable(GL_SCISSOR_TEST)); }
   GLCHECK(glPolygonOffset(0.0, 0.0));
   GLCHECK(glDisable(GL_POLYGON_OFFSET_FILL));
   GLCHECK(glUseProgram(0));
@@ -392,6 +932,137 @@ dd_backend_render(dd_ctx_t* ctx)
 }
 
 #if DBGDRAW_HAS_TEXT_SUPPORT
+// Returns the layer holding a font atlas with the same contents and sets
+// 'found', otherwise returns a free layer. -1 if the pool is full. Atlases with
+// a zero hash are never matched.
+int32_t
+dd__gl_find_font_slot(dd_shared_resources_t* shared, uint64_t hash, bool* found)
+{
+  *found            = false;
+  int32_t free_slot = -1;
+  for (int32_t i = 0; i < DBGDRAW_GL_MAX_SHARED_FONTS; ++i)
+  {
+    if (!shared->font_ref_counts[i])
+    {
+      if (free_slot < 0) { free_slot = i; }
+    }
+    else if (hash && shared->font_hashes[i] == hash)
+    {
+      *found = true;
+      return i;
+    }
+  }
+  return free_slot;
+}
+
+// Grows the font array to hold an atlas of the given size in the given layer.
+// Layers in use are copied on the GPU, through a framebuffer, since the pool
+// does not keep the atlases of other contexts.
+void
+dd__gl_reserve_font_array(dd_shared_resources_t* shared,
+                          int32_t width,
+                          int32_t height,
+                          int32_t layer)
+{
+  if (width <= shared->font_array_width &&
+      height <= shared->font_array_height &&
+      layer < shared->font_array_layers)
+  {
+    return;
+  }
+
+  int32_t layers = shared->font_array_layers;
+  while (layer >= layers)
+  {
+    layers = DD_MIN(DD_MAX(2 * layers, 1), DBGDRAW_GL_MAX_SHARED_FONTS);
+  }
+  width  = DD_MAX(width, shared->font_array_width);
+  height = DD_MAX(height, shared->font_array_height);
+
+  GLuint tex = 0;
+  GLCHECK(glGenTextures(1, &tex));
+  GLCHECK(glBindTexture(GL_TEXTURE_2D_ARRAY, tex));
+  GLCHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT));
+  GLCHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT));
+  GLCHECK(
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+  GLCHECK(
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+  GLCHECK(glTexImage3D(GL_TEXTURE_2D_ARRAY,
+                       0,
+                       GL_R8,
+                       width,
+                       height,
+                       layers,
+                       0,
+                       GL_RED,
+                       GL_UNSIGNED_BYTE,
+                       NULL));
+
+  if (shared->font_array)
+  {
+    GLint prev_read_fbo = 0;
+    GLuint fbo          = 0;
+    GLCHECK(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prev_read_fbo));
+    GLCHECK(glGenFramebuffers(1, &fbo));
+    GLCHECK(glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo));
+    for (int32_t i = 0; i < shared->font_array_layers; ++i)
+    {
+      if (!shared->font_ref_counts[i]) { continue; }
+      GLCHECK(glFramebufferTextureLayer(
+        GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, shared->font_array, 0, i));
+      GLCHECK(glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                                  0,
+                                  0,
+                                  0,
+                                  i,
+                                  0,
+                                  0,
+                                  shared->font_array_width,
+                                  shared->font_array_height));
+    }
+    GLCHECK(glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)prev_read_fbo));
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &shared->font_array);
+  }
+  GLCHECK(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+  shared->font_array        = tex;
+  shared->font_array_width  = width;
+  shared->font_array_height = height;
+  shared->font_array_layers = layers;
+}
+
+void
+dd__gl_upload_font_layer(dd_shared_resources_t* shared,
+                         const uint8_t* data,
+                         int32_t width,
+                         int32_t layer,
+                         int32_t x,
+                         int32_t y,
+                         int32_t w,
+                         int32_t h)
+{
+  GLCHECK(glBindTexture(GL_TEXTURE_2D_ARRAY, shared->font_array));
+  GLCHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+  GLCHECK(glPixelStorei(GL_UNPACK_ROW_LENGTH, width));
+  GLCHECK(glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                          0,
+                          x,
+                          y,
+                          layer,
+                          w,
+                          h,
+                          1,
+                          GL_RED,
+                          GL_UNSIGNED_BYTE,
+                          data + (size_t)y * width + x));
+  GLCHECK(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+  GLCHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+  GLCHECK(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
+
+// 'tex_id' is the layer of the font. Layers are as large as the largest font,
+// smaller fonts use their top left corner.
 int32_t
 dd_backend_init_font_texture(dd_ctx_t* ctx,
                              const uint8_t* data,
@@ -401,31 +1072,280 @@ dd_backend_init_font_texture(dd_ctx_t* ctx,
 {
   assert(ctx);
   assert(ctx->render_backend);
+  dd_render_backend_t* backend  = ctx->render_backend;
+  dd_shared_resources_t* shared = backend->shared;
+  if (backend->font_count >= DBGDRAW_GL_MAX_FONTS)
+  {
+    return DBGDRAW_ERR_FONT_LIMIT_REACHED;
+  }
+
+  uint64_t hash = dd__gl_hash_bytes(14695981039346656037ULL, &width, 4);
+  hash          = dd__gl_hash_bytes(hash, &height, 4);
+  hash          = dd__gl_hash_bytes(hash, data, (size_t)width * height);
+
+  // Contexts that load the same font share its layer
+  bool found   = false;
+  int32_t slot = dd__gl_find_font_slot(shared, hash, &found);
+  if (slot < 0) { return DBGDRAW_ERR_FONT_LIMIT_REACHED; }
+  backend->font_count++;
+  shared->font_ref_counts[slot]++;
+  backend->font_refs[slot]++;
+  *tex_id = (uint32_t)slot;
+  if (found) { return DBGDRAW_ERR_OK; }
+
+  shared->font_hashes[slot] = hash;
+  dd__gl_reserve_font_array(shared, width, height, slot);
+  dd__gl_upload_font_layer(shared, data, width, slot, 0, 0, width, height);
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_backend_update_font_texture(dd_ctx_t* ctx,
+                               const uint8_t* data,
+                               int32_t width,
+                               int32_t height,
+                               int32_t x,
+                               int32_t y,
+                               int32_t w,
+                               int32_t h,
+                               uint32_t* tex_id)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend  = ctx->render_backend;
+  dd_shared_resources_t* shared = backend->shared;
+  int32_t slot                  = (int32_t)*tex_id;
+  assert(backend->font_refs[slot]);
+
+  // Every font caches different glyphs, so a layer used by other fonts is
+  // copied before it changes. Changed layers are not shared.
+  if (shared->font_ref_counts[slot] > 1)
+  {
+    bool found           = false;
+    int32_t private_slot = dd__gl_find_font_slot(shared, 0, &found);
+    if (private_slot < 0) { return DBGDRAW_ERR_FONT_LIMIT_REACHED; }
+    shared->font_ref_counts[slot]--;
+    backend->font_refs[slot]--;
+
+    slot = private_slot;
+    shared->font_ref_counts[slot]++;
+    backend->font_refs[slot]++;
+    shared->font_hashes[slot] = 0;
+    *tex_id                   = (uint32_t)slot;
+    dd__gl_reserve_font_array(shared, width, height, slot);
+    dd__gl_upload_font_layer(shared, data, width, slot, 0, 0, width, height);
+    return DBGDRAW_ERR_OK;
+  }
+  shared->font_hashes[slot] = 0;
+  dd__gl_upload_font_layer(shared, data, width, slot, x, y, w, h);
+  return DBGDRAW_ERR_OK;
+}
+#endif
+
+void
+dd__gl_delete_image_target(dd_render_backend_t* backend)
+{
+  for (int32_t i = 0; i < DBGDRAW_READBACK_RING_SIZE; ++i)
+  {
+    if (backend->readback_fences[i])
+    {
+      glDeleteSync(backend->readback_fences[i]);
+      backend->readback_fences[i] = 0;
+    }
+  }
+  glDeleteFramebuffers(1, &backend->image_fbo);
+  glDeleteRenderbuffers(1, &backend->image_color_rb);
+  glDeleteRenderbuffers(1, &backend->image_depth_rb);
+  glDeleteBuffers(DBGDRAW_READBACK_RING_SIZE, backend->readback_pbos);
+  backend->image_fbo     = 0;
+  backend->readback_head = 0;
+  backend->readback_len  = 0;
+}
+
+void
+dd__gl_create_image_target(dd_render_backend_t* backend,
+                           int32_t width,
+                           int32_t height)
+{
+  GLint prev_fbo;
+  GLCHECK(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prev_fbo));
+
+  GLCHECK(glGenRenderbuffers(1, &backend->image_color_rb));
+  GLCHECK(glGenRenderbuffers(1, &backend->image_depth_rb));
+  GLCHECK(glBindRenderbuffer(GL_RENDERBUFFER, backend->image_color_rb));
+  GLCHECK(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height));
+  GLCHECK(glBindRenderbuffer(GL_RENDERBUFFER, backend->image_depth_rb));
+  GLCHECK(
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height));
+  GLCHECK(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+  GLCHECK(glGenFramebuffers(1, &backend->image_fbo));
+  GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, backend->image_fbo));
+  GLCHECK(glFramebufferRenderbuffer(GL_FRAMEBUFFER,
+                                    GL_COLOR_ATTACHMENT0,
+                                    GL_RENDERBUFFER,
+                                    backend->image_color_rb));
+  GLCHECK(glFramebufferRenderbuffer(GL_FRAMEBUFFER,
+                                    GL_DEPTH_ATTACHMENT,
+                                    GL_RENDERBUFFER,
+                                    backend->image_depth_rb));
+  GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, prev_fbo));
+
+  GLCHECK(glGenBuffers(DBGDRAW_READBACK_RING_SIZE, backend->readback_pbos));
+  for (int32_t i = 0; i < DBGDRAW_READBACK_RING_SIZE; ++i)
+  {
+    GLCHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, backend->readback_pbos[i]));
+    GLCHECK(glBufferData(GL_PIXEL_PACK_BUFFER,
+                         (size_t)width * height * 4,
+                         NULL,
+                         GL_STREAM_READ));
+  }
+  GLCHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+  backend->image_width       = width;
+  backend->image_height      = height;
+  backend->image_frame_count = 0;
+}
+
+// Copies the oldest pending readback into the image, waiting for it if needed.
+// Rows are flipped, so that the first row of the image is the top one.
+void
+dd__gl_retire_readback(dd_render_backend_t* backend, dd_image_t* image)
+{
+  int32_t slot = (backend->readback_head - backend->readback_len +
+                  DBGDRAW_READBACK_RING_SIZE) %
+                 DBGDRAW_READBACK_RING_SIZE;
+
+  GLCHECK(glClientWaitSync(backend->readback_fences[slot],
+                           GL_SYNC_FLUSH_COMMANDS_BIT,
+                           UINT64_MAX));
+  glDeleteSync(backend->readback_fences[slot]);
+  backend->readback_fences[slot] = 0;
+
+  size_t row_size   = (size_t)backend->image_width * 4;
+  size_t image_size = row_size * backend->image_height;
+  const uint8_t* src;
+  GLCHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, backend->readback_pbos[slot]));
+  GLCHECK(src = glMapBufferRange(GL_PIXEL_PACK_BUFFER,
+                                 0,
+                                 image_size,
+                                 GL_MAP_READ_BIT));
+  for (int32_t y = 0; y < backend->image_height; ++y)
+  {
+    memcpy(image->pixels + y * row_size,
+           src + (backend->image_height - 1 - y) * row_size,
+           row_size);
+  }
+  GLCHECK(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+  GLCHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+  image->frame_idx = backend->readback_frame_idx[slot];
+  backend->readback_len--;
+}
+
+int32_t
+dd_render_to_image(dd_ctx_t* ctx, dd_image_t* image)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  assert(image);
   dd_render_backend_t* backend = ctx->render_backend;
 
-  GLCHECK(glGenTextures(1, &backend->font_tex_ids[ctx->fonts_len]));
-  GLCHECK(glBindTexture(GL_TEXTURE_2D, backend->font_tex_ids[ctx->fonts_len]));
-  GLCHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
-  GLCHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
-  GLCHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-  GLCHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-  GLCHECK(glTexImage2D(GL_TEXTURE_2D,
-                       0,
-                       GL_R8,
-                       width,
-                       height,
+  if (image->width <= 0 || image->height <= 0 || !image->pixels)
+  {
+    return DBGDRAW_ERR_INVALID_IMAGE;
+  }
+
+  // Changing the size drops frames that were not read back yet
+  if (!backend->image_fbo || backend->image_width != image->width ||
+      backend->image_height != image->height)
+  {
+    if (backend->image_fbo) { dd__gl_delete_image_target(backend); }
+    dd__gl_create_image_target(backend, image->width, image->height);
+  }
+
+  GLint prev_fbo;
+  GLint prev_viewport[4];
+  GLCHECK(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prev_fbo));
+  GLCHECK(glGetIntegerv(GL_VIEWPORT, prev_viewport));
+
+  float clear_color[4] = { image->clear_color.r / 255.0f,
+                           image->clear_color.g / 255.0f,
+                           image->clear_color.b / 255.0f,
+                           image->clear_color.a / 255.0f };
+  float clear_depth    = 1.0f;
+  GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, backend->image_fbo));
+  GLCHECK(glViewport(0, 0, image->width, image->height));
+  GLCHECK(glClearBufferfv(GL_COLOR, 0, clear_color));
+  GLCHECK(glClearBufferfv(GL_DEPTH, 0, &clear_depth));
+
+  int32_t error = dd_render(ctx);
+
+  // Ring is full - the oldest frame has to be read back before it is reused
+  image->frame_idx = -1;
+  if (backend->readback_len == DBGDRAW_READBACK_RING_SIZE)
+  {
+    dd__gl_retire_readback(backend, image);
+  }
+
+  int32_t slot = backend->readback_head;
+  GLCHECK(glReadBuffer(GL_COLOR_ATTACHMENT0));
+  GLCHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, backend->readback_pbos[slot]));
+  GLCHECK(glReadPixels(0,
                        0,
-                       GL_RED,
+                       image->width,
+                       image->height,
+                       GL_RGBA,
                        GL_UNSIGNED_BYTE,
-                       data));
+                       NULL));
+  GLCHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+  backend->readback_fences[slot] =
+    glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  backend->readback_frame_idx[slot] = backend->image_frame_count++;
+  backend->readback_head = (slot + 1) % DBGDRAW_READBACK_RING_SIZE;
+  backend->readback_len++;
+
+  // Otherwise only return the oldest frame if the gpu is already done with it
+  if (image->frame_idx < 0)
+  {
+    int32_t oldest = (backend->readback_head - backend->readback_len +
+                      DBGDRAW_READBACK_RING_SIZE) %
+                     DBGDRAW_READBACK_RING_SIZE;
+    GLenum status  = glClientWaitSync(backend->readback_fences[oldest], 0, 0);
+    if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+    {
+      dd__gl_retire_readback(backend, image);
+    }
+  }
+
+  GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, prev_fbo));
+  GLCHECK(glViewport(prev_viewport[0],
+                     prev_viewport[1],
+                     prev_viewport[2],
+                     prev_viewport[3]));
 
-  *tex_id = backend->font_tex_ids[ctx->fonts_len];
-  backend->font_tex_attrib_loc =
-    glGetUniformLocation(backend->base_program, "tex");
-  GLCHECK(glBindTexture(GL_TEXTURE_2D, 0));
+  return error;
+}
+
+int32_t
+dd_flush_image(dd_ctx_t* ctx, dd_image_t* image)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  assert(image);
+  dd_render_backend_t* backend = ctx->render_backend;
+
+  image->frame_idx = -1;
+  if (!backend->readback_len) { return DBGDRAW_ERR_OK; }
+  if (image->width != backend->image_width ||
+      image->height != backend->image_height || !image->pixels)
+  {
+    return DBGDRAW_ERR_INVALID_IMAGE;
+  }
+
+  dd__gl_retire_readback(backend, image);
   return DBGDRAW_ERR_OK;
 }
-#endif
 
 int32_t
 dd_backend_term(dd_ctx_t* ctx)
@@ -436,14 +1356,42 @@ dd_backend_term(dd_ctx_t* ctx)
 
   glDeleteVertexArrays(1, &backend->vao);
   glDeleteBuffers(1, &backend->vbo);
-  glDeleteProgram(backend->base_program);
-  glDeleteProgram(backend->lines_program);
-#if DBGDRAW_HAS_TEXT_SUPPORT
-  for (int32_t i = 0; i < ctx->fonts_len; ++i)
+  glDeleteBuffers(1, &backend->impostor_buffer);
+  glDeleteTextures(1, &backend->impostor_data_texture_id);
+  glDeleteBuffers(1, &backend->glyph_buffer);
+  glDeleteTextures(1, &backend->glyph_data_texture_id);
+  glDeleteBuffers(1, &backend->anchor_buffer);
+  glDeleteTextures(1, &backend->anchor_data_texture_id);
+  if (backend->timer_queries[0][0])
   {
-    glDeleteTextures(1, &backend->font_tex_ids[i]);
+    glDeleteQueries(DBGDRAW_TIMER_FRAMES * DBGDRAW_MAX_TIMER_QUERIES,
+                    &backend->timer_queries[0][0]);
+    memset(backend->timer_queries, 0, sizeof(backend->timer_queries));
+    memset(backend->timer_query_count, 0, sizeof(backend->timer_query_count));
   }
-#endif
+  if (backend->image_fbo) { dd__gl_delete_image_target(backend); }
+
+  dd_shared_resources_t* shared = backend->shared;
+  for (int32_t i = 0; i < DBGDRAW_GL_MAX_SHARED_FONTS; ++i)
+  {
+    shared->font_ref_counts[i] -= backend->font_refs[i];
+  }
+
+  // Programs and fonts go with the last context that uses them
+  if (--shared->ref_count == 0)
+  {
+    glDeleteTextures(1, &shared->font_array);
+    glDeleteProgram(shared->base_program);
+    glDeleteProgram(shared->lines_program);
+    glDeleteProgram(shared->impostor_program);
+    glDeleteProgram(shared->glyph_program);
+    bool owned = shared->owned;
+    memset(shared, 0, sizeof(dd_shared_resources_t));
+    if (owned) { free(shared); }
+  }
+
+  free(backend);
+  ctx->render_backend = NULL;
   return DBGDRAW_ERR_OK;
 }
 
@@ -490,7 +1438,8 @@ dd__init_base_shaders_source(const char** vert_shdr_src,
   *frag_shdr_src =
     DBGDRAW_SHADER_HEADER
     DBGDRAW_STRINGIFY(
-      uniform sampler2D tex;
+      uniform sampler2DArray tex;
+      layout(location = 10) uniform vec4 u_fonts[16];
 
       layout(location = 0) in vec4 v_color;
       layout(location = 1) in vec3 v_uv_or_normal;
@@ -511,7 +1460,16 @@ dd__init_base_shaders_source(const char** vert_shdr_src,
         }
         else
         {
-          float texture_val = texture(tex, vec2(v_uv_or_normal)).r;
+          // Size relative to the layers, distance field flag and layer
+          vec4 font = u_fonts[int(v_uv_or_normal.z + 0.5)];
+          vec3 uv = vec3(v_uv_or_normal.xy * font.xy, font.w);
+          float texture_val = texture(tex, uv).r;
+          if (font.z > 0.0)
+          {
+            // Outline is at 128 / 255, antialiased over about a pixel
+            float width = 0.7 * fwidth(texture_val);
+            texture_val = smoothstep(0.502 - width, 0.502 + width, texture_val);
+          }
           float alpha = clamp(v_color.a * texture_val, 0.0, 1.0);
           frag_color = vec4(v_color.rgb, alpha);
         }
@@ -752,4 +1710,248 @@ dd__init_line_shaders_source(const char** vert_shdr_src,
   // clang-format on
 }
 
+void
+dd__init_impostor_shaders_source(const char** vert_shdr_src,
+                                 const char** frag_shdr_src)
+{
+  // clang-format off
+  *vert_shdr_src =
+    DBGDRAW_SHADER_HEADER
+    DBGDRAW_STRINGIFY(
+      layout(location = 1) uniform int shading_type;
+      layout(location = 3) uniform int u_procedural_base;
+      layout(location = 7) uniform mat4 u_model_view;
+      layout(location = 8) uniform mat4 u_proj;
+
+      layout(location = 4) uniform samplerBuffer u_prims;
+
+      layout(location = 0) out vec4 v_color;
+      layout(location = 1) out vec3 v_view_pos;
+      layout(location = 2) out flat int v_shading_type;
+      layout(location = 3) out flat int v_type;
+      layout(location = 4) out flat vec4 v_a_and_radius;
+      layout(location = 5) out flat vec4 v_b_and_extent;
+
+      const uint IMPOSTOR_SPHERE = 4u;
+      const uint IMPOSTOR_CAPSULE = 5u;
+
+      void main() {
+        // Each record spans three texels, see dd_procedural_prim_t
+        int record_idx = 3 * (u_procedural_base + gl_InstanceID);
+        vec4 center_and_radius_a = texelFetch(u_prims, record_idx + 0);
+        vec4 axis_and_radius_b = texelFetch(u_prims, record_idx + 1);
+        uvec4 color_type_and_detail = floatBitsToUint(texelFetch(u_prims, record_idx + 2));
+        uint type = color_type_and_detail.y;
+
+        // Non-impostor records, and spheres in commands that also contain boxes,
+        // collapse their triangles to a single point
+        int vertex_count = (type == IMPOSTOR_SPHERE) ? 6 : 36;
+        if (type < IMPOSTOR_SPHERE || gl_VertexID >= vertex_count)
+        {
+          v_color = vec4(0.0);
+          v_view_pos = vec3(0.0);
+          v_shading_type = shading_type;
+          v_type = 0;
+          v_a_and_radius = vec4(0.0);
+          v_b_and_extent = vec4(0.0);
+          gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+          return;
+        }
+
+        // Ray-casting happens in view space. Transform is assumed to have uniform scale.
+        float scale = length(u_model_view[0].xyz);
+        vec3 a = vec3(u_model_view * vec4(center_and_radius_a.xyz, 1.0));
+        vec3 b = a + mat3(u_model_view) * axis_and_radius_b.xyz;
+        float r = center_and_radius_a.w * scale;
+
+        vec3 position;
+        if (type == IMPOSTOR_SPHERE)
+        {
+          // Quad perpendicular to the direction towards the eye, placed at the
+          // near side of the sphere, always covers its silhouette.
+          vec3 n = (u_proj[3][3] == 1.0) ? vec3(0.0, 0.0, 1.0) : normalize(-a);
+          vec3 t = normalize(cross(n, (abs(n.x) > 0.9) ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0)));
+          vec3 bt = cross(n, t);
+          vec2 corners[6] = vec2[6](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+                                    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+          vec2 corner = corners[gl_VertexID];
+          position = a + r * (n + corner.x * t + corner.y * bt);
+        }
+        else
+        {
+          // Box aligned with the segment, extended by the radius for capsules.
+          int indices[36] = int[36](0, 4, 6, 0, 6, 2, 1, 3, 7, 1, 7, 5,
+                                    0, 1, 5, 0, 5, 4, 2, 6, 7, 2, 7, 3,
+                                    0, 2, 3, 0, 3, 1, 4, 5, 7, 4, 7, 6);
+          int idx = indices[gl_VertexID];
+          vec3 corner = vec3(ivec3(idx & 1, (idx >> 1) & 1, (idx >> 2) & 1)) * 2.0 - 1.0;
+          vec3 axis = b - a;
+          float half_length = 0.5 * length(axis);
+          vec3 n = axis / (2.0 * half_length);
+          vec3 t = normalize(cross(n, (abs(n.x) > 0.9) ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0)));
+          vec3 bt = cross(n, t);
+          float extent = half_length + ((type == IMPOSTOR_CAPSULE) ? r : 0.0);
+          position = 0.5 * (a + b) + r * (corner.x * t + corner.y * bt) + extent * corner.z * n;
+        }
+
+        v_color = unpackUnorm4x8(color_type_and_detail.x);
+        v_view_pos = position;
+        v_shading_type = shading_type;
+        v_type = int(type);
+        v_a_and_radius = vec4(a, r);
+        v_b_and_extent = vec4(b, length(b - a) + 2.0 * r);
+        gl_Position = u_proj * vec4(position, 1.0);
+      });
+
+  *frag_shdr_src =
+    DBGDRAW_SHADER_HEADER
+    DBGDRAW_STRINGIFY(
+      layout(location = 8) uniform mat4 u_proj;
+
+      layout(location = 0) in vec4 v_color;
+      layout(location = 1) in vec3 v_view_pos;
+      layout(location = 2) in flat int v_shading_type;
+      layout(location = 3) in flat int v_type;
+      layout(location = 4) in flat vec4 v_a_and_radius;
+      layout(location = 5) in flat vec4 v_b_and_extent;
+
+      layout(location = 0) out vec4 frag_color;
+
+      const int IMPOSTOR_SPHERE = 4;
+      const int IMPOSTOR_CAPSULE = 5;
+
+      // Ray-surface intersections return the distance along the ray in x, and
+      // the outward normal in yzw. Negative distance means a miss.
+      vec4 sphere_intersect(vec3 ro, vec3 rd, vec3 c, float r) {
+        vec3 oc = ro - c;
+        float b = dot(oc, rd);
+        float h = b * b - dot(oc, oc) + r * r;
+        if (h < 0.0) { return vec4(-1.0); }
+        float t = -b - sqrt(h);
+        return vec4(t, (oc + t * rd) / r);
+      }
+
+      vec4 capsule_intersect(vec3 ro, vec3 rd, vec3 pa, vec3 pb, float r) {
+        vec3 ba = pb - pa;
+        vec3 oa = ro - pa;
+        float baba = dot(ba, ba);
+        float bard = dot(ba, rd);
+        float baoa = dot(ba, oa);
+        float k2 = baba - bard * bard;
+        float k1 = baba * dot(oa, rd) - baoa * bard;
+        float k0 = baba * dot(oa, oa) - baoa * baoa - r * r * baba;
+        float h = k1 * k1 - k2 * k0;
+        if (h < 0.0) { return vec4(-1.0); }
+        float t = (-k1 - sqrt(h)) / k2;
+        float y = baoa + t * bard;
+        if (y > 0.0 && y < baba) { return vec4(t, (oa + t * rd - ba * y / baba) / r); }
+        return sphere_intersect(ro, rd, (y <= 0.0) ? pa : pb, r);
+      }
+
+      vec4 cylinder_intersect(vec3 ro, vec3 rd, vec3 pa, vec3 pb, float r) {
+        vec3 ba = pb - pa;
+        vec3 oa = ro - pa;
+        float baba = dot(ba, ba);
+        float bard = dot(ba, rd);
+        float baoa = dot(ba, oa);
+        float k2 = baba - bard * bard;
+        float k1 = baba * dot(oa, rd) - baoa * bard;
+        float k0 = baba * dot(oa, oa) - baoa * baoa - r * r * baba;
+        float h = k1 * k1 - k2 * k0;
+        if (h < 0.0) { return vec4(-1.0); }
+        h = sqrt(h);
+        float t = (-k1 - h) / k2;
+        float y = baoa + t * bard;
+        if (y > 0.0 && y < baba) { return vec4(t, (oa + t * rd - ba * y / baba) / r); }
+        t = (((y < 0.0) ? 0.0 : baba) - baoa) / bard;
+        if (abs(k1 + k2 * t) < h) { return vec4(t, ba * sign(y) / sqrt(baba)); }
+        return vec4(-1.0);
+      }
+
+      void main() {
+        // Rays start behind the proxy geometry, so that they always begin
+        // outside of the shape.
+        vec3 rd = (u_proj[3][3] == 1.0) ? vec3(0.0, 0.0, -1.0) : normalize(v_view_pos);
+        vec3 ro = v_view_pos - v_b_and_extent.w * rd;
+        vec3 pa = v_a_and_radius.xyz;
+        vec3 pb = v_b_and_extent.xyz;
+        float r = v_a_and_radius.w;
+
+        vec4 hit;
+        if (v_type == IMPOSTOR_SPHERE)       { hit = sphere_intersect(ro, rd, pa, r); }
+        else if (v_type == IMPOSTOR_CAPSULE) { hit = capsule_intersect(ro, rd, pa, pb, r); }
+        else                                 { hit = cylinder_intersect(ro, rd, pa, pb, r); }
+        if (hit.x < 0.0) { discard; }
+
+        vec4 clip_pos = u_proj * vec4(ro + hit.x * rd, 1.0);
+        float ndc_depth = clip_pos.z / clip_pos.w;
+        gl_FragDepth = 0.5 * (gl_DepthRange.diff * ndc_depth + gl_DepthRange.near + gl_DepthRange.far);
+
+        if (v_shading_type == 1)
+        {
+          // Same lighting as the mesh path, which uses inward facing normals.
+          vec3 normal = vec3(u_proj * vec4(-hit.yzw, 0.0));
+          vec3 light_dir = vec3(0, 0, 1);
+          float ndotl = dot(normal, light_dir);
+          frag_color = vec4(v_color.rgb * ndotl, v_color.a);
+        }
+        else
+        {
+          frag_color = v_color;
+        }
+      });
+  // clang-format on
+}
+
+void
+dd__init_glyph_shaders_source(const char** vert_shdr_src,
+                              const char** frag_shdr_src)
+{
+  const char* base_vert_shdr_src = NULL;
+  dd__init_base_shaders_source(&base_vert_shdr_src, frag_shdr_src);
+
+  // clang-format off
+  *vert_shdr_src =
+    DBGDRAW_SHADER_HEADER
+    DBGDRAW_STRINGIFY(
+      layout(location = 0) uniform mat4 u_mvp;
+      layout(location = 1) uniform int shading_type;
+      layout(location = 3) uniform int u_glyph_base;
+
+      layout(location = 4) uniform usamplerBuffer u_glyphs;
+      layout(location = 5) uniform samplerBuffer u_anchors;
+
+      layout(location = 0) out vec4 v_color;
+      layout(location = 1) out vec3 v_uv_or_normal;
+      layout(location = 2) out flat int v_shading_type;
+
+      void main() {
+        // Each glyph spans three texels and each anchor four, see
+        // dd_glyph_instance_t and dd_text_anchor_t
+        int glyph_idx = 3 * (u_glyph_base + gl_InstanceID);
+        vec2 glyph_pos = uintBitsToFloat(texelFetch(u_glyphs, glyph_idx + 0).xy);
+        uvec2 rect = texelFetch(u_glyphs, glyph_idx + 1).xy;
+        uvec2 anchor_and_color = texelFetch(u_glyphs, glyph_idx + 2).xy;
+        int anchor_idx = 4 * int(anchor_and_color.x);
+        vec3 origin = texelFetch(u_anchors, anchor_idx + 0).xyz;
+        vec3 axis_x = texelFetch(u_anchors, anchor_idx + 1).xyz;
+        vec3 axis_y = texelFetch(u_anchors, anchor_idx + 2).xyz;
+        vec4 atlas = texelFetch(u_anchors, anchor_idx + 3);
+
+        vec2 corners[6] = vec2[6](vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(1.0, 0.0),
+                                  vec2(0.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 1.0));
+        vec2 corner = corners[gl_VertexID];
+        vec2 st0 = vec2(rect.x & 0xFFFFu, rect.x >> 16u);
+        vec2 st1 = vec2(rect.y & 0xFFFFu, rect.y >> 16u);
+        vec2 st = mix(st0, st1, corner);
+        vec2 pos = glyph_pos + (st - st0) * atlas.z;
+
+        v_color = unpackUnorm4x8(anchor_and_color.y);
+        v_uv_or_normal = vec3(st * atlas.xy, atlas.w);
+        v_shading_type = shading_type;
+        gl_Position = u_mvp * vec4(origin + pos.x * axis_x + pos.y * axis_y, 1.0);
+      });
+  // clang-format on
+}
+
 #endif
@@ -1,21 +1,156 @@
 #ifndef DBGDRAW_OPENGL45_H
 #define DBGDRAW_OPENGL45_H
 
+#include <stddef.h>
+
+// Number of frames that can be in flight when rendering to image.
+#ifndef DBGDRAW_READBACK_RING_SIZE
+#define DBGDRAW_READBACK_RING_SIZE 3
+#endif
+
+// GPU timings are read back after at most this many frames.
+#ifndef DBGDRAW_TIMER_FRAMES
+#define DBGDRAW_TIMER_FRAMES 4
+#endif
+
+// Upper bound on (mode, shading) changes timed per frame; later commands are
+// attributed to the last timed bucket.
+#ifndef DBGDRAW_MAX_TIMER_QUERIES
+#define DBGDRAW_MAX_TIMER_QUERIES 32
+#endif
+
+// Define DBGDRAW_PROGRAM_CACHE_DIR to a writable directory to store linked
+// programs there, and skip shader compilation on later runs.
+
+typedef struct dd_gl_program
+{
+  GLuint id;
+  const char* vert_src;
+  const char* frag_src;
+  const char* comp_src;
+  uint64_t hash;
+  bool from_binary;
+  bool ready;
+} dd_gl_program_t;
+
+// Fonts of a context are described to the base shader by an array of this size,
+// so it is not configurable.
+#define DBGDRAW_GL_MAX_FONTS 16
+
+// Upper bound on distinct font atlases, the layers of the font texture array
+// in dd_shared_resources_t.
+#ifndef DBGDRAW_GL_MAX_SHARED_FONTS
+#define DBGDRAW_GL_MAX_SHARED_FONTS 64
+#endif
+
+// Programs and font atlases do not depend on the context they are used with.
+// Contexts initialized with the same 'shared_resources' in dd_ctx_desc_t
+// compile (or load from the binary cache) the programs once and upload each
+// distinct font atlas once, as a layer of one texture array, while buffers,
+// vertex arrays and offscreen targets stay per context. Their GL contexts have
+// to be the same or in one share group. Zero-initialize the pool before the
+// first dd_init; GL objects are deleted when the last context using them is
+// terminated. Without a pool, every context gets a private one.
+typedef struct dd_shared_resources
+{
+  dd_gl_program_t base_program;
+  dd_gl_program_t lines_program;
+  dd_gl_program_t procedural_program;
+  dd_gl_program_t impostor_program;
+  dd_gl_program_t glyph_program;
+  dd_gl_program_t cull_program;
+  bool parallel_compile;
+  bool binary_cache;
+  uint64_t driver_hash;
+  GLuint font_tex_attrib_loc;
+
+  GLuint font_array;
+  int32_t font_array_width;
+  int32_t font_array_height;
+  int32_t font_array_layers;
+  uint64_t font_hashes[DBGDRAW_GL_MAX_SHARED_FONTS];
+  int32_t font_ref_counts[DBGDRAW_GL_MAX_SHARED_FONTS];
+
+  int32_t ref_count;
+  bool owned;
+} dd_shared_resources_t;
+
 typedef struct dd_render_backend
 {
-  GLuint base_program;
-  GLuint lines_program;
+  dd_shared_resources_t* shared;
+  int32_t font_refs[DBGDRAW_GL_MAX_SHARED_FONTS];
+
   GLuint vao;
   GLuint vbo;
   GLuint ibo;
-  GLuint font_tex_attrib_loc;
-  GLuint font_tex_ids[16];
+  GLuint procedural_ssbo;
+  GLuint glyph_ssbo;
+  GLuint anchor_ssbo;
+  GLuint culled_ibo;
+  GLuint indirect_buffer;
+  GLuint cull_group_buffer;
 
   GLuint line_data_texture_id;
+  int32_t font_count;
   size_t vbo_size;
   size_t ibo_size;
+  size_t procedural_ssbo_size;
+  size_t glyph_ssbo_size;
+  size_t anchor_ssbo_size;
+  size_t culled_ibo_size;
+  size_t indirect_buffer_size;
+  size_t cull_group_buffer_size;
+  int32_t culled_cmd_count;
+  int32_t culled_instance_count;
+  int32_t cull_group_count;
+
+  GLuint image_fbo;
+  GLuint image_color_rb;
+  GLuint image_depth_rb;
+  GLuint readback_pbos[DBGDRAW_READBACK_RING_SIZE];
+  GLsync readback_fences[DBGDRAW_READBACK_RING_SIZE];
+  int32_t readback_frame_idx[DBGDRAW_READBACK_RING_SIZE];
+  int32_t readback_head;
+  int32_t readback_len;
+  int32_t image_frame_count;
+  int32_t image_width;
+  int32_t image_height;
+
+  GLuint timer_queries[DBGDRAW_TIMER_FRAMES][DBGDRAW_MAX_TIMER_QUERIES];
+  uint8_t timer_buckets[DBGDRAW_TIMER_FRAMES][DBGDRAW_MAX_TIMER_QUERIES];
+  int32_t timer_query_count[DBGDRAW_TIMER_FRAMES];
+  int32_t timer_frame_idx[DBGDRAW_TIMER_FRAMES];
+  int32_t timer_frame_count;
+  int32_t timer_slot;
+  int32_t timer_bucket;
 } dd_render_backend_t;
 
+// Offscreen rendering. The frame is rendered into an offscreen target of the
+// requested size and read back asynchronously, through a ring of pixel buffers.
+// 'pixels' must hold width * height * 4 bytes (RGBA, top row first). On return
+// 'frame_idx' is the index of the frame that was written to 'pixels', or -1 if
+// no frame was ready yet. Use dd_flush_image to read back remaining frames.
+typedef struct dd_image
+{
+  int32_t width;
+  int32_t height;
+  dd_color_t clear_color;
+  uint8_t* pixels;
+  int32_t frame_idx;
+} dd_image_t;
+
+int32_t dd_render_to_image(dd_ctx_t* ctx, dd_image_t* image);
+int32_t dd_flush_image(dd_ctx_t* ctx, dd_image_t* image);
+
+// Instanced commands with at least this many instances are frustum culled in a
+// compute shader, provided that frustum culling is enabled.
+#ifndef DBGDRAW_GPU_CULL_MIN_INSTANCES
+#define DBGDRAW_GPU_CULL_MIN_INSTANCES 1024
+#endif
+
+// Instances tested by one workgroup of the cull shader, its local_size_x
+#define DD_GL_CULL_GROUP_SIZE 256
+
 void
 dd__gl_check(const char* filename, uint32_t lineno)
 {
@@ -70,48 +205,184 @@ dd__check_gl_shader_status(GLuint shader_id, bool report_error)
   return 0;
 }
 
-GLuint
-dd__gl_compile_shader_src(GLuint shader_type, const char* shader_src)
+uint64_t
+dd__gl_hash(uint64_t hash, const char* str)
 {
-  const GLuint shader = glCreateShader(shader_type);
-  glShaderSource(shader, 1, &shader_src, NULL);
-  glCompileShader(shader);
-  int32_t error = dd__check_gl_shader_status(shader, true);
-  if (error) { exit(-1); }
-  return shader;
+  // FNV-1a
+  while (str && *str) { hash = (hash ^ (uint8_t)*str++) * 1099511628211ULL; }
+  return hash;
 }
 
-GLuint
-dd__gl_link_program(GLuint vertex_shader,
-                    GLuint geometry_shader,
-                    GLuint fragment_shader)
+uint64_t
+dd__gl_hash_bytes(uint64_t hash, const void* data, size_t size)
+{
+  // FNV-1a, identifies font atlases that are already uploaded
+  const uint8_t* bytes = (const uint8_t*)data;
+  for (size_t i = 0; i < size; ++i)
+  {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+#ifdef DBGDRAW_PROGRAM_CACHE_DIR
+typedef struct dd_gl_program_binary_header
+{
+  uint32_t magic;
+  uint32_t format;
+  uint32_t length;
+} dd_gl_program_binary_header_t;
+
+void
+dd__gl_program_binary_path(dd_gl_program_t* program, char* path, size_t size)
+{
+  snprintf(path,
+           size,
+           "%s/dbgdraw_%016llx.bin",
+           DBGDRAW_PROGRAM_CACHE_DIR,
+           (unsigned long long)program->hash);
+}
+
+bool
+dd__gl_load_program_binary(dd_gl_program_t* program)
+{
+  char path[512];
+  dd__gl_program_binary_path(program, path, sizeof(path));
+  FILE* fp = fopen(path, "rb");
+  if (!fp) { return false; }
+
+  bool loaded = false;
+  dd_gl_program_binary_header_t header;
+  if (fread(&header, sizeof(header), 1, fp) == 1 && header.magic == 0x42504444)
+  {
+    void* binary = malloc(header.length);
+    if (binary && fread(binary, header.length, 1, fp) == 1)
+    {
+      glProgramBinary(program->id, header.format, binary, header.length);
+      loaded = (glGetError() == GL_NO_ERROR);
+    }
+    free(binary);
+  }
+  fclose(fp);
+  return loaded;
+}
+
+void
+dd__gl_store_program_binary(dd_gl_program_t* program)
+{
+  GLint length = 0;
+  glGetProgramiv(program->id, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) { return; }
+
+  void* binary = malloc(length);
+  if (!binary) { return; }
+
+  GLenum format = 0;
+  glGetProgramBinary(program->id, length, &length, &format, binary);
+
+  char path[512];
+  dd__gl_program_binary_path(program, path, sizeof(path));
+  FILE* fp = fopen(path, "wb");
+  if (fp)
+  {
+    dd_gl_program_binary_header_t header = { 0x42504444, format, length };
+    fwrite(&header, sizeof(header), 1, fp);
+    fwrite(binary, length, 1, fp);
+    fclose(fp);
+  }
+  free(binary);
+}
+#endif
+
+// Compilation and linking are only issued here, errors are checked in
+// dd__gl_finish_program, so that drivers can compile in the background.
+void
+dd__gl_link_program_src(dd_shared_resources_t* shared, dd_gl_program_t* program)
+{
+  GLenum stages[3]       = { GL_VERTEX_SHADER,
+                             GL_FRAGMENT_SHADER,
+                             GL_COMPUTE_SHADER };
+  const char* sources[3] = { program->vert_src,
+                             program->frag_src,
+                             program->comp_src };
+  for (int32_t i = 0; i < 3; ++i)
+  {
+    if (!sources[i]) { continue; }
+    GLuint shader = glCreateShader(stages[i]);
+    glShaderSource(shader, 1, &sources[i], NULL);
+    glCompileShader(shader);
+    glAttachShader(program->id, shader);
+    glDeleteShader(shader);
+  }
+
+  if (shared->binary_cache)
+  {
+    glProgramParameteri(program->id,
+                        GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                        GL_TRUE);
+  }
+  glLinkProgram(program->id);
+}
+
+void
+dd__gl_start_program(dd_shared_resources_t* shared, dd_gl_program_t* program)
 {
-  GLuint program = glCreateProgram();
+  program->hash = dd__gl_hash(shared->driver_hash, program->vert_src);
+  program->hash = dd__gl_hash(program->hash, program->frag_src);
+  program->hash = dd__gl_hash(program->hash, program->comp_src);
+  program->id   = glCreateProgram();
 
-  if (vertex_shader) { glAttachShader(program, vertex_shader); }
-  if (geometry_shader) { glAttachShader(program, geometry_shader); }
-  if (fragment_shader) { glAttachShader(program, fragment_shader); }
+#ifdef DBGDRAW_PROGRAM_CACHE_DIR
+  if (shared->binary_cache && dd__gl_load_program_binary(program))
+  {
+    program->from_binary = true;
+    return;
+  }
+#endif
+  dd__gl_link_program_src(shared, program);
+}
 
-  glLinkProgram(program);
+void
+dd__gl_finish_program(dd_shared_resources_t* shared, dd_gl_program_t* program)
+{
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program->id, GL_LINK_STATUS, &linked);
 
-  if (vertex_shader)
+  // Binary might have been rejected, e.g. after a driver update
+  if (!linked && program->from_binary)
   {
-    glDetachShader(program, vertex_shader);
-    glDeleteShader(vertex_shader);
+    glDeleteProgram(program->id);
+    program->id          = glCreateProgram();
+    program->from_binary = false;
+    dd__gl_link_program_src(shared, program);
+    glGetProgramiv(program->id, GL_LINK_STATUS, &linked);
   }
-  if (geometry_shader)
+
+  GLuint shaders[3];
+  GLsizei shader_count = 0;
+  glGetAttachedShaders(program->id, 3, &shader_count, shaders);
+  for (int32_t i = 0; i < shader_count; ++i)
   {
-    glDetachShader(program, geometry_shader);
-    glDeleteShader(geometry_shader);
+    if (!linked) { dd__check_gl_shader_status(shaders[i], true); }
+    glDetachShader(program->id, shaders[i]);
   }
-  if (fragment_shader)
+  if (dd__check_gl_program_status(program->id, true)) { exit(-1); }
+
+#ifdef DBGDRAW_PROGRAM_CACHE_DIR
+  if (shared->binary_cache && !program->from_binary)
   {
-    glDetachShader(program, fragment_shader);
-    glDeleteShader(fragment_shader);
+    dd__gl_store_program_binary(program);
   }
+#endif
+  program->ready = true;
+}
 
-  dd__check_gl_program_status(program, true);
-  return program;
+GLuint
+dd__gl_program_id(dd_shared_resources_t* shared, dd_gl_program_t* program)
+{
+  if (!program->id) { dd__gl_start_program(shared, program); }
+  if (!program->ready) { dd__gl_finish_program(shared, program); }
+  return program->id;
 }
 
 #define DBGDRAW_SHADER_HEADER "#version 450 core\n"
@@ -121,136 +392,489 @@ void dd__init_base_shaders_source(const char** vert_shdr,
                                   const char** frag_shdr_src);
 void dd__init_line_shaders_source(const char** vert_shdr_src,
                                   const char** frag_shdr_src);
+void dd__init_procedural_shaders_source(const char** vert_shdr_src);
+void dd__init_impostor_shaders_source(const char** vert_shdr_src,
+                                      const char** frag_shdr_src);
+void dd__init_glyph_shaders_source(const char** vert_shdr_src);
+void dd__init_cull_shader_source(const char** comp_shdr_src);
 
-int32_t
-dd_backend_init(dd_ctx_t* ctx)
+// Called by the first context that uses the pool
+void
+dd__gl_init_shared_resources(dd_shared_resources_t* shared)
 {
-  static dd_render_backend_t backend = {0};
-  ctx->render_backend                = &backend;
+  dd__init_base_shaders_source(&shared->base_program.vert_src,
+                               &shared->base_program.frag_src);
+  dd__init_line_shaders_source(&shared->lines_program.vert_src,
+                               &shared->lines_program.frag_src);
+  dd__init_procedural_shaders_source(&shared->procedural_program.vert_src);
+  shared->procedural_program.frag_src = shared->base_program.frag_src;
+  dd__init_impostor_shaders_source(&shared->impostor_program.vert_src,
+                                   &shared->impostor_program.frag_src);
+  dd__init_glyph_shaders_source(&shared->glyph_program.vert_src);
+  shared->glyph_program.frag_src = shared->base_program.frag_src;
+  dd__init_cull_shader_source(&shared->cull_program.comp_src);
+
+  shared->driver_hash = dd__gl_hash(1469598103934665603ULL,
+                                   (const char*)glGetString(GL_VENDOR));
+  shared->driver_hash = dd__gl_hash(shared->driver_hash,
+                                   (const char*)glGetString(GL_RENDERER));
+  shared->driver_hash = dd__gl_hash(shared->driver_hash,
+                                   (const char*)glGetString(GL_VERSION));
+
+#ifdef DBGDRAW_PROGRAM_CACHE_DIR
+  GLint binary_format_count = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_format_count);
+  shared->binary_cache = (binary_format_count > 0);
+#endif
 
-  const char* base_vert_shdr_src = NULL;
-  const char* base_frag_shdr_src = NULL;
-  dd__init_base_shaders_source(&base_vert_shdr_src, &base_frag_shdr_src);
+  GLint extension_count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+  for (GLint i = 0; i < extension_count; ++i)
+  {
+    const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+    if (!strcmp(ext, "GL_KHR_parallel_shader_compile") ||
+        !strcmp(ext, "GL_ARB_parallel_shader_compile"))
+    {
+      shared->parallel_compile = true;
+    }
+  }
 
-  GLuint vertex_shader =
-    dd__gl_compile_shader_src(GL_VERTEX_SHADER, base_vert_shdr_src);
-  GLuint fragment_shader =
-    dd__gl_compile_shader_src(GL_FRAGMENT_SHADER, base_frag_shdr_src);
-  backend.base_program = dd__gl_link_program(vertex_shader, 0, fragment_shader);
+  // Only the base program is needed right away, for attribute locations.
+  // Remaining programs are built on first use. If the driver compiles in
+  // parallel, they are submitted now and finished in background.
+  dd__gl_program_id(shared, &shared->base_program);
+  if (shared->parallel_compile)
+  {
+    dd__gl_start_program(shared, &shared->lines_program);
+    dd__gl_start_program(shared, &shared->procedural_program);
+    dd__gl_start_program(shared, &shared->impostor_program);
+    dd__gl_start_program(shared, &shared->glyph_program);
+    dd__gl_start_program(shared, &shared->cull_program);
+  }
+  shared->font_tex_attrib_loc =
+    glGetUniformLocation(shared->base_program.id, "tex");
+}
 
-  const char* line_vert_shdr_src = NULL;
-  const char* line_frag_shdr_src = NULL;
-  dd__init_line_shaders_source(&line_vert_shdr_src, &line_frag_shdr_src);
+int32_t
+dd_backend_init(dd_ctx_t* ctx)
+{
+  dd_shared_resources_t* shared = ctx->shared_resources;
+  if (!shared)
+  {
+    shared = calloc(1, sizeof(dd_shared_resources_t));
+    if (!shared) { return DBGDRAW_ERR_FAILED_ALLOC; }
+    shared->owned = true;
+  }
 
-  GLuint vertex_shader2 =
-    dd__gl_compile_shader_src(GL_VERTEX_SHADER, line_vert_shdr_src);
-  GLuint fragment_shader2 =
-    dd__gl_compile_shader_src(GL_FRAGMENT_SHADER, line_frag_shdr_src);
-  backend.lines_program =
-    dd__gl_link_program(vertex_shader2, 0, fragment_shader2);
+  dd_render_backend_t* backend = calloc(1, sizeof(dd_render_backend_t));
+  if (!backend)
+  {
+    if (shared->owned) { free(shared); }
+    return DBGDRAW_ERR_FAILED_ALLOC;
+  }
+  ctx->render_backend = backend;
+  backend->shared     = shared;
+  if (!shared->ref_count++) { dd__gl_init_shared_resources(shared); }
 
-  GLCHECK(glCreateVertexArrays(1, &backend.vao));
+  GLCHECK(glCreateVertexArrays(1, &backend->vao));
 
-  GLCHECK(glCreateBuffers(1, &backend.vbo));
-  GLCHECK(glCreateBuffers(1, &backend.ibo));
+  GLCHECK(glCreateBuffers(1, &backend->vbo));
+  GLCHECK(glCreateBuffers(1, &backend->ibo));
 
-  backend.vbo_size = ctx->verts_cap * sizeof(dd_vertex_t);
+  backend->vbo_size = ctx->verts_cap * sizeof(dd_vertex_t);
   GLCHECK(
-    glNamedBufferData(backend.vbo, backend.vbo_size, NULL, GL_DYNAMIC_DRAW));
-  backend.ibo_size = 512 * sizeof(dd_instance_data_t);
+    glNamedBufferData(backend->vbo, backend->vbo_size, NULL, GL_DYNAMIC_DRAW));
+  backend->ibo_size = 512 * sizeof(dd_instance_data_t);
   GLCHECK(
-    glNamedBufferData(backend.ibo, backend.ibo_size, NULL, GL_DYNAMIC_DRAW));
+    glNamedBufferData(backend->ibo, backend->ibo_size, NULL, GL_DYNAMIC_DRAW));
+
+  // Sized by dd__gl_reserve_cull_buffers once culled commands are rendered
+  GLCHECK(glCreateBuffers(1, &backend->culled_ibo));
+  GLCHECK(glCreateBuffers(1, &backend->indirect_buffer));
+  GLCHECK(glCreateBuffers(1, &backend->cull_group_buffer));
+
+  GLCHECK(glCreateBuffers(1, &backend->procedural_ssbo));
+  backend->procedural_ssbo_size =
+    ctx->procedural_cap * sizeof(dd_procedural_prim_t);
+  GLCHECK(glNamedBufferData(backend->procedural_ssbo,
+                            backend->procedural_ssbo_size,
+                            NULL,
+                            GL_DYNAMIC_DRAW));
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  GLCHECK(glCreateBuffers(1, &backend->glyph_ssbo));
+  GLCHECK(glCreateBuffers(1, &backend->anchor_ssbo));
+  backend->glyph_ssbo_size =
+    ctx->glyph_instances_cap * sizeof(dd_glyph_instance_t);
+  backend->anchor_ssbo_size = ctx->text_anchors_cap * sizeof(dd_text_anchor_t);
+  GLCHECK(glNamedBufferData(backend->glyph_ssbo,
+                            backend->glyph_ssbo_size,
+                            NULL,
+                            GL_DYNAMIC_DRAW));
+  GLCHECK(glNamedBufferData(backend->anchor_ssbo,
+                            backend->anchor_ssbo_size,
+                            NULL,
+                            GL_DYNAMIC_DRAW));
+  ctx->backend_caps |= DBGDRAW_BACKEND_CAPS_GLYPH_INSTANCES;
+#endif
+  ctx->backend_caps |= DBGDRAW_BACKEND_CAPS_PROCEDURAL;
+  ctx->backend_caps |= DBGDRAW_BACKEND_CAPS_IMPOSTORS;
+  ctx->backend_caps |= DBGDRAW_BACKEND_CAPS_SDF_TEXT;
+  ctx->backend_caps |= DBGDRAW_BACKEND_CAPS_FONT_ARRAY;
+  ctx->backend_caps |= DBGDRAW_BACKEND_CAPS_CLIP_RECT;
 
   GLCHECK(
-    glCreateTextures(GL_TEXTURE_BUFFER, 1, &backend.line_data_texture_id));
+    glCreateTextures(GL_TEXTURE_BUFFER, 1, &backend->line_data_texture_id));
   GLCHECK(
-    glTextureBuffer(backend.line_data_texture_id, GL_RGBA32F, backend.vbo));
+    glTextureBuffer(backend->line_data_texture_id, GL_RGBA32F, backend->vbo));
 
   GLuint bind_idx = 0;
   GLuint pos_size_loc =
-    glGetAttribLocation(backend.base_program, "in_position_and_size");
+    glGetAttribLocation(shared->base_program.id, "in_position_and_size");
   GLuint uv_or_normal_loc =
-    glGetAttribLocation(backend.base_program, "in_uv_or_normal");
-  GLuint color_loc = glGetAttribLocation(backend.base_program, "in_color");
+    glGetAttribLocation(shared->base_program.id, "in_uv_or_normal");
+  GLuint color_loc = glGetAttribLocation(shared->base_program.id, "in_color");
 
   GLuint instance_pos_loc =
-    glGetAttribLocation(backend.base_program, "in_instance_pos");
+    glGetAttribLocation(shared->base_program.id, "in_instance_pos");
   GLuint instance_col_loc =
-    glGetAttribLocation(backend.base_program, "in_instance_col");
+    glGetAttribLocation(shared->base_program.id, "in_instance_col");
 
-  GLCHECK(glVertexArrayVertexBuffer(backend.vao,
+  GLCHECK(glVertexArrayVertexBuffer(backend->vao,
                                     bind_idx,
-                                    backend.vbo,
+                                    backend->vbo,
                                     0,
                                     sizeof(dd_vertex_t)));
 
-  GLCHECK(glEnableVertexArrayAttrib(backend.vao, pos_size_loc));
-  GLCHECK(glEnableVertexArrayAttrib(backend.vao, uv_or_normal_loc));
-  GLCHECK(glEnableVertexArrayAttrib(backend.vao, color_loc));
+  GLCHECK(glEnableVertexArrayAttrib(backend->vao, pos_size_loc));
+  GLCHECK(glEnableVertexArrayAttrib(backend->vao, uv_or_normal_loc));
+  GLCHECK(glEnableVertexArrayAttrib(backend->vao, color_loc));
 
-  GLCHECK(glVertexArrayAttribFormat(backend.vao,
+  GLCHECK(glVertexArrayAttribFormat(backend->vao,
                                     pos_size_loc,
                                     4,
                                     GL_FLOAT,
                                     GL_FALSE,
                                     offsetof(dd_vertex_t, pos_size)));
-  GLCHECK(glVertexArrayAttribFormat(backend.vao,
+  GLCHECK(glVertexArrayAttribFormat(backend->vao,
                                     uv_or_normal_loc,
                                     3,
                                     GL_FLOAT,
                                     GL_FALSE,
                                     offsetof(dd_vertex_t, uv)));
-  GLCHECK(glVertexArrayAttribFormat(backend.vao,
+  GLCHECK(glVertexArrayAttribFormat(backend->vao,
                                     color_loc,
                                     4,
                                     GL_UNSIGNED_BYTE,
                                     GL_TRUE,
                                     offsetof(dd_vertex_t, col)));
 
-  GLCHECK(glVertexArrayAttribBinding(backend.vao, pos_size_loc, bind_idx));
-  GLCHECK(glVertexArrayAttribBinding(backend.vao, uv_or_normal_loc, bind_idx));
-  GLCHECK(glVertexArrayAttribBinding(backend.vao, color_loc, bind_idx));
+  GLCHECK(glVertexArrayAttribBinding(backend->vao, pos_size_loc, bind_idx));
+  GLCHECK(glVertexArrayAttribBinding(backend->vao, uv_or_normal_loc, bind_idx));
+  GLCHECK(glVertexArrayAttribBinding(backend->vao, color_loc, bind_idx));
 
   bind_idx += 1;
-  GLCHECK(glVertexArrayVertexBuffer(backend.vao,
+  GLCHECK(glVertexArrayVertexBuffer(backend->vao,
                                     bind_idx,
-                                    backend.ibo,
+                                    backend->ibo,
                                     0,
                                     sizeof(dd_instance_data_t)));
 
-  GLCHECK(glEnableVertexArrayAttrib(backend.vao, instance_pos_loc));
-  GLCHECK(glEnableVertexArrayAttrib(backend.vao, instance_col_loc));
+  GLCHECK(glEnableVertexArrayAttrib(backend->vao, instance_pos_loc));
+  GLCHECK(glEnableVertexArrayAttrib(backend->vao, instance_col_loc));
 
-  GLCHECK(glVertexArrayAttribFormat(backend.vao,
+  GLCHECK(glVertexArrayAttribFormat(backend->vao,
                                     instance_pos_loc,
                                     3,
                                     GL_FLOAT,
                                     GL_FALSE,
                                     offsetof(dd_instance_data_t, position)));
-  GLCHECK(glVertexArrayAttribFormat(backend.vao,
+  GLCHECK(glVertexArrayAttribFormat(backend->vao,
                                     instance_col_loc,
                                     4,
                                     GL_UNSIGNED_BYTE,
                                     GL_TRUE,
                                     offsetof(dd_instance_data_t, color)));
 
-  GLCHECK(glVertexArrayAttribBinding(backend.vao, instance_pos_loc, bind_idx));
-  GLCHECK(glVertexArrayAttribBinding(backend.vao, instance_col_loc, bind_idx));
+  GLCHECK(glVertexArrayAttribBinding(backend->vao, instance_pos_loc, bind_idx));
+  GLCHECK(glVertexArrayAttribBinding(backend->vao, instance_col_loc, bind_idx));
 
-  GLCHECK(glVertexArrayBindingDivisor(backend.vao, bind_idx, 1));
+  GLCHECK(glVertexArrayBindingDivisor(backend->vao, bind_idx, 1));
 
   return DBGDRAW_ERR_OK;
 }
 
+bool
+dd__gl_is_culled_on_gpu(dd_ctx_t* ctx, dd_cmd_t* cmd)
+{
+  return ctx->frustum_cull && cmd->instance_data && cmd->vertex_count &&
+         cmd->instance_count >= DBGDRAW_GPU_CULL_MIN_INSTANCES;
+}
+
+void
+dd__gl_reserve_buffer(dd_ctx_t* ctx, GLuint buffer, size_t* size, size_t needed)
+{
+  if (*size >= needed) { return; }
+  *size = needed;
+  GLCHECK(glNamedBufferData(buffer, *size, NULL, GL_DYNAMIC_DRAW));
+  DBGDRAW_STATS(ctx->stats.grow_count++);
+}
+
+// Every culled command of the frame gets its own indirect draw record, range of
+// compacted instances and range of workgroup counts, so no command overwrites
+// data that an earlier one still reads.
+void
+dd__gl_reserve_cull_buffers(dd_ctx_t* ctx, dd_render_backend_t* backend)
+{
+  size_t cmd_count      = 0;
+  size_t instance_count = 0;
+  size_t group_count    = 0;
+  for (int32_t i = 0; i < ctx->commands_len; ++i)
+  {
+    dd_cmd_t* cmd = ctx->commands + i;
+    if (!dd__gl_is_culled_on_gpu(ctx, cmd)) { continue; }
+    cmd_count++;
+    instance_count += cmd->instance_count;
+    group_count += (cmd->instance_count + DD_GL_CULL_GROUP_SIZE - 1) /
+                   DD_GL_CULL_GROUP_SIZE;
+  }
+  backend->culled_cmd_count      = 0;
+  backend->culled_instance_count = 0;
+  backend->cull_group_count      = 0;
+  if (!cmd_count) { return; }
+
+  dd__gl_reserve_buffer(ctx,
+                        backend->culled_ibo,
+                        &backend->culled_ibo_size,
+                        instance_count * sizeof(dd_instance_data_t));
+  dd__gl_reserve_buffer(ctx,
+                        backend->indirect_buffer,
+                        &backend->indirect_buffer_size,
+                        cmd_count * 4 * sizeof(GLuint));
+  dd__gl_reserve_buffer(ctx,
+                        backend->cull_group_buffer,
+                        &backend->cull_group_buffer_size,
+                        group_count * sizeof(GLuint));
+}
+
+// Bounds of the instanced geometry are computed once per command on the cpu,
+// each instance then only offsets the bounding sphere. Visible instances are
+// compacted in two passes - the first counts them per workgroup, the second
+// writes them after the ones of earlier workgroups, so they keep their order
+// and blend the same way in every frame. Returns the byte offset of the
+// indirect draw record, or -1 if the command is not culled on the gpu.
+int64_t
+dd__gl_cull_instances(dd_ctx_t* ctx,
+                      dd_render_backend_t* backend,
+                      dd_cmd_t* cmd)
+{
+  if (!dd__gl_is_culled_on_gpu(ctx, cmd)) { return -1; }
+
+  dd_vec3_t min_pt = ctx->verts_data[cmd->base_index].pos;
+  dd_vec3_t max_pt = min_pt;
+  for (int32_t i = 1; i < cmd->vertex_count; ++i)
+  {
+    dd_vec3_t p = ctx->verts_data[cmd->base_index + i].pos;
+    min_pt      = dd_vec3(DD_MIN(min_pt.x, p.x),
+                     DD_MIN(min_pt.y, p.y),
+                     DD_MIN(min_pt.z, p.z));
+    max_pt      = dd_vec3(DD_MAX(max_pt.x, p.x),
+                     DD_MAX(max_pt.y, p.y),
+                     DD_MAX(max_pt.z, p.z));
+  }
+  float scale = DD_MAX(dd_vec3_norm(dd_vec4_to_vec3(cmd->xform.col[0])),
+                       DD_MAX(dd_vec3_norm(dd_vec4_to_vec3(cmd->xform.col[1])),
+                              dd_vec3_norm(dd_vec4_to_vec3(cmd->xform.col[2]))));
+  dd_vec3_t center = dd_vec3_scalar_mul(dd_vec3_add(min_pt, max_pt), 0.5f);
+  float radius = 0.5f * scale * dd_vec3_norm(dd_vec3_sub(max_pt, min_pt));
+
+  int32_t cmd_idx      = backend->culled_cmd_count++;
+  int32_t first_inst   = backend->culled_instance_count;
+  int32_t first_group  = backend->cull_group_count;
+  uint32_t group_count = (cmd->instance_count + DD_GL_CULL_GROUP_SIZE - 1) /
+                         DD_GL_CULL_GROUP_SIZE;
+  backend->culled_instance_count += cmd->instance_count;
+  backend->cull_group_count += group_count;
+
+  // Instance count is filled in by the compute shader
+  bool is_line = (cmd->draw_mode == DBGDRAW_MODE_STROKE);
+  GLuint indirect_cmd[4];
+  indirect_cmd[0]   = is_line ? 3 * cmd->vertex_count : cmd->vertex_count;
+  indirect_cmd[1]   = 0;
+  indirect_cmd[2]   = is_line ? 0 : cmd->base_index;
+  indirect_cmd[3]   = 0;
+  int64_t cmd_offset = (int64_t)cmd_idx * sizeof(indirect_cmd);
+  GLCHECK(glNamedBufferSubData(backend->indirect_buffer,
+                               cmd_offset,
+                               sizeof(indirect_cmd),
+                               indirect_cmd));
+
+  dd_shared_resources_t* shared = backend->shared;
+  GLCHECK(glUseProgram(dd__gl_program_id(shared, &shared->cull_program)));
+  GLCHECK(glUniformMatrix4fv(0, 1, GL_FALSE, &cmd->xform.data[0]));
+  GLCHECK(glUniform4f(1, center.x, center.y, center.z, radius));
+  GLCHECK(glUniform4fv(2, 6, ctx->frustum_planes[0].data));
+  GLCHECK(glUniform1ui(8, cmd->instance_count));
+  GLCHECK(glUniform3ui(10, first_inst, first_group, cmd_idx));
+  GLCHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, backend->ibo));
+  GLCHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, backend->culled_ibo));
+  GLCHECK(
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, backend->indirect_buffer));
+  GLCHECK(
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, backend->cull_group_buffer));
+  GLCHECK(glUniform1ui(9, 0));
+  GLCHECK(glDispatchCompute(group_count, 1, 1));
+  GLCHECK(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
+  GLCHECK(glUniform1ui(9, 1));
+  GLCHECK(glDispatchCompute(group_count, 1, 1));
+
+  // Records are rewritten with glNamedBufferSubData in the next frame
+  GLCHECK(glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT |
+                          GL_COMMAND_BARRIER_BIT |
+                          GL_BUFFER_UPDATE_BARRIER_BIT));
+  GLCHECK(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, backend->indirect_buffer));
+  GLCHECK(glVertexArrayVertexBuffer(backend->vao,
+                                    1,
+                                    backend->culled_ibo,
+                                    first_inst * sizeof(dd_instance_data_t),
+                                    sizeof(dd_instance_data_t)));
+  return cmd_offset;
+}
+
+// Results are only collected once available, so reading them never stalls. Slot
+// that is still in flight is not reused, that frame simply goes untimed.
+void
+dd__gl_collect_timers(dd_ctx_t* ctx, dd_render_backend_t* backend)
+{
+  // Oldest frame first, so that latest results end up in timings
+  for (int32_t i = 0; i < DBGDRAW_TIMER_FRAMES; ++i)
+  {
+    int32_t slot = (backend->timer_frame_count + i) % DBGDRAW_TIMER_FRAMES;
+    int32_t query_count = backend->timer_query_count[slot];
+    if (!query_count) { continue; }
+
+    GLint available = 0;
+    GLCHECK(glGetQueryObjectiv(backend->timer_queries[slot][query_count - 1],
+                               GL_QUERY_RESULT_AVAILABLE,
+                               &available));
+    if (!available) { break; }
+
+    dd_frame_timings_t* timings = &ctx->timings;
+    float* bucket_ms            = &timings->gpu_bucket_ms[0][0];
+    timings->gpu_ms             = 0.0f;
+    for (int32_t j = 0; j < DBGDRAW_MODE_COUNT * DBGDRAW_SHADING_COUNT; ++j)
+    {
+      bucket_ms[j] = 0.0f;
+    }
+    for (int32_t j = 0; j < query_count; ++j)
+    {
+      GLuint64 elapsed_ns = 0;
+      GLCHECK(glGetQueryObjectui64v(backend->timer_queries[slot][j],
+                                    GL_QUERY_RESULT,
+                                    &elapsed_ns));
+      bucket_ms[backend->timer_buckets[slot][j]] += elapsed_ns * 1e-6f;
+      timings->gpu_ms += elapsed_ns * 1e-6f;
+    }
+    timings->gpu_latency =
+      backend->timer_frame_count - backend->timer_frame_idx[slot];
+    backend->timer_query_count[slot] = 0;
+  }
+}
+
+void
+dd__gl_begin_timers(dd_ctx_t* ctx, dd_render_backend_t* backend)
+{
+  backend->timer_slot   = -1;
+  backend->timer_bucket = -1;
+  if (!ctx->enable_timings) { return; }
+
+  if (!backend->timer_queries[0][0])
+  {
+    GLCHECK(glCreateQueries(GL_TIME_ELAPSED,
+                            DBGDRAW_TIMER_FRAMES * DBGDRAW_MAX_TIMER_QUERIES,
+                            &backend->timer_queries[0][0]));
+  }
+
+  dd__gl_collect_timers(ctx, backend);
+  int32_t slot = backend->timer_frame_count % DBGDRAW_TIMER_FRAMES;
+  if (!backend->timer_query_count[slot])
+  {
+    backend->timer_slot            = slot;
+    backend->timer_frame_idx[slot] = backend->timer_frame_count;
+  }
+}
+
+void
+dd__gl_time_bucket(dd_render_backend_t* backend, dd_cmd_t* cmd)
+{
+  int32_t slot   = backend->timer_slot;
+  int32_t bucket = cmd->draw_mode * DBGDRAW_SHADING_COUNT + cmd->shading_type;
+  if (slot < 0 || bucket == backend->timer_bucket ||
+      backend->timer_query_count[slot] >= DBGDRAW_MAX_TIMER_QUERIES)
+  {
+    return;
+  }
+
+  if (backend->timer_bucket >= 0) { GLCHECK(glEndQuery(GL_TIME_ELAPSED)); }
+  int32_t query_idx = backend->timer_query_count[slot]++;
+  backend->timer_buckets[slot][query_idx] = (uint8_t)bucket;
+  backend->timer_bucket                   = bucket;
+  GLCHECK(
+    glBeginQuery(GL_TIME_ELAPSED, backend->timer_queries[slot][query_idx]));
+}
+
+void
+dd__gl_end_timers(dd_ctx_t* ctx, dd_render_backend_t* backend)
+{
+  if (!ctx->enable_timings) { return; }
+  if (backend->timer_bucket >= 0) { GLCHECK(glEndQuery(GL_TIME_ELAPSED)); }
+  backend->timer_frame_count++;
+}
+
+// Clip rects are in pixels of the viewport passed to dd_new_frame, from its top
+// left corner. Scissor boxes are in pixels of the GL viewport, from its bottom
+// left corner, and it is smaller when rendering to an image. Like
+// rasterization, a pixel is kept when its center is inside the rect.
+void
+dd__gl_apply_clip_rect(dd_ctx_t* ctx,
+                       dd_cmd_t* cmd,
+                       const GLint* viewport,
+                       bool* is_scissored)
+{
+  dd_vec4_t rect = cmd->clip_rect;
+  if (rect.z <= 0.0f)
+  {
+    if (*is_scissored) { GLCHECK(glDisable(GL_SCISSOR_TEST)); }
+    *is_scissored = false;
+    return;
+  }
+
+  float sx = ctx->viewport.z > 0.0f ? viewport[2] / ctx->viewport.z : 1.0f;
+  float sy = ctx->viewport.w > 0.0f ? viewport[3] / ctx->viewport.w : 1.0f;
+  GLint x0 = (GLint)ceilf(rect.x * sx - 0.5f);
+  GLint x1 = (GLint)ceilf((rect.x + rect.z) * sx - 0.5f);
+  GLint y0 = (GLint)ceilf(rect.y * sy - 0.5f);
+  GLint y1 = (GLint)ceilf((rect.y + rect.w) * sy - 0.5f);
+  if (!*is_scissored) { GLCHECK(glEnable(GL_SCISSOR_TEST)); }
+  *is_scissored = true;
+  GLCHECK(glScissor(viewport[0] + x0,
+                    viewport[1] + viewport[3] - y1,
+                    DD_MAX(x1 - x0, 0),
+                    DD_MAX(y1 - y0, 0)));
+}
+
 int32_t
 dd_backend_render(dd_ctx_t* ctx)
 {
   assert(ctx);
   assert(ctx->render_backend);
-  dd_render_backend_t* backend = ctx->render_backend;
+  dd_render_backend_t* backend  = ctx->render_backend;
+  dd_shared_resources_t* shared = backend->shared;
 
   if (!ctx->commands_len) { return DBGDRAW_ERR_OK; }
 
+  double upload_start_ms = ctx->enable_timings ? dd_time_ms() : 0.0;
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_backend_upload");
+
   // TODO(maciej): Swap to persitent mapped buffer (glBufferStorage +
   // glMapBufferRange) and measure the performance?
   if (backend->vbo_size < ctx->verts_cap * sizeof(dd_vertex_t))
@@ -260,11 +884,80 @@ dd_backend_render(dd_ctx_t* ctx)
                               backend->vbo_size,
                               NULL,
                               GL_DYNAMIC_DRAW));
+    DBGDRAW_STATS(ctx->stats.grow_count++);
   }
   GLCHECK(glNamedBufferSubData(backend->vbo,
                                0,
                                ctx->verts_len * sizeof(dd_vertex_t),
                                ctx->verts_data));
+  DBGDRAW_STATS(ctx->stats.bytes_uploaded +=
+                ctx->verts_len * sizeof(dd_vertex_t));
+
+  if (ctx->procedural_len)
+  {
+    size_t procedural_size = ctx->procedural_cap * sizeof(dd_procedural_prim_t);
+    if (backend->procedural_ssbo_size < procedural_size)
+    {
+      backend->procedural_ssbo_size = procedural_size;
+      GLCHECK(glNamedBufferData(backend->procedural_ssbo,
+                                backend->procedural_ssbo_size,
+                                NULL,
+                                GL_DYNAMIC_DRAW));
+      DBGDRAW_STATS(ctx->stats.grow_count++);
+    }
+    GLCHECK(
+      glNamedBufferSubData(backend->procedural_ssbo,
+                           0,
+                           ctx->procedural_len * sizeof(dd_procedural_prim_t),
+                           ctx->procedural_data));
+    DBGDRAW_STATS(ctx->stats.bytes_uploaded +=
+                  ctx->procedural_len * sizeof(dd_procedural_prim_t));
+    GLCHECK(
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, backend->procedural_ssbo));
+  }
+
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  if (ctx->glyph_instances_len)
+  {
+    size_t glyph_size  = ctx->glyph_instances_cap * sizeof(dd_glyph_instance_t);
+    size_t anchor_size = ctx->text_anchors_cap * sizeof(dd_text_anchor_t);
+    if (backend->glyph_ssbo_size < glyph_size)
+    {
+      backend->glyph_ssbo_size = glyph_size;
+      GLCHECK(glNamedBufferData(backend->glyph_ssbo,
+                                backend->glyph_ssbo_size,
+                                NULL,
+                                GL_DYNAMIC_DRAW));
+      DBGDRAW_STATS(ctx->stats.grow_count++);
+    }
+    if (backend->anchor_ssbo_size < anchor_size)
+    {
+      backend->anchor_ssbo_size = anchor_size;
+      GLCHECK(glNamedBufferData(backend->anchor_ssbo,
+                                backend->anchor_ssbo_size,
+                                NULL,
+                                GL_DYNAMIC_DRAW));
+      DBGDRAW_STATS(ctx->stats.grow_count++);
+    }
+    size_t glyph_bytes  = ctx->glyph_instances_len * sizeof(dd_glyph_instance_t);
+    size_t anchor_bytes = ctx->text_anchors_len * sizeof(dd_text_anchor_t);
+    GLCHECK(glNamedBufferSubData(
+      backend->glyph_ssbo, 0, glyph_bytes, ctx->glyph_instances));
+    GLCHECK(glNamedBufferSubData(
+      backend->anchor_ssbo, 0, anchor_bytes, ctx->text_anchors));
+    DBGDRAW_STATS(ctx->stats.bytes_uploaded += glyph_bytes + anchor_bytes);
+    GLCHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, backend->glyph_ssbo));
+    GLCHECK(
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, backend->anchor_ssbo));
+  }
+#endif
+
+  if (ctx->enable_timings)
+  {
+    ctx->timings.upload_ms += (float)(dd_time_ms() - upload_start_ms);
+  }
+  DBGDRAW_TRACE_END(ctx, "dd_backend_upload");
+  dd__gl_begin_timers(ctx, backend);
 
   // Setup required ogl state
   if (ctx->enable_depth_test) { GLCHECK(glEnable(GL_DEPTH_TEST)); }
@@ -278,6 +971,34 @@ dd_backend_render(dd_ctx_t* ctx)
   GLCHECK(glEnable(GL_POLYGON_OFFSET_FILL));
   GLCHECK(glPolygonOffset(1.0, 1.0));
 
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  // Per font: its size relative to the layers, whether it is a distance field
+  // and its layer. Text vertices index this with their font.
+  if (backend->font_count)
+  {
+    float fonts[DBGDRAW_GL_MAX_FONTS][4];
+    int32_t fonts_len = DD_MIN(ctx->fonts_len, DBGDRAW_GL_MAX_FONTS);
+    for (int32_t i = 0; i < fonts_len; ++i)
+    {
+      dd_font_data_t* font = ctx->fonts + i;
+      fonts[i][0] = (float)font->bitmap_width / shared->font_array_width;
+      fonts[i][1] = (float)font->bitmap_height / shared->font_array_height;
+      fonts[i][2] = font->is_sdf;
+      fonts[i][3] = (float)font->tex_id;
+    }
+    GLCHECK(glUseProgram(dd__gl_program_id(shared, &shared->base_program)));
+    GLCHECK(glUniform4fv(10, fonts_len, &fonts[0][0]));
+    if (ctx->glyph_instances_len)
+    {
+      GLCHECK(
+        glUseProgram(dd__gl_program_id(shared, &shared->glyph_program)));
+      GLCHECK(glUniform4fv(10, fonts_len, &fonts[0][0]));
+    }
+  }
+#endif
+
+  dd__gl_reserve_cull_buffers(ctx, backend);
+
   dd_vec2_t viewport_size =
     dd_vec2(ctx->viewport.data[2], ctx->viewport.data[3]);
 
@@ -286,6 +1007,10 @@ dd_backend_render(dd_ctx_t* ctx)
   gl_modes[DBGDRAW_MODE_STROKE] = GL_LINES;
   gl_modes[DBGDRAW_MODE_POINT]  = GL_POINTS;
 
+  GLint gl_viewport[4];
+  GLCHECK(glGetIntegerv(GL_VIEWPORT, gl_viewport));
+  bool is_scissored = false;
+
   for (int32_t i = 0; i < ctx->commands_len; ++i)
   {
     dd_cmd_t* cmd = ctx->commands + i;
@@ -294,8 +1019,14 @@ dd_backend_render(dd_ctx_t* ctx)
       ctx->proj,
       dd_mat4_mul(ctx->view, dd_mat4_transpose(dd_mat4_inverse(cmd->xform))));
 
+    DBGDRAW_TRACE_BEGIN(ctx, "dd_backend_submit");
+    dd__gl_time_bucket(backend, cmd);
+    dd__gl_apply_clip_rect(ctx, cmd, gl_viewport, &is_scissored);
+
     if (cmd->instance_count && cmd->instance_data)
     {
+      upload_start_ms = ctx->enable_timings ? dd_time_ms() : 0.0;
+      DBGDRAW_TRACE_BEGIN(ctx, "dd_backend_upload");
       if (backend->ibo_size < cmd->instance_count * sizeof(dd_instance_data_t))
       {
         ctx->instance_cap = cmd->instance_count;
@@ -304,47 +1035,122 @@ dd_backend_render(dd_ctx_t* ctx)
                                   backend->ibo_size,
                                   NULL,
                                   GL_DYNAMIC_DRAW));
+        DBGDRAW_STATS(ctx->stats.grow_count++);
       }
       GLCHECK(glNamedBufferSubData(backend->ibo,
                                    0,
-                                   backend->ibo_size,
+                                   cmd->instance_count *
+                                     sizeof(dd_instance_data_t),
                                    cmd->instance_data));
+      DBGDRAW_STATS(ctx->stats.bytes_uploaded +=
+                    cmd->instance_count * sizeof(dd_instance_data_t));
+      if (ctx->enable_timings)
+      {
+        ctx->timings.upload_ms += (float)(dd_time_ms() - upload_start_ms);
+      }
+      DBGDRAW_TRACE_END(ctx, "dd_backend_upload");
     }
 
+    // Culled instances are drawn indirectly, from the compacted buffer
+    int64_t indirect_offset = dd__gl_cull_instances(ctx, backend, cmd);
+    bool gpu_culled         = indirect_offset >= 0;
+
     if (cmd->draw_mode == DBGDRAW_MODE_FILL)
     {
-      GLCHECK(glUseProgram(backend->base_program));
+      GLCHECK(glUseProgram(dd__gl_program_id(shared, &shared->base_program)));
       GLCHECK(glUniformMatrix4fv(0, 1, GL_FALSE, &mvp.data[0]));
       GLCHECK(glUniformMatrix4fv(6, 1, GL_FALSE, &normal_matrix.data[0]));
       GLCHECK(glUniform1i(1, cmd->shading_type));
       GLCHECK(glUniform1i(2, (cmd->instance_count > 0)));
 
 #if DBGDRAW_HAS_TEXT_SUPPORT
-      if (cmd->font_idx >= 0)
+      if (cmd->shading_type == DBGDRAW_SHADING_TEXT)
       {
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, ctx->fonts[cmd->font_idx].tex_id);
-        glUniform1i(backend->font_tex_attrib_loc, 0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, shared->font_array);
+        glUniform1i(shared->font_tex_attrib_loc, 0);
       }
 #endif
-      if (cmd->instance_count <= 0)
+      if (cmd->instance_count <= 0 && cmd->vertex_count > 0)
       {
         GLCHECK(glDrawArrays(gl_modes[cmd->draw_mode],
                              cmd->base_index,
                              cmd->vertex_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
       }
-      else
+      else if (gpu_culled)
+      {
+        GLCHECK(glDrawArraysIndirect(gl_modes[cmd->draw_mode],
+                                     (const void*)(intptr_t)indirect_offset));
+        DBGDRAW_STATS(ctx->drawcall_count++);
+      }
+      else if (cmd->instance_count > 0)
       {
         GLCHECK(glDrawArraysInstanced(gl_modes[cmd->draw_mode],
                                       cmd->base_index,
                                       cmd->vertex_count,
                                       cmd->instance_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
       }
+
+      // Procedural shapes are expanded from their records by the vertex shader
+      if (cmd->procedural_vertex_count > 0)
+      {
+        GLCHECK(glUseProgram(
+          dd__gl_program_id(shared, &shared->procedural_program)));
+        GLCHECK(glUniformMatrix4fv(0, 1, GL_FALSE, &mvp.data[0]));
+        GLCHECK(glUniformMatrix4fv(6, 1, GL_FALSE, &normal_matrix.data[0]));
+        GLCHECK(glUniform1i(1, cmd->shading_type));
+        GLCHECK(glUniform1i(3, cmd->procedural_base_index));
+        GLCHECK(glDrawArraysInstanced(GL_TRIANGLES,
+                                      0,
+                                      cmd->procedural_vertex_count,
+                                      cmd->procedural_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
+      }
+
+      // Impostors are drawn as a quad (spheres) or a box (capsules and
+      // cylinders) per record, and the fragment shader ray-casts the surface
+      uint32_t impostor_box_types =
+        (1u << DBGDRAW_PROCEDURAL_IMPOSTOR_CAPSULE) |
+        (1u << DBGDRAW_PROCEDURAL_IMPOSTOR_CYLINDER);
+      uint32_t impostor_types =
+        impostor_box_types | (1u << DBGDRAW_PROCEDURAL_IMPOSTOR_SPHERE);
+      if (cmd->procedural_types & impostor_types)
+      {
+        dd_mat4_t model_view = dd_mat4_mul(ctx->view, cmd->xform);
+        GLCHECK(glUseProgram(
+          dd__gl_program_id(shared, &shared->impostor_program)));
+        GLCHECK(glUniform1i(1, cmd->shading_type));
+        GLCHECK(glUniform1i(3, cmd->procedural_base_index));
+        GLCHECK(glUniformMatrix4fv(7, 1, GL_FALSE, &model_view.data[0]));
+        GLCHECK(glUniformMatrix4fv(8, 1, GL_FALSE, &ctx->proj.data[0]));
+        GLCHECK(glDrawArraysInstanced(
+          GL_TRIANGLES,
+          0,
+          (cmd->procedural_types & impostor_box_types) ? 36 : 6,
+          cmd->procedural_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
+      }
+
+#if DBGDRAW_HAS_TEXT_SUPPORT
+      // Glyph records are expanded into quads, one instance each
+      if (cmd->glyph_count > 0)
+      {
+        GLCHECK(
+          glUseProgram(dd__gl_program_id(shared, &shared->glyph_program)));
+        GLCHECK(glUniformMatrix4fv(0, 1, GL_FALSE, &mvp.data[0]));
+        GLCHECK(glUniform1i(1, cmd->shading_type));
+        GLCHECK(glUniform1i(3, cmd->glyph_base_index));
+        GLCHECK(glDrawArraysInstanced(GL_TRIANGLES, 0, 6, cmd->glyph_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
+      }
+#endif
     }
 
     else if (cmd->draw_mode == DBGDRAW_MODE_POINT)
     {
-      GLCHECK(glUseProgram(backend->base_program));
+      GLCHECK(glUseProgram(dd__gl_program_id(shared, &shared->base_program)));
       GLCHECK(glUniformMatrix4fv(0, 1, GL_FALSE, &mvp.data[0]));
       GLCHECK(glUniform1i(1, 0));
       GLCHECK(glUniform1i(2, (int)(cmd->instance_count > 0)));
@@ -354,6 +1160,13 @@ dd_backend_render(dd_ctx_t* ctx)
         GLCHECK(glDrawArrays(gl_modes[cmd->draw_mode],
                              cmd->base_index,
                              cmd->vertex_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
+      }
+      else if (gpu_culled)
+      {
+        GLCHECK(glDrawArraysIndirect(gl_modes[cmd->draw_mode],
+                                     (const void*)(intptr_t)indirect_offset));
+        DBGDRAW_STATS(ctx->drawcall_count++);
       }
       else
       {
@@ -361,6 +1174,7 @@ dd_backend_render(dd_ctx_t* ctx)
                                       cmd->base_index,
                                       cmd->vertex_count,
                                       cmd->instance_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
       }
     }
 
@@ -369,7 +1183,8 @@ dd_backend_render(dd_ctx_t* ctx)
       GLCHECK(glActiveTexture(GL_TEXTURE0));
       GLCHECK(glBindTexture(GL_TEXTURE_BUFFER, backend->line_data_texture_id));
 
-      GLCHECK(glUseProgram(backend->lines_program));
+      GLCHECK(glUseProgram(
+        dd__gl_program_id(shared, &shared->lines_program)));
 
       GLCHECK(glUniformMatrix4fv(0, 1, GL_FALSE, mvp.data));
       GLCHECK(glUniform2fv(1, 1, viewport_size.data));
@@ -382,6 +1197,13 @@ dd_backend_render(dd_ctx_t* ctx)
       if (cmd->instance_count <= 0)
       {
         GLCHECK(glDrawArrays(GL_TRIANGLES, 0, 3 * cmd->vertex_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
+      }
+      else if (gpu_culled)
+      {
+        GLCHECK(glDrawArraysIndirect(GL_TRIANGLES,
+                                     (const void*)(intptr_t)indirect_offset));
+        DBGDRAW_STATS(ctx->drawcall_count++);
       }
       else
       {
@@ -389,11 +1211,25 @@ dd_backend_render(dd_ctx_t* ctx)
                                       0,
                                       3 * cmd->vertex_count,
                                       cmd->instance_count));
+        DBGDRAW_STATS(ctx->drawcall_count++);
       }
     }
+
+    if (gpu_culled)
+    {
+      GLCHECK(glVertexArrayVertexBuffer(backend->vao,
+                                        1,
+                                        backend->ibo,
+                                        0,
+                                        sizeof(dd_instance_data_t)));
+    }
+    DBGDRAW_TRACE_END(ctx, "dd_backend_submit");
   }
+  dd__gl_end_timers(ctx, backend);
 
   // Reset ogl state
+  if (is_scissored) { GLCHECK(glDisable(GL_SCISSOR_TEST)); }
+  GLCHECK(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
   GLCHECK(glPolygonOffset(0.0, 0.0));
   GLCHECK(glDisable(GL_POLYGON_OFFSET_FILL));
   GLCHECK(glUseProgram(0));
@@ -407,6 +1243,119 @@ dd_backend_render(dd_ctx_t* ctx)
 }
 
 #if DBGDRAW_HAS_TEXT_SUPPORT
+// Returns the layer holding a font atlas with the same contents and sets
+// 'found', otherwise returns a free layer. -1 if the pool is full. Atlases with
+// a zero hash are never matched.
+int32_t
+dd__gl_find_font_slot(dd_shared_resources_t* shared, uint64_t hash, bool* found)
+{
+  *found            = false;
+  int32_t free_slot = -1;
+  for (int32_t i = 0; i < DBGDRAW_GL_MAX_SHARED_FONTS; ++i)
+  {
+    if (!shared->font_ref_counts[i])
+    {
+      if (free_slot < 0) { free_slot = i; }
+    }
+    else if (hash && shared->font_hashes[i] == hash)
+    {
+      *found = true;
+      return i;
+    }
+  }
+  return free_slot;
+}
+
+// Grows the font array to hold an atlas of the given size in the given layer.
+// Layers in use are copied on the GPU, since the pool does not keep the
+// atlases of other contexts.
+void
+dd__gl_reserve_font_array(dd_shared_resources_t* shared,
+                          int32_t width,
+                          int32_t height,
+                          int32_t layer)
+{
+  if (width <= shared->font_array_width &&
+      height <= shared->font_array_height &&
+      layer < shared->font_array_layers)
+  {
+    return;
+  }
+
+  int32_t layers = shared->font_array_layers;
+  while (layer >= layers)
+  {
+    layers = DD_MIN(DD_MAX(2 * layers, 1), DBGDRAW_GL_MAX_SHARED_FONTS);
+  }
+  width  = DD_MAX(width, shared->font_array_width);
+  height = DD_MAX(height, shared->font_array_height);
+
+  GLuint tex = 0;
+  GLCHECK(glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &tex));
+  GLCHECK(glTextureParameteri(tex, GL_TEXTURE_WRAP_S, GL_REPEAT));
+  GLCHECK(glTextureParameteri(tex, GL_TEXTURE_WRAP_T, GL_REPEAT));
+  GLCHECK(glTextureParameteri(tex, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+  GLCHECK(glTextureParameteri(tex, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+  GLCHECK(glTextureStorage3D(tex, 1, GL_R8, width, height, layers));
+
+  if (shared->font_array)
+  {
+    for (int32_t i = 0; i < shared->font_array_layers; ++i)
+    {
+      if (!shared->font_ref_counts[i]) { continue; }
+      GLCHECK(glCopyImageSubData(shared->font_array,
+                                 GL_TEXTURE_2D_ARRAY,
+                                 0,
+                                 0,
+                                 0,
+                                 i,
+                                 tex,
+                                 GL_TEXTURE_2D_ARRAY,
+                                 0,
+                                 0,
+                                 0,
+                                 i,
+                                 shared->font_array_width,
+                                 shared->font_array_height,
+                                 1));
+    }
+    glDeleteTextures(1, &shared->font_array);
+  }
+  shared->font_array        = tex;
+  shared->font_array_width  = width;
+  shared->font_array_height = height;
+  shared->font_array_layers = layers;
+}
+
+void
+dd__gl_upload_font_layer(dd_shared_resources_t* shared,
+                         const uint8_t* data,
+                         int32_t width,
+                         int32_t layer,
+                         int32_t x,
+                         int32_t y,
+                         int32_t w,
+                         int32_t h)
+{
+  GLCHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+  GLCHECK(glPixelStorei(GL_UNPACK_ROW_LENGTH, width));
+  GLCHECK(glTextureSubImage3D(shared->font_array,
+                              0,
+                              x,
+                              y,
+                              layer,
+                              w,
+                              h,
+                              1,
+                              GL_RED,
+                              GL_UNSIGNED_BYTE,
+                              data + (size_t)y * width + x));
+  GLCHECK(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+  GLCHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+}
+
+// 'tex_id' is the layer of the font. Layers are as large as the largest font,
+// smaller fonts use their top left corner.
 int32_t
 dd_backend_init_font_texture(dd_ctx_t* ctx,
                              const uint8_t* data,
@@ -416,44 +1365,272 @@ dd_backend_init_font_texture(dd_ctx_t* ctx,
 {
   assert(ctx);
   assert(ctx->render_backend);
+  dd_render_backend_t* backend  = ctx->render_backend;
+  dd_shared_resources_t* shared = backend->shared;
+  if (backend->font_count >= DBGDRAW_GL_MAX_FONTS)
+  {
+    return DBGDRAW_ERR_FONT_LIMIT_REACHED;
+  }
+
+  uint64_t hash = dd__gl_hash_bytes(14695981039346656037ULL, &width, 4);
+  hash          = dd__gl_hash_bytes(hash, &height, 4);
+  hash          = dd__gl_hash_bytes(hash, data, (size_t)width * height);
+
+  // Contexts that load the same font share its layer
+  bool found   = false;
+  int32_t slot = dd__gl_find_font_slot(shared, hash, &found);
+  if (slot < 0) { return DBGDRAW_ERR_FONT_LIMIT_REACHED; }
+  backend->font_count++;
+  shared->font_ref_counts[slot]++;
+  backend->font_refs[slot]++;
+  *tex_id = (uint32_t)slot;
+  if (found) { return DBGDRAW_ERR_OK; }
+
+  shared->font_hashes[slot] = hash;
+  dd__gl_reserve_font_array(shared, width, height, slot);
+  dd__gl_upload_font_layer(shared, data, width, slot, 0, 0, width, height);
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_backend_update_font_texture(dd_ctx_t* ctx,
+                               const uint8_t* data,
+                               int32_t width,
+                               int32_t height,
+                               int32_t x,
+                               int32_t y,
+                               int32_t w,
+                               int32_t h,
+                               uint32_t* tex_id)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend  = ctx->render_backend;
+  dd_shared_resources_t* shared = backend->shared;
+  int32_t slot                  = (int32_t)*tex_id;
+  assert(backend->font_refs[slot]);
+
+  // Every font caches different glyphs, so a layer used by other fonts is
+  // copied before it changes. Changed layers are not shared.
+  if (shared->font_ref_counts[slot] > 1)
+  {
+    bool found           = false;
+    int32_t private_slot = dd__gl_find_font_slot(shared, 0, &found);
+    if (private_slot < 0) { return DBGDRAW_ERR_FONT_LIMIT_REACHED; }
+    shared->font_ref_counts[slot]--;
+    backend->font_refs[slot]--;
+
+    slot = private_slot;
+    shared->font_ref_counts[slot]++;
+    backend->font_refs[slot]++;
+    shared->font_hashes[slot] = 0;
+    *tex_id                   = (uint32_t)slot;
+    dd__gl_reserve_font_array(shared, width, height, slot);
+    dd__gl_upload_font_layer(shared, data, width, slot, 0, 0, width, height);
+    return DBGDRAW_ERR_OK;
+  }
+  shared->font_hashes[slot] = 0;
+  dd__gl_upload_font_layer(shared, data, width, slot, x, y, w, h);
+  return DBGDRAW_ERR_OK;
+}
+#endif
+
+void
+dd__gl_delete_image_target(dd_render_backend_t* backend)
+{
+  for (int32_t i = 0; i < DBGDRAW_READBACK_RING_SIZE; ++i)
+  {
+    if (backend->readback_fences[i])
+    {
+      glDeleteSync(backend->readback_fences[i]);
+      backend->readback_fences[i] = 0;
+    }
+  }
+  glDeleteFramebuffers(1, &backend->image_fbo);
+  glDeleteRenderbuffers(1, &backend->image_color_rb);
+  glDeleteRenderbuffers(1, &backend->image_depth_rb);
+  glDeleteBuffers(DBGDRAW_READBACK_RING_SIZE, backend->readback_pbos);
+  backend->image_fbo     = 0;
+  backend->readback_head = 0;
+  backend->readback_len  = 0;
+}
+
+void
+dd__gl_create_image_target(dd_render_backend_t* backend,
+                           int32_t width,
+                           int32_t height)
+{
+  GLCHECK(glCreateRenderbuffers(1, &backend->image_color_rb));
+  GLCHECK(glCreateRenderbuffers(1, &backend->image_depth_rb));
+  GLCHECK(
+    glNamedRenderbufferStorage(backend->image_color_rb, GL_RGBA8, width, height));
+  GLCHECK(glNamedRenderbufferStorage(backend->image_depth_rb,
+                                     GL_DEPTH_COMPONENT24,
+                                     width,
+                                     height));
+
+  GLCHECK(glCreateFramebuffers(1, &backend->image_fbo));
+  GLCHECK(glNamedFramebufferRenderbuffer(backend->image_fbo,
+                                         GL_COLOR_ATTACHMENT0,
+                                         GL_RENDERBUFFER,
+                                         backend->image_color_rb));
+  GLCHECK(glNamedFramebufferRenderbuffer(backend->image_fbo,
+                                         GL_DEPTH_ATTACHMENT,
+                                         GL_RENDERBUFFER,
+                                         backend->image_depth_rb));
+
+  GLCHECK(glCreateBuffers(DBGDRAW_READBACK_RING_SIZE, backend->readback_pbos));
+  for (int32_t i = 0; i < DBGDRAW_READBACK_RING_SIZE; ++i)
+  {
+    GLCHECK(glNamedBufferData(backend->readback_pbos[i],
+                              (size_t)width * height * 4,
+                              NULL,
+                              GL_STREAM_READ));
+  }
+
+  backend->image_width       = width;
+  backend->image_height      = height;
+  backend->image_frame_count = 0;
+}
+
+// Copies the oldest pending readback into the image, waiting for it if needed.
+// Rows are flipped, so that the first row of the image is the top one.
+void
+dd__gl_retire_readback(dd_render_backend_t* backend, dd_image_t* image)
+{
+  int32_t slot = (backend->readback_head - backend->readback_len +
+                  DBGDRAW_READBACK_RING_SIZE) %
+                 DBGDRAW_READBACK_RING_SIZE;
+
+  GLCHECK(glClientWaitSync(backend->readback_fences[slot],
+                           GL_SYNC_FLUSH_COMMANDS_BIT,
+                           UINT64_MAX));
+  glDeleteSync(backend->readback_fences[slot]);
+  backend->readback_fences[slot] = 0;
+
+  size_t row_size   = (size_t)backend->image_width * 4;
+  size_t image_size = row_size * backend->image_height;
+  const uint8_t* src;
+  GLCHECK(src = glMapNamedBufferRange(backend->readback_pbos[slot],
+                                      0,
+                                      image_size,
+                                      GL_MAP_READ_BIT));
+  for (int32_t y = 0; y < backend->image_height; ++y)
+  {
+    memcpy(image->pixels + y * row_size,
+           src + (backend->image_height - 1 - y) * row_size,
+           row_size);
+  }
+  GLCHECK(glUnmapNamedBuffer(backend->readback_pbos[slot]));
+
+  image->frame_idx = backend->readback_frame_idx[slot];
+  backend->readback_len--;
+}
+
+int32_t
+dd_render_to_image(dd_ctx_t* ctx, dd_image_t* image)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  assert(image);
   dd_render_backend_t* backend = ctx->render_backend;
 
+  if (image->width <= 0 || image->height <= 0 || !image->pixels)
+  {
+    return DBGDRAW_ERR_INVALID_IMAGE;
+  }
+
+  // Changing the size drops frames that were not read back yet
+  if (!backend->image_fbo || backend->image_width != image->width ||
+      backend->image_height != image->height)
+  {
+    if (backend->image_fbo) { dd__gl_delete_image_target(backend); }
+    dd__gl_create_image_target(backend, image->width, image->height);
+  }
+
+  GLint prev_fbo;
+  GLint prev_viewport[4];
+  GLCHECK(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prev_fbo));
+  GLCHECK(glGetIntegerv(GL_VIEWPORT, prev_viewport));
+
+  float clear_color[4] = { image->clear_color.r / 255.0f,
+                           image->clear_color.g / 255.0f,
+                           image->clear_color.b / 255.0f,
+                           image->clear_color.a / 255.0f };
+  float clear_depth    = 1.0f;
+  GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, backend->image_fbo));
+  GLCHECK(glViewport(0, 0, image->width, image->height));
+  GLCHECK(glClearNamedFramebufferfv(backend->image_fbo, GL_COLOR, 0, clear_color));
   GLCHECK(
-    glCreateTextures(GL_TEXTURE_2D, 1, &backend->font_tex_ids[ctx->fonts_len]));
-  GLCHECK(glTextureParameteri(backend->font_tex_ids[ctx->fonts_len],
-                              GL_TEXTURE_WRAP_S,
-                              GL_REPEAT));
-  GLCHECK(glTextureParameteri(backend->font_tex_ids[ctx->fonts_len],
-                              GL_TEXTURE_WRAP_T,
-                              GL_REPEAT));
-  GLCHECK(glTextureParameteri(backend->font_tex_ids[ctx->fonts_len],
-                              GL_TEXTURE_MIN_FILTER,
-                              GL_LINEAR));
-  GLCHECK(glTextureParameteri(backend->font_tex_ids[ctx->fonts_len],
-                              GL_TEXTURE_MAG_FILTER,
-                              GL_LINEAR));
-
-  GLCHECK(glTextureStorage2D(backend->font_tex_ids[ctx->fonts_len],
-                             1,
-                             GL_R8,
-                             width,
-                             height));
-  GLCHECK(glTextureSubImage2D(backend->font_tex_ids[ctx->fonts_len],
-                              0,
-                              0,
-                              0,
-                              width,
-                              height,
-                              GL_RED,
-                              GL_UNSIGNED_BYTE,
-                              data));
-  *tex_id = backend->font_tex_ids[ctx->fonts_len];
-  backend->font_tex_attrib_loc =
-    glGetUniformLocation(backend->base_program, "tex");
+    glClearNamedFramebufferfv(backend->image_fbo, GL_DEPTH, 0, &clear_depth));
+
+  int32_t error = dd_render(ctx);
+
+  // Ring is full - the oldest frame has to be read back before it is reused
+  image->frame_idx = -1;
+  if (backend->readback_len == DBGDRAW_READBACK_RING_SIZE)
+  {
+    dd__gl_retire_readback(backend, image);
+  }
+
+  int32_t slot = backend->readback_head;
+  GLCHECK(glNamedFramebufferReadBuffer(backend->image_fbo, GL_COLOR_ATTACHMENT0));
+  GLCHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, backend->readback_pbos[slot]));
+  GLCHECK(glReadPixels(0,
+                       0,
+                       image->width,
+                       image->height,
+                       GL_RGBA,
+                       GL_UNSIGNED_BYTE,
+                       NULL));
+  GLCHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+  backend->readback_fences[slot] =
+    glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  backend->readback_frame_idx[slot] = backend->image_frame_count++;
+  backend->readback_head = (slot + 1) % DBGDRAW_READBACK_RING_SIZE;
+  backend->readback_len++;
+
+  // Otherwise only return the oldest frame if the gpu is already done with it
+  if (image->frame_idx < 0)
+  {
+    int32_t oldest = (backend->readback_head - backend->readback_len +
+                      DBGDRAW_READBACK_RING_SIZE) %
+                     DBGDRAW_READBACK_RING_SIZE;
+    GLenum status  = glClientWaitSync(backend->readback_fences[oldest], 0, 0);
+    if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+    {
+      dd__gl_retire_readback(backend, image);
+    }
+  }
+
+  GLCHECK(glBindFramebuffer(GL_FRAMEBUFFER, prev_fbo));
+  GLCHECK(glViewport(prev_viewport[0],
+                     prev_viewport[1],
+                     prev_viewport[2],
+                     prev_viewport[3]));
+
+  return error;
+}
+
+int32_t
+dd_flush_image(dd_ctx_t* ctx, dd_image_t* image)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  assert(image);
+  dd_render_backend_t* backend = ctx->render_backend;
+
+  image->frame_idx = -1;
+  if (!backend->readback_len) { return DBGDRAW_ERR_OK; }
+  if (image->width != backend->image_width ||
+      image->height != backend->image_height || !image->pixels)
+  {
+    return DBGDRAW_ERR_INVALID_IMAGE;
+  }
 
+  dd__gl_retire_readback(backend, image);
   return DBGDRAW_ERR_OK;
 }
-#endif
 
 int32_t
 dd_backend_term(dd_ctx_t* ctx)
@@ -464,14 +1641,45 @@ dd_backend_term(dd_ctx_t* ctx)
 
   glDeleteVertexArrays(1, &backend->vao);
   glDeleteBuffers(1, &backend->vbo);
-  glDeleteProgram(backend->base_program);
-  glDeleteProgram(backend->lines_program);
-#if DBGDRAW_HAS_TEXT_SUPPORT
-  for (int32_t i = 0; i < ctx->fonts_len; ++i)
+  glDeleteBuffers(1, &backend->ibo);
+  glDeleteBuffers(1, &backend->procedural_ssbo);
+  glDeleteBuffers(1, &backend->glyph_ssbo);
+  glDeleteBuffers(1, &backend->anchor_ssbo);
+  glDeleteBuffers(1, &backend->culled_ibo);
+  glDeleteBuffers(1, &backend->indirect_buffer);
+  glDeleteBuffers(1, &backend->cull_group_buffer);
+  if (backend->timer_queries[0][0])
   {
-    glDeleteTextures(1, &backend->font_tex_ids[i]);
+    glDeleteQueries(DBGDRAW_TIMER_FRAMES * DBGDRAW_MAX_TIMER_QUERIES,
+                    &backend->timer_queries[0][0]);
+    memset(backend->timer_queries, 0, sizeof(backend->timer_queries));
+    memset(backend->timer_query_count, 0, sizeof(backend->timer_query_count));
   }
-#endif
+  if (backend->image_fbo) { dd__gl_delete_image_target(backend); }
+
+  dd_shared_resources_t* shared = backend->shared;
+  for (int32_t i = 0; i < DBGDRAW_GL_MAX_SHARED_FONTS; ++i)
+  {
+    shared->font_ref_counts[i] -= backend->font_refs[i];
+  }
+
+  // Programs and fonts go with the last context that uses them
+  if (--shared->ref_count == 0)
+  {
+    glDeleteTextures(1, &shared->font_array);
+    glDeleteProgram(shared->base_program.id);
+    glDeleteProgram(shared->lines_program.id);
+    glDeleteProgram(shared->procedural_program.id);
+    glDeleteProgram(shared->impostor_program.id);
+    glDeleteProgram(shared->glyph_program.id);
+    glDeleteProgram(shared->cull_program.id);
+    bool owned = shared->owned;
+    memset(shared, 0, sizeof(dd_shared_resources_t));
+    if (owned) { free(shared); }
+  }
+
+  free(backend);
+  ctx->render_backend = NULL;
   return DBGDRAW_ERR_OK;
 }
 
@@ -518,7 +1726,8 @@ dd__init_base_shaders_source(const char** vert_shdr_src,
   *frag_shdr_src =
     DBGDRAW_SHADER_HEADER
     DBGDRAW_STRINGIFY(
-      uniform sampler2D tex;
+      uniform sampler2DArray tex;
+      layout(location = 10) uniform vec4 u_fonts[16];
 
       layout(location = 0) in vec4 v_color;
       layout(location = 1) in vec3 v_uv_or_normal;
@@ -539,7 +1748,16 @@ dd__init_base_shaders_source(const char** vert_shdr_src,
         }
         else
         {
-          float texture_val = texture(tex, vec2(v_uv_or_normal)).r;
+          // Size relative to the layers, distance field flag and layer
+          vec4 font = u_fonts[int(v_uv_or_normal.z + 0.5)];
+          vec3 uv = vec3(v_uv_or_normal.xy * font.xy, font.w);
+          float texture_val = texture(tex, uv).r;
+          if (font.z > 0.0)
+          {
+            // Outline is at 128 / 255, antialiased over about a pixel
+            float width = 0.7 * fwidth(texture_val);
+            texture_val = smoothstep(0.502 - width, 0.502 + width, texture_val);
+          }
           float alpha = clamp(v_color.a * texture_val, 0.0, 1.0);
           frag_color = vec4(v_color.rgb, alpha);
         }
@@ -780,4 +1998,491 @@ dd__init_line_shaders_source(const char** vert_shdr_src,
   // clang-format on
 }
 
+void
+dd__init_procedural_shaders_source(const char** vert_shdr_src)
+{
+  // clang-format off
+  *vert_shdr_src =
+    DBGDRAW_SHADER_HEADER
+    DBGDRAW_STRINGIFY(
+      layout(location = 0) uniform mat4 u_mvp;
+      layout(location = 1) uniform int shading_type;
+      layout(location = 3) uniform int u_procedural_base;
+      layout(location = 6) uniform mat4 u_normal_matrix;
+
+      struct procedural_prim {
+        vec4 center_and_radius_a;
+        vec4 axis_and_radius_b;
+        uvec4 color_type_and_detail;
+      };
+
+      layout(std430, binding = 0) readonly buffer procedural_data {
+        procedural_prim prims[];
+      };
+
+      layout(location = 0) out vec4 v_color;
+      layout(location = 1) out vec3 v_uv_or_normal;
+      layout(location = 2) out flat int v_shading_type;
+
+      const float PI = 3.14159265358979;
+      const uint SPHERE = 0u;
+      const uint CONICAL_FRUSTUM = 1u;
+      const uint TORUS = 2u;
+      const uint IMPOSTOR_SPHERE = 4u;
+
+      // Returns radius and height of the revolved profile, along with the
+      // profile normal, for the v-th profile vertex of a given segment.
+      vec4 get_profile(uint type, int seg, int iv, int res_v, vec2 radii, float height) {
+        float t = float(iv) / float(res_v);
+        if (type == SPHERE)
+        {
+          float phi = (t - 0.5) * PI;
+          return vec4(radii.x * cos(phi), radii.x * sin(phi), cos(phi), sin(phi));
+        }
+        else if (type == TORUS)
+        {
+          float phi = 2.0 * PI * t;
+          return vec4(radii.x + radii.y * cos(phi), radii.y * sin(phi), cos(phi), sin(phi));
+        }
+        else if (type == CONICAL_FRUSTUM)
+        {
+          vec2 pts[4] = vec2[4](vec2(0.0, 0.0), vec2(radii.x, 0.0),
+                                vec2(radii.y, height), vec2(0.0, height));
+          vec2 normals[3] = vec2[3](vec2(0.0, -1.0),
+                                    normalize(vec2(height, radii.x - radii.y)),
+                                    vec2(0.0, 1.0));
+          return vec4(pts[iv], normals[seg]);
+        }
+        return vec4((1.0 - t) * radii.x, 0.0, 0.0, 1.0);
+      }
+
+      void main() {
+        procedural_prim prim = prims[u_procedural_base + gl_InstanceID];
+        uint type = prim.color_type_and_detail.y;
+        int res_u = 1 << (int(prim.color_type_and_detail.z) + 2);
+        int res_v = 1;
+        if (type == SPHERE)               { res_v = res_u / 2; }
+        else if (type == TORUS)           { res_v = max(4, res_u / 2); }
+        else if (type == CONICAL_FRUSTUM) { res_v = 3; }
+
+        // Records with lower detail than the largest one in a command collapse
+        // their extra triangles to a single point. Impostors are drawn separately.
+        int quad_idx = gl_VertexID / 6;
+        if (type >= IMPOSTOR_SPHERE || quad_idx >= res_u * res_v)
+        {
+          v_color = vec4(0.0);
+          v_uv_or_normal = vec3(0.0);
+          v_shading_type = shading_type;
+          gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+          return;
+        }
+
+        ivec2 corners[6] = ivec2[6](ivec2(0, 0), ivec2(1, 0), ivec2(1, 1),
+                                    ivec2(0, 0), ivec2(1, 1), ivec2(0, 1));
+        ivec2 corner = corners[gl_VertexID % 6];
+        int seg = quad_idx / res_u;
+        int iu = (quad_idx % res_u) + corner.x;
+        int iv = seg + corner.y;
+
+        vec3 axis = prim.axis_and_radius_b.xyz;
+        float height = length(axis);
+        vec3 n = axis / height;
+        vec3 t = normalize(cross(n, (abs(n.x) > 0.9) ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0)));
+        vec3 b = cross(n, t);
+
+        float theta = 2.0 * PI * float(iu) / float(res_u);
+        vec3 radial = cos(theta) * t + sin(theta) * b;
+        vec2 radii = vec2(prim.center_and_radius_a.w, prim.axis_and_radius_b.w);
+        vec4 profile = get_profile(type, seg, iv, res_v, radii, height);
+
+        vec3 position = prim.center_and_radius_a.xyz + profile.x * radial + profile.y * n;
+        // Normals are flipped to follow the winding convention of the cpu path
+        vec3 normal = -(profile.z * radial + profile.w * n);
+
+        v_color = unpackUnorm4x8(prim.color_type_and_detail.x);
+        if (shading_type == 1)
+        {
+          v_uv_or_normal = vec3(u_normal_matrix * vec4(normal, 0.0));
+        }
+        else
+        {
+          v_uv_or_normal = normal;
+        }
+        v_shading_type = shading_type;
+        gl_Position = u_mvp * vec4(position, 1.0);
+      });
+  // clang-format on
+}
+
+void
+dd__init_impostor_shaders_source(const char** vert_shdr_src,
+                                 const char** frag_shdr_src)
+{
+  // clang-format off
+  *vert_shdr_src =
+    DBGDRAW_SHADER_HEADER
+    DBGDRAW_STRINGIFY(
+      layout(location = 1) uniform int shading_type;
+      layout(location = 3) uniform int u_procedural_base;
+      layout(location = 7) uniform mat4 u_model_view;
+      layout(location = 8) uniform mat4 u_proj;
+
+      struct procedural_prim {
+        vec4 center_and_radius_a;
+        vec4 axis_and_radius_b;
+        uvec4 color_type_and_detail;
+      };
+
+      layout(std430, binding = 0) readonly buffer procedural_data {
+        procedural_prim prims[];
+      };
+
+      layout(location = 0) out vec4 v_color;
+      layout(location = 1) out vec3 v_view_pos;
+      layout(location = 2) out flat int v_shading_type;
+      layout(location = 3) out flat int v_type;
+      layout(location = 4) out flat vec4 v_a_and_radius;
+      layout(location = 5) out flat vec4 v_b_and_extent;
+
+      const uint IMPOSTOR_SPHERE = 4u;
+      const uint IMPOSTOR_CAPSULE = 5u;
+
+      void main() {
+        procedural_prim prim = prims[u_procedural_base + gl_InstanceID];
+        uint type = prim.color_type_and_detail.y;
+
+        // Non-impostor records, and spheres in commands that also contain boxes,
+        // collapse their triangles to a single point
+        int vertex_count = (type == IMPOSTOR_SPHERE) ? 6 : 36;
+        if (type < IMPOSTOR_SPHERE || gl_VertexID >= vertex_count)
+        {
+          v_color = vec4(0.0);
+          v_view_pos = vec3(0.0);
+          v_shading_type = shading_type;
+          v_type = 0;
+          v_a_and_radius = vec4(0.0);
+          v_b_and_extent = vec4(0.0);
+          gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+          return;
+        }
+
+        // Ray-casting happens in view space. Transform is assumed to have uniform scale.
+        float scale = length(u_model_view[0].xyz);
+        vec3 a = vec3(u_model_view * vec4(prim.center_and_radius_a.xyz, 1.0));
+        vec3 b = a + mat3(u_model_view) * prim.axis_and_radius_b.xyz;
+        float r = prim.center_and_radius_a.w * scale;
+
+        vec3 position;
+        if (type == IMPOSTOR_SPHERE)
+        {
+          // Quad perpendicular to the direction towards the eye, placed at the
+          // near side of the sphere, always covers its silhouette.
+          vec3 n = (u_proj[3][3] == 1.0) ? vec3(0.0, 0.0, 1.0) : normalize(-a);
+          vec3 t = normalize(cross(n, (abs(n.x) > 0.9) ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0)));
+          vec3 bt = cross(n, t);
+          vec2 corners[6] = vec2[6](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+                                    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+          vec2 corner = corners[gl_VertexID];
+          position = a + r * (n + corner.x * t + corner.y * bt);
+        }
+        else
+        {
+          // Box aligned with the segment, extended by the radius for capsules.
+          int indices[36] = int[36](0, 4, 6, 0, 6, 2, 1, 3, 7, 1, 7, 5,
+                                    0, 1, 5, 0, 5, 4, 2, 6, 7, 2, 7, 3,
+                                    0, 2, 3, 0, 3, 1, 4, 5, 7, 4, 7, 6);
+          int idx = indices[gl_VertexID];
+          vec3 corner = vec3(ivec3(idx & 1, (idx >> 1) & 1, (idx >> 2) & 1)) * 2.0 - 1.0;
+          vec3 axis = b - a;
+          float half_length = 0.5 * length(axis);
+          vec3 n = axis / (2.0 * half_length);
+          vec3 t = normalize(cross(n, (abs(n.x) > 0.9) ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0)));
+          vec3 bt = cross(n, t);
+          float extent = half_length + ((type == IMPOSTOR_CAPSULE) ? r : 0.0);
+          position = 0.5 * (a + b) + r * (corner.x * t + corner.y * bt) + extent * corner.z * n;
+        }
+
+        v_color = unpackUnorm4x8(prim.color_type_and_detail.x);
+        v_view_pos = position;
+        v_shading_type = shading_type;
+        v_type = int(type);
+        v_a_and_radius = vec4(a, r);
+        v_b_and_extent = vec4(b, length(b - a) + 2.0 * r);
+        gl_Position = u_proj * vec4(position, 1.0);
+      });
+
+  *frag_shdr_src =
+    DBGDRAW_SHADER_HEADER
+    DBGDRAW_STRINGIFY(
+      layout(location = 8) uniform mat4 u_proj;
+
+      layout(location = 0) in vec4 v_color;
+      layout(location = 1) in vec3 v_view_pos;
+      layout(location = 2) in flat int v_shading_type;
+      layout(location = 3) in flat int v_type;
+      layout(location = 4) in flat vec4 v_a_and_radius;
+      layout(location = 5) in flat vec4 v_b_and_extent;
+
+      layout(location = 0) out vec4 frag_color;
+
+      const int IMPOSTOR_SPHERE = 4;
+      const int IMPOSTOR_CAPSULE = 5;
+
+      // Ray-surface intersections return the distance along the ray in x, and
+      // the outward normal in yzw. Negative distance means a miss.
+      vec4 sphere_intersect(vec3 ro, vec3 rd, vec3 c, float r) {
+        vec3 oc = ro - c;
+        float b = dot(oc, rd);
+        float h = b * b - dot(oc, oc) + r * r;
+        if (h < 0.0) { return vec4(-1.0); }
+        float t = -b - sqrt(h);
+        return vec4(t, (oc + t * rd) / r);
+      }
+
+      vec4 capsule_intersect(vec3 ro, vec3 rd, vec3 pa, vec3 pb, float r) {
+        vec3 ba = pb - pa;
+        vec3 oa = ro - pa;
+        float baba = dot(ba, ba);
+        float bard = dot(ba, rd);
+        float baoa = dot(ba, oa);
+        float k2 = baba - bard * bard;
+        float k1 = baba * dot(oa, rd) - baoa * bard;
+        float k0 = baba * dot(oa, oa) - baoa * baoa - r * r * baba;
+        float h = k1 * k1 - k2 * k0;
+        if (h < 0.0) { return vec4(-1.0); }
+        float t = (-k1 - sqrt(h)) / k2;
+        float y = baoa + t * bard;
+        if (y > 0.0 && y < baba) { return vec4(t, (oa + t * rd - ba * y / baba) / r); }
+        return sphere_intersect(ro, rd, (y <= 0.0) ? pa : pb, r);
+      }
+
+      vec4 cylinder_intersect(vec3 ro, vec3 rd, vec3 pa, vec3 pb, float r) {
+        vec3 ba = pb - pa;
+        vec3 oa = ro - pa;
+        float baba = dot(ba, ba);
+        float bard = dot(ba, rd);
+        float baoa = dot(ba, oa);
+        float k2 = baba - bard * bard;
+        float k1 = baba * dot(oa, rd) - baoa * bard;
+        float k0 = baba * dot(oa, oa) - baoa * baoa - r * r * baba;
+        float h = k1 * k1 - k2 * k0;
+        if (h < 0.0) { return vec4(-1.0); }
+        h = sqrt(h);
+        float t = (-k1 - h) / k2;
+        float y = baoa + t * bard;
+        if (y > 0.0 && y < baba) { return vec4(t, (oa + t * rd - ba * y / baba) / r); }
+        t = (((y < 0.0) ? 0.0 : baba) - baoa) / bard;
+        if (abs(k1 + k2 * t) < h) { return vec4(t, ba * sign(y) / sqrt(baba)); }
+        return vec4(-1.0);
+      }
+
+      void main() {
+        // Rays start behind the proxy geometry, so that they always begin
+        // outside of the shape.
+        vec3 rd = (u_proj[3][3] == 1.0) ? vec3(0.0, 0.0, -1.0) : normalize(v_view_pos);
+        vec3 ro = v_view_pos - v_b_and_extent.w * rd;
+        vec3 pa = v_a_and_radius.xyz;
+        vec3 pb = v_b_and_extent.xyz;
+        float r = v_a_and_radius.w;
+
+        vec4 hit;
+        if (v_type == IMPOSTOR_SPHERE)       { hit = sphere_intersect(ro, rd, pa, r); }
+        else if (v_type == IMPOSTOR_CAPSULE) { hit = capsule_intersect(ro, rd, pa, pb, r); }
+        else                                 { hit = cylinder_intersect(ro, rd, pa, pb, r); }
+        if (hit.x < 0.0) { discard; }
+
+        vec4 clip_pos = u_proj * vec4(ro + hit.x * rd, 1.0);
+        float ndc_depth = clip_pos.z / clip_pos.w;
+        gl_FragDepth = 0.5 * (gl_DepthRange.diff * ndc_depth + gl_DepthRange.near + gl_DepthRange.far);
+
+        if (v_shading_type == 1)
+        {
+          // Same lighting as the mesh path, which uses inward facing normals.
+          vec3 normal = vec3(u_proj * vec4(-hit.yzw, 0.0));
+          vec3 light_dir = vec3(0, 0, 1);
+          float ndotl = dot(normal, light_dir);
+          frag_color = vec4(v_color.rgb * ndotl, v_color.a);
+        }
+        else
+        {
+          frag_color = v_color;
+        }
+      });
+  // clang-format on
+}
+
+void
+dd__init_cull_shader_source(const char** comp_shdr_src)
+{
+  // clang-format off
+  *comp_shdr_src =
+    DBGDRAW_SHADER_HEADER
+    DBGDRAW_STRINGIFY(
+      layout(local_size_x = 256) in;
+
+      layout(location = 0) uniform mat4 u_model;
+      layout(location = 1) uniform vec4 u_bounds;
+      layout(location = 2) uniform vec4 u_frustum_planes[6];
+      layout(location = 8) uniform uint u_instance_count;
+      layout(location = 9) uniform uint u_pass;
+      // First compacted instance, first workgroup count and indirect record
+      layout(location = 10) uniform uvec3 u_offsets;
+
+      struct instance_data {
+        vec3 position;
+        uint color;
+      };
+
+      struct draw_cmd {
+        uint vertex_count;
+        uint instance_count;
+        uint first_vertex;
+        uint base_instance;
+      };
+
+      layout(std430, binding = 1) readonly buffer instances_in {
+        instance_data src_instances[];
+      };
+
+      layout(std430, binding = 2) writeonly buffer instances_out {
+        instance_data dst_instances[];
+      };
+
+      layout(std430, binding = 3) buffer indirect_cmds {
+        draw_cmd cmds[];
+      };
+
+      layout(std430, binding = 4) buffer group_counts {
+        uint counts[];
+      };
+
+      shared uint s_sums[256];
+
+      bool is_visible(instance_data instance) {
+        vec4 center = u_model * vec4(u_bounds.xyz + instance.position, 1.0);
+        for (int i = 0; i < 6; ++i)
+        {
+          if (dot(center, u_frustum_planes[i]) <= -u_bounds.w)
+          {
+            return false;
+          }
+        }
+        return true;
+      }
+
+      void main() {
+        uint idx   = gl_GlobalInvocationID.x;
+        uint lid   = gl_LocalInvocationIndex;
+        uint group = gl_WorkGroupID.x;
+        instance_data instance;
+        bool visible = false;
+        if (idx < u_instance_count)
+        {
+          instance = src_instances[idx];
+          visible  = is_visible(instance);
+        }
+
+        // Inclusive scan of the visible instances in the workgroup
+        s_sums[lid] = visible ? 1u : 0u;
+        barrier();
+        for (uint step = 1u; step < 256u; step <<= 1)
+        {
+          uint sum = lid >= step ? s_sums[lid - step] : 0u;
+          barrier();
+          s_sums[lid] += sum;
+          barrier();
+        }
+        uint slot        = s_sums[lid] - (visible ? 1u : 0u);
+        uint group_count = s_sums[255];
+        if (u_pass == 0u)
+        {
+          if (lid == 0u) { counts[u_offsets.y + group] = group_count; }
+          return;
+        }
+
+        // Sum of the counts of earlier workgroups
+        uint sum = 0u;
+        for (uint i = lid; i < group; i += 256u)
+        {
+          sum += counts[u_offsets.y + i];
+        }
+        barrier();
+        s_sums[lid] = sum;
+        barrier();
+        for (uint step = 128u; step > 0u; step >>= 1)
+        {
+          if (lid < step) { s_sums[lid] += s_sums[lid + step]; }
+          barrier();
+        }
+        uint group_offset = s_sums[0];
+
+        if (visible)
+        {
+          dst_instances[u_offsets.x + group_offset + slot] = instance;
+        }
+        if (lid == 0u && group == gl_NumWorkGroups.x - 1u)
+        {
+          cmds[u_offsets.z].instance_count = group_offset + group_count;
+        }
+      });
+  // clang-format on
+}
+
+void
+dd__init_glyph_shaders_source(const char** vert_shdr_src)
+{
+  // clang-format off
+  *vert_shdr_src =
+    DBGDRAW_SHADER_HEADER
+    DBGDRAW_STRINGIFY(
+      layout(location = 0) uniform mat4 u_mvp;
+      layout(location = 1) uniform int shading_type;
+      layout(location = 3) uniform int u_glyph_base;
+
+      struct glyph_instance {
+        vec2 pos;
+        uvec2 rect;
+        uint anchor;
+        uint color;
+      };
+
+      struct text_anchor {
+        vec4 origin;
+        vec4 axis_x;
+        vec4 axis_y;
+        vec4 atlas;
+      };
+
+      layout(std430, binding = 4) readonly buffer glyph_data {
+        glyph_instance glyphs[];
+      };
+
+      layout(std430, binding = 5) readonly buffer anchor_data {
+        text_anchor anchors[];
+      };
+
+      layout(location = 0) out vec4 v_color;
+      layout(location = 1) out vec3 v_uv_or_normal;
+      layout(location = 2) out flat int v_shading_type;
+
+      void main() {
+        glyph_instance glyph = glyphs[u_glyph_base + gl_InstanceID];
+        text_anchor anchor = anchors[glyph.anchor];
+
+        vec2 corners[6] = vec2[6](vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(1.0, 0.0),
+                                  vec2(0.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 1.0));
+        vec2 corner = corners[gl_VertexID];
+        vec2 st0 = vec2(glyph.rect.x & 0xFFFFu, glyph.rect.x >> 16u);
+        vec2 st1 = vec2(glyph.rect.y & 0xFFFFu, glyph.rect.y >> 16u);
+        vec2 st = mix(st0, st1, corner);
+        vec2 pos = glyph.pos + (st - st0) * anchor.atlas.z;
+
+        v_color = unpackUnorm4x8(glyph.color);
+        v_uv_or_normal = vec3(st * anchor.atlas.xy, anchor.atlas.w);
+        v_shading_type = shading_type;
+        gl_Position = u_mvp * vec4(anchor.origin.xyz + pos.x * anchor.axis_x.xyz + pos.y * anchor.axis_y.xyz, 1.0);
+      });
+  // clang-format on
+}
+
 #endif
@@ -153,7 +153,8 @@ init(app_state_t* state)
                                    .max_commands        = 16,
                                    .detail_level        = 2,
                                    .enable_frustum_cull = true,
-                                   .enable_depth_test   = true};
+                                   .enable_depth_test   = true,
+                                   .enable_timings      = true};
   error                         = dd_init(state->primitives, &desc_primitives);
   if (error)
   {
@@ -312,6 +313,7 @@ frame(app_state_t* state)
 #define N_TIMES 100
   static float times[N_TIMES] = {0};
   static int32_t time_idx     = 0;
+  static dd_frame_timings_t timings[N_TIMES];
 
   msh_vec3_t min_pt  = msh_vec3(-0.5f, -0.5f, -0.5f);
   msh_vec3_t max_pt  = msh_vec3(0.5f, 0.5f, 0.5f);
@@ -431,6 +433,7 @@ frame(app_state_t* state)
   }
 
   dd_render(primitives);
+  dd_get_frame_timings(primitives, &timings[time_idx]);
 
   if (show_overlay)
   {
@@ -447,6 +450,8 @@ frame(app_state_t* state)
     int32_t x = win_width - 260;
     int32_t y = 10;
     draw_frame_timer(overlay, x, y, times, N_TIMES, time_idx);
+    draw_frame_timings(
+      overlay, x, y + 90, timings, N_TIMES, (time_idx + 1) % N_TIMES);
 
     char legend[256];
     snprintf(legend,
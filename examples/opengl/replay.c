@@ -0,0 +1,220 @@
+#define MSH_VEC_MATH_INCLUDE_LIBC_HEADERS
+#define MSH_VEC_MATH_IMPLEMENTATION
+#define DBGDRAW_USE_DEFAULT_FONT
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <string.h>
+
+#include "msh_vec_math.h"
+#include "stb_truetype.h"
+#include "dbgdraw.h"
+
+#if defined(DD_USE_OGL_33)
+#include "glad33.h"
+#include "dbgdraw_opengl33.h"
+#define DD_GL_VERSION_MAJOR 3
+#define DD_GL_VERSION_MINOR 3
+#elif defined(DD_USE_OGL_45)
+#include "glad45.h"
+#include "dbgdraw_opengl45.h"
+#define DD_GL_VERSION_MAJOR 4
+#define DD_GL_VERSION_MINOR 5
+#else
+#error "Unrecognized OpenGL Version! Please define either DD_USE_OGL_33 or DD_USE_OGL45!"
+#endif
+
+// Feeds frames recorded with dd_capture_begin back through dbgdraw, rendering
+// them offscreen, and reports how much time each phase took. Usage:
+//   dd_replay <capture file> [--repeat N] [--sort]
+// With --sort, commands are sorted with dd_sort_commands before rendering.
+
+typedef struct phase_t {
+  const char* name;
+  double total_ms;
+  double amount;
+  const char* unit;
+} phase_t;
+
+enum { PHASE_DECODE, PHASE_SORT, PHASE_RENDER, PHASE_UPLOAD, PHASE_GPU, PHASE_COUNT };
+
+int32_t init_egl( EGLDisplay* display, EGLContext* context );
+
+int32_t
+main( int32_t argc, char** argv )
+{
+  const char* filename = NULL;
+  int32_t repeat = 1;
+  bool sort = false;
+  for( int32_t i = 1; i < argc; ++i )
+  {
+    if( !strcmp( argv[i], "--repeat" ) && i + 1 < argc ) { repeat = atoi( argv[++i] ); }
+    else if( !strcmp( argv[i], "--sort" ) ) { sort = true; }
+    else { filename = argv[i]; }
+  }
+  if( !filename || repeat < 1 )
+  {
+    fprintf( stderr, "Usage: %s <capture file> [--repeat N] [--sort]\n", argv[0] );
+    return 1;
+  }
+
+  dd_replay_t replay = {0};
+  int32_t error = dd_replay_open( &replay, filename );
+  if( error )
+  {
+    fprintf( stderr, "%s\n", dd_error_message( error ) );
+    return 1;
+  }
+
+  EGLDisplay display = EGL_NO_DISPLAY;
+  EGLContext context = EGL_NO_CONTEXT;
+  if( init_egl( &display, &context ) ) { return 1; }
+
+  dd_ctx_t dd_ctx = {0};
+  dd_ctx_desc_t desc =
+  {
+    .max_vertices = 1024,
+    .max_commands = 16,
+    .enable_depth_test = true,
+    .enable_default_font = 1,
+    .enable_timings = 1
+  };
+  error = dd_init( &dd_ctx, &desc );
+  if( error )
+  {
+    fprintf( stderr, "[ERROR] Failed to initialize dbgdraw library!\n" );
+    return 1;
+  }
+
+  // The image matches the viewport of the first frame
+  error = dd_replay_frame( &dd_ctx, &replay, 0 );
+  if( error )
+  {
+    fprintf( stderr, "%s\n", dd_error_message( error ) );
+    return 1;
+  }
+  dd_image_t image = {0};
+  image.width       = DD_MAX( (int32_t)replay.frame.viewport.data[2], 1 );
+  image.height      = DD_MAX( (int32_t)replay.frame.viewport.data[3], 1 );
+  image.clear_color = dd_rgbf( 0.9f, 0.9f, 0.9f );
+  image.pixels      = malloc( image.width * image.height * 4 );
+
+  phase_t phases[PHASE_COUNT] =
+  {
+    [PHASE_DECODE] = { "decode", 0.0, 0.0, "MB/s captured data" },
+    [PHASE_SORT]   = { "sort",   0.0, 0.0, "M commands/s" },
+    [PHASE_RENDER] = { "render", 0.0, 0.0, "M vertices/s" },
+    [PHASE_UPLOAD] = { "upload", 0.0, 0.0, "MB/s uploaded" },
+    [PHASE_GPU]    = { "gpu",    0.0, 0.0, "M vertices/s" },
+  };
+  int32_t frame_count = 0;
+  int32_t gpu_frame_count = 0;
+  double start_ms = dd_time_ms();
+
+  for( int32_t r = 0; r < repeat && !error; ++r )
+  {
+    for( int32_t i = 0; i < replay.frame_count && !error; ++i )
+    {
+      double t0 = dd_time_ms();
+      error = dd_replay_frame( &dd_ctx, &replay, i );
+      double t1 = dd_time_ms();
+      if( error ) { break; }
+      uint64_t chunk_end = ( i + 1 < replay.frame_count ) ? replay.frame_offsets[i + 1] : replay.size;
+      phases[PHASE_DECODE].total_ms += t1 - t0;
+      phases[PHASE_DECODE].amount += (double)( chunk_end - replay.frame_offsets[i] ) / ( 1024.0 * 1024.0 );
+
+      if( sort ) { dd_sort_commands( &dd_ctx ); }
+      error = dd_render_to_image( &dd_ctx, &image );
+
+      dd_frame_timings_t timings;
+      dd_frame_stats_t stats;
+      dd_get_frame_timings( &dd_ctx, &timings );
+      dd_get_frame_stats( &dd_ctx, &stats );
+      int32_t vertex_count = 0;
+      for( int32_t m = 0; m < DBGDRAW_MODE_COUNT; ++m ) { vertex_count += stats.vertex_count[m]; }
+
+      phases[PHASE_SORT].total_ms += timings.sort_ms;
+      phases[PHASE_SORT].amount += dd_ctx.commands_len * 1e-6;
+      phases[PHASE_RENDER].total_ms += timings.render_ms;
+      phases[PHASE_RENDER].amount += vertex_count * 1e-6;
+      phases[PHASE_UPLOAD].total_ms += timings.upload_ms;
+      phases[PHASE_UPLOAD].amount += stats.bytes_uploaded / ( 1024.0 * 1024.0 );
+      // GPU timings lag behind, so they are attributed to the frame that is
+      // current when they arrive
+      if( timings.gpu_ms >= 0.0f )
+      {
+        phases[PHASE_GPU].total_ms += timings.gpu_ms;
+        phases[PHASE_GPU].amount += vertex_count * 1e-6;
+        gpu_frame_count++;
+      }
+      frame_count++;
+    }
+  }
+  double total_ms = dd_time_ms() - start_ms;
+  while( !dd_flush_image( &dd_ctx, &image ) && image.frame_idx >= 0 ) {}
+
+  if( error ) { fprintf( stderr, "%s\n", dd_error_message( error ) ); }
+
+  printf( "%s: %d frames (%d x %d), %.3f ms total\n", filename, frame_count, replay.frame_count, repeat, total_ms );
+  printf( "%-8s %12s %12s   %s\n", "phase", "total ms", "ms/frame", "throughput" );
+  for( int32_t i = 0; i < PHASE_COUNT; ++i )
+  {
+    phase_t* phase = phases + i;
+    int32_t n = ( i == PHASE_GPU ) ? gpu_frame_count : frame_count;
+    if( i == PHASE_SORT && !sort ) { continue; }
+    if( !n ) { printf( "%-8s %12s\n", phase->name, "n/a" ); continue; }
+    double throughput = phase->total_ms > 0.0 ? phase->amount / ( phase->total_ms * 1e-3 ) : 0.0;
+    printf( "%-8s %12.3f %12.4f   %.2f %s\n", phase->name, phase->total_ms, phase->total_ms / n, throughput, phase->unit );
+  }
+
+  dd_term( &dd_ctx );
+  dd_replay_close( &replay );
+  free( image.pixels );
+  eglMakeCurrent( display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+  eglDestroyContext( display, context );
+  eglTerminate( display );
+  return error ? 1 : 0;
+}
+
+int32_t init_egl( EGLDisplay* display, EGLContext* context )
+{
+  PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+    (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+  if( get_platform_display )
+  {
+    *display = get_platform_display( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL );
+  }
+  else
+  {
+    *display = eglGetDisplay( EGL_DEFAULT_DISPLAY );
+  }
+
+  if( !eglInitialize( *display, NULL, NULL ) )
+  {
+    fprintf( stderr, "[ERROR] Failed to initialize EGL display!\n" );
+    return 1;
+  }
+
+  eglBindAPI( EGL_OPENGL_API );
+  EGLint context_attribs[] =
+  {
+    EGL_CONTEXT_MAJOR_VERSION, DD_GL_VERSION_MAJOR,
+    EGL_CONTEXT_MINOR_VERSION, DD_GL_VERSION_MINOR,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE
+  };
+  *context = eglCreateContext( *display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs );
+  if( *context == EGL_NO_CONTEXT ||
+      !eglMakeCurrent( *display, EGL_NO_SURFACE, EGL_NO_SURFACE, *context ) )
+  {
+    fprintf( stderr, "[ERROR] Failed to create surfaceless OpenGL context!\n" );
+    return 1;
+  }
+
+  if( !gladLoadGLLoader( (GLADloadproc)eglGetProcAddress ) )
+  {
+    fprintf( stderr, "[ERROR] Failed to initialize OpenGL context!\n" );
+    return 1;
+  }
+  return 0;
+}
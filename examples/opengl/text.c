@@ -154,29 +154,27 @@ frame(app_state_t* state)
 
   int32_t base_x = -w / 2;
   int32_t base_y = h / 2;
-  dd_set_font(dd_ctx, CMU_FONT);
-  dd_set_color(dd_ctx, DBGDRAW_LIGHT_LIME);
   dd_set_shading_type(dd_ctx, DBGDRAW_SHADING_TEXT);
+
+  // Fonts can change within a command, all three lines are one draw call
   dd_begin_cmd(dd_ctx, DBGDRAW_MODE_FILL);
+  dd_set_font(dd_ctx, CMU_FONT);
+  dd_set_color(dd_ctx, DBGDRAW_LIGHT_LIME);
   dd_text_line(dd_ctx,
                msh_vec3(base_x + 10.0f, base_y - 42.0f, 0.0f).data,
                "The quick brown fox jumps over the lazy dog",
                NULL);
-  dd_end_cmd(dd_ctx);
 
   dd_set_color(dd_ctx, DBGDRAW_LIGHT_CYAN);
   dd_text_info_t info = {0};
   dd_set_font(dd_ctx, ANAKTORIA_FONT);
-  dd_begin_cmd(dd_ctx, DBGDRAW_MODE_FILL);
   dd_text_line(dd_ctx,
                msh_vec3(base_x + 10.0f, base_y - 82.0f, 0.0f).data,
                "Sphinx of black quartz, judge my vow.",
                &info);
-  dd_end_cmd(dd_ctx);
 
   dd_set_font(dd_ctx, CMU_FONT);
   dd_set_color(dd_ctx, DBGDRAW_LIGHT_BROWN);
-  dd_begin_cmd(dd_ctx, DBGDRAW_MODE_FILL);
   dd_text_line(dd_ctx,
                msh_vec3(base_x + 10.0f, base_y - 122.0f, 0.0f).data,
                "Σωκράτης was a famous philosopher",
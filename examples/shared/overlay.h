@@ -89,23 +89,106 @@ draw_frame_timer(dd_ctx_t* ctx,
 
   float dd_time = msh_compute_mean(frame_times, n_times);
 
-  char dd_time_buf[128];
-  snprintf(dd_time_buf,
-           128,
-           "Frame Time %4.3fms (%5.1f FPS)",
-           dd_time,
-           1000.0 / dd_time);
   dd_set_shading_type(ctx, DBGDRAW_SHADING_TEXT);
   dd_begin_cmd(ctx, DBGDRAW_MODE_FILL);
   dd_text_info_t alignment = {.vert_align = DBGDRAW_TEXT_TOP,
                               .horz_align = DBGDRAW_TEXT_RIGHT};
   dd_set_color(ctx, dd_rgbf(0.1f, 0.1f, 0.3f));
-  dd_text_line(ctx,
-               msh_vec3(max_x - 5.5f, min_y - 5.5f, 0.0).data,
-               dd_time_buf,
-               &alignment);
+  dd_text_fmt(ctx,
+              msh_vec3(max_x - 5.5f, min_y - 5.5f, 0.0).data,
+              &alignment,
+              "Frame Time %4.3fms (%5.1f FPS)",
+              dd_time,
+              1000.0 / dd_time);
   dd_end_cmd(ctx);
   dd_set_shading_type(ctx, DBGDRAW_SHADING_NONE);
 
   return DBGDRAW_ERR_OK;
-}
\ No newline at end of file
+}
+
+// Graphs CPU (record + sort + render) and GPU time that dbgdraw spent on each
+// of the 'n_timings' frames stored in the 'timings' ring buffer.
+int32_t
+draw_frame_timings(dd_ctx_t* ctx,
+                   int32_t x,
+                   int32_t y,
+                   dd_frame_timings_t* timings,
+                   int32_t n_timings,
+                   int32_t timing_idx)
+{
+  float min_x = (float)x;
+  float min_y = (float)y;
+  float max_x = min_x + 250;
+  float max_y = min_y + 80;
+
+  dd_begin_cmd(ctx, DBGDRAW_MODE_FILL);
+  dd_color_t col = DBGDRAW_GRAY;
+  col.a          = 125;
+  dd_set_color(ctx, col);
+  dd_quad(ctx,
+          msh_vec3(min_x, min_y, 0.0f).data,
+          msh_vec3(max_x, min_y, 0.0f).data,
+          msh_vec3(max_x, max_y, 0.0f).data,
+          msh_vec3(min_x, max_y, 0.0f).data);
+
+  col.a = 255;
+  dd_set_color(ctx, col);
+  dd_quad(ctx,
+          msh_vec3(min_x, min_y, 0.0f).data,
+          msh_vec3(max_x, min_y, 0.0f).data,
+          msh_vec3(max_x, min_y + 20.0f, 0.0f).data,
+          msh_vec3(min_x, min_y + 20.0f, 0.0f).data);
+  dd_end_cmd(ctx);
+
+  dd_begin_cmd(ctx, DBGDRAW_MODE_STROKE);
+  dd_set_primitive_size(ctx, 2.0f);
+
+  min_y += 20.0f;
+  static float min = 0;
+  static float max = 4;
+  float mean_cpu   = 0.0f;
+  float mean_gpu   = 0.0f;
+  for (int32_t i = 0; i < n_timings - 1; ++i)
+  {
+    dd_frame_timings_t* t1 = timings + (timing_idx + i) % n_timings;
+    dd_frame_timings_t* t2 = timings + (timing_idx + i + 1) % n_timings;
+    float cpu1   = t1->record_ms + t1->sort_ms + t1->render_ms;
+    float cpu2   = t2->record_ms + t2->sort_ms + t2->render_ms;
+    float cur_x1 = min_x + ((i) * (max_x - min_x) / (float)(n_timings - 1));
+    float cur_x2 = min_x + ((i + 1) * (max_x - min_x) / (float)(n_timings - 1));
+
+    float t_cpu1 = msh_clamp01((cpu1 - min) / (max - min));
+    float t_cpu2 = msh_clamp01((cpu2 - min) / (max - min));
+    float t_gpu1 = msh_clamp01((t1->gpu_ms - min) / (max - min));
+    float t_gpu2 = msh_clamp01((t2->gpu_ms - min) / (max - min));
+
+    dd_set_color(ctx, DBGDRAW_ORANGE);
+    dd_line(ctx,
+            msh_vec3(cur_x1, min_y + t_cpu1 * (max_y - min_y), 0.0).data,
+            msh_vec3(cur_x2, min_y + t_cpu2 * (max_y - min_y), 0.0).data);
+    dd_set_color(ctx, DBGDRAW_CYAN);
+    dd_line(ctx,
+            msh_vec3(cur_x1, min_y + t_gpu1 * (max_y - min_y), 0.0).data,
+            msh_vec3(cur_x2, min_y + t_gpu2 * (max_y - min_y), 0.0).data);
+
+    mean_cpu += cpu2 / (n_timings - 1);
+    mean_gpu += DD_MAX(t2->gpu_ms, 0.0f) / (n_timings - 1);
+  }
+  dd_end_cmd(ctx);
+
+  dd_set_shading_type(ctx, DBGDRAW_SHADING_TEXT);
+  dd_begin_cmd(ctx, DBGDRAW_MODE_FILL);
+  dd_text_info_t alignment = {.vert_align = DBGDRAW_TEXT_TOP,
+                              .horz_align = DBGDRAW_TEXT_RIGHT};
+  dd_set_color(ctx, dd_rgbf(0.1f, 0.1f, 0.3f));
+  dd_text_fmt(ctx,
+              msh_vec3(max_x - 5.5f, min_y - 5.5f, 0.0).data,
+              &alignment,
+              "dbgdraw CPU %4.3fms GPU %4.3fms",
+              mean_cpu,
+              mean_gpu);
+  dd_end_cmd(ctx);
+  dd_set_shading_type(ctx, DBGDRAW_SHADING_NONE);
+
+  return DBGDRAW_ERR_OK;
+}
@@ -0,0 +1,1659 @@
+#ifndef DBGDRAW_SOFTWARE_H
+#define DBGDRAW_SOFTWARE_H
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// Backend that renders on the cpu, for machines without a gpu or a software
+// OpenGL implementation. It follows what the OpenGL backends do - fill commands
+// are drawn as triangles, strokes are expanded into the same anti-aliased quads
+// as the line shader produces, and points are squares of 'size' pixels.
+// Procedural primitives and impostors are not supported, so dbgdraw tessellates
+// them before they reach the backend.
+//
+// Triangles are collected into batches of DBGDRAW_SW_BATCH_SIZE, binned into
+// screen tiles and the tiles are rasterized in parallel. Each tile keeps the
+// submission order of its triangles, so blending gives the same result as on
+// the gpu, regardless of the number of threads. Pixels are shaded four at a
+// time, with SSE2 where available.
+
+// Width and height of a tile in pixels. Needs to be a multiple of 4, as pixels
+// are shaded in groups of four along a row.
+#ifndef DBGDRAW_SW_TILE_SIZE
+#define DBGDRAW_SW_TILE_SIZE 64
+#endif
+
+// Number of triangles set up before they are rasterized.
+#ifndef DBGDRAW_SW_BATCH_SIZE
+#define DBGDRAW_SW_BATCH_SIZE 65536
+#endif
+
+// Number of threads that rasterize tiles, including the one that calls
+// dd_render. Zero uses one thread per core.
+#ifndef DBGDRAW_SW_THREAD_COUNT
+#define DBGDRAW_SW_THREAD_COUNT 0
+#endif
+
+#ifndef DBGDRAW_SW_MAX_THREADS
+#define DBGDRAW_SW_MAX_THREADS 64
+#endif
+
+#if !defined(DBGDRAW_SW_NO_SIMD) &&                                            \
+  (defined(__SSE2__) || defined(_M_X64) ||                                     \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define DBGDRAW_SW_SSE2 1
+#include <emmintrin.h>
+#else
+#define DBGDRAW_SW_SSE2 0
+#endif
+
+#if defined(_WIN32)
+typedef HANDLE dd__sw_thread_t;
+typedef CRITICAL_SECTION dd__sw_mutex_t;
+typedef CONDITION_VARIABLE dd__sw_cond_t;
+#else
+typedef pthread_t dd__sw_thread_t;
+typedef pthread_mutex_t dd__sw_mutex_t;
+typedef pthread_cond_t dd__sw_cond_t;
+#endif
+
+// Vertex in clip space. 'attr' holds the normal for lit shading, texture
+// coordinates for text and (u, v, width, half length) for lines, the same
+// values that the OpenGL shaders pass to fragment stage.
+typedef struct dd__sw_vertex
+{
+  float pos[4];
+  float col[4];
+  float attr[4];
+} dd__sw_vertex_t;
+
+typedef enum dd__sw_shading
+{
+  DD__SW_SHADING_NONE  = DBGDRAW_SHADING_NONE,
+  DD__SW_SHADING_SOLID = DBGDRAW_SHADING_SOLID,
+  DD__SW_SHADING_TEXT  = DBGDRAW_SHADING_TEXT,
+  DD__SW_SHADING_LINE,
+} dd__sw_shading_t;
+
+// Triangle in window space, with y pointing down. Edge 'i' is opposite to
+// vertex 'i', and its function a * x + b * y + c is positive inside the
+// triangle. Vertices are snapped to 1/256th of a pixel.
+typedef struct dd__sw_tri
+{
+  float x[3];
+  float y[3];
+  float a[3];
+  float b[3];
+  float inv_area;
+  float z[3];
+  float z_offset;
+  float inv_w[3];
+  float col[3][4];
+  float attr[3][4];
+  int32_t min_x, min_y, max_x, max_y;
+  uint8_t shading;
+  uint8_t top_left;
+  int8_t texture_idx;
+} dd__sw_tri_t;
+
+typedef struct dd__sw_bin
+{
+  uint32_t* data;
+  int32_t len;
+  int32_t cap;
+} dd__sw_bin_t;
+
+typedef struct dd__sw_texture
+{
+  uint8_t* data;
+  int32_t width;
+  int32_t height;
+} dd__sw_texture_t;
+
+typedef struct dd_render_backend
+{
+  uint8_t* pixels;
+  float* depth;
+  int32_t width;
+  int32_t height;
+  float* own_depth;
+  size_t own_depth_len;
+  int32_t image_frame_count;
+
+  float viewport[4];
+  int32_t scissor[4];
+  dd_vec2_t aa_radius;
+  uint8_t enable_depth_test;
+
+  dd__sw_vertex_t* cmd_verts;
+  dd__sw_vertex_t* instance_verts;
+  dd_vec2_t* screen;
+  int32_t verts_cap;
+
+  dd__sw_tri_t* tris;
+  int32_t tris_len;
+  int32_t tris_cap;
+
+  dd__sw_bin_t* bins;
+  int32_t* active_tiles;
+  int32_t active_tiles_len;
+  int32_t tiles_x;
+  int32_t tiles_y;
+  int32_t tiles_cap;
+
+  dd__sw_texture_t textures[16];
+  int32_t textures_len;
+
+  dd__sw_thread_t threads[DBGDRAW_SW_MAX_THREADS];
+  int32_t thread_count;
+  dd__sw_mutex_t mutex;
+  dd__sw_cond_t work_cond;
+  dd__sw_cond_t done_cond;
+  int32_t job_idx;
+  int32_t next_tile;
+  int32_t tiles_done;
+  int32_t quit;
+} dd_render_backend_t;
+
+// Render target. 'pixels' must hold width * height * 4 bytes (RGBA, top row
+// first) and 'depth' width * height floats, in the same order. Depth values
+// are in [0, 1], like in the OpenGL depth buffer. If 'depth' is NULL, the
+// backend uses a buffer of its own. The target is not cleared by dd_render,
+// use dd_sw_clear at the start of a frame.
+typedef struct dd_sw_target
+{
+  int32_t width;
+  int32_t height;
+  uint8_t* pixels;
+  float* depth;
+} dd_sw_target_t;
+
+int32_t dd_sw_set_target(dd_ctx_t* ctx, dd_sw_target_t* target);
+int32_t dd_sw_clear(dd_ctx_t* ctx, dd_color_t color, float depth);
+
+// Offscreen rendering, with the same interface as the OpenGL backends. Pixels
+// are ready as soon as dd_render_to_image returns, so 'frame_idx' is always the
+// index of the frame just rendered, and dd_flush_image has nothing to return.
+// dd_render_to_image replaces the target set with dd_sw_set_target.
+typedef struct dd_image
+{
+  int32_t width;
+  int32_t height;
+  dd_color_t clear_color;
+  uint8_t* pixels;
+  int32_t frame_idx;
+} dd_image_t;
+
+int32_t dd_render_to_image(dd_ctx_t* ctx, dd_image_t* image);
+int32_t dd_flush_image(dd_ctx_t* ctx, dd_image_t* image);
+
+////////////////////////////////////////////////////////////////////////////////
+// Four wide float vectors. Comparisons return masks, that can only be passed
+// to dd__sw_and, dd__sw_or, dd__sw_select and dd__sw_any.
+////////////////////////////////////////////////////////////////////////////////
+
+#if DBGDRAW_SW_SSE2
+
+typedef __m128 dd__sw_f4_t;
+
+static inline dd__sw_f4_t
+dd__sw_splat(float a)
+{
+  return _mm_set1_ps(a);
+}
+
+static inline dd__sw_f4_t
+dd__sw_lanes(float a, float b, float c, float d)
+{
+  return _mm_setr_ps(a, b, c, d);
+}
+
+static inline dd__sw_f4_t
+dd__sw_mask(bool value)
+{
+  return _mm_castsi128_ps(_mm_set1_epi32(value ? -1 : 0));
+}
+
+static inline dd__sw_f4_t
+dd__sw_load(const float* src)
+{
+  return _mm_loadu_ps(src);
+}
+
+static inline void
+dd__sw_store(float* dst, dd__sw_f4_t a)
+{
+  _mm_storeu_ps(dst, a);
+}
+
+// clang-format off
+static inline dd__sw_f4_t dd__sw_add(dd__sw_f4_t a, dd__sw_f4_t b) { return _mm_add_ps(a, b); }
+static inline dd__sw_f4_t dd__sw_sub(dd__sw_f4_t a, dd__sw_f4_t b) { return _mm_sub_ps(a, b); }
+static inline dd__sw_f4_t dd__sw_mul(dd__sw_f4_t a, dd__sw_f4_t b) { return _mm_mul_ps(a, b); }
+static inline dd__sw_f4_t dd__sw_div(dd__sw_f4_t a, dd__sw_f4_t b) { return _mm_div_ps(a, b); }
+static inline dd__sw_f4_t dd__sw_min(dd__sw_f4_t a, dd__sw_f4_t b) { return _mm_min_ps(a, b); }
+static inline dd__sw_f4_t dd__sw_max(dd__sw_f4_t a, dd__sw_f4_t b) { return _mm_max_ps(a, b); }
+static inline dd__sw_f4_t dd__sw_cmpgt(dd__sw_f4_t a, dd__sw_f4_t b) { return _mm_cmpgt_ps(a, b); }
+static inline dd__sw_f4_t dd__sw_cmpge(dd__sw_f4_t a, dd__sw_f4_t b) { return _mm_cmpge_ps(a, b); }
+static inline dd__sw_f4_t dd__sw_cmplt(dd__sw_f4_t a, dd__sw_f4_t b) { return _mm_cmplt_ps(a, b); }
+static inline dd__sw_f4_t dd__sw_cmple(dd__sw_f4_t a, dd__sw_f4_t b) { return _mm_cmple_ps(a, b); }
+static inline dd__sw_f4_t dd__sw_cmpeq(dd__sw_f4_t a, dd__sw_f4_t b) { return _mm_cmpeq_ps(a, b); }
+static inline dd__sw_f4_t dd__sw_and(dd__sw_f4_t a, dd__sw_f4_t b) { return _mm_and_ps(a, b); }
+static inline dd__sw_f4_t dd__sw_or(dd__sw_f4_t a, dd__sw_f4_t b) { return _mm_or_ps(a, b); }
+static inline int32_t dd__sw_any(dd__sw_f4_t mask) { return _mm_movemask_ps(mask); }
+// clang-format on
+
+static inline dd__sw_f4_t
+dd__sw_select(dd__sw_f4_t mask, dd__sw_f4_t a, dd__sw_f4_t b)
+{
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline dd__sw_f4_t
+dd__sw_abs(dd__sw_f4_t a)
+{
+  return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+}
+
+static inline void
+dd__sw_load_rgba(const uint8_t* src,
+                 dd__sw_f4_t* r,
+                 dd__sw_f4_t* g,
+                 dd__sw_f4_t* b,
+                 dd__sw_f4_t* a)
+{
+  __m128i pixels = _mm_loadu_si128((const __m128i*)src);
+  __m128i byte   = _mm_set1_epi32(0xff);
+  *r = _mm_cvtepi32_ps(_mm_and_si128(pixels, byte));
+  *g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 8), byte));
+  *b = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 16), byte));
+  *a = _mm_cvtepi32_ps(_mm_srli_epi32(pixels, 24));
+}
+
+// Values are expected to be in [0, 255]
+static inline void
+dd__sw_store_rgba(uint8_t* dst,
+                  dd__sw_f4_t mask,
+                  dd__sw_f4_t r,
+                  dd__sw_f4_t g,
+                  dd__sw_f4_t b,
+                  dd__sw_f4_t a)
+{
+  __m128i pixels = _mm_cvtps_epi32(r);
+  pixels = _mm_or_si128(pixels, _mm_slli_epi32(_mm_cvtps_epi32(g), 8));
+  pixels = _mm_or_si128(pixels, _mm_slli_epi32(_mm_cvtps_epi32(b), 16));
+  pixels = _mm_or_si128(pixels, _mm_slli_epi32(_mm_cvtps_epi32(a), 24));
+  __m128i keep = _mm_castps_si128(mask);
+  __m128i prev = _mm_loadu_si128((const __m128i*)dst);
+  pixels = _mm_or_si128(_mm_and_si128(keep, pixels), _mm_andnot_si128(keep, prev));
+  _mm_storeu_si128((__m128i*)dst, pixels);
+}
+
+#else
+
+typedef struct dd__sw_f4
+{
+  float v[4];
+} dd__sw_f4_t;
+
+#define DD__SW_LANEWISE(expr)                                                  \
+  dd__sw_f4_t r;                                                               \
+  for (int32_t i = 0; i < 4; ++i) { r.v[i] = (expr); }                        \
+  return r
+
+// clang-format off
+static inline dd__sw_f4_t dd__sw_splat(float a) { DD__SW_LANEWISE(a); }
+static inline dd__sw_f4_t dd__sw_mask(bool value) { DD__SW_LANEWISE(value ? 1.0f : 0.0f); }
+static inline dd__sw_f4_t dd__sw_load(const float* src) { DD__SW_LANEWISE(src[i]); }
+static inline dd__sw_f4_t dd__sw_add(dd__sw_f4_t a, dd__sw_f4_t b) { DD__SW_LANEWISE(a.v[i] + b.v[i]); }
+static inline dd__sw_f4_t dd__sw_sub(dd__sw_f4_t a, dd__sw_f4_t b) { DD__SW_LANEWISE(a.v[i] - b.v[i]); }
+static inline dd__sw_f4_t dd__sw_mul(dd__sw_f4_t a, dd__sw_f4_t b) { DD__SW_LANEWISE(a.v[i] * b.v[i]); }
+static inline dd__sw_f4_t dd__sw_div(dd__sw_f4_t a, dd__sw_f4_t b) { DD__SW_LANEWISE(a.v[i] / b.v[i]); }
+static inline dd__sw_f4_t dd__sw_min(dd__sw_f4_t a, dd__sw_f4_t b) { DD__SW_LANEWISE(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+static inline dd__sw_f4_t dd__sw_max(dd__sw_f4_t a, dd__sw_f4_t b) { DD__SW_LANEWISE(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+static inline dd__sw_f4_t dd__sw_cmpgt(dd__sw_f4_t a, dd__sw_f4_t b) { DD__SW_LANEWISE(a.v[i] > b.v[i]); }
+static inline dd__sw_f4_t dd__sw_cmpge(dd__sw_f4_t a, dd__sw_f4_t b) { DD__SW_LANEWISE(a.v[i] >= b.v[i]); }
+static inline dd__sw_f4_t dd__sw_cmplt(dd__sw_f4_t a, dd__sw_f4_t b) { DD__SW_LANEWISE(a.v[i] < b.v[i]); }
+static inline dd__sw_f4_t dd__sw_cmple(dd__sw_f4_t a, dd__sw_f4_t b) { DD__SW_LANEWISE(a.v[i] <= b.v[i]); }
+static inline dd__sw_f4_t dd__sw_cmpeq(dd__sw_f4_t a, dd__sw_f4_t b) { DD__SW_LANEWISE(a.v[i] == b.v[i]); }
+static inline dd__sw_f4_t dd__sw_and(dd__sw_f4_t a, dd__sw_f4_t b) { DD__SW_LANEWISE(a.v[i] != 0.0f && b.v[i] != 0.0f); }
+static inline dd__sw_f4_t dd__sw_or(dd__sw_f4_t a, dd__sw_f4_t b) { DD__SW_LANEWISE(a.v[i] != 0.0f || b.v[i] != 0.0f); }
+static inline dd__sw_f4_t dd__sw_select(dd__sw_f4_t mask, dd__sw_f4_t a, dd__sw_f4_t b) { DD__SW_LANEWISE(mask.v[i] != 0.0f ? a.v[i] : b.v[i]); }
+static inline dd__sw_f4_t dd__sw_abs(dd__sw_f4_t a) { DD__SW_LANEWISE(fabsf(a.v[i])); }
+// clang-format on
+
+static inline dd__sw_f4_t
+dd__sw_lanes(float a, float b, float c, float d)
+{
+  dd__sw_f4_t r = { { a, b, c, d } };
+  return r;
+}
+
+static inline void
+dd__sw_store(float* dst, dd__sw_f4_t a)
+{
+  for (int32_t i = 0; i < 4; ++i) { dst[i] = a.v[i]; }
+}
+
+static inline int32_t
+dd__sw_any(dd__sw_f4_t mask)
+{
+  return mask.v[0] != 0.0f || mask.v[1] != 0.0f || mask.v[2] != 0.0f ||
+         mask.v[3] != 0.0f;
+}
+
+static inline void
+dd__sw_load_rgba(const uint8_t* src,
+                 dd__sw_f4_t* r,
+                 dd__sw_f4_t* g,
+                 dd__sw_f4_t* b,
+                 dd__sw_f4_t* a)
+{
+  for (int32_t i = 0; i < 4; ++i)
+  {
+    r->v[i] = src[4 * i + 0];
+    g->v[i] = src[4 * i + 1];
+    b->v[i] = src[4 * i + 2];
+    a->v[i] = src[4 * i + 3];
+  }
+}
+
+static inline void
+dd__sw_store_rgba(uint8_t* dst,
+                  dd__sw_f4_t mask,
+                  dd__sw_f4_t r,
+                  dd__sw_f4_t g,
+                  dd__sw_f4_t b,
+                  dd__sw_f4_t a)
+{
+  for (int32_t i = 0; i < 4; ++i)
+  {
+    if (mask.v[i] == 0.0f) { continue; }
+    dst[4 * i + 0] = (uint8_t)(r.v[i] + 0.5f);
+    dst[4 * i + 1] = (uint8_t)(g.v[i] + 0.5f);
+    dst[4 * i + 2] = (uint8_t)(b.v[i] + 0.5f);
+    dst[4 * i + 3] = (uint8_t)(a.v[i] + 0.5f);
+  }
+}
+
+#undef DD__SW_LANEWISE
+
+#endif
+
+static inline dd__sw_f4_t
+dd__sw_clamp01(dd__sw_f4_t a)
+{
+  return dd__sw_min(dd__sw_max(a, dd__sw_splat(0.0f)), dd__sw_splat(1.0f));
+}
+
+static inline dd__sw_f4_t
+dd__sw_smoothstep(dd__sw_f4_t edge0, float edge1, dd__sw_f4_t x)
+{
+  dd__sw_f4_t t = dd__sw_clamp01(
+    dd__sw_div(dd__sw_sub(x, edge0), dd__sw_sub(dd__sw_splat(edge1), edge0)));
+  return dd__sw_mul(dd__sw_mul(t, t),
+                    dd__sw_sub(dd__sw_splat(3.0f),
+                               dd__sw_mul(dd__sw_splat(2.0f), t)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Thread pool
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(_WIN32)
+// clang-format off
+static inline void dd__sw_lock(dd__sw_mutex_t* m) { EnterCriticalSection(m); }
+static inline void dd__sw_unlock(dd__sw_mutex_t* m) { LeaveCriticalSection(m); }
+static inline void dd__sw_wait(dd__sw_cond_t* c, dd__sw_mutex_t* m) { SleepConditionVariableCS(c, m, INFINITE); }
+static inline void dd__sw_wake_all(dd__sw_cond_t* c) { WakeAllConditionVariable(c); }
+// clang-format on
+#else
+// clang-format off
+static inline void dd__sw_lock(dd__sw_mutex_t* m) { pthread_mutex_lock(m); }
+static inline void dd__sw_unlock(dd__sw_mutex_t* m) { pthread_mutex_unlock(m); }
+static inline void dd__sw_wait(dd__sw_cond_t* c, dd__sw_mutex_t* m) { pthread_cond_wait(c, m); }
+static inline void dd__sw_wake_all(dd__sw_cond_t* c) { pthread_cond_broadcast(c); }
+// clang-format on
+#endif
+
+void dd__sw_raster_tile(dd_render_backend_t* backend, int32_t tile_idx);
+
+// Called with the mutex locked, returns with it locked
+void
+dd__sw_run_tiles(dd_render_backend_t* backend)
+{
+  while (backend->next_tile < backend->active_tiles_len)
+  {
+    int32_t tile_idx = backend->active_tiles[backend->next_tile++];
+    dd__sw_unlock(&backend->mutex);
+    dd__sw_raster_tile(backend, tile_idx);
+    dd__sw_lock(&backend->mutex);
+    if (++backend->tiles_done == backend->active_tiles_len)
+    {
+      dd__sw_wake_all(&backend->done_cond);
+    }
+  }
+}
+
+void
+dd__sw_worker(dd_render_backend_t* backend)
+{
+  int32_t job_idx = 0;
+  dd__sw_lock(&backend->mutex);
+  for (;;)
+  {
+    while (backend->job_idx == job_idx && !backend->quit)
+    {
+      dd__sw_wait(&backend->work_cond, &backend->mutex);
+    }
+    if (backend->quit) { break; }
+    job_idx = backend->job_idx;
+    dd__sw_run_tiles(backend);
+  }
+  dd__sw_unlock(&backend->mutex);
+}
+
+#if defined(_WIN32)
+DWORD WINAPI
+dd__sw_thread_main(LPVOID param)
+{
+  dd__sw_worker((dd_render_backend_t*)param);
+  return 0;
+}
+#else
+void*
+dd__sw_thread_main(void* param)
+{
+  dd__sw_worker((dd_render_backend_t*)param);
+  return NULL;
+}
+#endif
+
+int32_t
+dd__sw_core_count(void)
+{
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (int32_t)info.dwNumberOfProcessors;
+#else
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (int32_t)count : 1;
+#endif
+}
+
+void
+dd__sw_start_threads(dd_render_backend_t* backend)
+{
+  int32_t thread_count = DBGDRAW_SW_THREAD_COUNT;
+  if (thread_count <= 0) { thread_count = dd__sw_core_count(); }
+  thread_count = DD_MAX(1, DD_MIN(thread_count, DBGDRAW_SW_MAX_THREADS));
+
+#if defined(_WIN32)
+  InitializeCriticalSection(&backend->mutex);
+  InitializeConditionVariable(&backend->work_cond);
+  InitializeConditionVariable(&backend->done_cond);
+#else
+  pthread_mutex_init(&backend->mutex, NULL);
+  pthread_cond_init(&backend->work_cond, NULL);
+  pthread_cond_init(&backend->done_cond, NULL);
+#endif
+
+  // The thread that calls dd_render rasterizes tiles too
+  backend->thread_count = 1;
+  for (int32_t i = 1; i < thread_count; ++i)
+  {
+    dd__sw_thread_t* thread = backend->threads + backend->thread_count;
+#if defined(_WIN32)
+    *thread = CreateThread(NULL, 0, dd__sw_thread_main, backend, 0, NULL);
+    if (!*thread) { break; }
+#else
+    if (pthread_create(thread, NULL, dd__sw_thread_main, backend)) { break; }
+#endif
+    backend->thread_count++;
+  }
+}
+
+void
+dd__sw_stop_threads(dd_render_backend_t* backend)
+{
+  dd__sw_lock(&backend->mutex);
+  backend->quit = 1;
+  dd__sw_wake_all(&backend->work_cond);
+  dd__sw_unlock(&backend->mutex);
+
+  for (int32_t i = 1; i < backend->thread_count; ++i)
+  {
+#if defined(_WIN32)
+    WaitForSingleObject(backend->threads[i], INFINITE);
+    CloseHandle(backend->threads[i]);
+#else
+    pthread_join(backend->threads[i], NULL);
+#endif
+  }
+  backend->thread_count = 0;
+
+#if defined(_WIN32)
+  DeleteCriticalSection(&backend->mutex);
+#else
+  pthread_cond_destroy(&backend->done_cond);
+  pthread_cond_destroy(&backend->work_cond);
+  pthread_mutex_destroy(&backend->mutex);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Rasterization
+////////////////////////////////////////////////////////////////////////////////
+
+// Bilinear filtering with repeat wrapping, same as the sampler of the font
+// texture in the OpenGL backends.
+float
+dd__sw_sample_texture(const dd__sw_texture_t* tex, float u, float v)
+{
+  float fx = u * tex->width - 0.5f;
+  float fy = v * tex->height - 0.5f;
+  if (!(fabsf(fx) < 1e7f && fabsf(fy) < 1e7f)) { return 0.0f; }
+
+  float floor_x = floorf(fx);
+  float floor_y = floorf(fy);
+  float tx      = fx - floor_x;
+  float ty      = fy - floor_y;
+  int32_t x0    = (int32_t)floor_x % tex->width;
+  int32_t y0    = (int32_t)floor_y % tex->height;
+  if (x0 < 0) { x0 += tex->width; }
+  if (y0 < 0) { y0 += tex->height; }
+  int32_t x1 = (x0 + 1) % tex->width;
+  int32_t y1 = (y0 + 1) % tex->height;
+
+  const uint8_t* row0 = tex->data + (size_t)y0 * tex->width;
+  const uint8_t* row1 = tex->data + (size_t)y1 * tex->width;
+  float top           = row0[x0] + (row0[x1] - row0[x0]) * tx;
+  float bottom        = row1[x0] + (row1[x1] - row1[x0]) * tx;
+  return (top + (bottom - top) * ty) * (1.0f / 255.0f);
+}
+
+// Interpolates vertex values with barycentric weights 'w1' and 'w2' (the weight
+// of the first vertex is implied).
+static inline dd__sw_f4_t
+dd__sw_interp(const float* v0,
+              const float* v1,
+              const float* v2,
+              int32_t idx,
+              dd__sw_f4_t w1,
+              dd__sw_f4_t w2)
+{
+  dd__sw_f4_t a  = dd__sw_splat(v0[idx]);
+  dd__sw_f4_t d1 = dd__sw_splat(v1[idx] - v0[idx]);
+  dd__sw_f4_t d2 = dd__sw_splat(v2[idx] - v0[idx]);
+  return dd__sw_add(a, dd__sw_add(dd__sw_mul(w1, d1), dd__sw_mul(w2, d2)));
+}
+
+void
+dd__sw_raster_tri(dd_render_backend_t* backend,
+                  const dd__sw_tri_t* tri,
+                  int32_t tile_x,
+                  int32_t tile_y,
+                  int32_t tile_max_x,
+                  int32_t tile_max_y)
+{
+  int32_t min_x = DD_MAX(tri->min_x, tile_x);
+  int32_t min_y = DD_MAX(tri->min_y, tile_y);
+  int32_t max_x = DD_MIN(tri->max_x, tile_max_x);
+  int32_t max_y = DD_MIN(tri->max_y, tile_max_y);
+  if (min_x > max_x || min_y > max_y) { return; }
+
+  // Edge functions are evaluated relative to the tile, the same way for every
+  // triangle, so an edge shared by two triangles gives exactly opposite values,
+  // and no pixel along it is drawn twice or skipped.
+  double center_x = tile_x + 0.5;
+  double center_y = tile_y + 0.5;
+  float edge_c[3];
+  dd__sw_f4_t edge_a[3];
+  dd__sw_f4_t top_left[3];
+  for (int32_t i = 0; i < 3; ++i)
+  {
+    int32_t j = (i + 1) % 3;
+    int32_t k = (i + 2) % 3;
+    edge_c[i] = (float)((double)tri->a[i] * center_x +
+                        (double)tri->b[i] * center_y +
+                        ((double)tri->x[j] * tri->y[k] -
+                         (double)tri->x[k] * tri->y[j]));
+    edge_a[i]   = dd__sw_splat(tri->a[i]);
+    top_left[i] = dd__sw_mask(tri->top_left & (1 << i));
+  }
+
+  const dd__sw_texture_t* texture =
+    tri->texture_idx >= 0 ? backend->textures + tri->texture_idx : NULL;
+  bool depth_test           = backend->enable_depth_test;
+  dd__sw_f4_t zero          = dd__sw_splat(0.0f);
+  dd__sw_f4_t one           = dd__sw_splat(1.0f);
+  dd__sw_f4_t inv_area      = dd__sw_splat(tri->inv_area);
+  dd__sw_f4_t lanes         = dd__sw_lanes(0.0f, 1.0f, 2.0f, 3.0f);
+  dd__sw_f4_t lane_min      = dd__sw_splat((float)(min_x - tile_x));
+  dd__sw_f4_t lane_max      = dd__sw_splat((float)(max_x - tile_x));
+  dd__sw_f4_t inv_w[3]      = { dd__sw_splat(tri->inv_w[0]),
+                                dd__sw_splat(tri->inv_w[1]),
+                                dd__sw_splat(tri->inv_w[2]) };
+  dd__sw_f4_t aa_width      = dd__sw_splat(2.0f * backend->aa_radius.x);
+  dd__sw_f4_t aa_length     = dd__sw_splat(backend->aa_radius.y);
+  dd__sw_f4_t z_offset      = dd__sw_splat(tri->z_offset);
+  const float* z            = tri->z;
+  int32_t width             = backend->width;
+  int32_t start_x           = tile_x + ((min_x - tile_x) & ~3);
+
+  for (int32_t y = min_y; y <= max_y; ++y)
+  {
+    float dy = (float)(y - tile_y);
+    dd__sw_f4_t edge_row[3];
+    for (int32_t i = 0; i < 3; ++i)
+    {
+      edge_row[i] = dd__sw_splat(tri->b[i] * dy + edge_c[i]);
+    }
+    uint8_t* pixels_row = backend->pixels + (size_t)y * width * 4;
+    float* depth_row    = backend->depth + (size_t)y * width;
+
+    for (int32_t x = start_x; x <= max_x; x += 4)
+    {
+      dd__sw_f4_t dx   = dd__sw_add(dd__sw_splat((float)(x - tile_x)), lanes);
+      dd__sw_f4_t mask = dd__sw_and(dd__sw_cmpge(dx, lane_min),
+                                    dd__sw_cmple(dx, lane_max));
+      dd__sw_f4_t edge[3];
+      for (int32_t i = 0; i < 3; ++i)
+      {
+        edge[i] = dd__sw_add(dd__sw_mul(edge_a[i], dx), edge_row[i]);
+        dd__sw_f4_t inside =
+          dd__sw_or(dd__sw_cmpgt(edge[i], zero),
+                    dd__sw_and(dd__sw_cmpeq(edge[i], zero), top_left[i]));
+        mask = dd__sw_and(mask, inside);
+      }
+      if (!dd__sw_any(mask)) { continue; }
+
+      dd__sw_f4_t b1 = dd__sw_mul(edge[1], inv_area);
+      dd__sw_f4_t b2 = dd__sw_mul(edge[2], inv_area);
+      dd__sw_f4_t b0 = dd__sw_sub(dd__sw_sub(one, b1), b2);
+
+      // Fragments outside of the depth range are clipped, the same as by the
+      // near and far planes on the gpu, then polygon offset is applied
+      dd__sw_f4_t depth = dd__sw_interp(z, z + 1, z + 2, 0, b1, b2);
+      mask              = dd__sw_and(mask,
+                        dd__sw_and(dd__sw_cmpge(depth, zero),
+                                   dd__sw_cmple(depth, one)));
+      depth             = dd__sw_clamp01(
+        dd__sw_add(depth, z_offset));
+
+      // Groups that cross the right edge of the target go through a copy
+      uint8_t* pixels = pixels_row + (size_t)x * 4;
+      float* depths   = depth_row + x;
+      uint8_t pixels_tmp[16];
+      float depths_tmp[4];
+      int32_t valid = DD_MIN(4, width - x);
+      if (valid < 4)
+      {
+        memset(pixels_tmp, 0, sizeof(pixels_tmp));
+        memset(depths_tmp, 0, sizeof(depths_tmp));
+        memcpy(pixels_tmp, pixels, valid * 4);
+        memcpy(depths_tmp, depths, valid * sizeof(float));
+        pixels = pixels_tmp;
+        depths = depths_tmp;
+      }
+
+      dd__sw_f4_t prev_depth = dd__sw_load(depths);
+      if (depth_test) { mask = dd__sw_and(mask, dd__sw_cmplt(depth, prev_depth)); }
+      if (!dd__sw_any(mask)) { continue; }
+
+      // Perspective correct weights, lines interpolate their parameters
+      // in screen space instead ('noperspective' in the line shader)
+      dd__sw_f4_t p0  = dd__sw_mul(b0, inv_w[0]);
+      dd__sw_f4_t p1  = dd__sw_mul(b1, inv_w[1]);
+      dd__sw_f4_t p2  = dd__sw_mul(b2, inv_w[2]);
+      dd__sw_f4_t sum = dd__sw_div(one, dd__sw_add(p0, dd__sw_add(p1, p2)));
+      p1              = dd__sw_mul(p1, sum);
+      p2              = dd__sw_mul(p2, sum);
+
+      const float* c0 = tri->col[0];
+      const float* c1 = tri->col[1];
+      const float* c2 = tri->col[2];
+      dd__sw_f4_t r   = dd__sw_interp(c0, c1, c2, 0, p1, p2);
+      dd__sw_f4_t g   = dd__sw_interp(c0, c1, c2, 1, p1, p2);
+      dd__sw_f4_t b   = dd__sw_interp(c0, c1, c2, 2, p1, p2);
+      dd__sw_f4_t a   = dd__sw_interp(c0, c1, c2, 3, p1, p2);
+
+      const float* a0 = tri->attr[0];
+      const float* a1 = tri->attr[1];
+      const float* a2 = tri->attr[2];
+      if (tri->shading == DD__SW_SHADING_SOLID)
+      {
+        dd__sw_f4_t ndotl = dd__sw_interp(a0, a1, a2, 2, p1, p2);
+        r                 = dd__sw_mul(r, ndotl);
+        g                 = dd__sw_mul(g, ndotl);
+        b                 = dd__sw_mul(b, ndotl);
+      }
+      else if (tri->shading == DD__SW_SHADING_TEXT)
+      {
+        float u[4], v[4], texel[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        dd__sw_store(u, dd__sw_interp(a0, a1, a2, 0, p1, p2));
+        dd__sw_store(v, dd__sw_interp(a0, a1, a2, 1, p1, p2));
+        for (int32_t i = 0; texture && i < 4; ++i)
+        {
+          texel[i] = dd__sw_sample_texture(texture, u[i], v[i]);
+        }
+        a = dd__sw_mul(a, dd__sw_load(texel));
+      }
+      else if (tri->shading == DD__SW_SHADING_LINE)
+      {
+        dd__sw_f4_t u     = dd__sw_interp(a0, a1, a2, 0, b1, b2);
+        dd__sw_f4_t v     = dd__sw_interp(a0, a1, a2, 1, b1, b2);
+        dd__sw_f4_t lw    = dd__sw_interp(a0, a1, a2, 2, b1, b2);
+        dd__sw_f4_t ll    = dd__sw_interp(a0, a1, a2, 3, b1, b2);
+        dd__sw_f4_t edge0 = dd__sw_sub(one, dd__sw_div(aa_width, lw));
+        dd__sw_f4_t edge1 = dd__sw_sub(one, dd__sw_div(aa_length, ll));
+        dd__sw_f4_t au    = dd__sw_sub(
+          one, dd__sw_smoothstep(edge0, 1.0f, dd__sw_abs(dd__sw_div(u, lw))));
+        dd__sw_f4_t av    = dd__sw_sub(
+          one, dd__sw_smoothstep(edge1, 1.0f, dd__sw_abs(dd__sw_div(v, ll))));
+        a                 = dd__sw_mul(a, dd__sw_min(au, av));
+      }
+
+      // Blend with src_alpha, one_minus_src_alpha, in [0, 255]
+      dd__sw_f4_t dst_r, dst_g, dst_b, dst_a;
+      dd__sw_load_rgba(pixels, &dst_r, &dst_g, &dst_b, &dst_a);
+      a                     = dd__sw_clamp01(a);
+      dd__sw_f4_t src_scale = dd__sw_mul(a, dd__sw_splat(255.0f));
+      dd__sw_f4_t dst_scale = dd__sw_sub(one, a);
+      r = dd__sw_add(dd__sw_mul(dd__sw_clamp01(r), src_scale),
+                     dd__sw_mul(dst_r, dst_scale));
+      g = dd__sw_add(dd__sw_mul(dd__sw_clamp01(g), src_scale),
+                     dd__sw_mul(dst_g, dst_scale));
+      b = dd__sw_add(dd__sw_mul(dd__sw_clamp01(b), src_scale),
+                     dd__sw_mul(dst_b, dst_scale));
+      a = dd__sw_add(dd__sw_mul(a, src_scale), dd__sw_mul(dst_a, dst_scale));
+      dd__sw_store_rgba(pixels, mask, r, g, b, a);
+      if (depth_test)
+      {
+        dd__sw_store(depths, dd__sw_select(mask, depth, prev_depth));
+      }
+
+      if (valid < 4)
+      {
+        memcpy(pixels_row + (size_t)x * 4, pixels_tmp, valid * 4);
+        memcpy(depth_row + x, depths_tmp, valid * sizeof(float));
+      }
+    }
+  }
+}
+
+void
+dd__sw_raster_tile(dd_render_backend_t* backend, int32_t tile_idx)
+{
+  int32_t tile_x     = (tile_idx % backend->tiles_x) * DBGDRAW_SW_TILE_SIZE;
+  int32_t tile_y     = (tile_idx / backend->tiles_x) * DBGDRAW_SW_TILE_SIZE;
+  int32_t tile_max_x = DD_MIN(tile_x + DBGDRAW_SW_TILE_SIZE, backend->width);
+  int32_t tile_max_y = DD_MIN(tile_y + DBGDRAW_SW_TILE_SIZE, backend->height);
+
+  dd__sw_bin_t* bin = backend->bins + tile_idx;
+  for (int32_t i = 0; i < bin->len; ++i)
+  {
+    dd__sw_raster_tri(backend,
+                      backend->tris + bin->data[i],
+                      tile_x,
+                      tile_y,
+                      tile_max_x - 1,
+                      tile_max_y - 1);
+  }
+  bin->len = 0;
+}
+
+// Bins the current batch of triangles and rasterizes the tiles they touch on
+// all threads.
+void
+dd__sw_flush(dd_ctx_t* ctx, dd_render_backend_t* backend)
+{
+  if (!backend->tris_len) { return; }
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_backend_raster");
+
+  backend->active_tiles_len = 0;
+  for (int32_t i = 0; i < backend->tris_len; ++i)
+  {
+    dd__sw_tri_t* tri = backend->tris + i;
+    int32_t min_tx    = tri->min_x / DBGDRAW_SW_TILE_SIZE;
+    int32_t min_ty    = tri->min_y / DBGDRAW_SW_TILE_SIZE;
+    int32_t max_tx    = tri->max_x / DBGDRAW_SW_TILE_SIZE;
+    int32_t max_ty    = tri->max_y / DBGDRAW_SW_TILE_SIZE;
+    for (int32_t ty = min_ty; ty <= max_ty; ++ty)
+    {
+      for (int32_t tx = min_tx; tx <= max_tx; ++tx)
+      {
+        int32_t tile_idx  = ty * backend->tiles_x + tx;
+        dd__sw_bin_t* bin = backend->bins + tile_idx;
+        if (bin->len >= bin->cap)
+        {
+          bin->cap  = DD_MAX(64, 2 * bin->cap);
+          bin->data = DBGDRAW_REALLOC(bin->data, bin->cap * sizeof(uint32_t));
+          assert(bin->data);
+          DBGDRAW_STATS(ctx->stats.grow_count++);
+        }
+        if (!bin->len)
+        {
+          backend->active_tiles[backend->active_tiles_len++] = tile_idx;
+        }
+        bin->data[bin->len++] = (uint32_t)i;
+      }
+    }
+  }
+
+  dd__sw_lock(&backend->mutex);
+  backend->next_tile  = 0;
+  backend->tiles_done = 0;
+  backend->job_idx++;
+  dd__sw_wake_all(&backend->work_cond);
+  dd__sw_run_tiles(backend);
+  while (backend->tiles_done < backend->active_tiles_len)
+  {
+    dd__sw_wait(&backend->done_cond, &backend->mutex);
+  }
+  dd__sw_unlock(&backend->mutex);
+
+  backend->tris_len = 0;
+  DBGDRAW_TRACE_END(ctx, "dd_backend_raster");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Primitive setup
+////////////////////////////////////////////////////////////////////////////////
+
+// Triangles are clipped against the near plane and a guard band this many
+// viewports wide, the rest of clipping is done per pixel.
+#define DD__SW_GUARD_BAND 8.0f
+#define DD__SW_CLIP_PLANES 5
+
+float
+dd__sw_plane_distance(const dd__sw_vertex_t* v, int32_t plane)
+{
+  float guard = DD__SW_GUARD_BAND * v->pos[3];
+  switch (plane)
+  {
+    case 0: return v->pos[2] + v->pos[3];
+    case 1: return guard + v->pos[0];
+    case 2: return guard - v->pos[0];
+    case 3: return guard + v->pos[1];
+    default: return guard - v->pos[1];
+  }
+}
+
+void
+dd__sw_setup_tri(dd_ctx_t* ctx,
+                 dd_render_backend_t* backend,
+                 const dd__sw_vertex_t* v0,
+                 const dd__sw_vertex_t* v1,
+                 const dd__sw_vertex_t* v2,
+                 uint8_t shading,
+                 int8_t texture_idx,
+                 bool polygon_offset)
+{
+  const dd__sw_vertex_t* verts[3] = { v0, v1, v2 };
+  const float* viewport           = backend->viewport;
+  float x[3], y[3], z[3], inv_w[3];
+  for (int32_t i = 0; i < 3; ++i)
+  {
+    const float* pos = verts[i]->pos;
+    if (!(pos[3] > 0.0f)) { return; }
+    inv_w[i] = 1.0f / pos[3];
+    x[i]     = viewport[0] + (pos[0] * inv_w[i] * 0.5f + 0.5f) * viewport[2];
+    y[i]     = viewport[1] + (pos[1] * inv_w[i] * 0.5f + 0.5f) * viewport[3];
+    y[i]     = backend->height - y[i];
+    z[i]     = pos[2] * inv_w[i] * 0.5f + 0.5f;
+    x[i]     = floorf(x[i] * 256.0f + 0.5f) * (1.0f / 256.0f);
+    y[i]     = floorf(y[i] * 256.0f + 0.5f) * (1.0f / 256.0f);
+  }
+
+  float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+  if (!(fabsf(area) > 0.0f)) { return; }
+  int32_t order[3] = { 0, 1, 2 };
+  if (area < 0.0f)
+  {
+    order[1] = 2;
+    order[2] = 1;
+    area     = -area;
+  }
+
+  float min_xf = DD_MIN(x[0], DD_MIN(x[1], x[2]));
+  float min_yf = DD_MIN(y[0], DD_MIN(y[1], y[2]));
+  float max_xf = DD_MAX(x[0], DD_MAX(x[1], x[2]));
+  float max_yf = DD_MAX(y[0], DD_MAX(y[1], y[2]));
+  int32_t min_x = DD_MAX((int32_t)ceilf(min_xf - 0.5f), backend->scissor[0]);
+  int32_t min_y = DD_MAX((int32_t)ceilf(min_yf - 0.5f), backend->scissor[1]);
+  int32_t max_x = DD_MIN((int32_t)floorf(max_xf - 0.5f), backend->scissor[2]);
+  int32_t max_y = DD_MIN((int32_t)floorf(max_yf - 0.5f), backend->scissor[3]);
+  if (min_x > max_x || min_y > max_y) { return; }
+
+  if (backend->tris_len >= DBGDRAW_SW_BATCH_SIZE) { dd__sw_flush(ctx, backend); }
+  if (backend->tris_len >= backend->tris_cap)
+  {
+    backend->tris_cap = DD_MIN(DD_MAX(1024, 2 * backend->tris_cap),
+                               DBGDRAW_SW_BATCH_SIZE);
+    backend->tris =
+      DBGDRAW_REALLOC(backend->tris, backend->tris_cap * sizeof(dd__sw_tri_t));
+    assert(backend->tris);
+    DBGDRAW_STATS(ctx->stats.grow_count++);
+  }
+
+  dd__sw_tri_t* tri = backend->tris + backend->tris_len++;
+  for (int32_t i = 0; i < 3; ++i)
+  {
+    int32_t src   = order[i];
+    tri->x[i]     = x[src];
+    tri->y[i]     = y[src];
+    tri->z[i]     = z[src];
+    tri->inv_w[i] = inv_w[src];
+    memcpy(tri->col[i], verts[src]->col, sizeof(tri->col[i]));
+    memcpy(tri->attr[i], verts[src]->attr, sizeof(tri->attr[i]));
+  }
+
+  tri->top_left = 0;
+  for (int32_t i = 0; i < 3; ++i)
+  {
+    int32_t j = (i + 1) % 3;
+    int32_t k = (i + 2) % 3;
+    tri->a[i] = tri->y[j] - tri->y[k];
+    tri->b[i] = tri->x[k] - tri->x[j];
+    if (tri->a[i] > 0.0f || (tri->a[i] == 0.0f && tri->b[i] > 0.0f))
+    {
+      tri->top_left |= (uint8_t)(1 << i);
+    }
+  }
+  tri->inv_area = 1.0f / area;
+
+  // Same as glPolygonOffset(1.0, 1.0) with a 24 bit depth buffer
+  tri->z_offset = 0.0f;
+  if (polygon_offset)
+  {
+    float dz1     = tri->z[1] - tri->z[0];
+    float dz2     = tri->z[2] - tri->z[0];
+    float dzdx    = (dz1 * tri->a[1] + dz2 * tri->a[2]) * tri->inv_area;
+    float dzdy    = (dz1 * tri->b[1] + dz2 * tri->b[2]) * tri->inv_area;
+    tri->z_offset = DD_MAX(fabsf(dzdx), fabsf(dzdy)) + 1.0f / 16777216.0f;
+  }
+
+  tri->min_x       = min_x;
+  tri->min_y       = min_y;
+  tri->max_x       = max_x;
+  tri->max_y       = max_y;
+  tri->shading     = shading;
+  tri->texture_idx = texture_idx;
+}
+
+void
+dd__sw_draw_tri(dd_ctx_t* ctx,
+                dd_render_backend_t* backend,
+                const dd__sw_vertex_t* tri,
+                uint8_t shading,
+                int8_t texture_idx,
+                bool polygon_offset)
+{
+  // Skip triangles that are entirely outside one of the frustum planes
+  uint32_t outside_all = 0x3f;
+  for (int32_t i = 0; i < 3; ++i)
+  {
+    const float* pos = tri[i].pos;
+    outside_all &= (uint32_t)(pos[0] < -pos[3]) << 0 |
+                   (uint32_t)(pos[0] > pos[3]) << 1 |
+                   (uint32_t)(pos[1] < -pos[3]) << 2 |
+                   (uint32_t)(pos[1] > pos[3]) << 3 |
+                   (uint32_t)(pos[2] < -pos[3]) << 4 |
+                   (uint32_t)(pos[2] > pos[3]) << 5;
+  }
+  if (outside_all) { return; }
+
+  uint32_t clip_any = 0;
+  for (int32_t i = 0; i < 3; ++i)
+  {
+    for (int32_t p = 0; p < DD__SW_CLIP_PLANES; ++p)
+    {
+      if (!(dd__sw_plane_distance(tri + i, p) >= 0.0f)) { clip_any |= 1 << p; }
+    }
+  }
+
+  if (!clip_any)
+  {
+    dd__sw_setup_tri(ctx,
+                     backend,
+                     tri + 0,
+                     tri + 1,
+                     tri + 2,
+                     shading,
+                     texture_idx,
+                     polygon_offset);
+    return;
+  }
+
+  // Every plane can add at most one vertex to the polygon
+  dd__sw_vertex_t buffers[2][3 + DD__SW_CLIP_PLANES];
+  dd__sw_vertex_t* src = buffers[0];
+  dd__sw_vertex_t* dst = buffers[1];
+  int32_t count        = 3;
+  memcpy(src, tri, 3 * sizeof(dd__sw_vertex_t));
+  for (int32_t p = 0; p < DD__SW_CLIP_PLANES && count; ++p)
+  {
+    if (!(clip_any & (1 << p))) { continue; }
+    int32_t dst_count = 0;
+    for (int32_t i = 0; i < count; ++i)
+    {
+      const dd__sw_vertex_t* a = src + i;
+      const dd__sw_vertex_t* b = src + (i + 1) % count;
+      float da                 = dd__sw_plane_distance(a, p);
+      float db                 = dd__sw_plane_distance(b, p);
+      if (da >= 0.0f) { dst[dst_count++] = *a; }
+      if ((da >= 0.0f) != (db >= 0.0f))
+      {
+        float t                = da / (da - db);
+        dd__sw_vertex_t* out   = dst + dst_count++;
+        const float* from      = &a->pos[0];
+        const float* to        = &b->pos[0];
+        float* result          = &out->pos[0];
+        for (int32_t j = 0; j < 12; ++j)
+        {
+          result[j] = from[j] + t * (to[j] - from[j]);
+        }
+      }
+    }
+    dd__sw_vertex_t* tmp = src;
+    src                  = dst;
+    dst                  = tmp;
+    count                = dst_count;
+  }
+
+  for (int32_t i = 2; i < count; ++i)
+  {
+    dd__sw_setup_tri(ctx,
+                     backend,
+                     src,
+                     src + i - 1,
+                     src + i,
+                     shading,
+                     texture_idx,
+                     polygon_offset);
+  }
+}
+
+void
+dd__sw_transform(const dd_mat4_t* m, dd_vec3_t p, float w, float* out)
+{
+  for (int32_t r = 0; r < 4; ++r)
+  {
+    out[r] = m->data[r] * p.x + m->data[4 + r] * p.y + m->data[8 + r] * p.z +
+             m->data[12 + r] * w;
+  }
+}
+
+// Vertices of a command are transformed to clip space once, into 'cmd_verts'.
+// Normals are transformed for lit shading, points and lines keep their size in
+// 'attr[0]'.
+void
+dd__sw_transform_vertices(dd_ctx_t* ctx,
+                          dd_render_backend_t* backend,
+                          dd_cmd_t* cmd,
+                          const dd_mat4_t* mvp)
+{
+  int32_t count = cmd->vertex_count;
+  if (backend->verts_cap < count)
+  {
+    backend->verts_cap = DD_MAX(count, 2 * backend->verts_cap);
+    size_t size        = backend->verts_cap * sizeof(dd__sw_vertex_t);
+    backend->cmd_verts = DBGDRAW_REALLOC(backend->cmd_verts, size);
+    backend->instance_verts = DBGDRAW_REALLOC(backend->instance_verts, size);
+    backend->screen         = DBGDRAW_REALLOC(backend->screen,
+                                      backend->verts_cap * sizeof(dd_vec2_t));
+    assert(backend->cmd_verts && backend->instance_verts && backend->screen);
+    DBGDRAW_STATS(ctx->stats.grow_count++);
+  }
+
+  bool lit = cmd->draw_mode == DBGDRAW_MODE_FILL &&
+             cmd->shading_type == DBGDRAW_SHADING_SOLID;
+  dd_mat4_t normal_matrix = dd_mat4_identity();
+  if (lit)
+  {
+    normal_matrix = dd_mat4_mul(
+      ctx->proj,
+      dd_mat4_mul(ctx->view, dd_mat4_transpose(dd_mat4_inverse(cmd->xform))));
+  }
+
+  dd_vertex_t* src = ctx->verts_data + cmd->base_index;
+  for (int32_t i = 0; i < count; ++i)
+  {
+    dd__sw_vertex_t* dst = backend->cmd_verts + i;
+    dd__sw_transform(mvp, src[i].pos, 1.0f, dst->pos);
+    dst->col[0] = src[i].col.r / 255.0f;
+    dst->col[1] = src[i].col.g / 255.0f;
+    dst->col[2] = src[i].col.b / 255.0f;
+    dst->col[3] = src[i].col.a / 255.0f;
+    if (lit) { dd__sw_transform(&normal_matrix, src[i].normal, 0.0f, dst->attr); }
+    else if (cmd->draw_mode == DBGDRAW_MODE_FILL)
+    {
+      memcpy(dst->attr, src[i].normal.data, sizeof(src[i].normal));
+    }
+    else { dst->attr[0] = src[i].size; }
+    dst->attr[3] = 0.0f;
+  }
+}
+
+// Instances offset the position and the color of all vertices, same as in the
+// OpenGL vertex shaders, so the offset is transformed once and added to the
+// vertices in clip space. Commands without instance data are drawn as a single
+// instance.
+const dd__sw_vertex_t*
+dd__sw_instance_vertices(dd_render_backend_t* backend,
+                         dd_cmd_t* cmd,
+                         int32_t idx,
+                         const dd_mat4_t* mvp)
+{
+  if (!(cmd->instance_count > 0 && cmd->instance_data))
+  {
+    return backend->cmd_verts;
+  }
+
+  dd_instance_data_t* instance = cmd->instance_data + idx;
+  float pos[4];
+  float col[4] = { instance->color.r / 255.0f,
+                   instance->color.g / 255.0f,
+                   instance->color.b / 255.0f,
+                   instance->color.a / 255.0f };
+  dd__sw_transform(mvp, instance->position, 0.0f, pos);
+  for (int32_t i = 0; i < cmd->vertex_count; ++i)
+  {
+    const dd__sw_vertex_t* src = backend->cmd_verts + i;
+    dd__sw_vertex_t* dst       = backend->instance_verts + i;
+    for (int32_t j = 0; j < 4; ++j)
+    {
+      dst->pos[j]  = src->pos[j] + pos[j];
+      dst->col[j]  = src->col[j] + col[j];
+      dst->attr[j] = src->attr[j];
+    }
+  }
+  return backend->instance_verts;
+}
+
+int32_t
+dd__sw_instance_count(dd_cmd_t* cmd)
+{
+  return (cmd->instance_count > 0 && cmd->instance_data) ? cmd->instance_count
+                                                         : 1;
+}
+
+void
+dd__sw_submit_triangles(dd_ctx_t* ctx,
+                        dd_render_backend_t* backend,
+                        dd_cmd_t* cmd)
+{
+  dd_mat4_t mvp = dd_mat4_mul(ctx->proj, dd_mat4_mul(ctx->view, cmd->xform));
+  dd__sw_transform_vertices(ctx, backend, cmd, &mvp);
+
+  int8_t texture_idx = -1;
+#if DBGDRAW_HAS_TEXT_SUPPORT
+  if (cmd->shading_type == DBGDRAW_SHADING_TEXT && cmd->font_idx >= 0)
+  {
+    texture_idx = (int8_t)(ctx->fonts[cmd->font_idx].tex_id - 1);
+  }
+#endif
+
+  for (int32_t inst = 0; inst < dd__sw_instance_count(cmd); ++inst)
+  {
+    const dd__sw_vertex_t* verts =
+      dd__sw_instance_vertices(backend, cmd, inst, &mvp);
+    for (int32_t i = 0; i + 2 < cmd->vertex_count; i += 3)
+    {
+      dd__sw_draw_tri(ctx,
+                      backend,
+                      verts + i,
+                      (uint8_t)cmd->shading_type,
+                      texture_idx,
+                      true);
+    }
+  }
+}
+
+// Points are squares of 'size' pixels, that are skipped entirely if their
+// center is outside of the view volume, like GL_POINTS.
+void
+dd__sw_submit_points(dd_ctx_t* ctx, dd_render_backend_t* backend, dd_cmd_t* cmd)
+{
+  dd_mat4_t mvp = dd_mat4_mul(ctx->proj, dd_mat4_mul(ctx->view, cmd->xform));
+  dd__sw_transform_vertices(ctx, backend, cmd, &mvp);
+
+  for (int32_t inst = 0; inst < dd__sw_instance_count(cmd); ++inst)
+  {
+    const dd__sw_vertex_t* verts =
+      dd__sw_instance_vertices(backend, cmd, inst, &mvp);
+    for (int32_t i = 0; i < cmd->vertex_count; ++i)
+    {
+      const float* center = verts[i].pos;
+      float w             = center[3];
+      if (!(fabsf(center[0]) <= w && fabsf(center[1]) <= w &&
+            fabsf(center[2]) <= w))
+      {
+        continue;
+      }
+
+      float size          = DD_MAX(verts[i].attr[0], 1.0f);
+      float hx            = size / backend->viewport[2] * w;
+      float hy            = size / backend->viewport[3] * w;
+      float corners[4][2] = { { -hx, -hy }, { hx, -hy }, { hx, hy }, { -hx, hy } };
+      dd__sw_vertex_t quad[6];
+      for (int32_t j = 0; j < 4; ++j)
+      {
+        quad[j]         = verts[i];
+        quad[j].pos[0] += corners[j][0];
+        quad[j].pos[1] += corners[j][1];
+      }
+      quad[4] = quad[0];
+      quad[5] = quad[2];
+      dd__sw_draw_tri(ctx, backend, quad, DD__SW_SHADING_NONE, -1, false);
+      dd__sw_draw_tri(ctx, backend, quad + 3, DD__SW_SHADING_NONE, -1, false);
+    }
+  }
+}
+
+// Mirrors the line vertex shader of the OpenGL backends - every segment becomes
+// a quad in screen space, 'size' pixels wide and extended by the anti-aliasing
+// radius, with miter joints to the neighbouring segments.
+void
+dd__sw_line_quad(dd_render_backend_t* backend,
+                 const dd__sw_vertex_t* verts,
+                 const dd_vec2_t* screen,
+                 int32_t count,
+                 int32_t idx,
+                 dd__sw_vertex_t* quad)
+{
+  bool has_prev = idx - 2 >= 0;
+  bool has_next = idx + 2 < count;
+
+  dd_vec2_t dirs[3]    = { { { 0 } } };
+  float lengths[3]     = { 0 };
+  float min_lengths[3] = { 0.0001f, 0.0001f, 0.001f };
+  for (int32_t i = 0; i < 3; ++i)
+  {
+    if ((i == 0 && !has_prev) || (i == 2 && !has_next)) { continue; }
+    const dd_vec2_t* a = screen + idx + 2 * (i - 1);
+    dd_vec2_t d        = dd_vec2(a[1].x - a[0].x, a[1].y - a[0].y);
+    lengths[i]         = sqrtf(d.x * d.x + d.y * d.y);
+    dirs[i]            = dd_vec2(d.x / lengths[i], d.y / lengths[i]);
+    if (lengths[i] <= min_lengths[i])
+    {
+      dirs[i]    = dd_vec2(0.0f, 0.0f);
+      lengths[i] = 0.0f;
+    }
+  }
+
+  dd_vec2_t dir    = dirs[1];
+  dd_vec2_t normal = dd_vec2(-dir.y, dir.x);
+  dd_vec2_t miter[2];
+  miter[0] = dd_vec2(-(dirs[1].y + dirs[0].y) * 0.5f,
+                     (dirs[1].x + dirs[0].x) * 0.5f);
+  miter[1] = dd_vec2(-(dirs[1].y + dirs[2].y) * 0.5f,
+                     (dirs[1].x + dirs[2].x) * 0.5f);
+  float miter_length[2] = { miter[0].x * normal.x + miter[0].y * normal.y,
+                            miter[1].x * normal.x + miter[1].y * normal.y };
+
+  // Joints are only used if the segments share an end point, and do not turn
+  // back too sharply
+  float cos_angle_threshold = -0.7f;
+  bool joint_prev           = has_prev && screen[idx].x == screen[idx - 1].x &&
+                    screen[idx].y == screen[idx - 1].y &&
+                    !(dirs[0].x * dir.x + dirs[0].y * dir.y <
+                      cos_angle_threshold);
+  bool joint_next = has_next && screen[idx + 2].x == screen[idx + 1].x &&
+                    screen[idx + 2].y == screen[idx + 1].y &&
+                    !(dirs[2].x * dir.x + dirs[2].y * dir.y <
+                      cos_angle_threshold);
+  if (!joint_prev)
+  {
+    miter[0]        = normal;
+    miter_length[0] = 1.0f;
+  }
+  if (!joint_next)
+  {
+    miter[1]        = normal;
+    miter_length[1] = 1.0f;
+  }
+
+  dd_vec2_t aa_radius    = backend->aa_radius;
+  float extension_length = aa_radius.y;
+  float half_length      = 0.5f * (lengths[1] + 2.0f * extension_length);
+  float half_w           = backend->viewport[2] * 0.5f;
+  float half_h           = backend->viewport[3] * 0.5f;
+
+  dd__sw_vertex_t ends[2];
+  dd_vec2_t normals[2];
+  float widths[2];
+  for (int32_t i = 0; i < 2; ++i)
+  {
+    const dd__sw_vertex_t* v = verts + idx + i;
+    float scale;
+    ends[i]          = *v;
+    widths[i]        = DD_MAX(v->attr[0], 1.0f) + aa_radius.x;
+    ends[i].col[3]   = DD_MIN(v->attr[0] * v->col[3], 1.0f);
+    scale            = 0.5f * widths[i] / miter_length[i];
+    normals[i]       = dd_vec2(miter[i].x * scale, miter[i].y * scale);
+  }
+
+  static const int32_t quad_pos[6][2] = { { 0, -1 }, { 0, 1 }, { 1, 1 },
+                                          { 0, -1 }, { 1, 1 }, { 1, -1 } };
+  dd_vec2_t start = screen[idx];
+  dd_vec2_t delta = dd_vec2(screen[idx + 1].x - start.x,
+                            screen[idx + 1].y - start.y);
+  for (int32_t i = 0; i < 6; ++i)
+  {
+    int32_t qx           = quad_pos[i][0];
+    int32_t qy           = quad_pos[i][1];
+    float along          = (float)(2 * qx - 1);
+    dd__sw_vertex_t* out = quad + i;
+
+    float x = start.x + qx * delta.x + along * extension_length * dir.x +
+              qy * normals[qx].x;
+    float y = start.y + qx * delta.y + along * extension_length * dir.y +
+              qy * normals[qx].y;
+    float w = ends[qx].pos[3];
+    *out    = ends[qx];
+    out->pos[0]  = ((x - half_w) / half_w) * w;
+    out->pos[1]  = ((y - half_h) / half_h) * w;
+    out->attr[0] = qy * widths[qx];
+    out->attr[1] = along * half_length;
+    out->attr[2] = widths[qx];
+    out->attr[3] = half_length;
+  }
+}
+
+void
+dd__sw_submit_lines(dd_ctx_t* ctx, dd_render_backend_t* backend, dd_cmd_t* cmd)
+{
+  dd_mat4_t mvp = dd_mat4_mul(ctx->proj, dd_mat4_mul(ctx->view, cmd->xform));
+  dd__sw_transform_vertices(ctx, backend, cmd, &mvp);
+
+  float half_w = backend->viewport[2] * 0.5f;
+  float half_h = backend->viewport[3] * 0.5f;
+  for (int32_t inst = 0; inst < dd__sw_instance_count(cmd); ++inst)
+  {
+    const dd__sw_vertex_t* verts =
+      dd__sw_instance_vertices(backend, cmd, inst, &mvp);
+    for (int32_t i = 0; i < cmd->vertex_count; ++i)
+    {
+      const float* pos   = verts[i].pos;
+      backend->screen[i] = dd_vec2((pos[0] / pos[3]) * half_w + half_w,
+                                   (pos[1] / pos[3]) * half_h + half_h);
+    }
+    for (int32_t i = 0; i + 1 < cmd->vertex_count; i += 2)
+    {
+      dd__sw_vertex_t quad[6];
+      dd__sw_line_quad(
+        backend, verts, backend->screen, cmd->vertex_count, i, quad);
+      dd__sw_draw_tri(ctx, backend, quad, DD__SW_SHADING_LINE, -1, true);
+      dd__sw_draw_tri(ctx, backend, quad + 3, DD__SW_SHADING_LINE, -1, true);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Backend interface
+////////////////////////////////////////////////////////////////////////////////
+
+int32_t
+dd_backend_init(dd_ctx_t* ctx)
+{
+  dd_render_backend_t* backend = DBGDRAW_MALLOC(sizeof(dd_render_backend_t));
+  if (!backend) { return DBGDRAW_ERR_FAILED_ALLOC; }
+  memset(backend, 0, sizeof(dd_render_backend_t));
+  ctx->render_backend = backend;
+
+  // No capabilities are reported, procedural primitives and impostors are
+  // tessellated by dbgdraw
+  dd__sw_start_threads(backend);
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_backend_render(dd_ctx_t* ctx)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend = ctx->render_backend;
+
+  if (!ctx->commands_len) { return DBGDRAW_ERR_OK; }
+  if (!backend->pixels) { return DBGDRAW_ERR_INVALID_IMAGE; }
+
+  memcpy(backend->viewport, ctx->viewport.data, sizeof(backend->viewport));
+  backend->aa_radius         = ctx->aa_radius;
+  backend->enable_depth_test = ctx->enable_depth_test;
+
+  // Nothing is drawn outside of the viewport, the target has its top row first
+  float* viewport     = backend->viewport;
+  backend->scissor[0] = DD_MAX(0, (int32_t)viewport[0]);
+  backend->scissor[1] =
+    DD_MAX(0, backend->height - (int32_t)(viewport[1] + viewport[3]));
+  backend->scissor[2] =
+    DD_MIN(backend->width, (int32_t)(viewport[0] + viewport[2])) - 1;
+  backend->scissor[3] =
+    DD_MIN(backend->height, backend->height - (int32_t)viewport[1]) - 1;
+
+  for (int32_t i = 0; i < ctx->commands_len; ++i)
+  {
+    dd_cmd_t* cmd = ctx->commands + i;
+    DBGDRAW_TRACE_BEGIN(ctx, "dd_backend_submit");
+    if (cmd->draw_mode == DBGDRAW_MODE_FILL)
+    {
+      dd__sw_submit_triangles(ctx, backend, cmd);
+    }
+    else if (cmd->draw_mode == DBGDRAW_MODE_POINT)
+    {
+      dd__sw_submit_points(ctx, backend, cmd);
+    }
+    else
+    {
+      dd__sw_submit_lines(ctx, backend, cmd);
+    }
+    if (cmd->vertex_count) { DBGDRAW_STATS(ctx->drawcall_count++); }
+    DBGDRAW_TRACE_END(ctx, "dd_backend_submit");
+  }
+  dd__sw_flush(ctx, backend);
+
+  return DBGDRAW_ERR_OK;
+}
+
+#if DBGDRAW_HAS_TEXT_SUPPORT
+int32_t
+dd_backend_init_font_texture(dd_ctx_t* ctx,
+                             const uint8_t* data,
+                             int32_t width,
+                             int32_t height,
+                             uint32_t* tex_id)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend = ctx->render_backend;
+  assert(backend->textures_len < 16);
+
+  dd__sw_texture_t* texture = backend->textures + backend->textures_len;
+  texture->data             = DBGDRAW_MALLOC((size_t)width * height);
+  if (!texture->data) { return DBGDRAW_ERR_FAILED_ALLOC; }
+  memcpy(texture->data, data, (size_t)width * height);
+  texture->width  = width;
+  texture->height = height;
+
+  *tex_id = ++backend->textures_len;
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_backend_update_font_texture(dd_ctx_t* ctx,
+                               const uint8_t* data,
+                               int32_t width,
+                               int32_t height,
+                               int32_t x,
+                               int32_t y,
+                               int32_t w,
+                               int32_t h,
+                               uint32_t* tex_id)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend = ctx->render_backend;
+  assert(*tex_id > 0 && *tex_id <= (uint32_t)backend->textures_len);
+  (void)height;
+
+  dd__sw_texture_t* texture = backend->textures + (*tex_id - 1);
+  for (int32_t row = y; row < y + h; ++row)
+  {
+    memcpy(texture->data + (size_t)row * width + x,
+           data + (size_t)row * width + x,
+           (size_t)w);
+  }
+  return DBGDRAW_ERR_OK;
+}
+#endif
+
+int32_t
+dd_backend_term(dd_ctx_t* ctx)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend = ctx->render_backend;
+
+  dd__sw_stop_threads(backend);
+  for (int32_t i = 0; i < backend->tiles_cap; ++i)
+  {
+    DBGDRAW_FREE(backend->bins[i].data);
+  }
+  for (int32_t i = 0; i < backend->textures_len; ++i)
+  {
+    DBGDRAW_FREE(backend->textures[i].data);
+  }
+  DBGDRAW_FREE(backend->bins);
+  DBGDRAW_FREE(backend->active_tiles);
+  DBGDRAW_FREE(backend->tris);
+  DBGDRAW_FREE(backend->cmd_verts);
+  DBGDRAW_FREE(backend->instance_verts);
+  DBGDRAW_FREE(backend->screen);
+  DBGDRAW_FREE(backend->own_depth);
+  DBGDRAW_FREE(backend);
+  ctx->render_backend = NULL;
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_sw_set_target(dd_ctx_t* ctx, dd_sw_target_t* target)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  assert(target);
+  dd_render_backend_t* backend = ctx->render_backend;
+
+  if (target->width <= 0 || target->height <= 0 || !target->pixels)
+  {
+    return DBGDRAW_ERR_INVALID_IMAGE;
+  }
+
+  float* depth     = target->depth;
+  size_t depth_len = (size_t)target->width * target->height;
+  if (!depth && backend->own_depth_len < depth_len)
+  {
+    float* own_depth =
+      DBGDRAW_REALLOC(backend->own_depth, depth_len * sizeof(float));
+    if (!own_depth) { return DBGDRAW_ERR_FAILED_ALLOC; }
+    backend->own_depth     = own_depth;
+    backend->own_depth_len = depth_len;
+    DBGDRAW_STATS(ctx->stats.grow_count++);
+  }
+  if (!depth) { depth = backend->own_depth; }
+
+  int32_t tiles_x = (target->width + DBGDRAW_SW_TILE_SIZE - 1) /
+                    DBGDRAW_SW_TILE_SIZE;
+  int32_t tiles_y = (target->height + DBGDRAW_SW_TILE_SIZE - 1) /
+                    DBGDRAW_SW_TILE_SIZE;
+  int32_t tile_count = tiles_x * tiles_y;
+  if (backend->tiles_cap < tile_count)
+  {
+    dd__sw_bin_t* bins =
+      DBGDRAW_REALLOC(backend->bins, tile_count * sizeof(dd__sw_bin_t));
+    if (!bins) { return DBGDRAW_ERR_FAILED_ALLOC; }
+    backend->bins = bins;
+    memset(bins + backend->tiles_cap,
+           0,
+           (tile_count - backend->tiles_cap) * sizeof(dd__sw_bin_t));
+    backend->tiles_cap = tile_count;
+
+    int32_t* active_tiles =
+      DBGDRAW_REALLOC(backend->active_tiles, tile_count * sizeof(int32_t));
+    if (!active_tiles) { return DBGDRAW_ERR_FAILED_ALLOC; }
+    backend->active_tiles = active_tiles;
+    DBGDRAW_STATS(ctx->stats.grow_count++);
+  }
+
+  backend->pixels  = target->pixels;
+  backend->depth   = depth;
+  backend->width   = target->width;
+  backend->height  = target->height;
+  backend->tiles_x = tiles_x;
+  backend->tiles_y = tiles_y;
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_sw_clear(dd_ctx_t* ctx, dd_color_t color, float depth)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend = ctx->render_backend;
+  if (!backend->pixels) { return DBGDRAW_ERR_INVALID_IMAGE; }
+
+  size_t count = (size_t)backend->width * backend->height;
+  for (size_t i = 0; i < count; ++i)
+  {
+    memcpy(backend->pixels + 4 * i, &color, 4);
+    backend->depth[i] = depth;
+  }
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_render_to_image(dd_ctx_t* ctx, dd_image_t* image)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  assert(image);
+  dd_render_backend_t* backend = ctx->render_backend;
+
+  dd_sw_target_t target = { .width  = image->width,
+                            .height = image->height,
+                            .pixels = image->pixels,
+                            .depth  = NULL };
+  int32_t error         = dd_sw_set_target(ctx, &target);
+  if (error) { return error; }
+
+  dd_sw_clear(ctx, image->clear_color, 1.0f);
+  error            = dd_render(ctx);
+  image->frame_idx = backend->image_frame_count++;
+  return error;
+}
+
+int32_t
+dd_flush_image(dd_ctx_t* ctx, dd_image_t* image)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  assert(image);
+  image->frame_idx = -1;
+  return DBGDRAW_ERR_OK;
+}
+
+#endif
@@ -0,0 +1,203 @@
+#define MSH_VEC_MATH_INCLUDE_LIBC_HEADERS
+#define MSH_VEC_MATH_IMPLEMENTATION
+#define DBGDRAW_VALIDATION_LAYERS
+#define DBGDRAW_USE_DEFAULT_FONT
+
+#include "msh_vec_math.h"
+#include "stb_truetype.h"
+#include "dbgdraw.h"
+#include "dbgdraw_software.h"
+
+// Renders a few frames on the cpu, with the software backend, and writes out
+// the color as .ppm and the depth as .pgm images. Needs neither a gpu nor an
+// OpenGL implementation. If a filename is passed as an argument, the frames are
+// also captured into that file, which can be replayed with dd_replay.
+
+#define IMAGE_WIDTH  640
+#define IMAGE_HEIGHT 320
+#define FRAME_COUNT  8
+
+typedef struct app_state_t {
+  dd_ctx_t* dd_ctx;
+  dd_sw_target_t target;
+#ifdef DBGDRAW_TRACING
+  dd_trace_file_t trace;
+#endif
+} app_state_t;
+
+int32_t init( app_state_t* state, const char* capture_filename );
+void frame( app_state_t* state, int32_t frame_idx );
+void write_images( dd_sw_target_t* target, int32_t frame_idx );
+void cleanup( app_state_t* state );
+
+int32_t
+main( int32_t argc, char** argv )
+{
+  int32_t error = 0;
+  app_state_t* state = calloc( 1, sizeof(app_state_t) );
+
+  error = init( state, argc > 1 ? argv[1] : NULL );
+  if( error ) { goto main_return; }
+
+  for( int32_t i = 0; i < FRAME_COUNT; ++i )
+  {
+    frame( state, i );
+    write_images( &state->target, i );
+  }
+
+  main_return:
+  cleanup( state );
+  return error;
+}
+
+int32_t init( app_state_t* state, const char* capture_filename ) {
+  int32_t error = 0;
+
+  state->dd_ctx = calloc( 1, sizeof(dd_ctx_t) );
+  dd_ctx_desc_t desc =
+  {
+    .max_vertices = 1024,
+    .max_commands = 16,
+    .detail_level = 2,
+    .enable_depth_test = true,
+    .enable_default_font = 1
+  };
+  error = dd_init( state->dd_ctx, &desc );
+  if( error )
+  {
+    fprintf( stderr, "[ERROR] Failed to initialize dbgdraw library!\n" );
+    return 1;
+  }
+
+  if( capture_filename )
+  {
+    error = dd_capture_begin( state->dd_ctx, capture_filename );
+    if( error ) { fprintf( stderr, "%s\n", dd_error_message( error ) ); }
+  }
+
+#ifdef DBGDRAW_TRACING
+  // Open the trace in chrome://tracing or ui.perfetto.dev
+  if( !dd_trace_file_open( &state->trace, "dbgdraw_software_trace.json" ) )
+  {
+    dd_trace_hooks_t hooks = dd_trace_file_hooks( &state->trace );
+    dd_set_trace_hooks( state->dd_ctx, &hooks );
+  }
+#endif
+
+  // Both buffers are ours, the backend only draws into them
+  state->target.width  = IMAGE_WIDTH;
+  state->target.height = IMAGE_HEIGHT;
+  state->target.pixels = malloc( IMAGE_WIDTH * IMAGE_HEIGHT * 4 );
+  state->target.depth  = malloc( IMAGE_WIDTH * IMAGE_HEIGHT * sizeof(float) );
+  error = dd_sw_set_target( state->dd_ctx, &state->target );
+  if( error )
+  {
+    fprintf( stderr, "%s\n", dd_error_message( error ) );
+    return 1;
+  }
+
+  return 0;
+}
+
+void frame( app_state_t* state, int32_t frame_idx )
+{
+  dd_ctx_t* dd_ctx = state->dd_ctx;
+  float w = (float)state->target.width;
+  float h = (float)state->target.height;
+
+  float fovy = 1.0472f; /* approx. 60 deg in radians */
+  float angle = frame_idx * (float)DBGDRAW_TWO_PI / FRAME_COUNT;
+
+  msh_vec3_t cam_pos = msh_vec3( 0.8f, 2.6f, 3.0f );
+  msh_mat4_t view = msh_look_at( cam_pos, msh_vec3_zeros(), msh_vec3_posy() );
+  msh_vec4_t viewport = msh_vec4( 0.0f, 0.0f, w, h );
+  msh_mat4_t proj = msh_perspective( fovy, w/h, 0.1f, 100.0f );
+  msh_mat4_t model = msh_mat4_identity();
+  model = msh_post_rotate( model, angle, msh_vec3_posy() );
+
+  dd_new_frame_info_t info = {
+    .view_matrix       = view.data,
+    .projection_matrix = proj.data,
+    .viewport_size     = viewport.data,
+    .vertical_fov      = fovy,
+    .projection_type   = DBGDRAW_PERSPECTIVE };
+  dd_new_frame( dd_ctx, &info );
+
+  dd_set_transform( dd_ctx, model.data );
+
+  dd_set_shading_type( dd_ctx, DBGDRAW_SHADING_SOLID );
+  dd_begin_cmd( dd_ctx, DBGDRAW_MODE_FILL );
+  dd_set_color( dd_ctx, DBGDRAW_RED );
+  dd_sphere( dd_ctx, msh_vec3( 0.0f, 0.0f, 0.0f ).data, 0.6f );
+  dd_set_color( dd_ctx, DBGDRAW_BLUE );
+  dd_cone( dd_ctx, msh_vec3( 1.0f, -0.5f, 0.0f ).data, msh_vec3( 1.0f, 0.5f, 0.0f ).data, 0.3f );
+  dd_end_cmd( dd_ctx );
+
+  dd_set_shading_type( dd_ctx, DBGDRAW_SHADING_NONE );
+  dd_begin_cmd( dd_ctx, DBGDRAW_MODE_STROKE );
+  dd_set_color( dd_ctx, DBGDRAW_GRAY );
+  dd_aabb( dd_ctx, msh_vec3( -1.1f, -1.1f, -1.1f ).data, msh_vec3( 1.1f, 1.1f, 1.1f ).data );
+  dd_end_cmd( dd_ctx );
+
+  char label[32];
+  snprintf( label, sizeof(label), "Frame %d", frame_idx );
+  dd_set_transform( dd_ctx, msh_mat4_identity().data );
+  dd_set_shading_type( dd_ctx, DBGDRAW_SHADING_TEXT );
+  dd_begin_cmd( dd_ctx, DBGDRAW_MODE_FILL );
+  dd_set_color( dd_ctx, DBGDRAW_BLACK );
+  dd_text_line( dd_ctx, msh_vec3( 0.0f, 1.4f, 0.0f ).data, label, NULL );
+  dd_end_cmd( dd_ctx );
+
+  dd_sw_clear( dd_ctx, dd_rgbf( 0.9f, 0.9f, 0.9f ), 1.0f );
+  int32_t error = dd_render( dd_ctx );
+  if( error ) { fprintf( stderr, "%s\n", dd_error_message( error ) ); }
+}
+
+void write_images( dd_sw_target_t* target, int32_t frame_idx )
+{
+  char filename[64];
+  snprintf( filename, sizeof(filename), "dbgdraw_software_%02d.ppm", frame_idx );
+  FILE* fp = fopen( filename, "wb" );
+  if( !fp )
+  {
+    fprintf( stderr, "[ERROR] Failed to open %s for writing!\n", filename );
+    return;
+  }
+
+  fprintf( fp, "P6\n%d %d\n255\n", target->width, target->height );
+  for( int32_t i = 0; i < target->width * target->height; ++i )
+  {
+    fwrite( target->pixels + 4 * i, 1, 3, fp );
+  }
+  fclose( fp );
+  printf( "Wrote %s\n", filename );
+
+  // Depth is non-linear, the same as in the OpenGL depth buffer
+  snprintf( filename, sizeof(filename), "dbgdraw_software_depth_%02d.pgm", frame_idx );
+  fp = fopen( filename, "wb" );
+  if( !fp )
+  {
+    fprintf( stderr, "[ERROR] Failed to open %s for writing!\n", filename );
+    return;
+  }
+
+  fprintf( fp, "P5\n%d %d\n255\n", target->width, target->height );
+  for( int32_t i = 0; i < target->width * target->height; ++i )
+  {
+    uint8_t value = (uint8_t)( target->depth[i] * 255.0f );
+    fwrite( &value, 1, 1, fp );
+  }
+  fclose( fp );
+  printf( "Wrote %s\n", filename );
+}
+
+void cleanup( app_state_t* state )
+{
+  if( state->dd_ctx ) { dd_term( state->dd_ctx ); }
+#ifdef DBGDRAW_TRACING
+  dd_trace_file_close( &state->trace );
+#endif
+  free( state->target.pixels );
+  free( state->target.depth );
+  free( state );
+}
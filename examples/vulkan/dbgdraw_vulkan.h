@@ -0,0 +1,1528 @@
+#ifndef DBGDRAW_VULKAN_H
+#define DBGDRAW_VULKAN_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Backend for applications that render with Vulkan. dd_render does not submit
+// anything - it records the frame into a secondary command buffer, which the
+// application executes inside its own render pass, with vkCmdExecuteCommands.
+// Vertex and instance data are written to a persistently mapped buffer, one per
+// frame in flight, per-command data is passed through push constants, and
+// pipelines are created on first use, one for each (mode, shading, depth test)
+// combination. Procedural primitives and impostors are not supported, so
+// dbgdraw tessellates them before they reach the backend.
+//
+// The shaders live in examples/vulkan/shaders, and are compiled to SPIR-V
+// headers with glslangValidator at build time (see CMakeLists.txt).
+
+#include "dd_vk_base_vert.h"
+#include "dd_vk_base_frag.h"
+#include "dd_vk_lines_vert.h"
+#include "dd_vk_lines_frag.h"
+
+// Number of frames that can be in flight. Data and command buffer of a frame
+// are reused DBGDRAW_VK_FRAMES_IN_FLIGHT frames later, so by the time dd_render
+// is called again the gpu has to be done with them - waiting on the
+// application's own frame fences is enough, as long as it does not keep more
+// frames in flight than this.
+#ifndef DBGDRAW_VK_FRAMES_IN_FLIGHT
+#define DBGDRAW_VK_FRAMES_IN_FLIGHT 3
+#endif
+
+#define DBGDRAW_VK_MAX_FONTS 16
+
+// Vulkan objects owned by the application. The backend only creates pipelines
+// and command buffers that are compatible with 'render_pass' and 'subpass', and
+// uses 'queue' for uploads of font textures. If 'render_pass' is
+// VK_NULL_HANDLE, the backend creates a render pass of its own, for use with
+// dd_render_to_image. 'pipeline_cache' is optional.
+typedef struct dd_vk_desc
+{
+  VkPhysicalDevice physical_device;
+  VkDevice device;
+  VkQueue queue;
+  uint32_t queue_family_index;
+  VkRenderPass render_pass;
+  uint32_t subpass;
+  VkSampleCountFlagBits sample_count;
+  VkPipelineCache pipeline_cache;
+} dd_vk_desc_t;
+
+typedef struct dd__vk_buffer
+{
+  VkBuffer buffer;
+  VkDeviceMemory memory;
+  uint8_t* mapped;
+  VkDeviceSize size;
+} dd__vk_buffer_t;
+
+typedef struct dd__vk_texture
+{
+  VkImage image;
+  VkDeviceMemory memory;
+  VkImageView view;
+  VkDescriptorSet set;
+} dd__vk_texture_t;
+
+typedef struct dd__vk_frame
+{
+  dd__vk_buffer_t data;
+  VkDescriptorSet data_set;
+  VkCommandBuffer cmd;
+
+  VkCommandBuffer image_cmd;
+  VkFence image_fence;
+  dd__vk_buffer_t readback;
+  int32_t image_frame_idx;
+  bool image_pending;
+} dd__vk_frame_t;
+
+typedef struct dd_render_backend
+{
+  const dd_vk_desc_t* vk;
+  VkPhysicalDeviceMemoryProperties memory_props;
+
+  VkShaderModule base_vert;
+  VkShaderModule base_frag;
+  VkShaderModule lines_vert;
+  VkShaderModule lines_frag;
+  VkDescriptorSetLayout data_set_layout;
+  VkDescriptorSetLayout font_set_layout;
+  VkPipelineLayout pipeline_layout;
+  VkPipeline pipelines[DBGDRAW_MODE_COUNT][DBGDRAW_SHADING_COUNT][2];
+  VkRenderPass render_pass;
+  VkDescriptorPool descriptor_pool;
+  VkCommandPool command_pool;
+  VkSampler font_sampler;
+
+  dd__vk_texture_t null_font;
+  dd__vk_texture_t fonts[DBGDRAW_VK_MAX_FONTS];
+  int32_t fonts_len;
+
+  dd__vk_frame_t frames[DBGDRAW_VK_FRAMES_IN_FLIGHT];
+  int32_t frame_count;
+  int32_t frame_slot;
+
+  VkRenderPass image_render_pass;
+  VkFormat image_depth_format;
+  VkImage image_color;
+  VkDeviceMemory image_color_memory;
+  VkImageView image_color_view;
+  VkImage image_depth;
+  VkDeviceMemory image_depth_memory;
+  VkImageView image_depth_view;
+  VkFramebuffer image_framebuffer;
+  int32_t image_width;
+  int32_t image_height;
+  int32_t image_frame_count;
+} dd_render_backend_t;
+
+// Command buffer recorded by the last call to dd_render. It is a secondary
+// command buffer, so the render pass that executes it has to be begun with
+// VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS. It sets its own viewport and
+// scissor, from the viewport passed to dd_new_frame (origin in the top left).
+VkCommandBuffer dd_vk_get_command_buffer(dd_ctx_t* ctx);
+
+// Offscreen rendering, with the same interface as the OpenGL backends - the
+// frame is rendered into an offscreen target and read back asynchronously,
+// through a ring of DBGDRAW_VK_FRAMES_IN_FLIGHT buffers. 'pixels' must hold
+// width * height * 4 bytes (RGBA, top row first). On return 'frame_idx' is the
+// index of the frame that was written to 'pixels', or -1 if no frame was ready
+// yet. Use dd_flush_image to read back remaining frames. Only available when
+// the backend owns the render pass ('render_pass' in dd_vk_desc_t is
+// VK_NULL_HANDLE), otherwise DBGDRAW_ERR_INVALID_IMAGE is returned.
+typedef struct dd_image
+{
+  int32_t width;
+  int32_t height;
+  dd_color_t clear_color;
+  uint8_t* pixels;
+  int32_t frame_idx;
+} dd_image_t;
+
+int32_t dd_render_to_image(dd_ctx_t* ctx, dd_image_t* image);
+int32_t dd_flush_image(dd_ctx_t* ctx, dd_image_t* image);
+
+// Layouts follow the push constant blocks of the shaders (std430)
+typedef struct dd__vk_base_push_constants
+{
+  dd_mat4_t mvp;
+  float normal_matrix[12];
+  int32_t instancing_enabled;
+} dd__vk_base_push_constants_t;
+
+typedef struct dd__vk_line_push_constants
+{
+  dd_mat4_t mvp;
+  dd_vec2_t viewport_size;
+  dd_vec2_t aa_radius;
+  int32_t command_info[2];
+  int32_t instancing_enabled;
+} dd__vk_line_push_constants_t;
+
+void
+dd__vk_check(VkResult result, const char* filename, uint32_t lineno)
+{
+  if (result != VK_SUCCESS)
+  {
+    printf("Vulkan Error %d at %s: %d\n", result, filename, lineno);
+    exit(-1);
+  }
+}
+
+#define VKCHECK(x) dd__vk_check((x), __FILE__, __LINE__)
+
+VkDeviceSize
+dd__vk_align(VkDeviceSize size, VkDeviceSize alignment)
+{
+  return (size + alignment - 1) & ~(alignment - 1);
+}
+
+// Returns UINT32_MAX if there is no memory type with all of 'flags'
+uint32_t
+dd__vk_memory_type(dd_render_backend_t* backend,
+                   uint32_t type_bits,
+                   VkMemoryPropertyFlags flags)
+{
+  const VkPhysicalDeviceMemoryProperties* props = &backend->memory_props;
+  for (uint32_t i = 0; i < props->memoryTypeCount; ++i)
+  {
+    if ((type_bits & (1u << i)) &&
+        (props->memoryTypes[i].propertyFlags & flags) == flags)
+    {
+      return i;
+    }
+  }
+  return UINT32_MAX;
+}
+
+VkDeviceMemory
+dd__vk_allocate(dd_render_backend_t* backend,
+                VkMemoryRequirements reqs,
+                VkMemoryPropertyFlags flags,
+                VkMemoryPropertyFlags preferred_flags)
+{
+  uint32_t type_idx =
+    dd__vk_memory_type(backend, reqs.memoryTypeBits, flags | preferred_flags);
+  if (type_idx == UINT32_MAX)
+  {
+    type_idx = dd__vk_memory_type(backend, reqs.memoryTypeBits, flags);
+  }
+  assert(type_idx != UINT32_MAX);
+
+  VkMemoryAllocateInfo alloc_info = {
+    .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+    .allocationSize  = reqs.size,
+    .memoryTypeIndex = type_idx
+  };
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VKCHECK(vkAllocateMemory(backend->vk->device, &alloc_info, NULL, &memory));
+  return memory;
+}
+
+// Host buffers are coherent and stay mapped until destroyed, so writes need no
+// flushes, and reads no invalidation.
+void
+dd__vk_create_buffer(dd_render_backend_t* backend,
+                     VkDeviceSize size,
+                     VkBufferUsageFlags usage,
+                     VkMemoryPropertyFlags preferred_flags,
+                     dd__vk_buffer_t* buffer)
+{
+  VkDevice device = backend->vk->device;
+
+  VkBufferCreateInfo buffer_info = { .sType =
+                                       VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                                     .size        = size,
+                                     .usage       = usage,
+                                     .sharingMode = VK_SHARING_MODE_EXCLUSIVE };
+  VKCHECK(vkCreateBuffer(device, &buffer_info, NULL, &buffer->buffer));
+
+  VkMemoryRequirements reqs;
+  vkGetBufferMemoryRequirements(device, buffer->buffer, &reqs);
+  buffer->memory = dd__vk_allocate(backend,
+                                   reqs,
+                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                   preferred_flags);
+  VKCHECK(vkBindBufferMemory(device, buffer->buffer, buffer->memory, 0));
+  VKCHECK(vkMapMemory(device,
+                      buffer->memory,
+                      0,
+                      VK_WHOLE_SIZE,
+                      0,
+                      (void**)&buffer->mapped));
+  buffer->size = size;
+}
+
+void
+dd__vk_destroy_buffer(dd_render_backend_t* backend, dd__vk_buffer_t* buffer)
+{
+  VkDevice device = backend->vk->device;
+  if (buffer->memory) { vkUnmapMemory(device, buffer->memory); }
+  vkDestroyBuffer(device, buffer->buffer, NULL);
+  vkFreeMemory(device, buffer->memory, NULL);
+  memset(buffer, 0, sizeof(*buffer));
+}
+
+VkImageView
+dd__vk_create_image(dd_render_backend_t* backend,
+                    int32_t width,
+                    int32_t height,
+                    VkFormat format,
+                    VkImageUsageFlags usage,
+                    VkImageAspectFlags aspect,
+                    VkImage* image,
+                    VkDeviceMemory* memory)
+{
+  VkDevice device = backend->vk->device;
+
+  VkImageCreateInfo image_info = {
+    .sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+    .imageType     = VK_IMAGE_TYPE_2D,
+    .format        = format,
+    .extent        = { (uint32_t)width, (uint32_t)height, 1 },
+    .mipLevels     = 1,
+    .arrayLayers   = 1,
+    .samples       = VK_SAMPLE_COUNT_1_BIT,
+    .tiling        = VK_IMAGE_TILING_OPTIMAL,
+    .usage         = usage,
+    .sharingMode   = VK_SHARING_MODE_EXCLUSIVE,
+    .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+  };
+  VKCHECK(vkCreateImage(device, &image_info, NULL, image));
+
+  VkMemoryRequirements reqs;
+  vkGetImageMemoryRequirements(device, *image, &reqs);
+  *memory =
+    dd__vk_allocate(backend, reqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+  VKCHECK(vkBindImageMemory(device, *image, *memory, 0));
+
+  VkImageViewCreateInfo view_info = {
+    .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+    .image            = *image,
+    .viewType         = VK_IMAGE_VIEW_TYPE_2D,
+    .format           = format,
+    .subresourceRange = { aspect, 0, 1, 0, 1 }
+  };
+  VkImageView view = VK_NULL_HANDLE;
+  VKCHECK(vkCreateImageView(device, &view_info, NULL, &view));
+  return view;
+}
+
+VkShaderModule
+dd__vk_create_shader_module(VkDevice device, const uint32_t* code, size_t size)
+{
+  VkShaderModuleCreateInfo module_info = {
+    .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+    .codeSize = size,
+    .pCode    = code
+  };
+  VkShaderModule module = VK_NULL_HANDLE;
+  VKCHECK(vkCreateShaderModule(device, &module_info, NULL, &module));
+  return module;
+}
+
+// Uploads happen at init time, and when new glyphs are added to a font atlas,
+// which is rare enough that they simply wait for the queue to become idle. That
+// also means no frame in flight still samples the texture.
+VkCommandBuffer
+dd__vk_begin_upload(dd_render_backend_t* backend)
+{
+  VkCommandBufferAllocateInfo alloc_info = {
+    .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+    .commandPool        = backend->command_pool,
+    .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+    .commandBufferCount = 1
+  };
+  VkCommandBuffer cmd = VK_NULL_HANDLE;
+  VKCHECK(vkAllocateCommandBuffers(backend->vk->device, &alloc_info, &cmd));
+
+  VkCommandBufferBeginInfo begin_info = {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+  };
+  VKCHECK(vkBeginCommandBuffer(cmd, &begin_info));
+  return cmd;
+}
+
+void
+dd__vk_end_upload(dd_render_backend_t* backend, VkCommandBuffer cmd)
+{
+  VKCHECK(vkEndCommandBuffer(cmd));
+  VkSubmitInfo submit_info = { .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                               .commandBufferCount = 1,
+                               .pCommandBuffers    = &cmd };
+  VKCHECK(vkQueueSubmit(backend->vk->queue, 1, &submit_info, VK_NULL_HANDLE));
+  VKCHECK(vkQueueWaitIdle(backend->vk->queue));
+  vkFreeCommandBuffers(backend->vk->device, backend->command_pool, 1, &cmd);
+}
+
+void
+dd__vk_create_texture(dd_render_backend_t* backend,
+                      const uint8_t* data,
+                      int32_t width,
+                      int32_t height,
+                      dd__vk_texture_t* texture)
+{
+  VkDevice device = backend->vk->device;
+  texture->view   = dd__vk_create_image(backend,
+                                      width,
+                                      height,
+                                      VK_FORMAT_R8_UNORM,
+                                      VK_IMAGE_USAGE_SAMPLED_BIT |
+                                        VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                                      VK_IMAGE_ASPECT_COLOR_BIT,
+                                      &texture->image,
+                                      &texture->memory);
+
+  dd__vk_buffer_t staging = { 0 };
+  dd__vk_create_buffer(backend,
+                       (VkDeviceSize)width * height,
+                       VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                       0,
+                       &staging);
+  memcpy(staging.mapped, data, (size_t)width * height);
+
+  VkCommandBuffer cmd = dd__vk_begin_upload(backend);
+  VkImageMemoryBarrier barrier = {
+    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+    .srcAccessMask       = 0,
+    .dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+    .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .image               = texture->image,
+    .subresourceRange    = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+  };
+  vkCmdPipelineBarrier(cmd,
+                       VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       0,
+                       0,
+                       NULL,
+                       0,
+                       NULL,
+                       1,
+                       &barrier);
+
+  VkBufferImageCopy region = {
+    .imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+    .imageExtent      = { (uint32_t)width, (uint32_t)height, 1 }
+  };
+  vkCmdCopyBufferToImage(cmd,
+                         staging.buffer,
+                         texture->image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         1,
+                         &region);
+
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  vkCmdPipelineBarrier(cmd,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       0,
+                       0,
+                       NULL,
+                       0,
+                       NULL,
+                       1,
+                       &barrier);
+  dd__vk_end_upload(backend, cmd);
+  dd__vk_destroy_buffer(backend, &staging);
+
+  VkDescriptorSetAllocateInfo alloc_info = {
+    .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+    .descriptorPool     = backend->descriptor_pool,
+    .descriptorSetCount = 1,
+    .pSetLayouts        = &backend->font_set_layout
+  };
+  VKCHECK(vkAllocateDescriptorSets(device, &alloc_info, &texture->set));
+
+  VkDescriptorImageInfo image_info = {
+    .sampler     = backend->font_sampler,
+    .imageView   = texture->view,
+    .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+  };
+  VkWriteDescriptorSet write = {
+    .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+    .dstSet          = texture->set,
+    .dstBinding      = 0,
+    .descriptorCount = 1,
+    .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    .pImageInfo      = &image_info
+  };
+  vkUpdateDescriptorSets(device, 1, &write, 0, NULL);
+}
+
+void
+dd__vk_destroy_texture(dd_render_backend_t* backend, dd__vk_texture_t* texture)
+{
+  VkDevice device = backend->vk->device;
+  vkDestroyImageView(device, texture->view, NULL);
+  vkDestroyImage(device, texture->image, NULL);
+  vkFreeMemory(device, texture->memory, NULL);
+  memset(texture, 0, sizeof(*texture));
+}
+
+// Vertices go first, followed by instance data of each command. The whole
+// buffer is also bound as a storage buffer, for the line shader.
+void
+dd__vk_create_frame_data(dd_render_backend_t* backend,
+                         dd__vk_frame_t* frame,
+                         VkDeviceSize size)
+{
+  dd__vk_create_buffer(backend,
+                       size,
+                       VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                       0,
+                       &frame->data);
+
+  VkDescriptorBufferInfo buffer_info = { .buffer = frame->data.buffer,
+                                         .offset = 0,
+                                         .range  = VK_WHOLE_SIZE };
+  VkWriteDescriptorSet write         = {
+    .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+    .dstSet          = frame->data_set,
+    .dstBinding      = 0,
+    .descriptorCount = 1,
+    .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+    .pBufferInfo     = &buffer_info
+  };
+  vkUpdateDescriptorSets(backend->vk->device, 1, &write, 0, NULL);
+}
+
+VkRenderPass
+dd__vk_create_image_render_pass(dd_render_backend_t* backend)
+{
+  VkFormat depth_formats[] = { VK_FORMAT_D32_SFLOAT,
+                               VK_FORMAT_X8_D24_UNORM_PACK32,
+                               VK_FORMAT_D16_UNORM };
+  for (int32_t i = 0; i < 3; ++i)
+  {
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(backend->vk->physical_device,
+                                        depth_formats[i],
+                                        &props);
+    if (props.optimalTilingFeatures &
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+    {
+      backend->image_depth_format = depth_formats[i];
+      break;
+    }
+  }
+
+  VkAttachmentDescription attachments[2] = {
+    { .format         = VK_FORMAT_R8G8B8A8_UNORM,
+      .samples        = VK_SAMPLE_COUNT_1_BIT,
+      .loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR,
+      .storeOp        = VK_ATTACHMENT_STORE_OP_STORE,
+      .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
+      .finalLayout    = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL },
+    { .format         = backend->image_depth_format,
+      .samples        = VK_SAMPLE_COUNT_1_BIT,
+      .loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR,
+      .storeOp        = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
+      .finalLayout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL }
+  };
+  VkAttachmentReference color_ref = {
+    0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+  };
+  VkAttachmentReference depth_ref = {
+    1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+  };
+  VkSubpassDescription subpass = {
+    .pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS,
+    .colorAttachmentCount    = 1,
+    .pColorAttachments       = &color_ref,
+    .pDepthStencilAttachment = &depth_ref
+  };
+
+  // Frames in flight share the attachments, so a frame waits for the copy and
+  // depth writes of the previous one, and the copy waits for the color writes
+  VkSubpassDependency dependencies[2] = {
+    { .srcSubpass    = VK_SUBPASS_EXTERNAL,
+      .dstSubpass    = 0,
+      .srcStageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT |
+                      VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+      .dstStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+      .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                       VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                       VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT },
+    { .srcSubpass    = 0,
+      .dstSubpass    = VK_SUBPASS_EXTERNAL,
+      .srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      .dstStageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT,
+      .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT }
+  };
+
+  VkRenderPassCreateInfo render_pass_info = {
+    .sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+    .attachmentCount = 2,
+    .pAttachments    = attachments,
+    .subpassCount    = 1,
+    .pSubpasses      = &subpass,
+    .dependencyCount = 2,
+    .pDependencies   = dependencies
+  };
+  VkRenderPass render_pass = VK_NULL_HANDLE;
+  VKCHECK(vkCreateRenderPass(backend->vk->device,
+                             &render_pass_info,
+                             NULL,
+                             &render_pass));
+  return render_pass;
+}
+
+int32_t
+dd_backend_init(dd_ctx_t* ctx)
+{
+  dd_render_backend_t* backend = (dd_render_backend_t*)ctx->render_backend;
+  const dd_vk_desc_t* vk       = backend->vk;
+  VkDevice device              = vk->device;
+
+  vkGetPhysicalDeviceMemoryProperties(vk->physical_device,
+                                      &backend->memory_props);
+
+  backend->base_vert  = dd__vk_create_shader_module(device,
+                                                   dd__vk_base_vert_spv,
+                                                   sizeof(dd__vk_base_vert_spv));
+  backend->base_frag  = dd__vk_create_shader_module(device,
+                                                   dd__vk_base_frag_spv,
+                                                   sizeof(dd__vk_base_frag_spv));
+  backend->lines_vert = dd__vk_create_shader_module(
+    device, dd__vk_lines_vert_spv, sizeof(dd__vk_lines_vert_spv));
+  backend->lines_frag = dd__vk_create_shader_module(
+    device, dd__vk_lines_frag_spv, sizeof(dd__vk_lines_frag_spv));
+
+  // Set 0 holds vertex data for the line shader, set 1 the font texture
+  VkDescriptorSetLayoutBinding data_binding = {
+    .binding         = 0,
+    .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+    .descriptorCount = 1,
+    .stageFlags      = VK_SHADER_STAGE_VERTEX_BIT
+  };
+  VkDescriptorSetLayoutCreateInfo set_layout_info = {
+    .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+    .bindingCount = 1,
+    .pBindings    = &data_binding
+  };
+  VKCHECK(vkCreateDescriptorSetLayout(device,
+                                      &set_layout_info,
+                                      NULL,
+                                      &backend->data_set_layout));
+
+  VkDescriptorSetLayoutBinding font_binding = {
+    .binding         = 0,
+    .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    .descriptorCount = 1,
+    .stageFlags      = VK_SHADER_STAGE_FRAGMENT_BIT
+  };
+  set_layout_info.pBindings = &font_binding;
+  VKCHECK(vkCreateDescriptorSetLayout(device,
+                                      &set_layout_info,
+                                      NULL,
+                                      &backend->font_set_layout));
+
+  VkDescriptorSetLayout set_layouts[2] = { backend->data_set_layout,
+                                           backend->font_set_layout };
+  VkPushConstantRange push_range       = {
+    .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+    .offset     = 0,
+    .size       = 128
+  };
+  VkPipelineLayoutCreateInfo pipeline_layout_info = {
+    .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+    .setLayoutCount         = 2,
+    .pSetLayouts            = set_layouts,
+    .pushConstantRangeCount = 1,
+    .pPushConstantRanges    = &push_range
+  };
+  VKCHECK(vkCreatePipelineLayout(device,
+                                 &pipeline_layout_info,
+                                 NULL,
+                                 &backend->pipeline_layout));
+
+  VkDescriptorPoolSize pool_sizes[2] = {
+    { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, DBGDRAW_VK_FRAMES_IN_FLIGHT },
+    { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, DBGDRAW_VK_MAX_FONTS + 1 }
+  };
+  VkDescriptorPoolCreateInfo pool_info = {
+    .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+    .maxSets       = DBGDRAW_VK_FRAMES_IN_FLIGHT + DBGDRAW_VK_MAX_FONTS + 1,
+    .poolSizeCount = 2,
+    .pPoolSizes    = pool_sizes
+  };
+  VKCHECK(vkCreateDescriptorPool(device,
+                                 &pool_info,
+                                 NULL,
+                                 &backend->descriptor_pool));
+
+  VkCommandPoolCreateInfo command_pool_info = {
+    .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+    .flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+    .queueFamilyIndex = vk->queue_family_index
+  };
+  VKCHECK(vkCreateCommandPool(device,
+                              &command_pool_info,
+                              NULL,
+                              &backend->command_pool));
+
+  VkSamplerCreateInfo sampler_info = {
+    .sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+    .magFilter    = VK_FILTER_LINEAR,
+    .minFilter    = VK_FILTER_LINEAR,
+    .mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+    .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+    .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+    .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+    .maxLod       = 0.0f
+  };
+  VKCHECK(
+    vkCreateSampler(device, &sampler_info, NULL, &backend->font_sampler));
+
+  backend->render_pass = vk->render_pass;
+  if (!backend->render_pass)
+  {
+    backend->image_render_pass = dd__vk_create_image_render_pass(backend);
+    backend->render_pass       = backend->image_render_pass;
+  }
+
+  VkDeviceSize data_size = ctx->verts_cap * sizeof(dd_vertex_t) +
+                           ctx->instance_cap * sizeof(dd_instance_data_t);
+  for (int32_t i = 0; i < DBGDRAW_VK_FRAMES_IN_FLIGHT; ++i)
+  {
+    dd__vk_frame_t* frame                  = backend->frames + i;
+    VkDescriptorSetAllocateInfo alloc_info = {
+      .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      .descriptorPool     = backend->descriptor_pool,
+      .descriptorSetCount = 1,
+      .pSetLayouts        = &backend->data_set_layout
+    };
+    VKCHECK(vkAllocateDescriptorSets(device, &alloc_info, &frame->data_set));
+    dd__vk_create_frame_data(backend, frame, data_size);
+
+    VkCommandBufferAllocateInfo cmd_info = {
+      .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool        = backend->command_pool,
+      .level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+      .commandBufferCount = 1
+    };
+    VKCHECK(vkAllocateCommandBuffers(device, &cmd_info, &frame->cmd));
+  }
+  backend->frame_slot = -1;
+
+  // Base shaders always declare the font texture, so something has to be bound
+  // even when there are no fonts
+  const uint8_t white = 255;
+  dd__vk_create_texture(backend, &white, 1, 1, &backend->null_font);
+
+  return DBGDRAW_ERR_OK;
+}
+
+VkPipeline
+dd__vk_pipeline(dd_render_backend_t* backend,
+                int32_t mode,
+                int32_t shading,
+                int32_t depth_test)
+{
+  VkPipeline* pipeline = &backend->pipelines[mode][shading][depth_test];
+  if (*pipeline) { return *pipeline; }
+
+  const dd_vk_desc_t* vk = backend->vk;
+  bool lines             = (mode == DBGDRAW_MODE_STROKE);
+
+  VkSpecializationMapEntry spec_entry = { 0, 0, sizeof(int32_t) };
+  VkSpecializationInfo spec_info      = { .mapEntryCount = 1,
+                                     .pMapEntries   = &spec_entry,
+                                     .dataSize      = sizeof(int32_t),
+                                     .pData         = &shading };
+  VkPipelineShaderStageCreateInfo stages[2] = {
+    { .sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+      .stage  = VK_SHADER_STAGE_VERTEX_BIT,
+      .module = lines ? backend->lines_vert : backend->base_vert,
+      .pName  = "main",
+      .pSpecializationInfo = lines ? NULL : &spec_info },
+    { .sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+      .stage  = VK_SHADER_STAGE_FRAGMENT_BIT,
+      .module = lines ? backend->lines_frag : backend->base_frag,
+      .pName  = "main",
+      .pSpecializationInfo = lines ? NULL : &spec_info }
+  };
+
+  // Line shader fetches vertices from the storage buffer, so it only takes
+  // the instance attributes
+  VkVertexInputBindingDescription bindings[2] = {
+    { 0, sizeof(dd_vertex_t), VK_VERTEX_INPUT_RATE_VERTEX },
+    { 1, sizeof(dd_instance_data_t), VK_VERTEX_INPUT_RATE_INSTANCE }
+  };
+  VkVertexInputAttributeDescription attributes[5] = {
+    { 0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(dd_vertex_t, pos_size) },
+    { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(dd_vertex_t, uv) },
+    { 2, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(dd_vertex_t, col) },
+    { 3,
+      1,
+      VK_FORMAT_R32G32B32_SFLOAT,
+      offsetof(dd_instance_data_t, position) },
+    { 4, 1, VK_FORMAT_R8G8B8A8_UNORM, offsetof(dd_instance_data_t, color) }
+  };
+  VkPipelineVertexInputStateCreateInfo vertex_input = {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+    .vertexBindingDescriptionCount   = lines ? 1 : 2,
+    .pVertexBindingDescriptions      = lines ? bindings + 1 : bindings,
+    .vertexAttributeDescriptionCount = lines ? 2 : 5,
+    .pVertexAttributeDescriptions    = lines ? attributes + 3 : attributes
+  };
+
+  VkPipelineInputAssemblyStateCreateInfo input_assembly = {
+    .sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+    .topology = (mode == DBGDRAW_MODE_POINT)
+                  ? VK_PRIMITIVE_TOPOLOGY_POINT_LIST
+                  : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST
+  };
+
+  VkPipelineViewportStateCreateInfo viewport_state = {
+    .sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+    .viewportCount = 1,
+    .scissorCount  = 1
+  };
+
+  // Same offset as glPolygonOffset(1, 1) in the OpenGL backends, which also
+  // only applies to triangles
+  VkPipelineRasterizationStateCreateInfo rasterization = {
+    .sType       = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+    .polygonMode = VK_POLYGON_MODE_FILL,
+    .cullMode    = VK_CULL_MODE_NONE,
+    .frontFace   = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+    .depthBiasEnable         = (mode != DBGDRAW_MODE_POINT),
+    .depthBiasConstantFactor = 1.0f,
+    .depthBiasSlopeFactor    = 1.0f,
+    .lineWidth               = 1.0f
+  };
+
+  VkPipelineMultisampleStateCreateInfo multisample = {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+    .rasterizationSamples = (vk->render_pass && vk->sample_count)
+                              ? vk->sample_count
+                              : VK_SAMPLE_COUNT_1_BIT
+  };
+
+  VkPipelineDepthStencilStateCreateInfo depth_stencil = {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+    .depthTestEnable  = (VkBool32)depth_test,
+    .depthWriteEnable = (VkBool32)depth_test,
+    .depthCompareOp   = VK_COMPARE_OP_LESS
+  };
+
+  VkPipelineColorBlendAttachmentState blend_attachment = {
+    .blendEnable         = VK_TRUE,
+    .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+    .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+    .colorBlendOp        = VK_BLEND_OP_ADD,
+    .srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+    .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+    .alphaBlendOp        = VK_BLEND_OP_ADD,
+    .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                      VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+  };
+  VkPipelineColorBlendStateCreateInfo color_blend = {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+    .attachmentCount = 1,
+    .pAttachments    = &blend_attachment
+  };
+
+  VkDynamicState dynamic_states[2]        = { VK_DYNAMIC_STATE_VIEWPORT,
+                                       VK_DYNAMIC_STATE_SCISSOR };
+  VkPipelineDynamicStateCreateInfo dynamic = {
+    .sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+    .dynamicStateCount = 2,
+    .pDynamicStates    = dynamic_states
+  };
+
+  VkGraphicsPipelineCreateInfo pipeline_info = {
+    .sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+    .stageCount          = 2,
+    .pStages             = stages,
+    .pVertexInputState   = &vertex_input,
+    .pInputAssemblyState = &input_assembly,
+    .pViewportState      = &viewport_state,
+    .pRasterizationState = &rasterization,
+    .pMultisampleState   = &multisample,
+    .pDepthStencilState  = &depth_stencil,
+    .pColorBlendState    = &color_blend,
+    .pDynamicState       = &dynamic,
+    .layout              = backend->pipeline_layout,
+    .renderPass          = backend->render_pass,
+    .subpass             = vk->render_pass ? vk->subpass : 0
+  };
+  VKCHECK(vkCreateGraphicsPipelines(vk->device,
+                                    vk->pipeline_cache,
+                                    1,
+                                    &pipeline_info,
+                                    NULL,
+                                    pipeline));
+  return *pipeline;
+}
+
+int32_t
+dd_backend_render(dd_ctx_t* ctx)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend = ctx->render_backend;
+  const dd_vk_desc_t* vk       = backend->vk;
+
+  int32_t slot          = backend->frame_count % DBGDRAW_VK_FRAMES_IN_FLIGHT;
+  dd__vk_frame_t* frame = backend->frames + slot;
+
+  double upload_start_ms = ctx->enable_timings ? dd_time_ms() : 0.0;
+  DBGDRAW_TRACE_BEGIN(ctx, "dd_backend_upload");
+
+  // Instance data of each command starts at a 16 byte boundary
+  VkDeviceSize verts_size = ctx->verts_len * sizeof(dd_vertex_t);
+  VkDeviceSize data_size  = dd__vk_align(verts_size, 16);
+  for (int32_t i = 0; i < ctx->commands_len; ++i)
+  {
+    dd_cmd_t* cmd = ctx->commands + i;
+    if (cmd->instance_count && cmd->instance_data)
+    {
+      data_size +=
+        dd__vk_align(cmd->instance_count * sizeof(dd_instance_data_t), 16);
+    }
+  }
+
+  // Frame that used this buffer before is done on the gpu, so it can be
+  // replaced right away
+  if (frame->data.size < data_size)
+  {
+    VkDeviceSize new_size = DD_MAX(data_size, 2 * frame->data.size);
+    dd__vk_destroy_buffer(backend, &frame->data);
+    dd__vk_create_frame_data(backend, frame, new_size);
+    DBGDRAW_STATS(ctx->stats.grow_count++);
+  }
+  memcpy(frame->data.mapped, ctx->verts_data, verts_size);
+  DBGDRAW_STATS(ctx->stats.bytes_uploaded += verts_size);
+
+  if (ctx->enable_timings)
+  {
+    ctx->timings.upload_ms += (float)(dd_time_ms() - upload_start_ms);
+  }
+  DBGDRAW_TRACE_END(ctx, "dd_backend_upload");
+
+  VkCommandBuffer cmd_buf                  = frame->cmd;
+  VkCommandBufferInheritanceInfo inheritance = {
+    .sType      = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+    .renderPass = backend->render_pass,
+    .subpass    = vk->render_pass ? vk->subpass : 0
+  };
+  VkCommandBufferBeginInfo begin_info = {
+    .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+    .flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+    .pInheritanceInfo = &inheritance
+  };
+  VKCHECK(vkResetCommandBuffer(cmd_buf, 0));
+  VKCHECK(vkBeginCommandBuffer(cmd_buf, &begin_info));
+
+  VkViewport viewport = { .x        = ctx->viewport.data[0],
+                          .y        = ctx->viewport.data[1],
+                          .width    = ctx->viewport.data[2],
+                          .height   = ctx->viewport.data[3],
+                          .minDepth = 0.0f,
+                          .maxDepth = 1.0f };
+  VkRect2D scissor    = {
+    .offset = { (int32_t)DD_MAX(viewport.x, 0.0f),
+                (int32_t)DD_MAX(viewport.y, 0.0f) },
+    .extent = { (uint32_t)DD_MAX(viewport.width, 0.0f),
+                (uint32_t)DD_MAX(viewport.height, 0.0f) }
+  };
+  vkCmdSetViewport(cmd_buf, 0, 1, &viewport);
+  vkCmdSetScissor(cmd_buf, 0, 1, &scissor);
+
+  VkDescriptorSet sets[2] = { frame->data_set, backend->null_font.set };
+  vkCmdBindDescriptorSets(cmd_buf,
+                          VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          backend->pipeline_layout,
+                          0,
+                          2,
+                          sets,
+                          0,
+                          NULL);
+  VkDeviceSize zero_offset = 0;
+  vkCmdBindVertexBuffers(cmd_buf, 0, 1, &frame->data.buffer, &zero_offset);
+
+  dd_vec2_t viewport_size =
+    dd_vec2(ctx->viewport.data[2], ctx->viewport.data[3]);
+  VkDeviceSize instance_offset = dd__vk_align(verts_size, 16);
+  VkPipeline bound_pipeline    = VK_NULL_HANDLE;
+  VkDescriptorSet bound_font   = backend->null_font.set;
+
+  for (int32_t i = 0; i < ctx->commands_len; ++i)
+  {
+    dd_cmd_t* cmd = ctx->commands + i;
+    dd_mat4_t mvp = dd_mat4_mul(ctx->proj, dd_mat4_mul(ctx->view, cmd->xform));
+
+    DBGDRAW_TRACE_BEGIN(ctx, "dd_backend_submit");
+
+    // Without instances the binding still has to point somewhere valid
+    bool instancing = (cmd->instance_count > 0 && cmd->instance_data);
+    VkDeviceSize offset = 0;
+    if (instancing)
+    {
+      size_t size = cmd->instance_count * sizeof(dd_instance_data_t);
+      memcpy(frame->data.mapped + instance_offset, cmd->instance_data, size);
+      DBGDRAW_STATS(ctx->stats.bytes_uploaded += size);
+      offset = instance_offset;
+      instance_offset += dd__vk_align(size, 16);
+      if (ctx->instance_cap < cmd->instance_count)
+      {
+        ctx->instance_cap = cmd->instance_count;
+      }
+    }
+    vkCmdBindVertexBuffers(cmd_buf, 1, 1, &frame->data.buffer, &offset);
+
+    int32_t shading =
+      (cmd->draw_mode == DBGDRAW_MODE_FILL) ? cmd->shading_type : 0;
+    VkPipeline pipeline = dd__vk_pipeline(backend,
+                                          cmd->draw_mode,
+                                          shading,
+                                          ctx->enable_depth_test ? 1 : 0);
+    if (pipeline != bound_pipeline)
+    {
+      vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+      bound_pipeline = pipeline;
+    }
+
+    uint32_t instance_count = instancing ? (uint32_t)cmd->instance_count : 1;
+    if (cmd->draw_mode == DBGDRAW_MODE_STROKE)
+    {
+      dd__vk_line_push_constants_t push = {
+        .mvp                = mvp,
+        .viewport_size      = viewport_size,
+        .aa_radius          = ctx->aa_radius,
+        .command_info       = { cmd->base_index, cmd->vertex_count },
+        .instancing_enabled = instancing
+      };
+      vkCmdPushConstants(cmd_buf,
+                         backend->pipeline_layout,
+                         VK_SHADER_STAGE_VERTEX_BIT |
+                           VK_SHADER_STAGE_FRAGMENT_BIT,
+                         0,
+                         sizeof(push),
+                         &push);
+      vkCmdDraw(cmd_buf, 3 * cmd->vertex_count, instance_count, 0, 0);
+    }
+    else
+    {
+      dd_mat4_t normal_matrix =
+        dd_mat4_mul(ctx->proj,
+                    dd_mat4_mul(ctx->view,
+                                dd_mat4_transpose(dd_mat4_inverse(cmd->xform))));
+      dd__vk_base_push_constants_t push = { .mvp = mvp,
+                                            .instancing_enabled = instancing };
+      for (int32_t col = 0; col < 3; ++col)
+      {
+        memcpy(push.normal_matrix + 4 * col,
+               normal_matrix.data + 4 * col,
+               3 * sizeof(float));
+      }
+      vkCmdPushConstants(cmd_buf,
+                         backend->pipeline_layout,
+                         VK_SHADER_STAGE_VERTEX_BIT |
+                           VK_SHADER_STAGE_FRAGMENT_BIT,
+                         0,
+                         sizeof(push),
+                         &push);
+
+#if DBGDRAW_HAS_TEXT_SUPPORT
+      if (shading == DBGDRAW_SHADING_TEXT && cmd->font_idx >= 0)
+      {
+        uint32_t tex_id     = ctx->fonts[cmd->font_idx].tex_id;
+        VkDescriptorSet set = backend->fonts[tex_id - 1].set;
+        if (set != bound_font)
+        {
+          vkCmdBindDescriptorSets(cmd_buf,
+                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                  backend->pipeline_layout,
+                                  1,
+                                  1,
+                                  &set,
+                                  0,
+                                  NULL);
+          bound_font = set;
+        }
+      }
+#endif
+      vkCmdDraw(cmd_buf,
+                cmd->vertex_count,
+                instance_count,
+                cmd->base_index,
+                0);
+    }
+    DBGDRAW_STATS(ctx->drawcall_count++);
+    DBGDRAW_TRACE_END(ctx, "dd_backend_submit");
+  }
+  (void)bound_font;
+
+  VKCHECK(vkEndCommandBuffer(cmd_buf));
+  backend->frame_slot = slot;
+  backend->frame_count++;
+
+  return DBGDRAW_ERR_OK;
+}
+
+VkCommandBuffer
+dd_vk_get_command_buffer(dd_ctx_t* ctx)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend = ctx->render_backend;
+  if (backend->frame_slot < 0) { return VK_NULL_HANDLE; }
+  return backend->frames[backend->frame_slot].cmd;
+}
+
+#if DBGDRAW_HAS_TEXT_SUPPORT
+int32_t
+dd_backend_init_font_texture(dd_ctx_t* ctx,
+                             const uint8_t* data,
+                             int32_t width,
+                             int32_t height,
+                             uint32_t* tex_id)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend = ctx->render_backend;
+
+  if (backend->fonts_len >= DBGDRAW_VK_MAX_FONTS)
+  {
+    return DBGDRAW_ERR_FONT_LIMIT_REACHED;
+  }
+
+  dd__vk_texture_t* texture = backend->fonts + backend->fonts_len;
+  dd__vk_create_texture(backend, data, width, height, texture);
+  *tex_id = ++backend->fonts_len;
+  return DBGDRAW_ERR_OK;
+}
+
+int32_t
+dd_backend_update_font_texture(dd_ctx_t* ctx,
+                               const uint8_t* data,
+                               int32_t width,
+                               int32_t height,
+                               int32_t x,
+                               int32_t y,
+                               int32_t w,
+                               int32_t h,
+                               uint32_t* tex_id)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend = ctx->render_backend;
+  assert(*tex_id > 0 && *tex_id <= (uint32_t)backend->fonts_len);
+  dd__vk_texture_t* texture = backend->fonts + (*tex_id - 1);
+  (void)height;
+
+  dd__vk_buffer_t staging = { 0 };
+  dd__vk_create_buffer(backend,
+                       (VkDeviceSize)w * h,
+                       VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                       0,
+                       &staging);
+  for (int32_t row = 0; row < h; ++row)
+  {
+    memcpy(staging.mapped + (size_t)row * w,
+           data + (size_t)(y + row) * width + x,
+           (size_t)w);
+  }
+
+  VkCommandBuffer cmd = dd__vk_begin_upload(backend);
+  VkImageMemoryBarrier barrier = {
+    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+    .srcAccessMask       = VK_ACCESS_SHADER_READ_BIT,
+    .dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+    .oldLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .image               = texture->image,
+    .subresourceRange    = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+  };
+  vkCmdPipelineBarrier(cmd,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       0,
+                       0,
+                       NULL,
+                       0,
+                       NULL,
+                       1,
+                       &barrier);
+
+  VkBufferImageCopy region = {
+    .imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+    .imageOffset      = { x, y, 0 },
+    .imageExtent      = { (uint32_t)w, (uint32_t)h, 1 }
+  };
+  vkCmdCopyBufferToImage(cmd,
+                         staging.buffer,
+                         texture->image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         1,
+                         &region);
+
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  vkCmdPipelineBarrier(cmd,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       0,
+                       0,
+                       NULL,
+                       0,
+                       NULL,
+                       1,
+                       &barrier);
+  dd__vk_end_upload(backend, cmd);
+  dd__vk_destroy_buffer(backend, &staging);
+  return DBGDRAW_ERR_OK;
+}
+#endif
+
+void
+dd__vk_delete_image_target(dd_render_backend_t* backend)
+{
+  VkDevice device = backend->vk->device;
+  for (int32_t i = 0; i < DBGDRAW_VK_FRAMES_IN_FLIGHT; ++i)
+  {
+    dd__vk_frame_t* frame = backend->frames + i;
+    if (frame->image_pending)
+    {
+      VKCHECK(
+        vkWaitForFences(device, 1, &frame->image_fence, VK_TRUE, UINT64_MAX));
+      frame->image_pending = false;
+    }
+    dd__vk_destroy_buffer(backend, &frame->readback);
+  }
+  vkDestroyFramebuffer(device, backend->image_framebuffer, NULL);
+  vkDestroyImageView(device, backend->image_color_view, NULL);
+  vkDestroyImage(device, backend->image_color, NULL);
+  vkFreeMemory(device, backend->image_color_memory, NULL);
+  vkDestroyImageView(device, backend->image_depth_view, NULL);
+  vkDestroyImage(device, backend->image_depth, NULL);
+  vkFreeMemory(device, backend->image_depth_memory, NULL);
+  backend->image_framebuffer = VK_NULL_HANDLE;
+}
+
+void
+dd__vk_create_image_target(dd_render_backend_t* backend,
+                           int32_t width,
+                           int32_t height)
+{
+  VkDevice device = backend->vk->device;
+
+  backend->image_color_view =
+    dd__vk_create_image(backend,
+                        width,
+                        height,
+                        VK_FORMAT_R8G8B8A8_UNORM,
+                        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                          VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                        VK_IMAGE_ASPECT_COLOR_BIT,
+                        &backend->image_color,
+                        &backend->image_color_memory);
+  backend->image_depth_view =
+    dd__vk_create_image(backend,
+                        width,
+                        height,
+                        backend->image_depth_format,
+                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                        VK_IMAGE_ASPECT_DEPTH_BIT,
+                        &backend->image_depth,
+                        &backend->image_depth_memory);
+
+  VkImageView attachments[2]         = { backend->image_color_view,
+                                 backend->image_depth_view };
+  VkFramebufferCreateInfo fb_info    = {
+    .sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+    .renderPass      = backend->image_render_pass,
+    .attachmentCount = 2,
+    .pAttachments    = attachments,
+    .width           = (uint32_t)width,
+    .height          = (uint32_t)height,
+    .layers          = 1
+  };
+  VKCHECK(
+    vkCreateFramebuffer(device, &fb_info, NULL, &backend->image_framebuffer));
+
+  for (int32_t i = 0; i < DBGDRAW_VK_FRAMES_IN_FLIGHT; ++i)
+  {
+    dd__vk_frame_t* frame = backend->frames + i;
+    dd__vk_create_buffer(backend,
+                         (VkDeviceSize)width * height * 4,
+                         VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                         VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+                         &frame->readback);
+
+    if (!frame->image_cmd)
+    {
+      VkCommandBufferAllocateInfo cmd_info = {
+        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool        = backend->command_pool,
+        .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1
+      };
+      VKCHECK(vkAllocateCommandBuffers(device, &cmd_info, &frame->image_cmd));
+
+      VkFenceCreateInfo fence_info = { .sType =
+                                         VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+      VKCHECK(vkCreateFence(device, &fence_info, NULL, &frame->image_fence));
+    }
+  }
+
+  backend->image_width       = width;
+  backend->image_height      = height;
+  backend->image_frame_count = 0;
+}
+
+// Copies the readback of the given frame into the image, waiting for it if
+// needed. Rows are already in top to bottom order.
+void
+dd__vk_retire_readback(dd_render_backend_t* backend,
+                       int32_t slot,
+                       dd_image_t* image)
+{
+  dd__vk_frame_t* frame = backend->frames + slot;
+  VKCHECK(vkWaitForFences(backend->vk->device,
+                          1,
+                          &frame->image_fence,
+                          VK_TRUE,
+                          UINT64_MAX));
+  memcpy(image->pixels,
+         frame->readback.mapped,
+         (size_t)backend->image_width * backend->image_height * 4);
+  image->frame_idx     = frame->image_frame_idx;
+  frame->image_pending = false;
+}
+
+// Returns -1 if no frame is waiting to be read back
+int32_t
+dd__vk_oldest_readback(dd_render_backend_t* backend)
+{
+  int32_t oldest = -1;
+  for (int32_t i = 0; i < DBGDRAW_VK_FRAMES_IN_FLIGHT; ++i)
+  {
+    dd__vk_frame_t* frame = backend->frames + i;
+    if (frame->image_pending &&
+        (oldest < 0 ||
+         frame->image_frame_idx < backend->frames[oldest].image_frame_idx))
+    {
+      oldest = i;
+    }
+  }
+  return oldest;
+}
+
+int32_t
+dd_render_to_image(dd_ctx_t* ctx, dd_image_t* image)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  assert(image);
+  dd_render_backend_t* backend = ctx->render_backend;
+  VkDevice device              = backend->vk->device;
+
+  if (image->width <= 0 || image->height <= 0 || !image->pixels ||
+      !backend->image_render_pass)
+  {
+    return DBGDRAW_ERR_INVALID_IMAGE;
+  }
+
+  // Changing the size drops frames that were not read back yet
+  if (!backend->image_framebuffer || backend->image_width != image->width ||
+      backend->image_height != image->height)
+  {
+    if (backend->image_framebuffer) { dd__vk_delete_image_target(backend); }
+    dd__vk_create_image_target(backend, image->width, image->height);
+  }
+
+  // Ring is full - the frame about to be recorded has to be read back first
+  image->frame_idx = -1;
+  int32_t slot     = backend->frame_count % DBGDRAW_VK_FRAMES_IN_FLIGHT;
+  if (backend->frames[slot].image_pending)
+  {
+    dd__vk_retire_readback(backend, slot, image);
+  }
+
+  int32_t error         = dd_render(ctx);
+  dd__vk_frame_t* frame = backend->frames + slot;
+
+  VkCommandBuffer cmd_buf             = frame->image_cmd;
+  VkCommandBufferBeginInfo begin_info = {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+  };
+  VKCHECK(vkResetCommandBuffer(cmd_buf, 0));
+  VKCHECK(vkBeginCommandBuffer(cmd_buf, &begin_info));
+
+  VkClearValue clear_values[2]         = { 0 };
+  clear_values[0].color.float32[0]     = image->clear_color.r / 255.0f;
+  clear_values[0].color.float32[1]     = image->clear_color.g / 255.0f;
+  clear_values[0].color.float32[2]     = image->clear_color.b / 255.0f;
+  clear_values[0].color.float32[3]     = image->clear_color.a / 255.0f;
+  clear_values[1].depthStencil.depth   = 1.0f;
+  VkRenderPassBeginInfo pass_info      = {
+    .sType           = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+    .renderPass      = backend->image_render_pass,
+    .framebuffer     = backend->image_framebuffer,
+    .renderArea      = { { 0, 0 },
+                    { (uint32_t)image->width, (uint32_t)image->height } },
+    .clearValueCount = 2,
+    .pClearValues    = clear_values
+  };
+  vkCmdBeginRenderPass(cmd_buf,
+                       &pass_info,
+                       VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+  vkCmdExecuteCommands(cmd_buf, 1, &frame->cmd);
+  vkCmdEndRenderPass(cmd_buf);
+
+  VkBufferImageCopy region = {
+    .imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+    .imageExtent      = { (uint32_t)image->width, (uint32_t)image->height, 1 }
+  };
+  vkCmdCopyImageToBuffer(cmd_buf,
+                         backend->image_color,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         frame->readback.buffer,
+                         1,
+                         &region);
+
+  VkBufferMemoryBarrier barrier = {
+    .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+    .srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+    .dstAccessMask       = VK_ACCESS_HOST_READ_BIT,
+    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .buffer              = frame->readback.buffer,
+    .offset              = 0,
+    .size                = VK_WHOLE_SIZE
+  };
+  vkCmdPipelineBarrier(cmd_buf,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT,
+                       0,
+                       0,
+                       NULL,
+                       1,
+                       &barrier,
+                       0,
+                       NULL);
+  VKCHECK(vkEndCommandBuffer(cmd_buf));
+
+  VkSubmitInfo submit_info = { .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                               .commandBufferCount = 1,
+                               .pCommandBuffers    = &cmd_buf };
+  VKCHECK(vkResetFences(device, 1, &frame->image_fence));
+  VKCHECK(
+    vkQueueSubmit(backend->vk->queue, 1, &submit_info, frame->image_fence));
+  frame->image_frame_idx = backend->image_frame_count++;
+  frame->image_pending   = true;
+
+  // Otherwise only return the oldest frame if the gpu is already done with it
+  if (image->frame_idx < 0)
+  {
+    int32_t oldest = dd__vk_oldest_readback(backend);
+    if (vkGetFenceStatus(device, backend->frames[oldest].image_fence) ==
+        VK_SUCCESS)
+    {
+      dd__vk_retire_readback(backend, oldest, image);
+    }
+  }
+
+  return error;
+}
+
+int32_t
+dd_flush_image(dd_ctx_t* ctx, dd_image_t* image)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  assert(image);
+  dd_render_backend_t* backend = ctx->render_backend;
+
+  image->frame_idx = -1;
+  int32_t oldest   = dd__vk_oldest_readback(backend);
+  if (oldest < 0) { return DBGDRAW_ERR_OK; }
+  if (image->width != backend->image_width ||
+      image->height != backend->image_height || !image->pixels)
+  {
+    return DBGDRAW_ERR_INVALID_IMAGE;
+  }
+
+  dd__vk_retire_readback(backend, oldest, image);
+  return DBGDRAW_ERR_OK;
+}
+
+// The application has to make sure that the gpu is done with the recorded
+// command buffers before calling dd_term. Offscreen frames are waited for here.
+int32_t
+dd_backend_term(dd_ctx_t* ctx)
+{
+  assert(ctx);
+  assert(ctx->render_backend);
+  dd_render_backend_t* backend = ctx->render_backend;
+  VkDevice device              = backend->vk->device;
+
+  if (backend->image_framebuffer) { dd__vk_delete_image_target(backend); }
+  for (int32_t i = 0; i < DBGDRAW_VK_FRAMES_IN_FLIGHT; ++i)
+  {
+    dd__vk_frame_t* frame = backend->frames + i;
+    dd__vk_destroy_buffer(backend, &frame->data);
+    vkDestroyFence(device, frame->image_fence, NULL);
+  }
+  for (int32_t i = 0; i < backend->fonts_len; ++i)
+  {
+    dd__vk_destroy_texture(backend, backend->fonts + i);
+  }
+  dd__vk_destroy_texture(backend, &backend->null_font);
+
+  for (int32_t i = 0; i < DBGDRAW_MODE_COUNT; ++i)
+  {
+    for (int32_t j = 0; j < DBGDRAW_SHADING_COUNT; ++j)
+    {
+      vkDestroyPipeline(device, backend->pipelines[i][j][0], NULL);
+      vkDestroyPipeline(device, backend->pipelines[i][j][1], NULL);
+    }
+  }
+  vkDestroyRenderPass(device, backend->image_render_pass, NULL);
+  vkDestroySampler(device, backend->font_sampler, NULL);
+  vkDestroyCommandPool(device, backend->command_pool, NULL);
+  vkDestroyDescriptorPool(device, backend->descriptor_pool, NULL);
+  vkDestroyPipelineLayout(device, backend->pipeline_layout, NULL);
+  vkDestroyDescriptorSetLayout(device, backend->data_set_layout, NULL);
+  vkDestroyDescriptorSetLayout(device, backend->font_set_layout, NULL);
+  vkDestroyShaderModule(device, backend->base_vert, NULL);
+  vkDestroyShaderModule(device, backend->base_frag, NULL);
+  vkDestroyShaderModule(device, backend->lines_vert, NULL);
+  vkDestroyShaderModule(device, backend->lines_frag, NULL);
+  memset(backend->pipelines, 0, sizeof(backend->pipelines));
+  return DBGDRAW_ERR_OK;
+}
+
+#endif
@@ -0,0 +1,279 @@
+#define MSH_VEC_MATH_INCLUDE_LIBC_HEADERS
+#define MSH_VEC_MATH_IMPLEMENTATION
+#define DBGDRAW_VALIDATION_LAYERS
+#define DBGDRAW_USE_DEFAULT_FONT
+
+#include <vulkan/vulkan.h>
+
+#include "msh_vec_math.h"
+#include "stb_truetype.h"
+#include "dbgdraw.h"
+#include "dbgdraw_vulkan.h"
+
+// Renders a few frames without a window or a swapchain, and writes them out as
+// .ppm images. Any Vulkan device with a graphics queue will do, so it also runs
+// on machines without a gpu, with Mesa lavapipe. If a filename is passed as an
+// argument, the frames are also captured into that file, which can be replayed
+// with dd_replay.
+
+#define IMAGE_WIDTH  640
+#define IMAGE_HEIGHT 320
+#define FRAME_COUNT  8
+
+typedef struct app_state_t {
+  VkInstance instance;
+  VkDevice device;
+  dd_vk_desc_t vk_desc;
+  dd_ctx_t* dd_ctx;
+  dd_image_t image;
+#ifdef DBGDRAW_TRACING
+  dd_trace_file_t trace;
+#endif
+} app_state_t;
+
+int32_t init( app_state_t* state, const char* capture_filename );
+void frame( app_state_t* state, int32_t frame_idx );
+void write_image( dd_image_t* image );
+void cleanup( app_state_t* state );
+
+int32_t
+main( int32_t argc, char** argv )
+{
+  int32_t error = 0;
+  app_state_t* state = calloc( 1, sizeof(app_state_t) );
+
+  error = init( state, argc > 1 ? argv[1] : NULL );
+  if( error ) { goto main_return; }
+
+  for( int32_t i = 0; i < FRAME_COUNT; ++i )
+  {
+    frame( state, i );
+    if( state->image.frame_idx >= 0 ) { write_image( &state->image ); }
+  }
+
+  // Frames still in flight need to be read back explicitly
+  while( !dd_flush_image( state->dd_ctx, &state->image ) &&
+         state->image.frame_idx >= 0 )
+  {
+    write_image( &state->image );
+  }
+
+  main_return:
+  cleanup( state );
+  return error;
+}
+
+int32_t init( app_state_t* state, const char* capture_filename ) {
+  int32_t error = 0;
+
+  VkApplicationInfo app_info =
+  {
+    .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+    .pApplicationName = "dd_vk_headless",
+    .apiVersion = VK_API_VERSION_1_0
+  };
+  VkInstanceCreateInfo instance_info =
+  {
+    .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+    .pApplicationInfo = &app_info
+  };
+  if( vkCreateInstance( &instance_info, NULL, &state->instance ) != VK_SUCCESS )
+  {
+    fprintf( stderr, "[ERROR] Failed to create Vulkan instance!\n" );
+    return 1;
+  }
+
+  // Pick the first device that can draw
+  VkPhysicalDevice physical_devices[16];
+  uint32_t physical_device_count = 16;
+  vkEnumeratePhysicalDevices( state->instance, &physical_device_count, physical_devices );
+
+  dd_vk_desc_t* vk_desc = &state->vk_desc;
+  for( uint32_t i = 0; i < physical_device_count && !vk_desc->physical_device; ++i )
+  {
+    VkQueueFamilyProperties families[16];
+    uint32_t family_count = 16;
+    vkGetPhysicalDeviceQueueFamilyProperties( physical_devices[i], &family_count, families );
+    for( uint32_t j = 0; j < family_count; ++j )
+    {
+      if( families[j].queueFlags & VK_QUEUE_GRAPHICS_BIT )
+      {
+        vk_desc->physical_device = physical_devices[i];
+        vk_desc->queue_family_index = j;
+        break;
+      }
+    }
+  }
+  if( !vk_desc->physical_device )
+  {
+    fprintf( stderr, "[ERROR] Failed to find a Vulkan device with a graphics queue!\n" );
+    return 1;
+  }
+
+  VkPhysicalDeviceProperties device_props;
+  vkGetPhysicalDeviceProperties( vk_desc->physical_device, &device_props );
+  printf( "Rendering on %s\n", device_props.deviceName );
+
+  // Points are drawn with gl_PointSize, which needs large points
+  VkPhysicalDeviceFeatures supported_features;
+  VkPhysicalDeviceFeatures features = { 0 };
+  vkGetPhysicalDeviceFeatures( vk_desc->physical_device, &supported_features );
+  features.largePoints = supported_features.largePoints;
+
+  float queue_priority = 1.0f;
+  VkDeviceQueueCreateInfo queue_info =
+  {
+    .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+    .queueFamilyIndex = vk_desc->queue_family_index,
+    .queueCount = 1,
+    .pQueuePriorities = &queue_priority
+  };
+  VkDeviceCreateInfo device_info =
+  {
+    .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+    .queueCreateInfoCount = 1,
+    .pQueueCreateInfos = &queue_info,
+    .pEnabledFeatures = &features
+  };
+  if( vkCreateDevice( vk_desc->physical_device, &device_info, NULL, &state->device ) != VK_SUCCESS )
+  {
+    fprintf( stderr, "[ERROR] Failed to create Vulkan device!\n" );
+    return 1;
+  }
+  vk_desc->device = state->device;
+  vkGetDeviceQueue( state->device, vk_desc->queue_family_index, 0, &vk_desc->queue );
+
+  // No render pass of our own, so the backend creates one for dd_render_to_image
+  state->dd_ctx = calloc( 1, sizeof(dd_ctx_t) );
+  dd_render_backend_t* backend = calloc( 1, sizeof(dd_render_backend_t) );
+  backend->vk = vk_desc;
+  state->dd_ctx->render_backend = backend;
+
+  dd_ctx_desc_t desc =
+  {
+    .max_vertices = 1024,
+    .max_commands = 16,
+    .detail_level = 2,
+    .enable_depth_test = true,
+    .enable_default_font = 1
+  };
+  error = dd_init( state->dd_ctx, &desc );
+  if( error )
+  {
+    fprintf( stderr, "[ERROR] Failed to initialize dbgdraw library!\n" );
+    return 1;
+  }
+
+  if( capture_filename )
+  {
+    error = dd_capture_begin( state->dd_ctx, capture_filename );
+    if( error ) { fprintf( stderr, "%s\n", dd_error_message( error ) ); }
+  }
+
+#ifdef DBGDRAW_TRACING
+  // Open the trace in chrome://tracing or ui.perfetto.dev
+  if( !dd_trace_file_open( &state->trace, "dbgdraw_vulkan_trace.json" ) )
+  {
+    dd_trace_hooks_t hooks = dd_trace_file_hooks( &state->trace );
+    dd_set_trace_hooks( state->dd_ctx, &hooks );
+  }
+#endif
+
+  state->image.width       = IMAGE_WIDTH;
+  state->image.height      = IMAGE_HEIGHT;
+  state->image.clear_color = dd_rgbf( 0.9f, 0.9f, 0.9f );
+  state->image.pixels      = malloc( IMAGE_WIDTH * IMAGE_HEIGHT * 4 );
+
+  return 0;
+}
+
+void frame( app_state_t* state, int32_t frame_idx )
+{
+  dd_ctx_t* dd_ctx = state->dd_ctx;
+  float w = (float)state->image.width;
+  float h = (float)state->image.height;
+
+  float fovy = 1.0472f; /* approx. 60 deg in radians */
+  float angle = frame_idx * (float)DBGDRAW_TWO_PI / FRAME_COUNT;
+
+  msh_vec3_t cam_pos = msh_vec3( 0.8f, 2.6f, 3.0f );
+  msh_mat4_t view = msh_look_at( cam_pos, msh_vec3_zeros(), msh_vec3_posy() );
+  msh_vec4_t viewport = msh_vec4( 0.0f, 0.0f, w, h );
+  msh_mat4_t proj = msh_perspective( fovy, w/h, 0.1f, 100.0f );
+  msh_mat4_t model = msh_mat4_identity();
+  model = msh_post_rotate( model, angle, msh_vec3_posy() );
+
+  dd_new_frame_info_t info = {
+    .view_matrix       = view.data,
+    .projection_matrix = proj.data,
+    .viewport_size     = viewport.data,
+    .vertical_fov      = fovy,
+    .projection_type   = DBGDRAW_PERSPECTIVE };
+  dd_new_frame( dd_ctx, &info );
+
+  dd_set_transform( dd_ctx, model.data );
+
+  dd_set_shading_type( dd_ctx, DBGDRAW_SHADING_SOLID );
+  dd_begin_cmd( dd_ctx, DBGDRAW_MODE_FILL );
+  dd_set_color( dd_ctx, DBGDRAW_RED );
+  dd_sphere( dd_ctx, msh_vec3( 0.0f, 0.0f, 0.0f ).data, 0.6f );
+  dd_set_color( dd_ctx, DBGDRAW_BLUE );
+  dd_cone( dd_ctx, msh_vec3( 1.0f, -0.5f, 0.0f ).data, msh_vec3( 1.0f, 0.5f, 0.0f ).data, 0.3f );
+  dd_end_cmd( dd_ctx );
+
+  dd_set_shading_type( dd_ctx, DBGDRAW_SHADING_NONE );
+  dd_begin_cmd( dd_ctx, DBGDRAW_MODE_STROKE );
+  dd_set_color( dd_ctx, DBGDRAW_GRAY );
+  dd_aabb( dd_ctx, msh_vec3( -1.1f, -1.1f, -1.1f ).data, msh_vec3( 1.1f, 1.1f, 1.1f ).data );
+  dd_end_cmd( dd_ctx );
+
+  char label[32];
+  snprintf( label, sizeof(label), "Frame %d", frame_idx );
+  dd_set_transform( dd_ctx, msh_mat4_identity().data );
+  dd_set_shading_type( dd_ctx, DBGDRAW_SHADING_TEXT );
+  dd_begin_cmd( dd_ctx, DBGDRAW_MODE_FILL );
+  dd_set_color( dd_ctx, DBGDRAW_BLACK );
+  dd_text_line( dd_ctx, msh_vec3( 0.0f, 1.4f, 0.0f ).data, label, NULL );
+  dd_end_cmd( dd_ctx );
+
+  int32_t error = dd_render_to_image( dd_ctx, &state->image );
+  if( error ) { fprintf( stderr, "%s\n", dd_error_message( error ) ); }
+}
+
+void write_image( dd_image_t* image )
+{
+  char filename[64];
+  snprintf( filename, sizeof(filename), "dbgdraw_vulkan_%02d.ppm", image->frame_idx );
+  FILE* fp = fopen( filename, "wb" );
+  if( !fp )
+  {
+    fprintf( stderr, "[ERROR] Failed to open %s for writing!\n", filename );
+    return;
+  }
+
+  fprintf( fp, "P6\n%d %d\n255\n", image->width, image->height );
+  for( int32_t i = 0; i < image->width * image->height; ++i )
+  {
+    fwrite( image->pixels + 4 * i, 1, 3, fp );
+  }
+  fclose( fp );
+  printf( "Wrote %s\n", filename );
+}
+
+void cleanup( app_state_t* state )
+{
+  if( state->dd_ctx )
+  {
+    if( state->device ) { vkDeviceWaitIdle( state->device ); }
+    dd_term( state->dd_ctx );
+    free( state->dd_ctx->render_backend );
+    free( state->dd_ctx );
+  }
+#ifdef DBGDRAW_TRACING
+  dd_trace_file_close( &state->trace );
+#endif
+  if( state->device ) { vkDestroyDevice( state->device, NULL ); }
+  if( state->instance ) { vkDestroyInstance( state->instance, NULL ); }
+  free( state->image.pixels );
+  free( state );
+}
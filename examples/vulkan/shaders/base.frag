@@ -0,0 +1,30 @@
+#version 450
+
+layout(constant_id = 0) const int shading_type = 0;
+
+layout(set = 1, binding = 0) uniform sampler2D u_font_texture;
+
+layout(location = 0) in vec4 v_color;
+layout(location = 1) in vec3 v_uv_or_normal;
+
+layout(location = 0) out vec4 frag_color;
+
+void main()
+{
+  if (shading_type == 0)
+  {
+    frag_color = v_color;
+  }
+  else if (shading_type == 1)
+  {
+    vec3 light_dir = vec3(0, 0, 1);
+    float ndotl = dot(v_uv_or_normal, light_dir);
+    frag_color = vec4(v_color.rgb * ndotl, v_color.a);
+  }
+  else
+  {
+    float texture_val = texture(u_font_texture, v_uv_or_normal.xy).r;
+    float alpha = clamp(v_color.a * texture_val, 0.0, 1.0);
+    frag_color = vec4(v_color.rgb, alpha);
+  }
+}
@@ -0,0 +1,42 @@
+#version 450
+
+// Fill and point commands. Shading type is a specialization constant, so each
+// (mode, shading) pair gets a pipeline of its own.
+layout(constant_id = 0) const int shading_type = 0;
+
+layout(push_constant) uniform dd_push_constants
+{
+  mat4 u_mvp;
+  mat3 u_normal_matrix;
+  int u_instancing_enabled;
+};
+
+layout(location = 0) in vec4 in_position_and_size;
+layout(location = 1) in vec3 in_uv_or_normal;
+layout(location = 2) in vec4 in_color;
+layout(location = 3) in vec3 in_instance_pos;
+layout(location = 4) in vec4 in_instance_col;
+
+layout(location = 0) out vec4 v_color;
+layout(location = 1) out vec3 v_uv_or_normal;
+
+void main()
+{
+  vec3 position = in_position_and_size.xyz;
+  v_color = in_color;
+  if (u_instancing_enabled != 0)
+  {
+    position += in_instance_pos;
+    v_color += in_instance_col;
+  }
+
+  if (shading_type == 1) { v_uv_or_normal = u_normal_matrix * in_uv_or_normal; }
+  else                   { v_uv_or_normal = in_uv_or_normal; }
+
+  gl_Position = u_mvp * vec4(position, 1.0);
+  gl_PointSize = in_position_and_size.w;
+
+  // dbgdraw produces OpenGL clip space - flip y and move depth to [0, 1]
+  gl_Position.y = -gl_Position.y;
+  gl_Position.z = 0.5 * (gl_Position.z + gl_Position.w);
+}
@@ -0,0 +1,26 @@
+#version 450
+
+layout(push_constant) uniform dd_push_constants
+{
+  mat4 u_mvp;
+  vec2 u_viewport_size;
+  vec2 u_aa_radius;
+  ivec2 u_command_info;
+  int u_instancing_enabled;
+};
+
+layout(location = 0) in vec4 v_col;
+layout(location = 1) in noperspective float v_u;
+layout(location = 2) in noperspective float v_v;
+layout(location = 3) in noperspective float v_line_width;
+layout(location = 4) in noperspective float v_line_length;
+
+layout(location = 0) out vec4 frag_color;
+
+void main()
+{
+  float au = 1.0 - smoothstep(1.0 - ((2.0 * u_aa_radius[0]) / v_line_width), 1.0, abs(v_u / v_line_width));
+  float av = 1.0 - smoothstep(1.0 - ((u_aa_radius[1]) / v_line_length), 1.0, abs(v_v / v_line_length));
+  frag_color = v_col;
+  frag_color.a *= min(au, av);
+}
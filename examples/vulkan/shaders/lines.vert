@@ -0,0 +1,217 @@
+#version 450
+
+// Stroke commands. Every segment is expanded into a quad of two triangles, with
+// miter joins to neighbouring segments, same as in the OpenGL backends. Vertex
+// data is read from the storage buffer, so only instance data comes in as
+// vertex attributes.
+layout(push_constant) uniform dd_push_constants
+{
+  mat4 u_mvp;
+  vec2 u_viewport_size;
+  vec2 u_aa_radius;
+  ivec2 u_command_info;
+  int u_instancing_enabled;
+};
+
+layout(set = 0, binding = 0) readonly buffer dd_line_data
+{
+  vec4 u_line_data[];
+};
+
+layout(location = 3) in vec3 in_instance_pos;
+layout(location = 4) in vec4 in_instance_col;
+
+layout(location = 0) out vec4 v_col;
+layout(location = 1) out noperspective float v_u;
+layout(location = 2) out noperspective float v_v;
+layout(location = 3) out noperspective float v_line_width;
+layout(location = 4) out noperspective float v_line_length;
+
+vec4 get_vertex_position(int idx) {
+  return u_line_data[idx];
+}
+
+vec4 get_vertex_color(int idx) {
+  uint packed_color = floatBitsToUint(u_line_data[idx].w);
+  vec4 color = vec4(float((packed_color)&uint(0x000000FF)),
+                    float((packed_color >> 8) & uint(0x000000FF)),
+                    float((packed_color >> 16) & uint(0x000000FF)),
+                    float((packed_color >> 24) & uint(0x000000FF)));
+  return color / 255.0f;
+}
+
+ivec3 calculate_segment_ids() {
+  int base_idx = (gl_VertexIndex / 6) * 2;
+  return ivec3(base_idx - 2, base_idx, base_idx + 2);
+}
+
+ivec2 calculate_vertex_ids(int segment_idx, int base_idx) {
+  return ivec2(base_idx + segment_idx * 2, base_idx + (segment_idx + 1) * 2);
+}
+
+void main() {
+  float u_width = u_viewport_size[0];
+  float u_height = u_viewport_size[1];
+  int u_base_idx = u_command_info[0];
+  int u_count = u_command_info[1];
+
+  // Get indices of line segments
+  int base_idx = 2 * u_base_idx;
+  ivec3 segment_ids = calculate_segment_ids();
+  ivec2 line_ids_0 = calculate_vertex_ids(segment_ids[0], base_idx);
+  ivec2 line_ids_1 = calculate_vertex_ids(segment_ids[1], base_idx);
+  ivec2 line_ids_2 = calculate_vertex_ids(segment_ids[2], base_idx);
+
+  // Sample data for this line segment
+  vec4 pos_width[6] = vec4[6](vec4(0), vec4(0), vec4(0), vec4(0), vec4(0), vec4(0));
+  if (segment_ids[0] >= 0)
+  {
+    pos_width[0] = get_vertex_position(line_ids_0[0]);
+    pos_width[1] = get_vertex_position(line_ids_0[1]);
+  }
+  pos_width[2] = get_vertex_position(line_ids_1[0]);
+  pos_width[3] = get_vertex_position(line_ids_1[1]);
+
+  if (segment_ids[2] < u_count)
+  {
+    pos_width[4] = get_vertex_position(line_ids_2[0]);
+    pos_width[5] = get_vertex_position(line_ids_2[1]);
+  }
+
+  if (u_instancing_enabled != 0)
+  {
+    pos_width[0] = pos_width[0] + vec4(in_instance_pos, 0.0);
+    pos_width[1] = pos_width[1] + vec4(in_instance_pos, 0.0);
+    pos_width[2] = pos_width[2] + vec4(in_instance_pos, 0.0);
+    pos_width[3] = pos_width[3] + vec4(in_instance_pos, 0.0);
+    pos_width[4] = pos_width[4] + vec4(in_instance_pos, 0.0);
+    pos_width[5] = pos_width[5] + vec4(in_instance_pos, 0.0);
+  }
+
+  vec4 clip_pos[6];
+  clip_pos[0] = u_mvp * vec4(pos_width[0].xyz, 1.0);
+  clip_pos[1] = u_mvp * vec4(pos_width[1].xyz, 1.0);
+  clip_pos[2] = u_mvp * vec4(pos_width[2].xyz, 1.0);
+  clip_pos[3] = u_mvp * vec4(pos_width[3].xyz, 1.0);
+  clip_pos[4] = u_mvp * vec4(pos_width[4].xyz, 1.0);
+  clip_pos[5] = u_mvp * vec4(pos_width[5].xyz, 1.0);
+
+  vec2 ndc_pos[6];
+  ndc_pos[0] = clip_pos[0].xy / clip_pos[0].w;
+  ndc_pos[1] = clip_pos[1].xy / clip_pos[1].w;
+  ndc_pos[2] = clip_pos[2].xy / clip_pos[2].w;
+  ndc_pos[3] = clip_pos[3].xy / clip_pos[3].w;
+  ndc_pos[4] = clip_pos[4].xy / clip_pos[4].w;
+  ndc_pos[5] = clip_pos[5].xy / clip_pos[5].w;
+
+  float half_w = u_width / 2;
+  float half_h = u_height / 2;
+  vec2 viewport_pos[6];
+  viewport_pos[0] = vec2(ndc_pos[0].x * half_w + half_w, ndc_pos[0].y * half_h + half_h);
+  viewport_pos[1] = vec2(ndc_pos[1].x * half_w + half_w, ndc_pos[1].y * half_h + half_h);
+  viewport_pos[2] = vec2(ndc_pos[2].x * half_w + half_w, ndc_pos[2].y * half_h + half_h);
+  viewport_pos[3] = vec2(ndc_pos[3].x * half_w + half_w, ndc_pos[3].y * half_h + half_h);
+  viewport_pos[4] = vec2(ndc_pos[4].x * half_w + half_w, ndc_pos[4].y * half_h + half_h);
+  viewport_pos[5] = vec2(ndc_pos[5].x * half_w + half_w, ndc_pos[5].y * half_h + half_h);
+
+  vec2 line_vector_0 = viewport_pos[1] - viewport_pos[0];
+  vec2 line_vector_1 = viewport_pos[3] - viewport_pos[2];
+  vec2 line_vector_2 = viewport_pos[5] - viewport_pos[4];
+
+  float line_vector_0_length = length(line_vector_0);
+  float line_vector_1_length = length(line_vector_1);
+  float line_vector_2_length = length(line_vector_2);
+
+  vec2 line_vector_0_unit = line_vector_0 / line_vector_0_length;
+  vec2 line_vector_1_unit = line_vector_1 / line_vector_1_length;
+  vec2 line_vector_2_unit = line_vector_2 / line_vector_2_length;
+
+  if (line_vector_0_length <= 0.0001)
+  {
+    line_vector_0_unit = vec2(0.0, 0.0);
+    line_vector_0_length = 0.0;
+  }
+  if (line_vector_1_length <= 0.0001)
+  {
+    line_vector_1_unit = vec2(0.0, 0.0);
+    line_vector_1_length = 0.0;
+  }
+  if (line_vector_2_length <= 0.001)
+  {
+    line_vector_2_unit = vec2(0.0, 0.0);
+    line_vector_2_length = 0.0;
+  }
+
+  vec2 mitter_0 = line_vector_1_unit + line_vector_0_unit;
+  vec2 mitter_1 = line_vector_1_unit + line_vector_2_unit;
+  mitter_0 = vec2(-mitter_0.y, mitter_0.x) * 0.5;
+  mitter_1 = vec2(-mitter_1.y, mitter_1.x) * 0.5;
+
+  vec2 dir = line_vector_1_unit;
+  vec2 normal = vec2(-dir.y, dir.x);
+
+  float mitter_0_length = dot(mitter_0, normal);
+  float mitter_1_length = dot(mitter_1, normal);
+  float cos_angle_threshold = -0.7;
+
+  if (segment_ids[0] < 0 ||
+      length(viewport_pos[2] - viewport_pos[1]) > 0 ||
+      dot(line_vector_0_unit, line_vector_1_unit) < cos_angle_threshold)
+  {
+    mitter_0 = normal;
+    mitter_0_length = 1;
+  }
+
+  if (segment_ids[2] >= u_count ||
+      length(viewport_pos[4] - viewport_pos[3]) > 0 ||
+      dot(line_vector_2_unit, line_vector_1_unit) < cos_angle_threshold)
+  {
+    mitter_1 = normal;
+    mitter_1_length = 1;
+  }
+
+  float extension_length = u_aa_radius.y;
+  float line_length = line_vector_1_length + 2.0 * extension_length;
+  float line_width_a = max(pos_width[2].w, 1.0) + u_aa_radius.x;
+  float line_width_b = max(pos_width[3].w, 1.0) + u_aa_radius.x;
+
+  vec2 normal_a = 0.5 * line_width_a * mitter_0 / mitter_0_length;
+  vec2 normal_b = 0.5 * line_width_b * mitter_1 / mitter_1_length;
+  vec2 extension = extension_length * dir;
+
+  int quad_id = gl_VertexIndex % 6;
+  ivec2 quad[6] = ivec2[6](ivec2(0, -1), ivec2(0, 1), ivec2(1, 1),
+                           ivec2(0, -1), ivec2(1, 1), ivec2(1, -1));
+  ivec2 quad_pos = quad[quad_id];
+
+  v_line_width = (1.0 - quad_pos.x) * line_width_a + quad_pos.x * line_width_b;
+  v_line_length = 0.5 * line_length;
+  v_v = (2.0 * quad_pos.x - 1.0) * v_line_length;
+  v_u = (quad_pos.y) * v_line_width;
+
+  vec2 zw_part = (1.0 - quad_pos.x) * clip_pos[2].zw + quad_pos.x * clip_pos[3].zw;
+  vec2 dir_y = quad_pos.y * ((1.0 - quad_pos.x) * normal_a + quad_pos.x * normal_b);
+  vec2 dir_x = quad_pos.x * line_vector_1 + (2.0 * quad_pos.x - 1.0) * extension;
+
+  vec4 color[2];
+  color[0] = get_vertex_color(line_ids_1[0] + 1);
+  color[1] = get_vertex_color(line_ids_1[1] + 1);
+
+  if (u_instancing_enabled != 0)
+  {
+    color[0] += in_instance_col;
+    color[1] += in_instance_col;
+  }
+
+  v_col = color[quad_pos.x];
+  v_col.a = min(pos_width[2 + quad_pos.x].w * v_col.a, 1.0f);
+
+  vec2 viewport_pt = viewport_pos[2] + dir_x + dir_y;
+  vec2 ndc_pt = vec2((viewport_pt.x - half_w) / half_w, (viewport_pt.y - half_h) / half_h);
+
+  gl_Position = vec4(ndc_pt * zw_part.y, zw_part);
+
+  // dbgdraw produces OpenGL clip space - flip y and move depth to [0, 1]
+  gl_Position.y = -gl_Position.y;
+  gl_Position.z = 0.5 * (gl_Position.z + gl_Position.w);
+}